@@ -17,18 +17,26 @@
 
 #include <cc/data.h>
 
+#include <acl/dns.h>
+#include <acl/loader.h>
+
 #include <datasrc/factory.h>
 
 #include <auth/auth_srv.h>
 #include <auth/auth_config.h>
 #include <auth/common.h>
+#include <auth/response_cache.h>
+#include <auth/rrl.h>
 
 #include <server_common/portconfig.h>
 
+#include <util/random/qid_gen.h>
+
 #include <boost/foreach.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
 
+#include <ctime>
 #include <set>
 #include <string>
 #include <utility>
@@ -137,6 +145,173 @@ private:
     size_t timeout_;
 };
 
+/// \brief Configuration for the number of UDP worker threads
+class UDPWorkersConfig : public AuthConfigParser {
+public:
+    UDPWorkersConfig(AuthSrv& server) : server_(server), workers_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            workers_ = config->intValue();
+        } else {
+            bundy_throw(AuthConfigError, "udp_workers must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        server_.setUDPWorkers(workers_);
+    }
+private:
+    AuthSrv& server_;
+    size_t workers_;
+};
+
+/// \brief Configuration for response rate limiting
+///
+/// All parameters of the "rrl" map are optional; the defaults of the spec
+/// are used for missing ones.  If rate limiting is disabled, commit()
+/// clears any limiter the server currently has.
+class RRLConfig : public AuthConfigParser {
+public:
+    RRLConfig(AuthSrv& server) : server_(server) {}
+
+    virtual void build(ConstElementPtr config) {
+        if (!getBool(config, "enable", false)) {
+            rrl_.reset();
+            return;
+        }
+        const int max_table_size = getInt(config, "max_table_size", 20000);
+        if (max_table_size <= 0) {
+            bundy_throw(AuthConfigError,
+                        "rrl max_table_size must be positive");
+        }
+        bundy::util::random::QidGenerator& qid_gen =
+            bundy::util::random::QidGenerator::getInstance();
+        const uint32_t hash_seed =
+            (static_cast<uint32_t>(qid_gen.generateQid()) << 16) |
+            qid_gen.generateQid();
+        try {
+            rrl_.reset(new bundy::auth::ResponseRateLimiter(
+                           getInt(config, "responses_per_second", 0),
+                           getInt(config, "nxdomains_per_second", 0),
+                           getInt(config, "errors_per_second", 0),
+                           getInt(config, "window", 15),
+                           getInt(config, "slip", 2),
+                           max_table_size,
+                           getInt(config, "ipv4_prefix_length", 24),
+                           getInt(config, "ipv6_prefix_length", 56),
+                           std::time(NULL), hash_seed));
+        } catch (const bundy::InvalidParameter& ex) {
+            bundy_throw(AuthConfigError, "Invalid rrl configuration: " <<
+                        ex.what());
+        }
+    }
+
+    virtual void commit() {
+        server_.setRRL(rrl_);
+    }
+private:
+    static bool getBool(ConstElementPtr config, const char* name,
+                        bool default_val)
+    {
+        ConstElementPtr elem = config->get(name);
+        return (elem ? elem->boolValue() : default_val);
+    }
+    static int getInt(ConstElementPtr config, const char* name,
+                      int default_val)
+    {
+        ConstElementPtr elem = config->get(name);
+        return (elem ? elem->intValue() : default_val);
+    }
+
+    AuthSrv& server_;
+    boost::shared_ptr<bundy::auth::ResponseRateLimiter> rrl_;
+};
+
+/// \brief Configuration for the response cache
+///
+/// The cache is (re)created only when its size is changed, so the cached
+/// responses survive other configuration updates.  The size of 0 disables
+/// the cache.
+class ResponseCacheSizeConfig : public AuthConfigParser {
+public:
+    ResponseCacheSizeConfig(AuthSrv& server) : server_(server), size_(0)
+    {}
+
+    virtual void build(ConstElementPtr config) {
+        if (config->intValue() >= 0) {
+            size_ = config->intValue();
+        } else {
+            bundy_throw(AuthConfigError,
+                        "response_cache_size must be 0 or higher");
+        }
+    }
+
+    virtual void commit() {
+        const boost::shared_ptr<bundy::auth::ResponseCache> current =
+            server_.getResponseCache();
+        if ((current ? current->getMaxEntries() : 0) == size_) {
+            return;
+        }
+        boost::shared_ptr<bundy::auth::ResponseCache> cache;
+        if (size_ > 0) {
+            bundy::util::random::QidGenerator& qid_gen =
+                bundy::util::random::QidGenerator::getInstance();
+            const uint32_t hash_seed =
+                (static_cast<uint32_t>(qid_gen.generateQid()) << 16) |
+                qid_gen.generateQid();
+            cache.reset(new bundy::auth::ResponseCache(size_, hash_seed));
+        }
+        server_.setResponseCache(cache);
+    }
+private:
+    AuthSrv& server_;
+    size_t size_;
+};
+
+/// \brief Configuration for zone transfers served by bundy-auth
+///
+/// The ACL is loaded in build(), so an invalid one is rejected before
+/// anything is changed.  Unless "native" is true, the ACL is cleared and
+/// the requests are passed on to bundy-xfrout.
+class XfroutConfig : public AuthConfigParser {
+public:
+    XfroutConfig(AuthSrv& server) : server_(server), max_transfers_(0) {}
+
+    virtual void build(ConstElementPtr config) {
+        acl_.reset();
+        ConstElementPtr elem = config->get("native");
+        if (!elem || !elem->boolValue()) {
+            return;
+        }
+        elem = config->get("transfers_out");
+        const int max_transfers = elem ? elem->intValue() : 10;
+        if (max_transfers < 0) {
+            bundy_throw(AuthConfigError,
+                        "xfrout transfers_out must be 0 or higher");
+        }
+        max_transfers_ = max_transfers;
+        elem = config->get("transfer_acl");
+        try {
+            acl_ = bundy::acl::dns::getRequestLoader().load(
+                elem ? elem :
+                Element::fromJSON("[{\"action\": \"ACCEPT\"}]"));
+        } catch (const bundy::acl::LoaderError& ex) {
+            bundy_throw(AuthConfigError, "Invalid xfrout transfer_acl: " <<
+                        ex.what());
+        }
+    }
+
+    virtual void commit() {
+        server_.setXfrout(acl_, max_transfers_);
+    }
+private:
+    AuthSrv& server_;
+    boost::shared_ptr<const bundy::acl::dns::RequestACL> acl_;
+    size_t max_transfers_;
+};
+
 } // end of unnamed namespace
 
 AuthConfigParser*
@@ -170,6 +345,14 @@ createAuthConfigParser(AuthSrv& server, const std::string& config_id) {
         return (new VersionConfig());
     } else if (config_id == "tcp_recv_timeout") {
         return (new TCPRecvTimeoutConfig(server));
+    } else if (config_id == "rrl") {
+        return (new RRLConfig(server));
+    } else if (config_id == "udp_workers") {
+        return (new UDPWorkersConfig(server));
+    } else if (config_id == "xfrout") {
+        return (new XfroutConfig(server));
+    } else if (config_id == "response_cache_size") {
+        return (new ResponseCacheSizeConfig(server));
     } else {
         bundy_throw(AuthConfigError, "Unknown configuration identifier: " <<
                     config_id);
@@ -15,6 +15,8 @@
 #include <config.h>
 
 #include <util/io/socketsession.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
 #include <asiolink/asiolink.h>
 #include <asiolink/io_endpoint.h>
@@ -30,6 +32,7 @@
 
 #include <dns/edns.h>
 #include <dns/exceptions.h>
+#include <dns/labelsequence.h>
 #include <dns/messagerenderer.h>
 #include <dns/name.h>
 #include <dns/question.h>
@@ -45,6 +48,11 @@
 #include <datasrc/exceptions.h>
 #include <datasrc/client_list.h>
 
+#include <auth/response_cache.h>
+#include <auth/rrl.h>
+#include <auth/rrl_response_type.h>
+#include <auth/rrl_result.h>
+
 #include <auth/common.h>
 #include <auth/auth_config.h>
 #include <auth/auth_srv.h>
@@ -52,13 +60,25 @@
 #include <auth/statistics.h>
 #include <auth/auth_log.h>
 #include <auth/datasrc_clients_mgr.h>
+#include <auth/xfrout_session.h>
+
+#include <server_common/client.h>
+
+#include <asio.hpp>
 
 #include <boost/bind.hpp>
+#include <boost/foreach.hpp>
+#include <boost/function.hpp>
 #include <boost/lexical_cast.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/optional.hpp>
 #include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <algorithm>
+#include <list>
 #include <cassert>
+#include <ctime>
 #include <iostream>
 #include <vector>
 #include <memory>
@@ -84,6 +104,8 @@ using namespace bundy::asiodns;
 using namespace bundy::server_common::portconfig;
 using bundy::auth::statistics::Counters;
 using bundy::auth::statistics::MessageAttributes;
+using bundy::acl::dns::RequestACL;
+using bundy::server_common::Client;
 
 namespace {
 // A helper class for cleaning up message renderer.
@@ -231,6 +253,28 @@ private:
 };
 }
 
+// The state used for processing DNS messages that can't be shared by
+// multiple threads.  The main thread has one, and each UDP worker thread
+// has its own.
+struct ProcessingContext : boost::noncopyable {
+    MessageRenderer renderer_;
+    auth::Query query_;
+
+    /// Query counters for statistics.  They are updated by the thread
+    /// owning the context, and read by the main thread, so they are
+    /// protected by counters_mutex_.
+    Counters counters_;
+    bundy::util::thread::Mutex counters_mutex_;
+
+    /// Response rate limiter; NULL if rate limiting is disabled.  The
+    /// limiter itself is shared by all contexts (see
+    /// AuthSrvImpl::rrl_mutex_); the pointer is only touched by the thread
+    /// owning the context.
+    boost::shared_ptr<bundy::auth::ResponseRateLimiter> rrl_;
+};
+
+class UDPWorker;
+
 class AuthSrvImpl {
 private:
     // prohibit copy
@@ -239,25 +283,99 @@ private:
 public:
     AuthSrvImpl(BaseSocketSessionForwarder& xfrout_forwarder,
                 BaseSocketSessionForwarder& ddns_forwarder);
+    ~AuthSrvImpl();
 
-    bool processNormalQuery(const IOMessage& io_message,
+    /// \brief Process a DNS message using the given context.
+    ///
+    /// This is the body of \c AuthSrv::processMessage(), which uses the
+    /// main context.  UDP worker threads call it with their own context.
+    void processMessage(ProcessingContext& ctx, const IOMessage& io_message,
+                        Message& message, OutputBuffer& buffer,
+                        DNSServer* server);
+
+    bool processNormalQuery(ProcessingContext& ctx,
+                            const IOMessage& io_message,
                             ConstEDNSPtr remote_edns, Message& message,
                             OutputBuffer& buffer,
                             unique_ptr<TSIGContext> tsig_context,
                             MessageAttributes& stats_attrs);
-    bool processXfrQuery(const IOMessage& io_message, Message& message,
-                         OutputBuffer& buffer,
+    bool processXfrQuery(ProcessingContext& ctx, const IOMessage& io_message,
+                         Message& message, OutputBuffer& buffer,
                          unique_ptr<TSIGContext> tsig_context,
                          MessageAttributes& stats_attrs);
-    bool processNotify(const IOMessage& io_message, Message& message,
-                       OutputBuffer& buffer,
+    bool processNotify(ProcessingContext& ctx, const IOMessage& io_message,
+                       Message& message, OutputBuffer& buffer,
+                       unique_ptr<TSIGContext> tsig_context,
+                       MessageAttributes& stats_attrs);
+    bool processUpdate(ProcessingContext& ctx, const IOMessage& io_message,
+                       Message& message, OutputBuffer& buffer,
                        unique_ptr<TSIGContext> tsig_context,
                        MessageAttributes& stats_attrs);
-    bool processUpdate(const IOMessage& io_message);
+
+    /// \brief Apply response rate limiting to a response to a normal query.
+    ///
+    /// It classifies the response in \c message (built but not rendered)
+    /// in terms of RRL, and checks it with the rate limiter.  If the
+    /// response should slip, the message is converted to a truncated one
+    /// in place.  Error responses are already minimal, so they are left
+    /// as they are.  \c stats_attrs is updated to record the result.
+    ///
+    /// This must be called only when \c ctx.rrl_ is non NULL.
+    ///
+    /// \return false if the response should be dropped; true otherwise.
+    bool applyRRL(ProcessingContext& ctx, const IOMessage& io_message,
+                  Message& message, MessageAttributes& stats_attrs);
+
+    /// \brief Check a response with the response rate limiter.
+    ///
+    /// This is the common part of \c applyRRL() and \c sendCachedResponse().
+    /// \c name is the name to be passed to the limiter for \c resp_type.
+    /// \c stats_attrs is updated to record the result.
+    bundy::auth::RRLResult checkRRL(ProcessingContext& ctx,
+                                    const IOMessage& io_message,
+                                    const Question& question,
+                                    bundy::auth::detail::ResponseType
+                                    resp_type,
+                                    const Name* name,
+                                    MessageAttributes& stats_attrs);
+
+    /// \brief Complete the response to a normal query found in the
+    /// response cache.
+    ///
+    /// \c buffer contains the cached response, and \c message is the
+    /// response built so far (with the question and EDNS only).  The RCODE
+    /// and AA flag of the cached response are copied to \c message for
+    /// statistics, and response rate limiting is applied.  A slipped
+    /// response is rendered from \c message.
+    ///
+    /// \return false if the response should be dropped; true otherwise.
+    bool sendCachedResponse(ProcessingContext& ctx,
+                            const IOMessage& io_message, Message& message,
+                            OutputBuffer& buffer, const Name* nxdomain_zone,
+                            MessageAttributes& stats_attrs);
+
+    /// \brief Remove cached responses for updated zone data, and abort
+    /// the transfers of the zone.
+    ///
+    /// This is called by the data source clients builder thread.
+    void dataUpdated(const RRClass& rrclass, const Name& origin);
+
+    /// \brief Call \c callback with the data source clients locked.
+    ///
+    /// This is the data locker of the zone transfers.
+    void withDataLocked(const boost::function<void ()>& callback);
+
+    /// \brief Remove a finished zone transfer.
+    void xfroutFinished(XfroutSession* session);
+
+    /// \brief Stop and remove all UDP workers.
+    ///
+    /// Their statistics counters are merged into the main context so
+    /// they won't be lost.
+    void stopUDPWorkers();
 
     IOService io_service_;
 
-    MessageRenderer renderer_;
     /// Currently non-configurable, but will be.
     static const uint16_t DEFAULT_LOCAL_UDPSIZE = 4096;
 
@@ -265,8 +383,19 @@ public:
     ModuleCCSession* config_session_;
     AbstractSession* xfrin_session_;
 
-    /// Query counters for statistics
-    Counters counters_;
+    /// The processing context of the main thread
+    ProcessingContext main_context_;
+
+    /// Serializes the use of the response rate limiter shared by all
+    /// contexts
+    bundy::util::thread::Mutex rrl_mutex_;
+
+    /// Serializes the use of the xfrin session and the DDNS forwarder,
+    /// which can be used by UDP workers.
+    bundy::util::thread::Mutex control_mutex_;
+
+    /// Threads processing UDP queries; empty unless configured
+    std::vector<boost::shared_ptr<UDPWorker> > udp_workers_;
 
     /// Addresses we listen on
     AddressList listen_addresses_;
@@ -274,11 +403,30 @@ public:
     /// The TSIG keyring
     const boost::shared_ptr<TSIGKeyRing>* keyring_;
 
+    /// The response cache; NULL if it's disabled.  It can be replaced by
+    /// the main thread and used by UDP workers and the data source
+    /// clients builder, so it's accessed with boost::atomic_load and
+    /// boost::atomic_store.  It must be declared before
+    /// datasrc_clients_mgr_, which refers to it until it's destroyed.
+    boost::shared_ptr<bundy::auth::ResponseCache> response_cache_;
+
     /// The data source client list manager
     auth::DataSrcClientsMgr datasrc_clients_mgr_;
 
     boost::scoped_ptr<SocketSessionForwarderHolder> xfrout_forwarder_;
 
+    /// The ACL of zone transfers served by ourselves; NULL if they are
+    /// forwarded to bundy-xfrout.
+    boost::shared_ptr<const RequestACL> xfrout_acl_;
+
+    /// The maximum number of zone transfers served at a time; 0 for no limit
+    size_t max_transfers_out_;
+
+    /// The zone transfers being served.  It's modified by the main thread
+    /// with the data source clients locked, so the builder thread can
+    /// invalidate them with the clients locked exclusively.
+    std::list<boost::shared_ptr<XfroutSession> > xfrout_sessions_;
+
     /// Socket session forwarder for dynamic update requests
     BaseSocketSessionForwarder& ddns_base_forwarder_;
 
@@ -294,36 +442,39 @@ public:
     ///
     /// This method is expected to be called by processMessage()
     ///
+    /// \param ctx The processing context used for the message
     /// \param server The DNSServer as passed to processMessage()
     /// \param message The response as constructed by processMessage()
     /// \param stats_attrs Object to store message attributes in for use
     ///                    with statistics
     /// \param done If true, it indicates there is a response.
     ///             this value will be passed to server->resume(bool)
-    void resumeServer(bundy::asiodns::DNSServer* server,
+    void resumeServer(ProcessingContext& ctx,
+                      bundy::asiodns::DNSServer* server,
                       bundy::dns::Message& message,
                       MessageAttributes& stats_attrs,
                       const bool done);
 
     /// Are we currently subscribed to the SegmentReader group?
     bool readers_group_subscribed_;
-private:
-    auth::Query query_;
 };
 
 AuthSrvImpl::AuthSrvImpl(BaseSocketSessionForwarder& xfrout_forwarder,
                          BaseSocketSessionForwarder& ddns_forwarder) :
     config_session_(NULL),
     xfrin_session_(NULL),
-    counters_(),
     keyring_(NULL),
     datasrc_clients_mgr_(io_service_),
     xfrout_forwarder_(new SocketSessionForwarderHolder("xfrout",
                                                        xfrout_forwarder)),
+    max_transfers_out_(0),
     ddns_base_forwarder_(ddns_forwarder),
     ddns_forwarder_(NULL),
     readers_group_subscribed_(false)
-{}
+{
+    datasrc_clients_mgr_.setDataUpdatedCallback(
+        boost::bind(&AuthSrvImpl::dataUpdated, this, _1, _2));
+}
 
 // This is a derived class of \c DNSLookup, to serve as a
 // callback in the asiolink module.  It calls
@@ -364,6 +515,112 @@ public:
     {}
 };
 
+// A variant of MessageLookup for UDP worker threads.  It processes the
+// message with the worker's own processing context.
+class ContextMessageLookup : public DNSLookup {
+public:
+    ContextMessageLookup(AuthSrvImpl& impl, ProcessingContext& ctx) :
+        impl_(impl), ctx_(ctx)
+    {}
+    virtual void operator()(const IOMessage& io_message,
+                            MessagePtr message,
+                            MessagePtr, // Not used here
+                            OutputBufferPtr buffer,
+                            DNSServer* server) const
+    {
+        MessageHolder message_holder(*message);
+        impl_.processMessage(ctx_, io_message, *message, *buffer, server);
+    }
+private:
+    AuthSrvImpl& impl_;
+    ProcessingContext& ctx_;
+};
+
+// A thread processing UDP queries with its own IOService and processing
+// context.  The thread is started on construction and runs until stop()
+// is called (or the object is destroyed).  Servers are attached to the
+// IOService via DNSServiceBase::addUDPWorker().
+class UDPWorker : boost::noncopyable {
+public:
+    UDPWorker(AuthSrvImpl& impl,
+              const boost::shared_ptr<ResponseRateLimiter>& rrl) :
+        lookup_(impl, context_),
+        work_(new asio::io_service::work(io_service_.get_io_service()))
+    {
+        context_.rrl_ = rrl;
+        thread_.reset(new bundy::util::thread::Thread(
+                          boost::bind(&UDPWorker::run, this)));
+    }
+
+    ~UDPWorker() {
+        stop();
+    }
+
+    // Stop the event loop and wait for the thread to terminate.  Servers
+    // that remain attached to the IOService are destroyed along with it.
+    void stop() {
+        if (thread_) {
+            io_service_.stop();
+            try {
+                thread_->wait();
+            } catch (const std::exception& ex) {
+                LOG_ERROR(auth_logger, AUTH_UDP_WORKER_ERROR).arg(ex.what());
+            }
+            thread_.reset();
+        }
+    }
+
+    // Replace the rate limiter.  Must be called in the worker thread.
+    void setRRL(const boost::shared_ptr<ResponseRateLimiter>& rrl) {
+        context_.rrl_ = rrl;
+    }
+
+    IOService& getIOService() { return (io_service_); }
+    DNSLookup* getDNSLookup() { return (&lookup_); }
+    ProcessingContext& getContext() { return (context_); }
+
+private:
+    void run() {
+        // Like the main thread, an exception from a handler would stop
+        // the event loop.  We log it and keep the worker running rather
+        // than silently losing a share of the UDP queries.
+        while (true) {
+            try {
+                io_service_.run();
+                return;
+            } catch (const std::exception& ex) {
+                LOG_ERROR(auth_logger, AUTH_UDP_WORKER_ERROR).arg(ex.what());
+            }
+        }
+    }
+
+    IOService io_service_;
+    ProcessingContext context_;
+    ContextMessageLookup lookup_;
+    boost::scoped_ptr<asio::io_service::work> work_;
+    boost::scoped_ptr<bundy::util::thread::Thread> thread_;
+};
+
+AuthSrvImpl::~AuthSrvImpl() {
+    // Make sure the workers won't refer to us any more.
+    udp_workers_.clear();
+    // Nor the data source clients builder to the zone transfers.
+    DataSrcClientsMgr::Holder holder(datasrc_clients_mgr_);
+    xfrout_sessions_.clear();
+}
+
+void
+AuthSrvImpl::stopUDPWorkers() {
+    BOOST_FOREACH(const boost::shared_ptr<UDPWorker>& worker, udp_workers_) {
+        worker->stop();
+        ProcessingContext& ctx = worker->getContext();
+        bundy::util::thread::Mutex::Locker locker(
+            main_context_.counters_mutex_);
+        main_context_.counters_.add(ctx.counters_);
+    }
+    udp_workers_.clear();
+}
+
 AuthSrv::AuthSrv(bundy::util::io::BaseSocketSessionForwarder& xfrout_forwarder,
                  bundy::util::io::BaseSocketSessionForwarder& ddns_forwarder) :
     dnss_(NULL)
@@ -437,6 +694,20 @@ makeErrorMessage(MessageRenderer& renderer, Message& message,
     LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_ERROR_RESPONSE)
               .arg(renderer.getLength()).arg(message);
 }
+
+// Return the name of the zone of an NXDOMAIN response, i.e., the owner name
+// of the SOA in the authority section, or NULL if it's not found.
+const Name*
+getNXDOMAINZone(const Message& message) {
+    for (RRsetIterator it = message.beginSection(Message::SECTION_AUTHORITY);
+         it != message.endSection(Message::SECTION_AUTHORITY);
+         ++it) {
+        if ((*it)->getType() == RRType::SOA()) {
+            return (&(*it)->getName());
+        }
+    }
+    return (NULL);
+}
 }
 
 IOService&
@@ -467,6 +738,15 @@ AuthSrv::getConfigSession() const {
 void
 AuthSrv::processMessage(const IOMessage& io_message, Message& message,
                         OutputBuffer& buffer, DNSServer* server)
+{
+    impl_->processMessage(impl_->main_context_, io_message, message, buffer,
+                          server);
+}
+
+void
+AuthSrvImpl::processMessage(ProcessingContext& ctx,
+                            const IOMessage& io_message, Message& message,
+                            OutputBuffer& buffer, DNSServer* server)
 {
     InputBuffer request_buffer(io_message.getData(), io_message.getDataSize());
     MessageAttributes stats_attrs;
@@ -484,13 +764,13 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
         // Ignore all responses.
         if (message.getHeaderFlag(Message::HEADERFLAG_QR)) {
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_RECEIVED);
-            impl_->resumeServer(server, message, stats_attrs, false);
+            resumeServer(ctx, server, message, stats_attrs, false);
             return;
         }
     } catch (const bundy::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_HEADER_PARSE_FAIL)
                   .arg(ex.what());
-        impl_->resumeServer(server, message, stats_attrs, false);
+        resumeServer(ctx, server, message, stats_attrs, false);
         return;
     }
 
@@ -507,16 +787,16 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
     } catch (const DNSProtocolError& error) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PROTOCOL_FAILURE)
                   .arg(error.getRcode().toText()).arg(error.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, error.getRcode(),
+        makeErrorMessage(ctx.renderer_, message, buffer, error.getRcode(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(ctx, server, message, stats_attrs, true);
         return;
     } catch (const bundy::Exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_PACKET_PARSE_FAILED)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(ctx, server, message, stats_attrs, true);
         return;
     } // other exceptions will be handled at a higher layer.
 
@@ -532,20 +812,24 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
     // Do we do TSIG?
     // The keyring can be null if we're in test
-    if (impl_->keyring_ != NULL && tsig_record != NULL) {
+    if (keyring_ != NULL && tsig_record != NULL) {
+        // The keyring can be replaced by the main thread while UDP workers
+        // are running, so we take a snapshot of it atomically.
+        const boost::shared_ptr<TSIGKeyRing> keyring =
+            boost::atomic_load(keyring_);
         tsig_context.reset(new TSIGContext(tsig_record->getName(),
                                            tsig_record->getRdata().
                                                 getAlgorithm(),
-                                           **impl_->keyring_));
+                                           *keyring));
         tsig_error = tsig_context->verify(tsig_record, io_message.getData(),
                                           io_message.getDataSize());
         stats_attrs.setRequestTSIG(true, tsig_error != TSIGError::NOERROR());
     }
 
     if (tsig_error != TSIGError::NOERROR()) {
-        makeErrorMessage(impl_->renderer_, message, buffer,
+        makeErrorMessage(ctx.renderer_, message, buffer,
                          tsig_error.toRcode(), stats_attrs, move(tsig_context));
-        impl_->resumeServer(server, message, stats_attrs, true);
+        resumeServer(ctx, server, message, stats_attrs, true);
         return;
     }
 
@@ -560,57 +844,54 @@ AuthSrv::processMessage(const IOMessage& io_message, Message& message,
 
         // note: This can only be reliable after TSIG check succeeds.
         if (opcode == Opcode::NOTIFY()) {
-            send_answer = impl_->processNotify(io_message, message, buffer,
-                                               move(tsig_context), stats_attrs);
+            send_answer = processNotify(ctx, io_message, message, buffer,
+                                        move(tsig_context), stats_attrs);
         } else if (opcode == Opcode::UPDATE()) {
-            if (impl_->ddns_forwarder_) {
-                send_answer = impl_->processUpdate(io_message);
-            } else {
-                makeErrorMessage(impl_->renderer_, message, buffer,
-                                 Rcode::NOTIMP(), stats_attrs, move(tsig_context));
-            }
+            send_answer = processUpdate(ctx, io_message, message, buffer,
+                                        move(tsig_context), stats_attrs);
         } else if (opcode != Opcode::QUERY()) {
             const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
             LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_UNSUPPORTED_OPCODE)
                 .arg(message.getOpcode().toText()).arg(remote_ep);
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(ctx.renderer_, message, buffer,
                              Rcode::NOTIMP(), stats_attrs, move(tsig_context));
         } else if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
-            makeErrorMessage(impl_->renderer_, message, buffer,
+            makeErrorMessage(ctx.renderer_, message, buffer,
                              Rcode::FORMERR(), stats_attrs, move(tsig_context));
         } else {
             ConstQuestionPtr question = *message.beginQuestion();
             const RRType& qtype = question->getType();
             if (qtype == RRType::AXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, move(tsig_context),
-                                                     stats_attrs);
+                send_answer = processXfrQuery(ctx, io_message, message,
+                                              buffer, move(tsig_context),
+                                              stats_attrs);
             } else if (qtype == RRType::IXFR()) {
-                send_answer = impl_->processXfrQuery(io_message, message,
-                                                     buffer, move(tsig_context),
-                                                     stats_attrs);
+                send_answer = processXfrQuery(ctx, io_message, message,
+                                              buffer, move(tsig_context),
+                                              stats_attrs);
             } else {
-                send_answer = impl_->processNormalQuery(io_message, edns,
-                                                        message, buffer,
-                                                        move(tsig_context),
-                                                        stats_attrs);
+                send_answer = processNormalQuery(ctx, io_message, edns,
+                                                 message, buffer,
+                                                 move(tsig_context),
+                                                 stats_attrs);
             }
         }
     } catch (const std::exception& ex) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE)
                   .arg(ex.what());
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     } catch (...) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RESPONSE_FAILURE_UNKNOWN);
-        makeErrorMessage(impl_->renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
     }
-    impl_->resumeServer(server, message, stats_attrs, send_answer);
+    resumeServer(ctx, server, message, stats_attrs, send_answer);
 }
 
 bool
-AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
+AuthSrvImpl::processNormalQuery(ProcessingContext& ctx,
+                                const IOMessage& io_message,
                                 ConstEDNSPtr remote_edns, Message& message,
                                 OutputBuffer& buffer,
                                 unique_ptr<TSIGContext> tsig_context,
@@ -631,6 +912,36 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
         message.setEDNS(local_edns);
     }
 
+    const bool udp_buffer =
+        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
+    const size_t length_limit = udp_buffer ? remote_bufsize : 65535;
+
+    // Try the response cache first.  TSIG signed responses are specific to
+    // each query, so they are neither taken from nor stored in the cache.
+    boost::shared_ptr<ResponseCache> response_cache;
+    if (!tsig_context) {
+        response_cache = boost::atomic_load(&response_cache_);
+    }
+    boost::optional<ResponseCacheKey> cache_key;
+    if (response_cache) {
+        const ConstQuestionPtr question = *message.beginQuestion();
+        cache_key = ResponseCacheKey(question->getName(), question->getType(),
+                                     question->getClass(),
+                                     remote_edns.get() != NULL, dnssec_ok,
+                                     length_limit);
+        const uint16_t query_flags =
+            (message.getHeaderFlag(Message::HEADERFLAG_RD) ?
+             Message::HEADERFLAG_RD : 0) |
+            (message.getHeaderFlag(Message::HEADERFLAG_CD) ?
+             Message::HEADERFLAG_CD : 0);
+        boost::shared_ptr<const Name> nxdomain_zone;
+        if (response_cache->find(*cache_key, length_limit, message.getQid(),
+                                 query_flags, buffer, &nxdomain_zone)) {
+            return (sendCachedResponse(ctx, io_message, message, buffer,
+                                       nxdomain_zone.get(), stats_attrs));
+        }
+    }
+
     // Get access to data source client list through the holder and keep
     // the holder until the processing and rendering is done to avoid
     // race with any other thread(s) such as the background loader.
@@ -643,28 +954,50 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
         if (list) {
             const RRType& qtype = question->getType();
             const Name& qname = question->getName();
-            query_.process(*list, qname, qtype, message, dnssec_ok);
+            ctx.query_.process(*list, qname, qtype, message, dnssec_ok);
         } else {
-            makeErrorMessage(renderer_, message, buffer, Rcode::REFUSED(),
+            message.setRcode(Rcode::REFUSED());
+            if (ctx.rrl_ && !applyRRL(ctx, io_message, message, stats_attrs)) {
+                return (false);
+            }
+            makeErrorMessage(ctx.renderer_, message, buffer, Rcode::REFUSED(),
                              stats_attrs);
             return (true);
         }
     } catch (const bundy::Exception& ex) {
         LOG_ERROR(auth_logger, AUTH_PROCESS_FAIL).arg(ex.what());
-        makeErrorMessage(renderer_, message, buffer, Rcode::SERVFAIL(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::SERVFAIL(),
                          stats_attrs);
         return (true);
     }
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    const bool udp_buffer =
-        (io_message.getSocket().getProtocol() == IPPROTO_UDP);
-    renderer_.setLengthLimit(udp_buffer ? remote_bufsize : 65535);
-    message.toWire(renderer_, tsig_context.get());
+    // Check rate limiting before rendering, so we can skip the rendering
+    // cost for responses that won't be sent.
+    if (ctx.rrl_ && !applyRRL(ctx, io_message, message, stats_attrs)) {
+        return (false);
+    }
+
+    RendererHolder holder(ctx.renderer_, &buffer, stats_attrs);
+    ctx.renderer_.setLengthLimit(length_limit);
+    message.toWire(ctx.renderer_, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
 
+    // Store the response in the cache while the data sources are still
+    // locked, so it can't be older than the data when it's invalidated.
+    // Truncated or slipped responses depend on the query, and other
+    // RCODEs indicate errors, so they aren't cached.
+    const Rcode& rcode = message.getRcode();
+    if (cache_key && !ctx.renderer_.isTruncated() &&
+        !stats_attrs.responseIsRRLSlipped() &&
+        (rcode == Rcode::NOERROR() || rcode == Rcode::NXDOMAIN())) {
+        response_cache->insert(*cache_key, buffer.getData(),
+                               buffer.getLength(),
+                               rcode == Rcode::NXDOMAIN() ?
+                               getNXDOMAINZone(message) : NULL);
+    }
+
     LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_NORMAL_RESPONSE)
-              .arg(renderer_.getLength()).arg(message);
+              .arg(ctx.renderer_.getLength()).arg(message);
     return (true);
     // The message can contain some data from the locked resource. But outside
     // this method, we touch only the RCode of it, so it should be safe.
@@ -674,24 +1007,262 @@ AuthSrvImpl::processNormalQuery(const IOMessage& io_message,
 }
 
 bool
-AuthSrvImpl::processXfrQuery(const IOMessage& io_message, Message& message,
+AuthSrvImpl::applyRRL(ProcessingContext& ctx, const IOMessage& io_message,
+                      Message& message, MessageAttributes& stats_attrs)
+{
+    using bundy::auth::detail::ResponseType;
+
+    const ConstQuestionPtr question = *message.beginQuestion();
+    const Rcode& rcode = message.getRcode();
+
+    // Normal answers are limited per query name and type, NXDOMAIN per zone
+    // (so random subdomain queries are aggregated), and errors per client.
+    ResponseType resp_type = bundy::auth::detail::RESPONSE_ERROR;
+    const Name* name = NULL;
+    if (rcode == Rcode::NOERROR()) {
+        resp_type = bundy::auth::detail::RESPONSE_QUERY;
+        name = &question->getName();
+    } else if (rcode == Rcode::NXDOMAIN()) {
+        resp_type = bundy::auth::detail::RESPONSE_NXDOMAIN;
+        name = getNXDOMAINZone(message);
+        if (name == NULL) {
+            name = &question->getName();
+        }
+    }
+
+    switch (checkRRL(ctx, io_message, *question, resp_type, name,
+                     stats_attrs)) {
+    case bundy::auth::RRL_OK:
+        break;
+    case bundy::auth::RRL_DROP:
+        return (false);
+    case bundy::auth::RRL_SLIP:
+        if (resp_type != bundy::auth::detail::RESPONSE_ERROR) {
+            message.clearSection(Message::SECTION_ANSWER);
+            message.clearSection(Message::SECTION_AUTHORITY);
+            message.clearSection(Message::SECTION_ADDITIONAL);
+            message.setHeaderFlag(Message::HEADERFLAG_TC);
+        }
+        break;
+    }
+    return (true);
+}
+
+bundy::auth::RRLResult
+AuthSrvImpl::checkRRL(ProcessingContext& ctx, const IOMessage& io_message,
+                      const Question& question,
+                      bundy::auth::detail::ResponseType resp_type,
+                      const Name* name, MessageAttributes& stats_attrs)
+{
+    const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
+    const bool is_tcp =
+        (io_message.getSocket().getProtocol() == IPPROTO_TCP);
+    bundy::auth::RRLResult result;
+    {
+        // The limiter is shared by all processing contexts.
+        bundy::util::thread::Mutex::Locker locker(rrl_mutex_);
+        if (name != NULL) {
+            const LabelSequence labels(*name);
+            result = ctx.rrl_->check(remote_ep, is_tcp, question.getClass(),
+                                     question.getType(), &labels, resp_type,
+                                     std::time(NULL));
+        } else {
+            result = ctx.rrl_->check(remote_ep, is_tcp, question.getClass(),
+                                     question.getType(), NULL, resp_type,
+                                     std::time(NULL));
+        }
+    }
+
+    switch (result) {
+    case bundy::auth::RRL_OK:
+        break;
+    case bundy::auth::RRL_DROP:
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_DROP)
+            .arg(question.getName()).arg(question.getType())
+            .arg(remote_ep);
+        stats_attrs.setResponseRRLDropped(true);
+        break;
+    case bundy::auth::RRL_SLIP:
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RRL_SLIP)
+            .arg(question.getName()).arg(question.getType())
+            .arg(remote_ep);
+        stats_attrs.setResponseRRLSlipped(true);
+        break;
+    }
+    return (result);
+}
+
+bool
+AuthSrvImpl::sendCachedResponse(ProcessingContext& ctx,
+                                const IOMessage& io_message, Message& message,
+                                OutputBuffer& buffer,
+                                const Name* nxdomain_zone,
+                                MessageAttributes& stats_attrs)
+{
+    // Copy the header fields referred to for statistics.  Only NOERROR and
+    // NXDOMAIN responses are cached, so the RCODE fits in the header.
+    const uint8_t* const data = static_cast<const uint8_t*>(buffer.getData());
+    const Rcode rcode(data[3] & 0x0f);
+    message.setRcode(rcode);
+    message.setHeaderFlag(Message::HEADERFLAG_AA, (data[2] & 0x04) != 0);
+    stats_attrs.setResponseCached(true, data[6] != 0 || data[7] != 0);
+
+    const ConstQuestionPtr question = *message.beginQuestion();
+    if (ctx.rrl_) {
+        using bundy::auth::detail::ResponseType;
+
+        ResponseType resp_type = bundy::auth::detail::RESPONSE_QUERY;
+        const Name* name = &question->getName();
+        if (rcode == Rcode::NXDOMAIN()) {
+            resp_type = bundy::auth::detail::RESPONSE_NXDOMAIN;
+            if (nxdomain_zone != NULL) {
+                name = nxdomain_zone;
+            }
+        }
+        switch (checkRRL(ctx, io_message, *question, resp_type, name,
+                         stats_attrs)) {
+        case bundy::auth::RRL_OK:
+            break;
+        case bundy::auth::RRL_DROP:
+            buffer.clear();
+            return (false);
+        case bundy::auth::RRL_SLIP: {
+            // Render the empty truncated response as applyRRL() makes it.
+            buffer.clear();
+            stats_attrs.setResponseCached(false, false);
+            message.setHeaderFlag(Message::HEADERFLAG_TC);
+            RendererHolder holder(ctx.renderer_, &buffer, stats_attrs);
+            message.toWire(ctx.renderer_);
+            return (true);
+        }
+        }
+    }
+
+    LOG_DEBUG(auth_logger, DBG_AUTH_MESSAGES, AUTH_SEND_CACHED_RESPONSE)
+        .arg(buffer.getLength()).arg(question->getName())
+        .arg(question->getType()).arg(rcode);
+    return (true);
+}
+
+void
+AuthSrvImpl::dataUpdated(const RRClass& rrclass, const Name& origin) {
+    const boost::shared_ptr<ResponseCache> response_cache =
+        boost::atomic_load(&response_cache_);
+    if (response_cache) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_RESPONSE_CACHE_INVALIDATE)
+            .arg(origin).arg(rrclass);
+        response_cache->invalidate(rrclass, origin);
+    }
+    BOOST_FOREACH(const boost::shared_ptr<XfroutSession>& session,
+                  xfrout_sessions_) {
+        if (session->getZoneClass() == rrclass &&
+            (origin == Name::ROOT_NAME() ||
+             session->getZoneName() == origin)) {
+            session->invalidate();
+        }
+    }
+}
+
+void
+AuthSrvImpl::withDataLocked(const boost::function<void ()>& callback) {
+    DataSrcClientsMgr::Holder holder(datasrc_clients_mgr_);
+    callback();
+}
+
+void
+AuthSrvImpl::xfroutFinished(XfroutSession* session) {
+    DataSrcClientsMgr::Holder holder(datasrc_clients_mgr_);
+    for (std::list<boost::shared_ptr<XfroutSession> >::iterator it =
+             xfrout_sessions_.begin(); it != xfrout_sessions_.end(); ++it) {
+        if (it->get() == session) {
+            xfrout_sessions_.erase(it);
+            return;
+        }
+    }
+}
+
+bool
+AuthSrvImpl::processXfrQuery(ProcessingContext& ctx,
+                             const IOMessage& io_message, Message& message,
                              OutputBuffer& buffer,
                              unique_ptr<TSIGContext> tsig_context,
                              MessageAttributes& stats_attrs)
 {
     if (io_message.getSocket().getProtocol() == IPPROTO_UDP) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_AXFR_UDP);
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
 
-    xfrout_forwarder_->push(io_message);
+    if (!xfrout_acl_) {
+        xfrout_forwarder_->push(io_message);
+        return (false);
+    }
+
+    const ConstQuestionPtr question = *message.beginQuestion();
+    const IOEndpoint& remote_ep = io_message.getRemoteEndpoint();
+    const bundy::acl::BasicAction action(
+        xfrout_acl_->execute(acl::dns::RequestContext(
+                                 Client(io_message).getRequestSourceIPAddress(),
+                                 message.getTSIGRecord())));
+    if (action != bundy::acl::ACCEPT) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_XFROUT_REFUSED)
+            .arg(remote_ep).arg(question->getName())
+            .arg(question->getClass());
+        if (action == bundy::acl::DROP) {
+            return (false);
+        }
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::REFUSED(),
+                         stats_attrs, move(tsig_context));
+        return (true);
+    }
+    if (max_transfers_out_ > 0 &&
+        xfrout_sessions_.size() >= max_transfers_out_) {
+        LOG_WARN(auth_logger, AUTH_XFROUT_QUOTA_EXCEEDED)
+            .arg(remote_ep).arg(xfrout_sessions_.size());
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::REFUSED(),
+                         stats_attrs, move(tsig_context));
+        return (true);
+    }
+
+    boost::shared_ptr<XfroutSession> session;
+    Rcode rcode = Rcode::NOTAUTH();
+    {
+        DataSrcClientsMgr::Holder holder(datasrc_clients_mgr_);
+        const boost::shared_ptr<ConfigurableClientList> list =
+            holder.findClientList(question->getClass());
+        if (list) {
+            XfroutData data;
+            rcode = prepareXfroutData(*list, message, remote_ep, data);
+            if (rcode == Rcode::NOERROR()) {
+                session.reset(new XfroutSession(
+                                  io_service_,
+                                  io_message.getSocket().getNative(),
+                                  remote_ep, message, data,
+                                  move(tsig_context),
+                                  boost::bind(&AuthSrvImpl::withDataLocked,
+                                              this, _1),
+                                  boost::bind(&AuthSrvImpl::xfroutFinished,
+                                              this, _1)));
+                xfrout_sessions_.push_back(session);
+            }
+        }
+    }
+    if (!session) {
+        makeErrorMessage(ctx.renderer_, message, buffer, rcode, stats_attrs,
+                         move(tsig_context));
+        return (true);
+    }
+    // The session has its own copy of the socket, so the server closes
+    // the connection as usual.
+    session->start();
     return (false);
 }
 
 bool
-AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
+AuthSrvImpl::processNotify(ProcessingContext& ctx,
+                           const IOMessage& io_message, Message& message,
                            OutputBuffer& buffer,
                            std::unique_ptr<TSIGContext> tsig_context,
                            MessageAttributes& stats_attrs)
@@ -703,7 +1274,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (message.getRRCount(Message::SECTION_QUESTION) != 1) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_QUESTIONS)
                   .arg(message.getRRCount(Message::SECTION_QUESTION));
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
@@ -711,7 +1282,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (question->getType() != RRType::SOA()) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_NOTIFY_RRTYPE)
                   .arg(question->getType().toText());
-        makeErrorMessage(renderer_, message, buffer, Rcode::FORMERR(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::FORMERR(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
@@ -733,7 +1304,7 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     if (!is_auth) {
         LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_RECEIVED_NOTIFY_NOTAUTH)
             .arg(question->getName()).arg(question->getClass()).arg(remote_ep);
-        makeErrorMessage(renderer_, message, buffer, Rcode::NOTAUTH(),
+        makeErrorMessage(ctx.renderer_, message, buffer, Rcode::NOTAUTH(),
                          stats_attrs, move(tsig_context));
         return (true);
     }
@@ -755,6 +1326,8 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     static const string command_template_end = "\"}]}";
 
     try {
+        // The session may be shared with UDP worker threads.
+        bundy::util::thread::Mutex::Locker locker(control_mutex_);
         ConstElementPtr notify_command = Element::fromJSON(
                 command_template_start + question->getName().toText() +
                 command_template_master + remote_ip_address +
@@ -793,27 +1366,44 @@ AuthSrvImpl::processNotify(const IOMessage& io_message, Message& message,
     message.setHeaderFlag(Message::HEADERFLAG_AA);
     message.setRcode(Rcode::NOERROR());
 
-    RendererHolder holder(renderer_, &buffer, stats_attrs);
-    message.toWire(renderer_, tsig_context.get());
+    RendererHolder holder(ctx.renderer_, &buffer, stats_attrs);
+    message.toWire(ctx.renderer_, tsig_context.get());
     stats_attrs.setResponseTSIG(tsig_context.get() != NULL);
     return (true);
 }
 
 bool
-AuthSrvImpl::processUpdate(const IOMessage& io_message)
+AuthSrvImpl::processUpdate(ProcessingContext& ctx,
+                           const IOMessage& io_message, Message& message,
+                           OutputBuffer& buffer,
+                           unique_ptr<TSIGContext> tsig_context,
+                           MessageAttributes& stats_attrs)
 {
-    // Push the update request to a separate process via the forwarder.
-    // On successful push, the request shouldn't be responded from bundy-auth,
-    // so we return false.
-    ddns_forwarder_->push(io_message);
-    return (false);
+    {
+        // The forwarder can be created or destroyed by the main thread
+        // while UDP workers are running.
+        bundy::util::thread::Mutex::Locker locker(control_mutex_);
+        if (ddns_forwarder_) {
+            // Push the update request to a separate process via the
+            // forwarder.  On successful push, the request shouldn't be
+            // responded from bundy-auth, so we return false.
+            ddns_forwarder_->push(io_message);
+            return (false);
+        }
+    }
+    makeErrorMessage(ctx.renderer_, message, buffer, Rcode::NOTIMP(),
+                     stats_attrs, move(tsig_context));
+    return (true);
 }
 
 void
-AuthSrvImpl::resumeServer(DNSServer* server, Message& message,
-                          MessageAttributes& stats_attrs,
+AuthSrvImpl::resumeServer(ProcessingContext& ctx, DNSServer* server,
+                          Message& message, MessageAttributes& stats_attrs,
                           const bool done) {
-    counters_.inc(stats_attrs, message, done);
+    {
+        bundy::util::thread::Mutex::Locker locker(ctx.counters_mutex_);
+        ctx.counters_.inc(stats_attrs, message, done);
+    }
     server->resume(done);
 }
 
@@ -833,7 +1423,26 @@ AuthSrv::updateConfig(ConstElementPtr new_config) {
 }
 
 ConstElementPtr AuthSrv::getStatistics() const {
-    return (impl_->counters_.get());
+    if (impl_->udp_workers_.empty()) {
+        bundy::util::thread::Mutex::Locker locker(
+            impl_->main_context_.counters_mutex_);
+        return (impl_->main_context_.counters_.get());
+    }
+
+    // Sum up the counters of all threads.
+    Counters total;
+    {
+        bundy::util::thread::Mutex::Locker locker(
+            impl_->main_context_.counters_mutex_);
+        total.add(impl_->main_context_.counters_);
+    }
+    BOOST_FOREACH(const boost::shared_ptr<UDPWorker>& worker,
+                  impl_->udp_workers_) {
+        ProcessingContext& ctx = worker->getContext();
+        bundy::util::thread::Mutex::Locker locker(ctx.counters_mutex_);
+        total.add(ctx.counters_);
+    }
+    return (total.get());
 }
 
 const AddressList&
@@ -862,6 +1471,7 @@ AuthSrv::setTSIGKeyRing(const boost::shared_ptr<TSIGKeyRing>* keyring) {
 void
 AuthSrv::createDDNSForwarder() {
     LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_START_DDNS_FORWARDER);
+    bundy::util::thread::Mutex::Locker locker(impl_->control_mutex_);
     impl_->ddns_forwarder_.reset(
         new SocketSessionForwarderHolder("update",
                                          impl_->ddns_base_forwarder_));
@@ -869,12 +1479,98 @@ AuthSrv::createDDNSForwarder() {
 
 void
 AuthSrv::destroyDDNSForwarder() {
+    bundy::util::thread::Mutex::Locker locker(impl_->control_mutex_);
     if (impl_->ddns_forwarder_) {
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_STOP_DDNS_FORWARDER);
         impl_->ddns_forwarder_.reset();
     }
 }
 
+void
+AuthSrv::setRRL(const boost::shared_ptr<bundy::auth::ResponseRateLimiter>& rrl)
+{
+    impl_->main_context_.rrl_ = rrl;
+    // Workers replace their own copy in their thread.
+    BOOST_FOREACH(const boost::shared_ptr<UDPWorker>& worker,
+                  impl_->udp_workers_) {
+        worker->getIOService().post(boost::bind(&UDPWorker::setRRL,
+                                                worker.get(), rrl));
+    }
+}
+
+const boost::shared_ptr<bundy::auth::ResponseRateLimiter>&
+AuthSrv::getRRL() const {
+    return (impl_->main_context_.rrl_);
+}
+
+void
+AuthSrv::setResponseCache(
+    const boost::shared_ptr<bundy::auth::ResponseCache>& cache)
+{
+    boost::atomic_store(&impl_->response_cache_, cache);
+}
+
+boost::shared_ptr<bundy::auth::ResponseCache>
+AuthSrv::getResponseCache() const {
+    return (boost::atomic_load(&impl_->response_cache_));
+}
+
+void
+AuthSrv::setUDPWorkers(size_t workers) {
+    if (workers == impl_->udp_workers_.size()) {
+        return;
+    }
+    LOG_INFO(auth_logger, AUTH_UDP_WORKERS_SET).arg(workers);
+
+    // Detach the servers from the current workers first, then replace
+    // the workers.
+    dnss_->clearServers();
+    dnss_->clearUDPWorkers();
+    impl_->stopUDPWorkers();
+    for (size_t i = 0; i < workers; ++i) {
+        boost::shared_ptr<UDPWorker> worker(
+            new UDPWorker(*impl_, impl_->main_context_.rrl_));
+        impl_->udp_workers_.push_back(worker);
+        dnss_->addUDPWorker(worker->getIOService(), worker->getDNSLookup());
+    }
+
+    // Reopen the sockets so the servers are attached to the new workers.
+    if (!impl_->listen_addresses_.empty()) {
+        const AddressList addresses(impl_->listen_addresses_);
+        setListenAddresses(addresses);
+    }
+}
+
+size_t
+AuthSrv::getUDPWorkers() const {
+    return (impl_->udp_workers_.size());
+}
+
+void
+AuthSrv::setXfrout(const boost::shared_ptr<const RequestACL>& acl,
+                   size_t max_transfers)
+{
+    impl_->xfrout_acl_ = acl;
+    impl_->max_transfers_out_ = max_transfers;
+    LOG_INFO(auth_logger, AUTH_XFROUT_SET)
+        .arg(acl ? "enabled" : "disabled").arg(max_transfers);
+}
+
+const boost::shared_ptr<const RequestACL>&
+AuthSrv::getXfroutACL() const {
+    return (impl_->xfrout_acl_);
+}
+
+size_t
+AuthSrv::getMaxTransfersOut() const {
+    return (impl_->max_transfers_out_);
+}
+
+size_t
+AuthSrv::getTransfersOut() const {
+    return (impl_->xfrout_sessions_.size());
+}
+
 void
 AuthSrv::setTCPRecvTimeout(size_t timeout) {
     dnss_->setTCPRecvTimeout(timeout);
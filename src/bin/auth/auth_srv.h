@@ -15,6 +15,7 @@
 #ifndef AUTH_SRV_H
 #define AUTH_SRV_H 1
 
+#include <acl/dns.h>
 #include <config/ccsession.h>
 
 #include <datasrc/factory.h>
@@ -59,6 +60,10 @@ class AbstractXfroutClient;
 namespace dns {
 class TSIGKeyRing;
 }
+namespace auth {
+class ResponseRateLimiter;
+class ResponseCache;
+}
 }
 
 
@@ -270,6 +275,100 @@ public:
     /// open forever.
     void setTCPRecvTimeout(size_t timeout);
 
+    /// \brief Set the response rate limiter.
+    ///
+    /// If \c rrl is non NULL, responses to normal queries are subject to
+    /// rate limiting by it; if it's NULL, response rate limiting is disabled.
+    /// Any previously set limiter is replaced (and its state is discarded).
+    ///
+    /// \throw None
+    void setRRL(const boost::shared_ptr<bundy::auth::ResponseRateLimiter>&
+                rrl);
+
+    /// \brief Return the current response rate limiter.
+    ///
+    /// \throw None
+    /// \return The limiter set by \c setRRL(), or NULL if it's not set.
+    const boost::shared_ptr<bundy::auth::ResponseRateLimiter>& getRRL() const;
+
+    /// \brief Set the response cache.
+    ///
+    /// If \c cache is non NULL, rendered responses to normal queries are
+    /// stored in it, and later queries for the same data are answered
+    /// from it without looking up the data sources.  Responses for a zone
+    /// are removed from it when the data of the zone is updated.  If it's
+    /// NULL, response caching is disabled.  Any previously set cache is
+    /// replaced.
+    ///
+    /// \throw None
+    void setResponseCache(
+        const boost::shared_ptr<bundy::auth::ResponseCache>& cache);
+
+    /// \brief Return the current response cache.
+    ///
+    /// \throw None
+    /// \return The cache set by \c setResponseCache(), or NULL if it's not
+    /// set.
+    boost::shared_ptr<bundy::auth::ResponseCache> getResponseCache() const;
+
+    /// \brief Set the number of threads processing UDP queries.
+    ///
+    /// If \c workers is non 0, that number of threads are started, each
+    /// of which has its own event loop and processing state (such as the
+    /// message renderer and statistics counters), and UDP queries are
+    /// handled by them instead of the main thread.  They share each
+    /// listening UDP socket.  TCP queries and all other events are still
+    /// handled in the main thread.  If \c workers is 0, all UDP queries
+    /// are handled in the main thread (the default).
+    ///
+    /// The worker threads look up data sources concurrently, so they
+    /// should only be used with data sources that support it, i.e., the
+    /// in-memory data source.
+    ///
+    /// If the number is changed, the current workers are stopped and the
+    /// listening sockets are reopened so they'll be used by the new ones.
+    /// This method must be called after \c setDNSService().
+    ///
+    /// \param workers The number of UDP worker threads.
+    void setUDPWorkers(size_t workers);
+
+    /// \brief Return the number of threads processing UDP queries.
+    ///
+    /// \throw None
+    size_t getUDPWorkers() const;
+
+    /// \brief Configure the zone transfers served by bundy-auth itself.
+    ///
+    /// If \c acl is non NULL, AXFR and IXFR requests allowed by it are
+    /// served by bundy-auth (see \c bundy::auth::XfroutSession), and
+    /// requests it rejects get a REFUSED response (or none at all, for
+    /// DROP).  At most \c max_transfers transfers run at a time; further
+    /// requests are refused.  If \c max_transfers is 0, there's no limit.
+    /// If \c acl is NULL, the requests are passed on to bundy-xfrout (the
+    /// default).  Running transfers aren't affected.
+    ///
+    /// \throw None
+    void setXfrout(const boost::shared_ptr<const bundy::acl::dns::RequestACL>&
+                   acl, size_t max_transfers);
+
+    /// \brief Return the ACL of the zone transfers served by bundy-auth.
+    ///
+    /// \throw None
+    /// \return The ACL set by \c setXfrout(), or NULL if the transfers are
+    /// passed on to bundy-xfrout.
+    const boost::shared_ptr<const bundy::acl::dns::RequestACL>&
+    getXfroutACL() const;
+
+    /// \brief Return the maximum number of zone transfers served at a time.
+    ///
+    /// \throw None
+    size_t getMaxTransfersOut() const;
+
+    /// \brief Return the number of zone transfers being served.
+    ///
+    /// \throw None
+    size_t getTransfersOut() const;
+
     /// \brief Notify the authoritative server that the client lists were
     ///     reconfigured.
     ///
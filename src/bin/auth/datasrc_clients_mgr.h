@@ -105,6 +105,18 @@ typedef boost::function<void (data::ConstElementPtr arg)> FinishedCallback;
 /// \brief A pair of the callback functor and its argument.
 typedef std::pair<FinishedCallback, data::ConstElementPtr> FinishedCallbackPair;
 
+/// \brief Callback to be called when data of zones are updated.
+///
+/// It takes the class and the origin of the updated zone.  If more than
+/// one zone can be updated at once, e.g., on reconfiguration, the origin
+/// is the root name, meaning any zone of the class.
+///
+/// Unlike \c FinishedCallback, it's called in the builder thread, while
+/// the lock of the client lists is held.  So it must be quick and must
+/// not use the manager.
+typedef boost::function<void (const dns::RRClass& rrclass,
+                              const dns::Name& origin)> DataUpdatedCallback;
+
 /// \brief The data type passed from DataSrcClientsMgr to
 ///     DataSrcClientsBuilder.
 ///
@@ -158,7 +170,7 @@ struct Command {
 /// need one specific specialization that has a typedef of
 /// \c DataSrcClientsMgr.
 template <typename ThreadType, typename BuilderType, typename MutexType,
-          typename CondVarType>
+          typename CondVarType, typename MapMutexType = MutexType>
 class DataSrcClientsMgrBase : boost::noncopyable {
 private:
     typedef std::map<dns::RRClass,
@@ -249,7 +261,7 @@ public:
         }
     private:
         DataSrcClientsMgrBase& mgr_;
-        typename MutexType::Locker locker_;
+        typename MapMutexType::ReaderLocker locker_;
     };
 
     /// \brief Constructor.
@@ -269,7 +281,8 @@ public:
         fd_guard_(new FDGuard(this)),
         read_fd_(-1), write_fd_(-1),
         builder_(&command_queue_, &callback_queue_, &cond_, &queue_mutex_,
-                 &clients_map_, &map_mutex_, createFds()),
+                 &clients_map_, &map_mutex_, createFds(),
+                 &data_updated_callback_),
         builder_thread_(boost::bind(&BuilderType::run, &builder_)),
         wakeup_socket_(service, read_fd_)
     {
@@ -352,10 +365,23 @@ public:
     /// cleaner way to use faked data source clients.  Non test code or
     /// newer tests must not use this.
     void setDataSrcClientLists(datasrc::ClientListMapPtr new_lists) {
-        typename MutexType::Locker locker(map_mutex_);
+        typename MapMutexType::Locker locker(map_mutex_);
         clients_map_ = new_lists;
     }
 
+    /// \brief Set the callback to be called when data of zones are updated.
+    ///
+    /// See \c DataUpdatedCallback for when and how it's called.  An empty
+    /// callback disables the notification.
+    ///
+    /// \throw None
+    void setDataUpdatedCallback(
+        const datasrc_clientmgr_internal::DataUpdatedCallback& callback)
+    {
+        typename MapMutexType::Locker locker(map_mutex_);
+        data_updated_callback_ = callback;
+    }
+
     /// \brief Instruct internal thread to (re)load a zone
     ///
     /// \param args Element argument that should be a map of the form
@@ -567,7 +593,9 @@ private:
                                 // map of actual data source client objects
     boost::scoped_ptr<FDGuard> fd_guard_; // A guard to close the fds.
     int read_fd_, write_fd_;    // Descriptors for wakeup
-    MutexType map_mutex_;       // mutex to protect the clients map
+    MapMutexType map_mutex_;    // lock to protect the clients map
+    // Called by the builder on zone updates; protected by map_mutex_
+    datasrc_clientmgr_internal::DataUpdatedCallback data_updated_callback_;
 
     BuilderType builder_;
     ThreadType builder_thread_; // for safety this should be placed last
@@ -593,7 +621,8 @@ namespace datasrc_clientmgr_internal {
 ///
 /// This class is templated so that we can test it without involving actual
 /// threads or locks.
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType,
+          typename MapMutexType = MutexType>
 class DataSrcClientsBuilderBase : boost::noncopyable {
 private:
     typedef std::map<dns::RRClass,
@@ -621,13 +650,15 @@ public:
                               std::list<FinishedCallbackPair>* callback_queue,
                               CondVarType* cond, MutexType* queue_mutex,
                               datasrc::ClientListMapPtr* clients_map,
-                              MutexType* map_mutex,
-                              int wake_fd
+                              MapMutexType* map_mutex,
+                              int wake_fd,
+                              DataUpdatedCallback* data_updated_callback =
+                              NULL
         ) :
         command_queue_(command_queue), callback_queue_(callback_queue),
         cond_(cond), queue_mutex_(queue_mutex),
         clients_map_(clients_map), map_mutex_(map_mutex), wake_fd_(wake_fd),
-        gen_id_(-1)
+        data_updated_callback_(data_updated_callback), gen_id_(-1)
     {}
 
     /// \brief The main loop.
@@ -679,6 +710,24 @@ private:
                              isClientListWaiting) == clients_map.end());
     }
 
+    // Notify the user of the manager of updated zone data, if it wants to.
+    // This must be called with map_mutex_ held.
+    void notifyDataUpdated(const dns::RRClass& rrclass,
+                           const dns::Name& origin)
+    {
+        if (data_updated_callback_ != NULL && *data_updated_callback_) {
+            (*data_updated_callback_)(rrclass, origin);
+        }
+    }
+
+    // Same as above, for all zones of all classes in the given map.
+    void notifyDataUpdated(const ClientListsMap& clients_map) {
+        for (ClientListsMap::const_iterator it = clients_map.begin();
+             it != clients_map.end(); ++it) {
+            notifyDataUpdated(it->first, dns::Name::ROOT_NAME());
+        }
+    }
+
     // Swap pending clients map with the current when all waiting memory
     // segments are ready.
     void installClientsMap() {
@@ -686,8 +735,11 @@ private:
         // this way, after the swap, the lock is guaranteed to be released
         // before the old data is destroyed, minimizing the lock duration.
         {
-            typename MutexType::Locker locker(*map_mutex_);
+            typename MapMutexType::Locker locker(*map_mutex_);
             pending_map_->clients_map_.swap(*clients_map_);
+            // Both the classes that are gone and new ones are updated.
+            notifyDataUpdated(*pending_map_->clients_map_);
+            notifyDataUpdated(**clients_map_);
         } // lock is released by leaving scope
           // old clients_map_ data is released by leaving scope
 
@@ -807,7 +859,7 @@ private:
             }
         }
 
-        typename MutexType::Locker locker(*map_mutex_);
+        typename MapMutexType::Locker locker(*map_mutex_);
         if (!list->resetMemorySegment(
                 dsrc_name, bundy::datasrc::memory::ZoneTableSegment::READ_ONLY,
                 segment_params)) {
@@ -816,6 +868,9 @@ private:
                 .arg(rrclass).arg(dsrc_name);
             std::terminate();
         }
+        if (&clients_map == clients_map_->get()) {
+            notifyDataUpdated(rrclass, dns::Name::ROOT_NAME());
+        }
     }
 
     void doSegmentUpdate(const bundy::data::ConstElementPtr& arg) {
@@ -887,8 +942,9 @@ private:
     CondVarType* cond_;
     MutexType* queue_mutex_;
     datasrc::ClientListMapPtr* clients_map_;
-    MutexType* map_mutex_;
+    MapMutexType* map_mutex_;
     int wake_fd_;
+    DataUpdatedCallback* data_updated_callback_;
 
     // These are local to the builder thread:
     // Placeholder for pending new generation of data source clients.  Defined
@@ -913,12 +969,13 @@ private:
 };
 
 // Shortcut typedef for normal use
-typedef DataSrcClientsBuilderBase<util::thread::Mutex, util::thread::CondVar>
+typedef DataSrcClientsBuilderBase<util::thread::Mutex, util::thread::CondVar,
+                                  util::thread::RWMutex>
 DataSrcClientsBuilder;
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 void
-DataSrcClientsBuilderBase<MutexType, CondVarType>::run() {
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::run() {
     LOG_INFO(auth_logger, AUTH_DATASRC_CLIENTS_BUILDER_STARTED);
 
     try {
@@ -985,9 +1042,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::run() {
     }
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 bool
-DataSrcClientsBuilderBase<MutexType, CondVarType>::handleCommand(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::handleCommand(
     const Command& command)
 {
     const CommandID cid = command.id;
@@ -1036,9 +1093,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::handleCommand(
     return (keep_running);
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 void
-DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::doUpdateZone(
     datasrc_clientmgr_internal::CommandID command,
     const bundy::data::ConstElementPtr& arg)
 {
@@ -1085,8 +1142,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
 
         zwriter->load(); // this can take time but doesn't cause a race
         {   // install() can cause a race and must be in a critical section
-            typename MutexType::Locker locker(*map_mutex_);
+            typename MapMutexType::Locker locker(*map_mutex_);
             zwriter->install();
+            notifyDataUpdated(rrclass, origin);
         }
         LOG_DEBUG(auth_logger, DBG_AUTH_OPS,
                   AUTH_DATASRC_CLIENTS_BUILDER_LOAD_ZONE)
@@ -1109,9 +1167,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doUpdateZone(
 
 // A dedicated subroutine of doUpdateZone().  Separated just for keeping the
 // main method concise.
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 boost::shared_ptr<datasrc::memory::ZoneWriter>
-DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::getZoneWriter(
     datasrc_clientmgr_internal::CommandID command,
     datasrc::ConfigurableClientList& client_list,
     const std::string& datasrc_name, const dns::RRClass& rrclass,
@@ -1122,9 +1180,15 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     // source for lookup.  So we need to protect the access here.
     datasrc::ConfigurableClientList::ZoneWriterPair writerpair;
     {
-        typename MutexType::Locker locker(*map_mutex_);
+        typename MapMutexType::Locker locker(*map_mutex_);
         writerpair = client_list.getCachedZoneWriter(origin, false,
                                                      datasrc_name);
+        // A zone that is not cached is served directly from the data
+        // source, which may have been updated by someone else.
+        if (writerpair.first ==
+            datasrc::ConfigurableClientList::ZONE_NOT_CACHED) {
+            notifyDataUpdated(rrclass, origin);
+        }
     }
 
     switch (writerpair.first) {
@@ -1163,9 +1227,9 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::getZoneWriter(
     return (boost::shared_ptr<datasrc::memory::ZoneWriter>());
 }
 
-template <typename MutexType, typename CondVarType>
+template <typename MutexType, typename CondVarType, typename MapMutexType>
 FinishedCallback
-DataSrcClientsBuilderBase<MutexType, CondVarType>::doReleaseSegments(
+DataSrcClientsBuilderBase<MutexType, CondVarType, MapMutexType>::doReleaseSegments(
     const Command& command)
 {
     try {
@@ -1206,7 +1270,8 @@ DataSrcClientsBuilderBase<MutexType, CondVarType>::doReleaseSegments(
 typedef DataSrcClientsMgrBase<
     util::thread::Thread,
     datasrc_clientmgr_internal::DataSrcClientsBuilder,
-    util::thread::Mutex, util::thread::CondVar> DataSrcClientsMgr;
+    util::thread::Mutex, util::thread::CondVar,
+    util::thread::RWMutex> DataSrcClientsMgr;
 } // namespace auth
 } // namespace bundy
 
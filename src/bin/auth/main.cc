@@ -38,6 +38,7 @@
 #include <asiodns/asiodns.h>
 #include <asiolink/asiolink.h>
 #include <log/logger_support.h>
+#include <log/logger_manager.h>
 #include <server_common/keyring.h>
 #include <server_common/socket_request.h>
 
@@ -123,8 +124,9 @@ datasrcConfigHandler(AuthSrv* server, bool* first_time,
 
 void
 usage() {
-    cerr << "Usage:  bundy-auth [-v]"
+    cerr << "Usage:  bundy-auth [-a] [-v]"
          << endl;
+    cerr << "\t-a: asynchronous logging" << endl;
     cerr << "\t-v: verbose logging (debug-level)" << endl;
     exit(1);
 }
@@ -135,9 +137,13 @@ int
 main(int argc, char* argv[]) {
     int ch;
     bool verbose = false;
+    bool async_logging = false;
 
-    while ((ch = getopt(argc, argv, ":nu:v")) != -1) {
+    while ((ch = getopt(argc, argv, ":anu:v")) != -1) {
         switch (ch) {
+        case 'a':
+            async_logging = true;
+            break;
         case 'v':
             verbose = true;
             break;
@@ -155,6 +161,9 @@ main(int argc, char* argv[]) {
     bundy::log::initLogger(AUTH_NAME,
                          (verbose ? bundy::log::DEBUG : bundy::log::INFO),
                          bundy::log::MAX_DEBUG_LEVEL, NULL, true);
+    if (async_logging) {
+        bundy::log::LoggerManager::setAsync(true);
+    }
 
     int ret = 0;
 
@@ -72,6 +72,12 @@ private:
         REQ_BADSIG,                 // request is signed but bad signature
         RES_IS_TRUNCATED,           // response is truncated
         RES_TSIG_SIGNED,            // response is signed with TSIG
+        RES_RRL_DROPPED,            // response is dropped by RRL
+        RES_RRL_SLIPPED,            // response is replaced with a truncated
+                                    // one by RRL
+        RES_FROM_CACHE,             // response is taken from the response
+                                    // cache
+        RES_CACHED_WITH_ANSWER,     // response from the cache has answer RRs
         BIT_ATTRIBUTES_TYPES
     };
     std::bitset<BIT_ATTRIBUTES_TYPES> bit_attributes_;
@@ -251,6 +257,71 @@ public:
     void setResponseTSIG(const bool signed_tsig) {
         bit_attributes_[RES_TSIG_SIGNED] = signed_tsig;
     }
+
+    /// \brief Return whether the response is dropped by response rate
+    /// limiting.
+    ///
+    /// \return true if the response is dropped by RRL
+    /// \throw None
+    bool responseIsRRLDropped() const {
+        return (bit_attributes_[RES_RRL_DROPPED]);
+    }
+
+    /// \brief Set whether the response is dropped by response rate limiting.
+    ///
+    /// \param dropped true if the response is dropped by RRL
+    /// \throw None
+    void setResponseRRLDropped(const bool dropped) {
+        bit_attributes_[RES_RRL_DROPPED] = dropped;
+    }
+
+    /// \brief Return whether the response is replaced with a truncated one
+    /// by response rate limiting.
+    ///
+    /// \return true if the response is slipped by RRL
+    /// \throw None
+    bool responseIsRRLSlipped() const {
+        return (bit_attributes_[RES_RRL_SLIPPED]);
+    }
+
+    /// \brief Set whether the response is replaced with a truncated one
+    /// by response rate limiting.
+    ///
+    /// \param slipped true if the response is slipped by RRL
+    /// \throw None
+    void setResponseRRLSlipped(const bool slipped) {
+        bit_attributes_[RES_RRL_SLIPPED] = slipped;
+    }
+
+    /// \brief Return whether the response is taken from the response cache.
+    ///
+    /// \return true if the response is taken from the response cache
+    /// \throw None
+    bool responseIsCached() const {
+        return (bit_attributes_[RES_FROM_CACHE]);
+    }
+
+    /// \brief Return whether the response taken from the response cache
+    /// has any RRs in the answer section.
+    ///
+    /// The sections of a cached response are not parsed into the response
+    /// message, so this is recorded separately.
+    ///
+    /// \return true if the cached response has answer RRs
+    /// \throw None
+    bool cachedResponseHasAnswer() const {
+        return (bit_attributes_[RES_CACHED_WITH_ANSWER]);
+    }
+
+    /// \brief Set whether the response is taken from the response cache.
+    ///
+    /// \param cached true if the response is taken from the response cache
+    /// \param has_answer true if the cached response has answer RRs
+    /// \throw None
+    void setResponseCached(const bool cached, const bool has_answer) {
+        bit_attributes_[RES_FROM_CACHE] = cached;
+        bit_attributes_[RES_CACHED_WITH_ANSWER] = cached && has_answer;
+    }
 };
 
 /// \brief Set of DNS message counters.
@@ -316,6 +387,15 @@ public:
     /// \return statistics data
     /// \throw std::bad_alloc Internal resource allocation fails
     ConstItemTreePtr get() const;
+
+    /// \brief Add the counters of another object to this one.
+    ///
+    /// This is used to aggregate counters maintained per processing
+    /// thread into a single set of statistics.
+    ///
+    /// \param other Counters to be added.
+    /// \throw None
+    void add(const Counters& other);
 };
 
 } // namespace statistics
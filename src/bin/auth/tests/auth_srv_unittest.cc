@@ -31,6 +31,7 @@
 #include <server_common/portconfig.h>
 #include <server_common/keyring.h>
 
+#include <acl/dns.h>
 #include <datasrc/client_list.h>
 #include <auth/auth_srv.h>
 #include <auth/command.h>
@@ -38,6 +39,8 @@
 #include <auth/statistics.h>
 #include <auth/statistics_items.h>
 #include <auth/datasrc_config.h>
+#include <auth/response_cache.h>
+#include <auth/rrl.h>
 
 #include <config/tests/fake_session.h>
 #include <config/ccsession.h>
@@ -60,6 +63,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/foreach.hpp>
 
+#include <ctime>
 #include <vector>
 
 #include <sys/types.h>
@@ -707,6 +711,53 @@ TEST_F(AuthSrvTest, IXFRDisconnectFail) {
     xfrout_forwarder.enableClose();
 }
 
+void
+setXfroutACL(AuthSrv& server, const char* acl) {
+    server.setXfrout(bundy::acl::dns::getRequestLoader().load(
+                         Element::fromJSON(acl)), 10);
+}
+
+TEST_F(AuthSrvTest, nativeXfrRefused) {
+    // Requests rejected by the ACL aren't passed to bundy-xfrout either
+    setXfroutACL(server, "[{\"action\": \"REJECT\"}]");
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("example.com"), RRClass::IN(),
+                                       RRType::AXFR());
+    createRequestPacket(request_message, IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::REFUSED(),
+                opcode.getCode(), QR_FLAG, 1, 0, 0, 0);
+    EXPECT_FALSE(xfrout_forwarder.isConnected());
+
+    // Dropped ones get no response at all
+    setXfroutACL(server, "[{\"action\": \"DROP\"}]");
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createRequestPacket(request_message, IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_FALSE(dnsserv.hasAnswer());
+    EXPECT_FALSE(xfrout_forwarder.isConnected());
+}
+
+TEST_F(AuthSrvTest, nativeXfrNotAuth) {
+    setXfroutACL(server, "[{\"action\": \"ACCEPT\"}]");
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    UnitTestUtil::createRequestMessage(request_message, opcode, default_qid,
+                                       Name("example.org"), RRClass::IN(),
+                                       RRType::AXFR());
+    createRequestPacket(request_message, IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOTAUTH(),
+                opcode.getCode(), QR_FLAG, 1, 0, 0, 0);
+    EXPECT_FALSE(xfrout_forwarder.isConnected());
+    EXPECT_EQ(0, server.getTransfersOut());
+}
+
 TEST_F(AuthSrvTest, notify) {
     updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE, false);
 
@@ -1292,6 +1343,166 @@ TEST_F(AuthSrvTest, chQueryWithInMemoryClient) {
                 opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 1, 0);
 }
 
+TEST_F(AuthSrvTest, rrlDrop) {
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    server.setRRL(boost::shared_ptr<ResponseRateLimiter>(
+                      new ResponseRateLimiter(1, 0, 0, 15, 0, 100, 24, 56,
+                                              time(NULL), 0)));
+
+    // The first response is sent as usual.
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 2, 1);
+
+    // The second one exceeds the limit and is dropped (slip is 0).
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_FALSE(dnsserv.hasAnswer());
+
+    ConstElementPtr stats = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    std::map<std::string, int> expect;
+    expect["request.v4"] = 2;
+    expect["request.udp"] = 2;
+    expect["opcode.query"] = 2;
+    expect["responses"] = 1;
+    expect["qrysuccess"] = 1;
+    expect["qryauthans"] = 1;
+    expect["rcode.noerror"] = 1;
+    expect["rrl.dropped"] = 1;
+    checkStatisticsCounters(stats, expect);
+}
+
+TEST_F(AuthSrvTest, rrlSlip) {
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    server.setRRL(boost::shared_ptr<ResponseRateLimiter>(
+                      new ResponseRateLimiter(1, 0, 0, 15, 1, 100, 24, 56,
+                                              time(NULL), 0)));
+
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+
+    // With slip = 1, the limited response is replaced with an empty
+    // truncated one.
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG | TC_FLAG, 1, 0, 0, 0);
+
+    ConstElementPtr stats = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    EXPECT_EQ(1, stats->get("rrl")->get("slipped")->intValue());
+    EXPECT_EQ(0, stats->get("rrl")->get("dropped")->intValue());
+
+    // Queries over TCP are never limited.
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire", IPPROTO_TCP);
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 2, 1);
+}
+
+TEST_F(AuthSrvTest, responseCache) {
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    const boost::shared_ptr<ResponseCache> cache(new ResponseCache(10, 0));
+    server.setResponseCache(cache);
+
+    // The first response is rendered as usual and stored in the cache.
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 2, 1);
+    EXPECT_EQ(1, cache->getEntryCount());
+    const std::vector<uint8_t> rendered(
+        static_cast<const uint8_t*>(response_obuffer->getData()),
+        static_cast<const uint8_t*>(response_obuffer->getData()) +
+        response_obuffer->getLength());
+
+    // The second one is answered from the cache with the same data.
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    matchWireData(&rendered[0], rendered.size(),
+                  response_obuffer->getData(), response_obuffer->getLength());
+
+    // Statistics are counted the same way for both.
+    ConstElementPtr stats = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    std::map<std::string, int> expect;
+    expect["request.v4"] = 2;
+    expect["request.udp"] = 2;
+    expect["opcode.query"] = 2;
+    expect["responses"] = 2;
+    expect["response.cached"] = 1;
+    expect["qrysuccess"] = 2;
+    expect["qryauthans"] = 2;
+    expect["rcode.noerror"] = 2;
+    checkStatisticsCounters(stats, expect);
+
+    // Disabling the cache makes the server render the response again.
+    server.setResponseCache(boost::shared_ptr<ResponseCache>());
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    headerCheck(*parse_message, default_qid, Rcode::NOERROR(),
+                opcode.getCode(), QR_FLAG | AA_FLAG, 1, 1, 2, 1);
+}
+
+TEST_F(AuthSrvTest, responseCacheWithRRL) {
+    updateInMemory(server, "example.", CONFIG_INMEMORY_EXAMPLE);
+    server.setResponseCache(boost::shared_ptr<ResponseCache>(
+                                new ResponseCache(10, 0)));
+    server.setRRL(boost::shared_ptr<ResponseRateLimiter>(
+                      new ResponseRateLimiter(1, 0, 0, 15, 1, 100, 24, 56,
+                                              time(NULL), 0)));
+
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+
+    // Responses from the cache are rate limited, too.  The slipped one is
+    // an empty truncated response.
+    parse_message->clear(Message::PARSE);
+    response_obuffer->clear();
+    createDataFromFile("nsec3query_nodnssec_fromWire.wire");
+    server.processMessage(*io_message, *parse_message, *response_obuffer,
+                          &dnsserv);
+    EXPECT_TRUE(dnsserv.hasAnswer());
+    Message m(Message::PARSE);
+    InputBuffer ib(response_obuffer->getData(), response_obuffer->getLength());
+    m.fromWire(ib);
+    headerCheck(m, default_qid, Rcode::NOERROR(), opcode.getCode(),
+                QR_FLAG | AA_FLAG | TC_FLAG, 1, 0, 0, 0);
+
+    ConstElementPtr stats = server.getStatistics()->get("zones")->
+        get("_SERVER_");
+    EXPECT_EQ(1, stats->get("rrl")->get("slipped")->intValue());
+    EXPECT_EQ(0, stats->get("response")->get("cached")->intValue());
+}
+
 #ifdef USE_STATIC_LINK
 TEST_F(AuthSrvTest, DISABLED_queryCounterTruncTest) {
 #else
@@ -26,6 +26,8 @@
 #include <auth/auth_srv.h>
 #include <auth/auth_config.h>
 #include <auth/common.h>
+#include <auth/response_cache.h>
+#include <auth/rrl.h>
 
 #include "datasrc_util.h"
 
@@ -157,4 +159,113 @@ TEST_F(AuthConfigTest, tcpRecvTimeoutConfig) {
                  AuthConfigError);
 }
 
+// Configure response rate limiting
+TEST_F(AuthConfigTest, rrlConfig) {
+    // Disabled by default
+    EXPECT_FALSE(server.getRRL());
+
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"rrl\": {\"enable\": true, \"responses_per_second\": 5,"
+    "             \"slip\": 3, \"max_table_size\": 100} }"));
+    ASSERT_TRUE(server.getRRL());
+    EXPECT_EQ(5, server.getRRL()->getResponseRate());
+    EXPECT_EQ(0, server.getRRL()->getNXDOMAINRate());
+    EXPECT_EQ(0, server.getRRL()->getErrorRate());
+    EXPECT_EQ(15, server.getRRL()->getWindow());
+    EXPECT_EQ(3, server.getRRL()->getSlip());
+    EXPECT_EQ(100, server.getRRL()->getTableSize());
+
+    // Invalid parameters are rejected, and the current setting is kept.
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"rrl\": {\"enable\": true, \"window\": 0} }")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"rrl\": {\"enable\": true,"
+                    "            \"max_table_size\": 0} }")),
+                 AuthConfigError);
+    ASSERT_TRUE(server.getRRL());
+    EXPECT_EQ(5, server.getRRL()->getResponseRate());
+
+    // Disabling it removes the limiter.
+    configureAuthServer(server, Element::fromJSON(
+    "{ \"rrl\": {\"enable\": false, \"responses_per_second\": 5} }"));
+    EXPECT_FALSE(server.getRRL());
+}
+
+// Configure the number of UDP worker threads
+TEST_F(AuthConfigTest, udpWorkers) {
+    // By default UDP queries are handled in the main thread.
+    EXPECT_EQ(0, server.getUDPWorkers());
+
+    configureAuthServer(server, Element::fromJSON("{ \"udp_workers\": 2 }"));
+    EXPECT_EQ(2, server.getUDPWorkers());
+    EXPECT_EQ(2, dnss_.getUDPWorkerCount());
+
+    configureAuthServer(server, Element::fromJSON("{ \"udp_workers\": 0 }"));
+    EXPECT_EQ(0, server.getUDPWorkers());
+    EXPECT_EQ(0, dnss_.getUDPWorkerCount());
+
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"udp_workers\": -1 }")),
+                 AuthConfigError);
+    EXPECT_EQ(0, server.getUDPWorkers());
+}
+
+// Configure zone transfers served by bundy-auth
+TEST_F(AuthConfigTest, xfroutConfig) {
+    // Passed on to bundy-xfrout by default
+    EXPECT_FALSE(server.getXfroutACL());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"xfrout\": {\"native\": true,"
+                            "              \"transfers_out\": 5} }"));
+    EXPECT_TRUE(server.getXfroutACL());
+    EXPECT_EQ(5, server.getMaxTransfersOut());
+
+    // Invalid parameters are rejected, and the current setting is kept.
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"xfrout\": {\"native\": true,"
+                    "              \"transfers_out\": -1} }")),
+                 AuthConfigError);
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"xfrout\": {\"native\": true,"
+                    "              \"transfer_acl\": [{\"action\": \"X\"}]}"
+                    "}")),
+                 AuthConfigError);
+    EXPECT_TRUE(server.getXfroutACL());
+    EXPECT_EQ(5, server.getMaxTransfersOut());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"xfrout\": {\"native\": false} }"));
+    EXPECT_FALSE(server.getXfroutACL());
+}
+
+// Configure the response cache
+TEST_F(AuthConfigTest, responseCacheSize) {
+    // Disabled by default
+    EXPECT_FALSE(server.getResponseCache());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"response_cache_size\": 100 }"));
+    const boost::shared_ptr<bundy::auth::ResponseCache> cache =
+        server.getResponseCache();
+    ASSERT_TRUE(cache);
+    EXPECT_EQ(100, cache->getMaxEntries());
+
+    // The same size keeps the current cache.
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"response_cache_size\": 100 }"));
+    EXPECT_EQ(cache, server.getResponseCache());
+
+    // Invalid size is rejected, and the current setting is kept.
+    EXPECT_THROW(configureAuthServer(server, Element::fromJSON(
+                    "{ \"response_cache_size\": -1 }")),
+                 AuthConfigError);
+    EXPECT_EQ(cache, server.getResponseCache());
+
+    configureAuthServer(server, Element::fromJSON(
+                            "{ \"response_cache_size\": 0 }"));
+    EXPECT_FALSE(server.getResponseCache());
+}
+
 }
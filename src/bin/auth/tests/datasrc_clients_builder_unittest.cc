@@ -34,6 +34,7 @@
 
 #include <gtest/gtest.h>
 
+#include <boost/bind.hpp>
 #include <boost/function.hpp>
 
 #include <sys/types.h>
@@ -43,6 +44,8 @@
 #include <string>
 #include <sstream>
 #include <cerrno>
+#include <utility>
+#include <vector>
 #include <unistd.h>
 
 using bundy::data::ConstElementPtr;
@@ -61,11 +64,15 @@ protected:
                     boost::shared_ptr<ConfigurableClientList> >),
         write_end(-1), read_end(-1),
         builder(&command_queue, &callback_queue, &cond, &queue_mutex,
-                &clients_map, &map_mutex, generateSockets()),
+                &clients_map, &map_mutex, generateSockets(),
+                &data_updated_callback),
         cond(command_queue, delayed_command_queue), rrclass(RRClass::IN()),
         shutdown_cmd(SHUTDOWN, ConstElementPtr(), FinishedCallback()),
         noop_cmd(NOOP, ConstElementPtr(), FinishedCallback())
-    {}
+    {
+        data_updated_callback =
+            boost::bind(&DataSrcClientsBuilderTest::dataUpdated, this, _1, _2);
+    }
     ~ DataSrcClientsBuilderTest() {
 
     }
@@ -79,6 +86,13 @@ protected:
     void checkLoadOrUpdateZone(CommandID cmdid);
     ConstElementPtr createSegments() const;
 
+    // Record notifications of updated zone data from the builder.
+    void dataUpdated(const RRClass& updated_class, const Name& origin) {
+        updated_zones.push_back(std::make_pair(updated_class, origin));
+    }
+
+    DataUpdatedCallback data_updated_callback;
+    std::vector<std::pair<RRClass, Name> > updated_zones;
     ClientListMapPtr clients_map; // configured clients
     std::list<Command> command_queue; // test command queue
     std::list<Command> delayed_command_queue; // commands available after wait
@@ -249,6 +263,10 @@ TEST_F(DataSrcClientsBuilderTest, reconfigure) {
     EXPECT_FALSE(builder.getInternalCallbacks().front().second->boolValue());
     EXPECT_EQ(1, clients_map->size());
     EXPECT_EQ(1, map_mutex.lock_count);
+    // All data of the new class should have been notified as updated.
+    ASSERT_EQ(1, updated_zones.size());
+    EXPECT_EQ(RRClass::IN(), updated_zones[0].first);
+    EXPECT_EQ(Name::ROOT_NAME(), updated_zones[0].second);
 
     // Store the nonempty clients map we now have
     ClientListMapPtr working_config_clients(clients_map);
@@ -400,6 +418,7 @@ TEST_F(DataSrcClientsBuilderTest, loadZone) {
     EXPECT_EQ(0, map_mutex.unlock_count);
 
     configureZones();
+    updated_zones.clear();
 
     EXPECT_EQ(0, system(INSTALL_PROG " -c " TEST_DATA_DIR
                         "/test1-new.zone.in "
@@ -414,6 +433,11 @@ TEST_F(DataSrcClientsBuilderTest, loadZone) {
                                FinishedCallback());
     EXPECT_TRUE(builder.handleCommand(loadzone_cmd));
 
+    // The update of the zone should have been notified.
+    ASSERT_EQ(1, updated_zones.size());
+    EXPECT_EQ(rrclass, updated_zones[0].first);
+    EXPECT_EQ(Name("test1.example"), updated_zones[0].second);
+
     // loadZone involves two critical sections: one for getting the zone
     // writer, and one for actually updating the zone data.  So the lock/unlock
     // count should be incremented by 2.
@@ -37,6 +37,7 @@ TestMutex* FakeDataSrcClientsBuilder::queue_mutex = NULL;
 bundy::datasrc::ClientListMapPtr*
     FakeDataSrcClientsBuilder::clients_map = NULL;
 TestMutex* FakeDataSrcClientsBuilder::map_mutex = NULL;
+DataUpdatedCallback* FakeDataSrcClientsBuilder::data_updated_callback = NULL;
 TestMutex FakeDataSrcClientsBuilder::queue_mutex_copy;
 bool FakeDataSrcClientsBuilder::thread_waited = false;
 FakeDataSrcClientsBuilder::ExceptionFromWait
@@ -71,6 +71,9 @@ public:
     private:
         TestMutex& mutex_;
     };
+    // The clients map is protected by a read-write lock in the real
+    // manager; for tests a reader lock is just a normal lock.
+    typedef Locker ReaderLocker;
     size_t lock_count; // number of lock acquisitions; tests can check this
     size_t unlock_count; // number of lock releases; tests can check this
     size_t noop_count;          // allow doNoop() to modify this
@@ -143,6 +146,7 @@ public:
     static int wakeup_fd;
     static bundy::datasrc::ClientListMapPtr* clients_map;
     static TestMutex* map_mutex;
+    static DataUpdatedCallback* data_updated_callback;
     static std::list<Command> command_queue_copy;
     static std::list<FinishedCallbackPair> callback_queue_copy;
     static TestCondVar cond_copy;
@@ -162,7 +166,8 @@ public:
         TestCondVar* cond,
         TestMutex* queue_mutex,
         bundy::datasrc::ClientListMapPtr* clients_map,
-        TestMutex* map_mutex, int wakeup_fd)
+        TestMutex* map_mutex, int wakeup_fd,
+        DataUpdatedCallback* data_updated_callback)
     {
         FakeDataSrcClientsBuilder::started = false;
         FakeDataSrcClientsBuilder::command_queue = command_queue;
@@ -172,6 +177,8 @@ public:
         FakeDataSrcClientsBuilder::wakeup_fd = wakeup_fd;
         FakeDataSrcClientsBuilder::clients_map = clients_map;
         FakeDataSrcClientsBuilder::map_mutex = map_mutex;
+        FakeDataSrcClientsBuilder::data_updated_callback =
+            data_updated_callback;
         FakeDataSrcClientsBuilder::thread_waited = false;
         FakeDataSrcClientsBuilder::thread_throw_on_wait = NOTHROW;
     }
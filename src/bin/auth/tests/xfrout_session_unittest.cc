@@ -0,0 +1,388 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <auth/xfrout_session.h>
+
+#include <asiolink/io_address.h>
+#include <cc/data.h>
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/opcode.h>
+#include <dns/question.h>
+#include <dns/rcode.h>
+#include <dns/rdataclass.h>
+#include <dns/rrclass.h>
+#include <dns/rrttl.h>
+#include <dns/rrtype.h>
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+#include <asio.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/weak_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace bundy::auth;
+using namespace bundy::dns;
+using namespace bundy::dns::rdata;
+using namespace bundy::datasrc;
+using bundy::asiolink::IOAddress;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOService;
+using bundy::data::Element;
+using bundy::util::InputBuffer;
+using std::string;
+using std::vector;
+
+namespace {
+
+const char* const ZONE_FILE = TEST_DATA_DIR "/example.zone";
+const qid_t QID = 0x1035;
+
+// A source of RRsets for the transfers
+class FakeSource {
+public:
+    FakeSource() : pos_(0) {}
+    ConstRRsetPtr getNext() {
+        return (pos_ < rrsets_.size() ? rrsets_[pos_++] : ConstRRsetPtr());
+    }
+    vector<ConstRRsetPtr> rrsets_;
+    size_t pos_;
+};
+
+void
+callDirectly(const boost::function<void ()>& callback) {
+    callback();
+}
+
+class XfroutSessionTest : public ::testing::Test {
+protected:
+    XfroutSessionTest() :
+        list_(RRClass::IN()),
+        remote_(IOEndpoint::create(IPPROTO_TCP, IOAddress("192.0.2.1"),
+                                   53210)),
+        query_(Message::RENDER),
+        finished_(NULL),
+        finished_count_(0)
+    {
+        list_.configure(Element::fromJSON(
+                            "[{\"type\": \"MasterFiles\","
+                            "  \"cache-enable\": true,"
+                            "  \"params\": {\"example.com\": \"" +
+                            string(ZONE_FILE) + "\"}}]"), true);
+        setQuery(RRType::AXFR());
+
+        int fds[2];
+        EXPECT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+        server_fd_ = fds[0];
+        client_fd_ = fds[1];
+        fcntl(client_fd_, F_SETFL, O_NONBLOCK);
+    }
+
+    ~XfroutSessionTest() {
+        session_.reset();
+        close(server_fd_);
+        close(client_fd_);
+    }
+
+    void setQuery(const RRType& qtype, const Name& zone = Name("example.com"),
+                  uint32_t serial = 0)
+    {
+        query_.clear(Message::RENDER);
+        query_.setQid(QID);
+        query_.setOpcode(Opcode::QUERY());
+        query_.addQuestion(Question(zone, RRClass::IN(), qtype));
+        if (serial != 0) {
+            RRsetPtr soa(new RRset(zone, RRClass::IN(), RRType::SOA(),
+                                   RRTTL(0)));
+            soa->addRdata(generic::SOA(Name("ns.example.com"),
+                                       Name("admin.example.com"), serial,
+                                       3600, 1800, 2419200, 7200));
+            query_.addRRset(Message::SECTION_AUTHORITY, soa);
+        }
+    }
+
+    // The SOA of the example.com zone, with the given serial
+    ConstRRsetPtr createSOA(uint32_t serial = 1234) {
+        RRsetPtr soa(new RRset(Name("example.com"), RRClass::IN(),
+                               RRType::SOA(), RRTTL(3600)));
+        soa->addRdata(generic::SOA(Name("ns.example.com"),
+                                   Name("admin.example.com"), serial,
+                                   3600, 1800, 2419200, 7200));
+        return (soa);
+    }
+
+    void startSession(const XfroutData& data) {
+        session_.reset(new XfroutSession(
+                           io_service_, server_fd_, *remote_, query_, data,
+                           std::unique_ptr<TSIGContext>(),
+                           callDirectly,
+                           boost::bind(&XfroutSessionTest::finished, this,
+                                       _1)));
+        session_->start();
+    }
+
+    void finished(XfroutSession* session) {
+        finished_ = session;
+        ++finished_count_;
+    }
+
+    // Run the session until the connection is closed, and parse what was
+    // sent.
+    void receive() {
+        // The session keeps our copy of the socket open, so it's closed
+        // here; the connection is closed when the session closes its copy.
+        close(server_fd_);
+        server_fd_ = -1;
+        vector<uint8_t> data;
+        while (true) {
+            io_service_.get_io_service().poll();
+            io_service_.get_io_service().reset();
+            uint8_t buf[4096];
+            const ssize_t len = read(client_fd_, buf, sizeof(buf));
+            if (len == 0) {
+                break;
+            } else if (len > 0) {
+                data.insert(data.end(), buf, buf + len);
+            }
+        }
+
+        for (size_t pos = 0; pos < data.size(); ) {
+            ASSERT_LE(pos + 2, data.size());
+            const size_t len = (data[pos] << 8) | data[pos + 1];
+            pos += 2;
+            ASSERT_LE(pos + len, data.size());
+            InputBuffer buffer(&data[pos], len);
+            MessagePtr message(new Message(Message::PARSE));
+            message->fromWire(buffer, Message::PRESERVE_ORDER);
+            messages_.push_back(message);
+            pos += len;
+        }
+    }
+
+    // Return all the answer RRsets sent, checking the messages on the way
+    vector<ConstRRsetPtr> getAnswers() {
+        vector<ConstRRsetPtr> answers;
+        for (size_t i = 0; i < messages_.size(); ++i) {
+            const Message& message = *messages_[i];
+            EXPECT_EQ(QID, message.getQid());
+            EXPECT_TRUE(message.getHeaderFlag(Message::HEADERFLAG_QR));
+            EXPECT_TRUE(message.getHeaderFlag(Message::HEADERFLAG_AA));
+            EXPECT_EQ(Rcode::NOERROR(), message.getRcode());
+            // Only the first one has the question
+            EXPECT_EQ(i == 0 ? 1 : 0,
+                      message.getRRCount(Message::SECTION_QUESTION));
+            for (RRsetIterator it =
+                     message.beginSection(Message::SECTION_ANSWER);
+                 it != message.endSection(Message::SECTION_ANSWER); ++it) {
+                answers.push_back(*it);
+            }
+        }
+        return (answers);
+    }
+
+    ConfigurableClientList list_;
+    boost::scoped_ptr<const IOEndpoint> remote_;
+    Message query_;
+    IOService io_service_;
+    int server_fd_;
+    int client_fd_;
+    boost::scoped_ptr<XfroutSession> session_;
+    XfroutSession* finished_;
+    size_t finished_count_;
+    vector<MessagePtr> messages_;
+};
+
+TEST_F(XfroutSessionTest, prepareAXFR) {
+    XfroutData data;
+    EXPECT_EQ(Rcode::NOERROR(),
+              prepareXfroutData(list_, query_, *remote_, data));
+    ASSERT_TRUE(data.soa_);
+    EXPECT_EQ(createSOA()->toText(), data.soa_->toText());
+    EXPECT_TRUE(data.skip_soa_);
+    ASSERT_FALSE(data.source_.empty());
+    size_t count = 0;
+    while (data.source_()) {
+        ++count;
+    }
+    // SOA, NS and A
+    EXPECT_EQ(3, count);
+
+    // Not our zone
+    setQuery(RRType::AXFR(), Name("example.org"));
+    EXPECT_EQ(Rcode::NOTAUTH(),
+              prepareXfroutData(list_, query_, *remote_, data));
+    // Not the zone apex
+    setQuery(RRType::AXFR(), Name("ns.example.com"));
+    EXPECT_EQ(Rcode::NOTAUTH(),
+              prepareXfroutData(list_, query_, *remote_, data));
+}
+
+TEST_F(XfroutSessionTest, prepareIXFR) {
+    // The client has the current version, so only the SOA is sent
+    setQuery(RRType::IXFR(), Name("example.com"), 1234);
+    XfroutData data;
+    EXPECT_EQ(Rcode::NOERROR(),
+              prepareXfroutData(list_, query_, *remote_, data));
+    ASSERT_TRUE(data.soa_);
+    EXPECT_EQ(createSOA()->toText(), data.soa_->toText());
+    EXPECT_TRUE(data.source_.empty());
+
+    // An older version.  The zone file has no journal, so the whole zone
+    // is sent.
+    setQuery(RRType::IXFR(), Name("example.com"), 1000);
+    XfroutData data2;
+    EXPECT_EQ(Rcode::NOERROR(),
+              prepareXfroutData(list_, query_, *remote_, data2));
+    EXPECT_FALSE(data2.source_.empty());
+    EXPECT_TRUE(data2.skip_soa_);
+
+    // No SOA in the request
+    setQuery(RRType::IXFR());
+    EXPECT_EQ(Rcode::FORMERR(),
+              prepareXfroutData(list_, query_, *remote_, data));
+}
+
+TEST_F(XfroutSessionTest, AXFR) {
+    XfroutData data;
+    ASSERT_EQ(Rcode::NOERROR(),
+              prepareXfroutData(list_, query_, *remote_, data));
+    startSession(data);
+    EXPECT_EQ(Name("example.com"), session_->getZoneName());
+    EXPECT_EQ(RRClass::IN(), session_->getZoneClass());
+    receive();
+
+    // All in one message, with the SOA only at the ends
+    ASSERT_EQ(1, messages_.size());
+    const vector<ConstRRsetPtr> answers = getAnswers();
+    ASSERT_EQ(4, answers.size());
+    EXPECT_EQ(RRType::SOA(), answers[0]->getType());
+    EXPECT_EQ(RRType::NS(), answers[1]->getType());
+    EXPECT_EQ(RRType::A(), answers[2]->getType());
+    EXPECT_EQ(RRType::SOA(), answers[3]->getType());
+    EXPECT_EQ(1, finished_count_);
+    EXPECT_EQ(session_.get(), finished_);
+}
+
+TEST_F(XfroutSessionTest, SOAOnly) {
+    setQuery(RRType::IXFR(), Name("example.com"), 1234);
+    XfroutData data;
+    data.soa_ = createSOA();
+    startSession(data);
+    receive();
+
+    ASSERT_EQ(1, messages_.size());
+    const vector<ConstRRsetPtr> answers = getAnswers();
+    ASSERT_EQ(1, answers.size());
+    EXPECT_EQ(data.soa_->toText(), answers[0]->toText());
+    EXPECT_EQ(1, finished_count_);
+}
+
+TEST_F(XfroutSessionTest, manyMessages) {
+    // Enough data for several messages and batches.  The SOAs from the
+    // source are sent as they are, like in an IXFR.
+    FakeSource source;
+    source.rrsets_.push_back(createSOA(1000));
+    const string txt(200, 'x');
+    for (size_t i = 0; i < 5000; ++i) {
+        RRsetPtr rrset(new RRset(Name(boost::lexical_cast<string>(i) +
+                                      ".example.com"), RRClass::IN(),
+                                 RRType::TXT(), RRTTL(3600)));
+        rrset->addRdata(generic::TXT(txt));
+        source.rrsets_.push_back(rrset);
+    }
+    source.rrsets_.push_back(createSOA());
+    XfroutData data;
+    data.soa_ = createSOA();
+    data.source_ = boost::bind(&FakeSource::getNext, &source);
+    startSession(data);
+    receive();
+
+    EXPECT_LT(XfroutSession::BATCH_SIZE * 3 / 65535, messages_.size());
+    const vector<ConstRRsetPtr> answers = getAnswers();
+    ASSERT_EQ(source.rrsets_.size() + 2, answers.size());
+    EXPECT_EQ(data.soa_->toText(), answers[0]->toText());
+    for (size_t i = 0; i < source.rrsets_.size(); ++i) {
+        EXPECT_EQ(source.rrsets_[i]->toText(), answers[i + 1]->toText());
+    }
+    EXPECT_EQ(data.soa_->toText(), answers.back()->toText());
+    EXPECT_EQ(1, finished_count_);
+}
+
+TEST_F(XfroutSessionTest, invalidated) {
+    XfroutData data;
+    ASSERT_EQ(Rcode::NOERROR(),
+              prepareXfroutData(list_, query_, *remote_, data));
+    startSession(data);
+    // The zone is updated before anything is sent; the connection is
+    // just closed.
+    session_->invalidate();
+    receive();
+    EXPECT_TRUE(messages_.empty());
+    EXPECT_EQ(1, finished_count_);
+}
+
+TEST_F(XfroutSessionTest, tooLargeRR) {
+    // A single RR that doesn't fit in a message with the header
+    FakeSource source;
+    RRsetPtr rrset(new RRset(Name("large.example.com"), RRClass::IN(),
+                             RRType::TXT(), RRTTL(3600)));
+    string txt;
+    for (size_t i = 0; i < 255; ++i) {
+        txt += "\"" + string(255, 'x') + "\" ";
+    }
+    txt += "\"" + string(220, 'x') + "\"";
+    rrset->addRdata(generic::TXT(txt));
+    source.rrsets_.push_back(rrset);
+    XfroutData data;
+    data.soa_ = createSOA();
+    data.source_ = boost::bind(&FakeSource::getNext, &source);
+    startSession(data);
+    receive();
+    // The transfer fails, and the connection is closed.
+    EXPECT_TRUE(messages_.empty());
+    EXPECT_EQ(1, finished_count_);
+}
+
+TEST_F(XfroutSessionTest, destroyed) {
+    XfroutData data;
+    ASSERT_EQ(Rcode::NOERROR(),
+              prepareXfroutData(list_, query_, *remote_, data));
+    ASSERT_TRUE(data.life_keeper_);
+    const boost::weak_ptr<ClientList::FindResult::LifeKeeper>
+        life_keeper(data.life_keeper_);
+    startSession(data);
+    data = XfroutData();
+    // The transfer is aborted without the callback.  The data is released
+    // right away, not when the pending handlers are done.
+    session_.reset();
+    EXPECT_TRUE(life_keeper.expired());
+    receive();
+    EXPECT_TRUE(messages_.empty());
+    EXPECT_EQ(0, finished_count_);
+}
+
+}
@@ -0,0 +1,571 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <auth/xfrout_session.h>
+#include <auth/auth_log.h>
+
+#include <asiolink/io_error.h>
+#include <datasrc/client.h>
+#include <datasrc/exceptions.h>
+#include <datasrc/memory/memory_client.h>
+#include <datasrc/zone_finder.h>
+#include <datasrc/zone_iterator.h>
+#include <dns/messagerenderer.h>
+#include <dns/question.h>
+#include <dns/rdataclass.h>
+#include <dns/rrtype.h>
+#include <dns/serial.h>
+#include <exceptions/exceptions.h>
+#include <util/buffer.h>
+
+#include <asio.hpp>
+
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include <unistd.h>
+
+using namespace bundy::dns;
+using namespace bundy::datasrc;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOService;
+using bundy::util::OutputBuffer;
+using std::string;
+
+namespace bundy {
+namespace auth {
+
+namespace {
+
+// The maximum size of a DNS message over TCP
+const size_t MAX_MESSAGE_SIZE = 65535;
+const size_t HEADER_SIZE = 12;
+
+// The QR and AA flags, with the QUERY opcode and NOERROR
+const uint16_t RESPONSE_FLAGS = 0x8400;
+
+// Make a copy of the SOA of a zone, so it can be used after the data
+// source is unlocked.
+ConstRRsetPtr
+copySOA(const AbstractRRset& soa) {
+    const RRsetPtr copy(new RRset(soa.getName(), soa.getClass(),
+                                  soa.getType(), soa.getTTL()));
+    for (RdataIteratorPtr rdata(soa.getRdataIterator()); !rdata->isLast();
+         rdata->next()) {
+        copy->addRdata(rdata::createRdata(soa.getType(), soa.getClass(),
+                                          rdata->getCurrent()));
+    }
+    return (copy);
+}
+
+// Set up an AXFR (or AXFR-style IXFR) from a zone iterator
+Rcode
+prepareAXFR(const DataSourceClient& client, const Name& zone_name,
+            XfroutData& data)
+{
+    ZoneIteratorPtr iterator;
+    try {
+        // Each RR is separate, so we can transfer even a (half) broken zone
+        // and never need to split an RRset between messages.
+        iterator = client.getIterator(zone_name, true);
+    } catch (const DataSourceError&) {
+        // We can't tell "no such zone" from other errors here.  As the zone
+        // was found in the list, this is quite unexpected anyway.
+        return (Rcode::NOTAUTH());
+    }
+    const ConstRRsetPtr soa = iterator->getSOA();
+    if (!soa || soa->getRdataCount() != 1) {
+        return (Rcode::SERVFAIL());
+    }
+    data.soa_ = copySOA(*soa);
+    data.source_ = boost::bind(&ZoneIterator::getNextRRset, iterator);
+    data.skip_soa_ = true;
+    return (Rcode::NOERROR());
+}
+
+// Return the data source client a cached zone is loaded from, or NULL
+// if the given client isn't the cache of a data source of the list.
+const DataSourceClient*
+findBackingClient(const ConfigurableClientList& list,
+                  const DataSourceClient* client)
+{
+    BOOST_FOREACH(const ConfigurableClientList::DataSourceInfo& info,
+                  list.getDataSources()) {
+        if (info.cache_ && info.cache_.get() == client) {
+            return (info.data_src_client_);
+        }
+    }
+    return (NULL);
+}
+
+}
+
+Rcode
+prepareXfroutData(const ConfigurableClientList& list, const Message& query,
+                  const IOEndpoint& remote, XfroutData& data)
+{
+    const ConstQuestionPtr question = *query.beginQuestion();
+    const Name& zone_name = question->getName();
+    const RRClass& zone_class = question->getClass();
+
+    const ClientList::FindResult result = list.find(zone_name, true);
+    if (result.dsrc_client_ == NULL || !result.finder_) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_XFROUT_NOT_AUTH)
+            .arg(remote).arg(zone_name).arg(zone_class);
+        return (Rcode::NOTAUTH());
+    }
+    data.life_keeper_ = result.life_keeper_;
+
+    if (question->getType() == RRType::AXFR()) {
+        return (prepareAXFR(*result.dsrc_client_, zone_name, data));
+    }
+
+    // For IXFR, the version of the client is in the authority section.
+    ConstRRsetPtr remote_soa;
+    for (RRsetIterator it = query.beginSection(Message::SECTION_AUTHORITY);
+         it != query.endSection(Message::SECTION_AUTHORITY); ++it) {
+        if ((*it)->getName() != zone_name ||
+            (*it)->getType() != RRType::SOA() ||
+            (*it)->getClass() != zone_class) {
+            continue;
+        }
+        if ((*it)->getRdataCount() != 1) {
+            remote_soa.reset();
+            break;
+        }
+        remote_soa = *it;
+    }
+    if (!remote_soa) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_XFROUT_IXFR_NO_SOA)
+            .arg(remote);
+        return (Rcode::FORMERR());
+    }
+
+    const ZoneFinderContextPtr context =
+        result.finder_->find(zone_name, RRType::SOA());
+    if (context->code != ZoneFinder::SUCCESS ||
+        context->rrset->getRdataCount() != 1) {
+        return (Rcode::SERVFAIL());
+    }
+    data.soa_ = copySOA(*context->rrset);
+
+    // As RFC 1995 says, a client with the same or a newer version just
+    // gets our SOA.
+    const Serial begin_serial = dynamic_cast<const rdata::generic::SOA&>(
+        remote_soa->getRdataIterator()->getCurrent()).getSerial();
+    const Serial end_serial = dynamic_cast<const rdata::generic::SOA&>(
+        data.soa_->getRdataIterator()->getCurrent()).getSerial();
+    if (!(begin_serial < end_serial)) {
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_XFROUT_IXFR_UPTODATE)
+            .arg(remote).arg(zone_name).arg(zone_class)
+            .arg(begin_serial.getValue()).arg(end_serial.getValue());
+        return (Rcode::NOERROR());
+    }
+
+    // The in-memory cache doesn't keep the journal, but the data source
+    // the zone is loaded from may.
+    const DataSourceClient* journal_client = result.dsrc_client_;
+    std::pair<ZoneJournalReader::Result, ZoneJournalReaderPtr> reader;
+    while (true) {
+        try {
+            reader = journal_client->getJournalReader(
+                zone_name, begin_serial.getValue(), end_serial.getValue());
+            break;
+        } catch (const bundy::NotImplemented&) {
+            journal_client = (journal_client == result.dsrc_client_) ?
+                findBackingClient(list, journal_client) : NULL;
+            if (journal_client == NULL) {
+                LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL,
+                          AUTH_XFROUT_IXFR_NO_JOURNAL)
+                    .arg(remote).arg(zone_name).arg(zone_class);
+                return (prepareAXFR(*result.dsrc_client_, zone_name, data));
+            }
+        }
+    }
+    switch (reader.first) {
+    case ZoneJournalReader::SUCCESS:
+        break;
+    case ZoneJournalReader::NO_SUCH_VERSION:
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_XFROUT_IXFR_NO_VERSION)
+            .arg(remote).arg(zone_name).arg(zone_class)
+            .arg(begin_serial.getValue()).arg(end_serial.getValue());
+        return (prepareAXFR(*result.dsrc_client_, zone_name, data));
+    case ZoneJournalReader::NO_SUCH_ZONE:
+        // Unexpected, as we've just found the zone, but the backing data
+        // source may be out of sync with the cache.
+        LOG_DEBUG(auth_logger, DBG_AUTH_DETAIL, AUTH_XFROUT_NOT_AUTH)
+            .arg(remote).arg(zone_name).arg(zone_class);
+        return (Rcode::NOTAUTH());
+    }
+    data.source_ = boost::bind(&ZoneJournalReader::getNextDiff,
+                               reader.second);
+    data.skip_soa_ = false;
+    return (Rcode::NOERROR());
+}
+
+class XfroutSessionImpl :
+    public boost::enable_shared_from_this<XfroutSessionImpl>
+{
+public:
+    XfroutSessionImpl(XfroutSession* owner, IOService& io_service, int fd,
+                      const IOEndpoint& remote, const Message& query,
+                      const XfroutData& data,
+                      std::unique_ptr<TSIGContext> tsig_ctx,
+                      const XfroutSession::DataLocker& locker,
+                      const XfroutSession::FinishedCallback& finished) :
+        owner_(owner),
+        io_service_(io_service),
+        socket_(io_service.get_io_service()),
+        remote_(boost::lexical_cast<string>(remote)),
+        question_(**query.beginQuestion()),
+        qid_(query.getQid()),
+        data_(data),
+        tsig_ctx_(std::move(tsig_ctx)),
+        locker_(locker),
+        finished_(finished),
+        valid_(true),
+        aborted_(false),
+        state_(FIRST_SOA),
+        first_message_(true),
+        messages_(0),
+        error_(),
+        pending_(new OutputBuffer(BATCH_RESERVE)),
+        sending_(new OutputBuffer(BATCH_RESERVE))
+    {
+        renderer_.setCompressMode(MessageRenderer::CASE_SENSITIVE);
+        const int sock = dup(fd);
+        if (sock < 0) {
+            bundy_throw(bundy::asiolink::IOError,
+                        "failed to duplicate the transfer socket: " <<
+                        std::strerror(errno));
+        }
+        asio::error_code ec;
+        socket_.assign(remote.getFamily() == AF_INET6 ?
+                       asio::ip::tcp::v6() : asio::ip::tcp::v4(), sock, ec);
+        if (ec) {
+            close(sock);
+            bundy_throw(bundy::asiolink::IOError,
+                        "failed to use the transfer socket: " <<
+                        ec.message());
+        }
+    }
+
+    void start() {
+        LOG_DEBUG(auth_logger, DBG_AUTH_OPS, AUTH_XFROUT_STARTED)
+            .arg(question_.getType()).arg(remote_)
+            .arg(question_.getName()).arg(question_.getClass());
+        // Not rendered right away, as the caller may have the data locked.
+        io_service_.post(boost::bind(&XfroutSessionImpl::sendNext,
+                                     shared_from_this()));
+    }
+
+    void invalidate() {
+        valid_ = false;
+    }
+
+    // Called when the owner is destroyed, with the data locked.  We may
+    // be kept alive by pending handlers for a while, but they won't do
+    // anything, so the data is released right away.
+    void cancel() {
+        owner_ = NULL;
+        asio::error_code ec;
+        socket_.close(ec);
+        releaseData();
+    }
+
+    const Question& getQuestion() const { return (question_); }
+
+private:
+    enum State {
+        FIRST_SOA,              // Nothing rendered yet
+        BODY,                   // Rendering the RRsets from the source
+        DONE                    // The closing SOA is rendered
+    };
+
+    // The initial capacity of the buffers of a batch
+    static const size_t BATCH_RESERVE = XfroutSession::BATCH_SIZE +
+        MAX_MESSAGE_SIZE + 2;
+
+    bool moreToRender() const {
+        return (state_ != DONE || next_rrset_);
+    }
+
+    // Return the next RRset to send, or NULL at the end.  This must be
+    // called with the data locked.
+    ConstRRsetPtr nextRRset() {
+        if (next_rrset_) {
+            return (next_rrset_);
+        }
+        switch (state_) {
+        case FIRST_SOA:
+            state_ = data_.source_.empty() ? DONE : BODY;
+            return (data_.soa_);
+        case BODY:
+            while (true) {
+                const ConstRRsetPtr rrset = data_.source_();
+                if (!rrset) {
+                    state_ = DONE;
+                    return (data_.soa_);
+                }
+                if (!data_.skip_soa_ || rrset->getType() != RRType::SOA()) {
+                    return (rrset);
+                }
+            }
+        case DONE:
+            break;
+        }
+        return (ConstRRsetPtr());
+    }
+
+    // Render one message into the renderer.  It returns false if there's
+    // nothing more to send.  This must be called with the data locked.
+    bool renderMessage() {
+        const size_t tsig_len = tsig_ctx_ ? tsig_ctx_->getTSIGLength() : 0;
+        renderer_.clear();
+        renderer_.setLengthLimit(MAX_MESSAGE_SIZE - tsig_len);
+        renderer_.skip(HEADER_SIZE);
+        // The question is only in the first message (RFC 5936, 2.2).
+        if (first_message_) {
+            question_.toWire(renderer_);
+        }
+
+        // The sources return single RRs (see prepareXfroutData()), so
+        // the length of an RRset is that of one RR.
+        size_t ancount = 0;
+        while ((next_rrset_ = nextRRset())) {
+            if (renderer_.getLength() + next_rrset_->getLength() >
+                renderer_.getLengthLimit()) {
+                if (ancount == 0) {
+                    bundy_throw(bundy::Unexpected, "RR too large to send: " <<
+                                next_rrset_->getName() << "/" <<
+                                next_rrset_->getType());
+                }
+                break;
+            }
+            ancount += next_rrset_->toWire(renderer_);
+            next_rrset_.reset();
+        }
+        if (ancount == 0 && !first_message_) {
+            return (false);
+        }
+
+        renderer_.writeUint16At(qid_, 0);
+        renderer_.writeUint16At(RESPONSE_FLAGS, 2);
+        renderer_.writeUint16At(first_message_ ? 1 : 0, 4);
+        renderer_.writeUint16At(ancount, 6);
+        renderer_.writeUint16At(0, 8);
+        renderer_.writeUint16At(0, 10);
+        if (tsig_ctx_) {
+            // Every message is signed, which is always allowed
+            // (RFC 2845, 4.4).
+            renderer_.setLengthLimit(MAX_MESSAGE_SIZE);
+            const ConstTSIGRecordPtr tsig =
+                tsig_ctx_->sign(qid_, renderer_.getData(),
+                                renderer_.getLength());
+            tsig->toWire(renderer_);
+            renderer_.writeUint16At(1, 10);
+        }
+        first_message_ = false;
+        ++messages_;
+        return (true);
+    }
+
+    // Render the next batch of messages into pending_.  This is called with
+    // the data locked.
+    void renderBatch() {
+        if (!valid_) {
+            aborted_ = true;
+            return;
+        }
+        try {
+            while (moreToRender()) {
+                if (!renderMessage()) {
+                    break;
+                }
+                pending_->writeUint16(renderer_.getLength());
+                pending_->writeData(renderer_.getData(),
+                                    renderer_.getLength());
+                if (pending_->getLength() >= XfroutSession::BATCH_SIZE) {
+                    break;
+                }
+            }
+        } catch (const std::exception& ex) {
+            error_ = ex.what();
+        }
+    }
+
+    // Send the rendered batch (if any) and render the next one.
+    void sendNext() {
+        if (owner_ == NULL) {
+            return;
+        }
+        if (pending_->getLength() == 0 && moreToRender()) {
+            locker_(boost::bind(&XfroutSessionImpl::renderBatch, this));
+        }
+        if (!checkStatus()) {
+            return;
+        }
+        if (pending_->getLength() == 0) {
+            finish();
+            return;
+        }
+
+        pending_.swap(sending_);
+        pending_->clear();
+        asio::async_write(socket_, asio::buffer(sending_->getData(),
+                                                sending_->getLength()),
+                          boost::bind(&XfroutSessionImpl::writeDone,
+                                      shared_from_this(), _1));
+
+        // Prepare the next batch while this one is being sent.
+        if (moreToRender()) {
+            locker_(boost::bind(&XfroutSessionImpl::renderBatch, this));
+        }
+    }
+
+    void writeDone(const asio::error_code& ec) {
+        if (owner_ == NULL) {
+            return;
+        }
+        if (ec) {
+            error_ = ec.message();
+            checkStatus();
+            return;
+        }
+        sendNext();
+    }
+
+    // Abort the transfer if the data were updated or something failed.
+    // It returns false if so.
+    bool checkStatus() {
+        if (aborted_) {
+            LOG_INFO(auth_logger, AUTH_XFROUT_ABORTED)
+                .arg(question_.getType()).arg(remote_)
+                .arg(question_.getName()).arg(question_.getClass());
+        } else if (!error_.empty()) {
+            LOG_WARN(auth_logger, AUTH_XFROUT_FAILED)
+                .arg(question_.getType()).arg(remote_)
+                .arg(question_.getName()).arg(question_.getClass())
+                .arg(error_);
+        } else {
+            return (true);
+        }
+        stop();
+        return (false);
+    }
+
+    void finish() {
+        LOG_INFO(auth_logger, AUTH_XFROUT_DONE)
+            .arg(question_.getType()).arg(remote_)
+            .arg(question_.getName()).arg(question_.getClass())
+            .arg(messages_);
+        stop();
+    }
+
+    // Close the connection and tell the owner.  The owner may destroy
+    // itself, but we're kept alive by the handler that called us.
+    void stop() {
+        asio::error_code ec;
+        socket_.close(ec);
+        locker_(boost::bind(&XfroutSessionImpl::releaseData, this));
+        XfroutSession* const owner = owner_;
+        owner_ = NULL;
+        if (owner != NULL && finished_) {
+            finished_(owner);
+        }
+    }
+
+    // The source may refer to the zone data, so it's released with the
+    // data locked.
+    void releaseData() {
+        data_.source_.clear();
+        data_.life_keeper_.reset();
+        next_rrset_.reset();
+    }
+
+    XfroutSession* owner_;
+    IOService& io_service_;
+    asio::ip::tcp::socket socket_;
+    const string remote_;
+    const Question question_;
+    const qid_t qid_;
+    XfroutData data_;
+    std::unique_ptr<TSIGContext> tsig_ctx_;
+    const XfroutSession::DataLocker locker_;
+    const XfroutSession::FinishedCallback finished_;
+
+    // Cleared (with the data locked exclusively) when the zone is updated
+    bool valid_;
+    // Set when valid_ is found cleared, so it can be checked unlocked
+    bool aborted_;
+
+    State state_;
+    bool first_message_;
+    size_t messages_;
+    string error_;
+    ConstRRsetPtr next_rrset_;  // The one that didn't fit in the last message
+    MessageRenderer renderer_;
+    boost::scoped_ptr<OutputBuffer> pending_; // The next batch to send
+    boost::scoped_ptr<OutputBuffer> sending_; // The batch being sent
+};
+
+const size_t XfroutSession::BATCH_SIZE;
+
+XfroutSession::XfroutSession(IOService& io_service, int fd,
+                             const IOEndpoint& remote, const Message& query,
+                             const XfroutData& data,
+                             std::unique_ptr<TSIGContext> tsig_ctx,
+                             const DataLocker& locker,
+                             const FinishedCallback& finished) :
+    impl_(new XfroutSessionImpl(this, io_service, fd, remote, query, data,
+                                std::move(tsig_ctx), locker, finished))
+{}
+
+XfroutSession::~XfroutSession() {
+    impl_->cancel();
+}
+
+void
+XfroutSession::start() {
+    impl_->start();
+}
+
+void
+XfroutSession::invalidate() {
+    impl_->invalidate();
+}
+
+const Name&
+XfroutSession::getZoneName() const {
+    return (impl_->getQuestion().getName());
+}
+
+const RRClass&
+XfroutSession::getZoneClass() const {
+    return (impl_->getQuestion().getClass());
+}
+
+} // namespace auth
+} // namespace bundy
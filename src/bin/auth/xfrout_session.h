@@ -0,0 +1,166 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef XFROUT_SESSION_H
+#define XFROUT_SESSION_H 1
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_service.h>
+#include <datasrc/client_list.h>
+#include <dns/message.h>
+#include <dns/rcode.h>
+#include <dns/rrset.h>
+#include <dns/tsig.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <memory>
+
+namespace bundy {
+namespace auth {
+
+/// \brief The zone data sent in an outgoing zone transfer.
+struct XfroutData {
+    XfroutData() : skip_soa_(false) {}
+
+    /// \brief The SOA sent at the beginning and at the end.
+    ///
+    /// It's a copy of the SOA of the zone, so it can be used without
+    /// locking the data sources.
+    dns::ConstRRsetPtr soa_;
+
+    /// \brief The RRsets to be sent between the SOAs.
+    ///
+    /// It returns a NULL pointer at the end.  It's empty if only the SOA
+    /// is sent, i.e., for an IXFR of a version the client already has.
+    boost::function<dns::ConstRRsetPtr ()> source_;
+
+    /// \brief Whether the SOA returned by the source is skipped.
+    ///
+    /// This is the case for a zone iterator (AXFR), but not for a journal
+    /// reader (IXFR), whose sequences have their own SOAs.
+    bool skip_soa_;
+
+    /// \brief Keeps the data source client of the source alive.
+    boost::shared_ptr<datasrc::ClientList::FindResult::LifeKeeper>
+        life_keeper_;
+};
+
+/// \brief Find the zone of a zone transfer request and set up its data.
+///
+/// For an AXFR request, it sets up a zone iterator.  For an IXFR request,
+/// it reads the version of the client from the SOA in the authority
+/// section.  If it's not older than ours, only our SOA is sent.  Otherwise,
+/// the differences are read from the journal of the data source, or, if
+/// the journal of a cached zone isn't in the cache, of the data source
+/// it's loaded from.  If the journal doesn't have them, the whole zone is
+/// sent (AXFR-style IXFR).
+///
+/// This must be called with the data source client list locked, as well as
+/// anything done with \c data later, except for using its SOA.
+///
+/// \param list The data source client list of the RR class of the request.
+/// \param query The request.
+/// \param remote The address of the client, for logging.
+/// \param data Set up with the data to send on success.
+/// \return NOERROR on success, or the RCODE of the error response to send:
+/// NOTAUTH if we don't have the zone, FORMERR for an IXFR request without
+/// a single SOA, or SERVFAIL if the zone is broken.
+dns::Rcode prepareXfroutData(const datasrc::ConfigurableClientList& list,
+                             const dns::Message& query,
+                             const asiolink::IOEndpoint& remote,
+                             XfroutData& data);
+
+class XfroutSessionImpl;
+
+/// \brief An outgoing zone transfer served by bundy-auth itself.
+///
+/// It sends the response to an AXFR or IXFR request over the TCP
+/// connection of the request, without handing the connection over to
+/// bundy-xfrout.  As many RRs as fit are packed in each message.
+///
+/// The messages are rendered in batches, each one while the zone data is
+/// locked, so the data source clients can be updated between them.  A batch
+/// is rendered while the previous one is being sent, but not more, so the
+/// transfer can't run ahead of a slow client.  If the zone is updated while
+/// it's being sent, the transfer is aborted by closing the connection (the
+/// client will retry and get the new version).  Everything runs in the
+/// thread of the given \c IOService.
+class XfroutSession : boost::noncopyable {
+public:
+    /// \brief Function calling the given function with the zone data locked.
+    typedef boost::function<void (const boost::function<void ()>&)>
+        DataLocker;
+
+    /// \brief Function called when the transfer is finished.
+    ///
+    /// It's called in the thread of the \c IOService, but not while the
+    /// data is locked.  It may destroy the session.
+    typedef boost::function<void (XfroutSession*)> FinishedCallback;
+
+    /// \brief The approximate size of a batch of rendered messages.
+    static const size_t BATCH_SIZE = 256 * 1024;
+
+    /// \brief Constructor.
+    ///
+    /// \param io_service The service to send the messages from.
+    /// \param fd The socket of the client connection.  A duplicate of it is
+    /// used, so the caller can (and should) close its own.
+    /// \param remote The address of the client.
+    /// \param query The transfer request.
+    /// \param data The data to send, as set up by \c prepareXfroutData().
+    /// \param tsig_ctx The TSIG context of a signed request, used to sign
+    /// the messages; NULL if the request isn't signed.
+    /// \param locker Called to lock the zone data while rendering.
+    /// \param finished Called when the transfer is finished.
+    /// \throw bundy::asiolink::IOError if the socket can't be used.
+    XfroutSession(asiolink::IOService& io_service, int fd,
+                  const asiolink::IOEndpoint& remote,
+                  const dns::Message& query, const XfroutData& data,
+                  std::unique_ptr<dns::TSIGContext> tsig_ctx,
+                  const DataLocker& locker, const FinishedCallback& finished);
+
+    /// \brief Destructor.
+    ///
+    /// If the transfer isn't finished yet, it's aborted, and the finished
+    /// callback isn't called any more.  The zone data it refers to is
+    /// released, so this must be called with the zone data locked (like
+    /// \c invalidate()) unless the transfer is finished.
+    ~XfroutSession();
+
+    /// \brief Start sending the response.
+    void start();
+
+    /// \brief Abort the transfer, as the zone data was updated.
+    ///
+    /// This must be called with the zone data locked (exclusively), e.g.,
+    /// by the data updated callback of the data source clients manager.
+    void invalidate();
+
+    /// \brief The name of the transferred zone.
+    const dns::Name& getZoneName() const;
+
+    /// \brief The RR class of the transferred zone.
+    const dns::RRClass& getZoneClass() const;
+
+private:
+    boost::shared_ptr<XfroutSessionImpl> impl_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // XFROUT_SESSION_H
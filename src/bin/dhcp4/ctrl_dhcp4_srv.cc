@@ -182,6 +182,9 @@ void ControlledDhcpv4Srv::sessionReader(void) {
     // Process one asio event. If there are more events, iface_mgr will call
     // this callback more than once.
     if (server_) {
+        // The configuration and the commands are not handled while the
+        // worker threads, if any, are processing packets.
+        PacketWorkers<Pkt4Ptr>::Pause pause(server_->workers_);
         server_->io_service_.run_one();
     }
 }
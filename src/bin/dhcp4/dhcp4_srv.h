@@ -23,6 +23,7 @@
 #include <dhcp/option_custom.h>
 #include <dhcp_ddns/ncr_msg.h>
 #include <dhcpsrv/d2_client_mgr.h>
+#include <dhcpsrv/packet_workers.h>
 #include <dhcpsrv/subnet.h>
 #include <dhcpsrv/alloc_engine.h>
 #include <hooks/callout_handle.h>
@@ -108,6 +109,20 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Sets the number of threads processing the packets.
+    ///
+    /// By default, the packets are processed by the thread calling @c run.
+    /// If the number is not 0, that thread only receives the packets, and
+    /// they are processed by the given number of worker threads, which are
+    /// started by @c run. The lease database and the hooks callouts are
+    /// used by one thread at a time, and the packets of a client are not
+    /// processed by two threads at once.
+    ///
+    /// @param thread_count Number of worker threads.
+    void setWorkerThreads(size_t thread_count) {
+        worker_threads_ = thread_count;
+    }
+
     /// @brief Return textual type of packet received by server
     ///
     /// Returns the name of valid packet received by the server (e.g. DISCOVER).
@@ -632,10 +647,44 @@ protected:
     /// @return selected subnet (or NULL if no suitable subnet was found)
     bundy::dhcp::Subnet4Ptr selectSubnet(const Pkt4Ptr& question) const;
 
+    /// @brief Processes a received packet.
+    ///
+    /// This is called by @c run for each received packet, in a worker
+    /// thread if the server uses them. It calls @c prepareQuery and then
+    /// @c processQuery, which is serialized with the processing of the
+    /// other packets of the client when workers are used.
+    ///
+    /// @param packet Received packet.
+    void processPacket(const Pkt4Ptr& packet);
+
+    /// @brief Parses and checks a received packet.
+    ///
+    /// Executes the buffer4_receive callouts, unpacks the packet,
+    /// classifies it and checks whether it should be processed.
+    ///
+    /// @param [in,out] query Received packet. It may be replaced by the
+    /// callouts.
+    /// @return true if the packet should be processed, false if it should
+    /// be dropped.
+    bool prepareQuery(Pkt4Ptr& query);
+
+    /// @brief Generates and sends the response to a query.
+    ///
+    /// Executes the pkt4_receive callouts, processes the query according to
+    /// its type and sends the response, if any.
+    ///
+    /// @param query Query accepted by @c prepareQuery.
+    void processQuery(Pkt4Ptr query);
+
     /// indicates if shutdown is in progress. Setting it to true will
     /// initiate server shutdown procedure.
     volatile bool shutdown_;
 
+    /// @brief Worker threads processing the packets.
+    ///
+    /// It is set by @c run while the workers exist, NULL otherwise.
+    PacketWorkers<Pkt4Ptr>* workers_;
+
     /// @brief dummy wrapper around IfaceMgr::receive4
     ///
     /// This method is useful for testing purposes, where its replacement
@@ -705,6 +754,9 @@ private:
     uint16_t port_;  ///< UDP port number on which server listens.
     bool use_bcast_; ///< Should broadcast be enabled on sockets (if true).
 
+    /// Number of worker threads processing the packets (0 for none).
+    size_t worker_threads_;
+
     /// Indexes for registered hook points
     int hook_index_pkt4_receive_;
     int hook_index_subnet4_select_;
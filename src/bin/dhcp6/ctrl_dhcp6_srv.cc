@@ -182,6 +182,9 @@ void ControlledDhcpv6Srv::sessionReader(void) {
     // Process one asio event. If there are more events, iface_mgr will call
     // this callback more than once.
     if (server_) {
+        // The configuration and the commands are not handled while the
+        // worker threads, if any, are processing packets.
+        PacketWorkers<Pkt6Ptr>::Pause pause(server_->workers_);
         server_->io_service_.run_one();
     }
 }
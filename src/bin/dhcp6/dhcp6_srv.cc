@@ -48,6 +48,7 @@
 
 #include <boost/bind.hpp>
 #include <boost/foreach.hpp>
+#include <boost/scoped_ptr.hpp>
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string/erase.hpp>
 
@@ -64,6 +65,7 @@ using namespace bundy::dhcp;
 using namespace bundy::hooks;
 using namespace bundy::util;
 using namespace std;
+using bundy::util::thread::Mutex;
 
 namespace {
 
@@ -97,6 +99,33 @@ struct Dhcp6Hooks {
 // module is called.
 Dhcp6Hooks Hooks;
 
+/// @brief Returns the IA_NA and IA_PD options of a message.
+///
+/// The options are returned in the order they are stored in the message,
+/// i.e., IA_NA options first. If the message was unpacked lazily, other
+/// options are not parsed.
+///
+/// @param pkt the message.
+/// @return collection of the IA_NA and IA_PD options.
+OptionCollection
+getIAs(const Pkt6Ptr& pkt) {
+    OptionCollection ias = pkt->getOptions(D6O_IA_NA);
+    const OptionCollection ia_pds = pkt->getOptions(D6O_IA_PD);
+    ias.insert(ia_pds.begin(), ia_pds.end());
+    return (ias);
+}
+
+/// Number of received packets which may wait for the worker threads, for
+/// each thread.
+const size_t WORKER_QUEUE_SIZE = 256;
+
+/// Sends a name change request to bundy-dhcp-ddns. This is posted to the
+/// main thread by the worker threads, as the sender is not thread safe.
+void
+sendNameChangeRequest(NameChangeRequestPtr ncr) {
+    CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
+}
+
 }; // anonymous namespace
 
 namespace bundy {
@@ -115,7 +144,8 @@ const std::string Dhcpv6Srv::VENDOR_CLASS_PREFIX("VENDOR_CLASS_");
 static const char* SERVER_DUID_FILE = "bundy-dhcp6-serverid";
 
 Dhcpv6Srv::Dhcpv6Srv(uint16_t port)
-:alloc_engine_(), serverid_(), port_(port), shutdown_(true)
+:alloc_engine_(), serverid_(), port_(port), worker_threads_(0),
+ shutdown_(true), workers_(NULL)
 {
 
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_OPEN_SOCKET).arg(port);
@@ -235,6 +265,21 @@ Dhcpv6Srv::testUnicast(const Pkt6Ptr& pkt) const {
 }
 
 bool Dhcpv6Srv::run() {
+    // The workers are stopped when the function returns.
+    boost::scoped_ptr<PacketWorkers<Pkt6Ptr> > workers;
+    if (worker_threads_ > 0) {
+        // The option definitions and the hooks manager are set up on first
+        // use, which must not happen in several workers at once.
+        LibDHCP::getOptionDefs(Option::V6);
+        HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_);
+
+        workers.reset(new PacketWorkers<Pkt6Ptr>(worker_threads_,
+                          worker_threads_ * WORKER_QUEUE_SIZE,
+                          boost::bind(&Dhcpv6Srv::processPacket, this, _1)));
+        workers_ = workers.get();
+        LOG_INFO(dhcp6_logger, DHCP6_WORKERS_STARTED).arg(worker_threads_);
+    }
+
     while (!shutdown_) {
         /// @todo Calculate actual timeout to the next event (e.g. lease
         /// expiration) once we have lease database. The idea here is that
@@ -245,9 +290,8 @@ bool Dhcpv6Srv::run() {
         //cppcheck-suppress variableScope This is temporary anyway
         const int timeout = 1000;
 
-        // client's message and server's response
+        // client's message
         Pkt6Ptr query;
-        Pkt6Ptr rsp;
 
         try {
             query = receivePacket(timeout);
@@ -261,63 +305,114 @@ bool Dhcpv6Srv::run() {
             continue;
         }
 
-        // In order to parse the DHCP options, the server needs to use some
-        // configuration information such as: existing option spaces, option
-        // definitions etc. This is the kind of information which is not
-        // available in the libdhcp, so we need to supply our own implementation
-        // of the option parsing function here, which would rely on the
-        // configuration data.
-        query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
-                                       _3, _4, _5));
+        if (!workers_) {
+            processPacket(query);
+        } else if (!workers_->push(query)) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_WORKERS_QUEUE_FULL)
+                .arg(query->getRemoteAddr().toText())
+                .arg(query->getIface());
+        }
+    }
 
-        bool skip_unpack = false;
+    // The workers use workers_ until they are stopped.
+    workers.reset();
+    workers_ = NULL;
 
-        // The packet has just been received so contains the uninterpreted wire
-        // data; execute callouts registered for buffer6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    return (true);
+}
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+void Dhcpv6Srv::processPacket(const Pkt6Ptr& packet) {
+    Pkt6Ptr query = packet;
+    if (!prepareQuery(query)) {
+        return;
+    }
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+    if (!workers_) {
+        processQuery(query);
+        return;
+    }
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
+    // The client is identified by its DUID, so that its retransmissions
+    // are not processed by two workers at once.
+    PacketWorkers<Pkt6Ptr>::ClientKey key;
+    try {
+        OptionPtr client_id = query->getOption(D6O_CLIENTID);
+        if (client_id) {
+            key = client_id->getData();
+        }
+    } catch (const bundy::Exception&) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_PARSE_FAIL);
+        return;
+    }
+    workers_->processSerialized(key, query,
+                                boost::bind(&Dhcpv6Srv::processQuery, this,
+                                            _1));
+}
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to parse the packet, so skip at this
-            // stage means that callouts did the parsing already, so server
-            // should skip parsing.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
-                skip_unpack = true;
-            }
+bool Dhcpv6Srv::prepareQuery(Pkt6Ptr& query) {
+    // In order to parse the DHCP options, the server needs to use some
+    // configuration information such as: existing option spaces, option
+    // definitions etc. This is the kind of information which is not
+    // available in the libdhcp, so we need to supply our own implementation
+    // of the option parsing function here, which would rely on the
+    // configuration data.
+    query->setCallback(boost::bind(&Dhcpv6Srv::unpackOptions, this, _1, _2,
+                                   _3, _4, _5));
+    // Most options of a query (and of its relays) are never looked at,
+    // so they are only parsed when needed.
+    query->setLazyUnpack(true);
+
+    bool skip_unpack = false;
+
+    // The packet has just been received so contains the uninterpreted wire
+    // data; execute callouts registered for buffer6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_receive_)) {
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
+
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query6", query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_buffer6_receive_, *callout_handle);
 
-            callout_handle->getArgument("query6", query);
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to parse the packet, so skip at this
+        // stage means that callouts did the parsing already, so server
+        // should skip parsing.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_RCVD_SKIP);
+            skip_unpack = true;
         }
 
-        // Unpack the packet information unless the buffer6_receive callouts
-        // indicated they did it
-        if (!skip_unpack) {
-            if (!query->unpack()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
-                          DHCP6_PACKET_PARSE_FAIL);
-                continue;
-            }
+        callout_handle->getArgument("query6", query);
+    }
+
+    // Unpack the packet information unless the buffer6_receive callouts
+    // indicated they did it
+    if (!skip_unpack) {
+        if (!query->unpack()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_PACKET_PARSE_FAIL);
+            return (false);
         }
+    }
+    // Options are unpacked lazily, so a malformed one may only be
+    // found here.
+    try {
         // Check if received query carries server identifier matching
         // server identifier being used by the server.
         if (!testServerID(query)) {
-            continue;
+            return (false);
         }
 
-        // Check if the received query has been sent to unicast or multicast.
-        // The Solicit, Confirm, Rebind and Information Request will be
-        // discarded if sent to unicast address.
+        // Check if the received query has been sent to unicast or
+        // multicast. The Solicit, Confirm, Rebind and Information
+        // Request will be discarded if sent to unicast address.
         if (!testUnicast(query)) {
-            continue;
+            return (false);
         }
 
         LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL, DHCP6_PACKET_RECEIVED)
@@ -326,206 +421,225 @@ bool Dhcpv6Srv::run() {
             .arg(static_cast<int>(query->getType()))
             .arg(query->getBuffer().getLength())
             .arg(query->toText());
+    } catch (const bundy::Exception&) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                  DHCP6_PACKET_PARSE_FAIL);
+        return (false);
+    }
 
-        // At this point the information in the packet has been unpacked into
-        // the various packet fields and option objects has been cretated.
-        // Execute callouts registered for packet6_receive.
-        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
-            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+    return (true);
+}
 
-            // Delete previously set arguments
-            callout_handle->deleteAllArguments();
+void Dhcpv6Srv::processQuery(Pkt6Ptr query) {
+    // server's response
+    Pkt6Ptr rsp;
 
-            // Pass incoming packet as argument
-            callout_handle->setArgument("query6", query);
+    // At this point the information in the packet has been unpacked into
+    // the various packet fields and option objects has been cretated.
+    // Execute callouts registered for packet6_receive.
+    if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_receive_)) {
+        // Callouts may access the options directly, so they must all
+        // be parsed.
+        try {
+            query->unpackOptionViews();
+        } catch (const bundy::Exception&) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL,
+                      DHCP6_PACKET_PARSE_FAIL);
+            return;
+        }
 
-            // Call callouts
-            HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
+        CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-            // Callouts decided to skip the next processing step. The next
-            // processing step would to process the packet, so skip at this
-            // stage means drop.
-            if (callout_handle->getSkip()) {
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
-                continue;
-            }
+        // Delete previously set arguments
+        callout_handle->deleteAllArguments();
 
-            callout_handle->getArgument("query6", query);
+        // Pass incoming packet as argument
+        callout_handle->setArgument("query6", query);
+
+        // Call callouts
+        HooksManager::callCallouts(Hooks.hook_index_pkt6_receive_, *callout_handle);
+
+        // Callouts decided to skip the next processing step. The next
+        // processing step would to process the packet, so skip at this
+        // stage means drop.
+        if (callout_handle->getSkip()) {
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_RCVD_SKIP);
+            return;
         }
 
+        callout_handle->getArgument("query6", query);
+    }
+
+    try {
         // Assign this packet to a class, if possible
         classifyPacket(query);
 
-        try {
-                NameChangeRequestPtr ncr;
-            switch (query->getType()) {
-            case DHCPV6_SOLICIT:
-                rsp = processSolicit(query);
-                    break;
-
-            case DHCPV6_REQUEST:
-                rsp = processRequest(query);
+            NameChangeRequestPtr ncr;
+        switch (query->getType()) {
+        case DHCPV6_SOLICIT:
+            rsp = processSolicit(query);
                 break;
 
-            case DHCPV6_RENEW:
-                rsp = processRenew(query);
-                break;
+        case DHCPV6_REQUEST:
+            rsp = processRequest(query);
+            break;
 
-            case DHCPV6_REBIND:
-                rsp = processRebind(query);
-                break;
+        case DHCPV6_RENEW:
+            rsp = processRenew(query);
+            break;
 
-            case DHCPV6_CONFIRM:
-                rsp = processConfirm(query);
-                break;
+        case DHCPV6_REBIND:
+            rsp = processRebind(query);
+            break;
 
-            case DHCPV6_RELEASE:
-                rsp = processRelease(query);
-                break;
+        case DHCPV6_CONFIRM:
+            rsp = processConfirm(query);
+            break;
 
-            case DHCPV6_DECLINE:
-                rsp = processDecline(query);
-                break;
+        case DHCPV6_RELEASE:
+            rsp = processRelease(query);
+            break;
 
-            case DHCPV6_INFORMATION_REQUEST:
-                rsp = processInfRequest(query);
-                break;
+        case DHCPV6_DECLINE:
+            rsp = processDecline(query);
+            break;
 
-            default:
-                // We received a packet type that we do not recognize.
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
-                    .arg(static_cast<int>(query->getType()))
-                    .arg(query->getIface());
-                // Only action is to output a message if debug is enabled,
-                // and that will be covered by the debug statement before
-                // the "switch" statement.
-                ;
-            }
+        case DHCPV6_INFORMATION_REQUEST:
+            rsp = processInfRequest(query);
+            break;
 
-        } catch (const RFCViolation& e) {
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+        default:
+            // We received a packet type that we do not recognize.
+            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_UNKNOWN_MSG_RECEIVED)
+                .arg(static_cast<int>(query->getType()))
+                .arg(query->getIface());
+            // Only action is to output a message if debug is enabled,
+            // and that will be covered by the debug statement before
+            // the "switch" statement.
+            ;
+        }
 
-        } catch (const bundy::Exception& e) {
+    } catch (const RFCViolation& e) {
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_REQUIRED_OPTIONS_CHECK_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+
+    } catch (const bundy::Exception& e) {
+
+        // Catch-all exception (at least for ones based on the isc
+        // Exception class, which covers more or less all that
+        // are explicitly raised in the BUNDY code).  Just log
+        // the problem and ignore the packet. (The problem is logged
+        // as a debug message because debug is disabled by default -
+        // it prevents a DDOS attack based on the sending of problem
+        // packets.)
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
+            .arg(query->getName())
+            .arg(query->getRemoteAddr().toText())
+            .arg(e.what());
+    }
 
-            // Catch-all exception (at least for ones based on the isc
-            // Exception class, which covers more or less all that
-            // are explicitly raised in the BUNDY code).  Just log
-            // the problem and ignore the packet. (The problem is logged
-            // as a debug message because debug is disabled by default -
-            // it prevents a DDOS attack based on the sending of problem
-            // packets.)
-            LOG_DEBUG(dhcp6_logger, DBG_DHCP6_BASIC, DHCP6_PACKET_PROCESS_FAIL)
-                .arg(query->getName())
-                .arg(query->getRemoteAddr().toText())
-                .arg(e.what());
+    if (rsp) {
+        rsp->setRemoteAddr(query->getRemoteAddr());
+        rsp->setLocalAddr(query->getLocalAddr());
+
+        if (rsp->relay_info_.empty()) {
+            // Direct traffic, send back to the client directly
+            rsp->setRemotePort(DHCP6_CLIENT_PORT);
+        } else {
+            // Relayed traffic, send back to the relay agent
+            rsp->setRemotePort(DHCP6_SERVER_PORT);
         }
 
-        if (rsp) {
-            rsp->setRemoteAddr(query->getRemoteAddr());
-            rsp->setLocalAddr(query->getLocalAddr());
+        rsp->setLocalPort(DHCP6_SERVER_PORT);
+        rsp->setIndex(query->getIndex());
+        rsp->setIface(query->getIface());
 
-            if (rsp->relay_info_.empty()) {
-                // Direct traffic, send back to the client directly
-                rsp->setRemotePort(DHCP6_CLIENT_PORT);
-            } else {
-                // Relayed traffic, send back to the relay agent
-                rsp->setRemotePort(DHCP6_SERVER_PORT);
+        // Specifies if server should do the packing
+        bool skip_pack = false;
+
+        // Server's reply packet now has all options and fields set.
+        // Options are represented by individual objects, but the
+        // output wire data has not been prepared yet.
+        // Execute all callouts registered for packet6_send
+        if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
+            CalloutHandlePtr callout_handle = getCalloutHandle(query);
+
+            // Delete all previous arguments
+            callout_handle->deleteAllArguments();
+
+            // Set our response
+            callout_handle->setArgument("response6", rsp);
+
+            // Call all installed callouts
+            HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
+
+            // Callouts decided to skip the next processing step. The next
+            // processing step would to pack the packet (create wire data).
+            // That step will be skipped if any callout sets skip flag.
+            // It essentially means that the callout already did packing,
+            // so the server does not have to do it again.
+            if (callout_handle->getSkip()) {
+                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
+                skip_pack = true;
+            }
+        }
+
+        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
+                  DHCP6_RESPONSE_DATA)
+            .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
+
+        if (!skip_pack) {
+            try {
+                rsp->pack();
+            } catch (const std::exception& e) {
+                LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
+                    .arg(e.what());
+                return;
             }
 
-            rsp->setLocalPort(DHCP6_SERVER_PORT);
-            rsp->setIndex(query->getIndex());
-            rsp->setIface(query->getIface());
+        }
 
-            // Specifies if server should do the packing
-            bool skip_pack = false;
+        try {
 
-            // Server's reply packet now has all options and fields set.
-            // Options are represented by individual objects, but the
-            // output wire data has not been prepared yet.
-            // Execute all callouts registered for packet6_send
-            if (HooksManager::calloutsPresent(Hooks.hook_index_pkt6_send_)) {
+            // Now all fields and options are constructed into output wire buffer.
+            // Option objects modification does not make sense anymore. Hooks
+            // can only manipulate wire buffer at this stage.
+            // Let's execute all callouts registered for buffer6_send
+            if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
                 CalloutHandlePtr callout_handle = getCalloutHandle(query);
 
-                // Delete all previous arguments
+                // Delete previously set arguments
                 callout_handle->deleteAllArguments();
 
-                // Set our response
+                // Pass incoming packet as argument
                 callout_handle->setArgument("response6", rsp);
 
-                // Call all installed callouts
-                HooksManager::callCallouts(Hooks.hook_index_pkt6_send_, *callout_handle);
+                // Call callouts
+                HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
 
                 // Callouts decided to skip the next processing step. The next
-                // processing step would to pack the packet (create wire data).
-                // That step will be skipped if any callout sets skip flag.
-                // It essentially means that the callout already did packing,
-                // so the server does not have to do it again.
+                // processing step would to parse the packet, so skip at this
+                // stage means drop.
                 if (callout_handle->getSkip()) {
-                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_PACKET_SEND_SKIP);
-                    skip_pack = true;
+                    LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
+                    return;
                 }
+
+                callout_handle->getArgument("response6", rsp);
             }
 
             LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
                       DHCP6_RESPONSE_DATA)
                 .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
 
-            if (!skip_pack) {
-                try {
-                    rsp->pack();
-                } catch (const std::exception& e) {
-                    LOG_ERROR(dhcp6_logger, DHCP6_PACK_FAIL)
-                        .arg(e.what());
-                    continue;
-                }
-
-            }
-
-            try {
-
-                // Now all fields and options are constructed into output wire buffer.
-                // Option objects modification does not make sense anymore. Hooks
-                // can only manipulate wire buffer at this stage.
-                // Let's execute all callouts registered for buffer6_send
-                if (HooksManager::calloutsPresent(Hooks.hook_index_buffer6_send_)) {
-                    CalloutHandlePtr callout_handle = getCalloutHandle(query);
-
-                    // Delete previously set arguments
-                    callout_handle->deleteAllArguments();
-
-                    // Pass incoming packet as argument
-                    callout_handle->setArgument("response6", rsp);
-
-                    // Call callouts
-                    HooksManager::callCallouts(Hooks.hook_index_buffer6_send_, *callout_handle);
-
-                    // Callouts decided to skip the next processing step. The next
-                    // processing step would to parse the packet, so skip at this
-                    // stage means drop.
-                    if (callout_handle->getSkip()) {
-                        LOG_DEBUG(dhcp6_logger, DBG_DHCP6_HOOKS, DHCP6_HOOK_BUFFER_SEND_SKIP);
-                        continue;
-                    }
-
-                    callout_handle->getArgument("response6", rsp);
-                }
-
-                LOG_DEBUG(dhcp6_logger, DBG_DHCP6_DETAIL_DATA,
-                          DHCP6_RESPONSE_DATA)
-                    .arg(static_cast<int>(rsp->getType())).arg(rsp->toText());
-
-                sendPacket(rsp);
-            } catch (const std::exception& e) {
-                LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
-                    .arg(e.what());
-            }
+            sendPacket(rsp);
+        } catch (const std::exception& e) {
+            LOG_ERROR(dhcp6_logger, DHCP6_PACKET_SEND_FAIL)
+                .arg(e.what());
         }
     }
-
-    return (true);
 }
 
 bool Dhcpv6Srv::loadServerID(const std::string& file_name) {
@@ -977,8 +1091,9 @@ Dhcpv6Srv::assignLeases(const Pkt6Ptr& question, Pkt6Ptr& answer) {
     // responses in answer message (ADVERTISE or REPLY).
     //
     // @todo: IA_TA once we implement support for temporary addresses.
-    for (OptionCollection::iterator opt = question->options_.begin();
-         opt != question->options_.end(); ++opt) {
+    OptionCollection ias = getIAs(question);
+    for (OptionCollection::iterator opt = ias.begin(); opt != ias.end();
+         ++opt) {
         switch (opt->second->getType()) {
         case D6O_IA_NA: {
             OptionPtr answer_opt = assignIA_NA(subnet, duid, question, answer,
@@ -1123,7 +1238,11 @@ Dhcpv6Srv::createNameChangeRequests(const Pkt6Ptr& answer) {
                   DHCP6_DDNS_CREATE_ADD_NAME_CHANGE_REQUEST).arg(ncr->toText());
 
         // Post the NCR to the D2ClientMgr.
-        CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
+        if (workers_) {
+            workers_->post(boost::bind(&sendNameChangeRequest, ncr));
+        } else {
+            CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
+        }
 
         /// @todo Currently we create NCR with the first IPv6 address that
         /// is carried in one of the IA_NAs. In the future, the NCR API should
@@ -1185,7 +1304,11 @@ Dhcpv6Srv::createRemovalNameChangeRequest(const Lease6Ptr& lease) {
               DHCP6_DDNS_CREATE_REMOVE_NAME_CHANGE_REQUEST).arg(ncr->toText());
 
     // Post the NCR to the D2ClientMgr.
-    CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
+    if (workers_) {
+        workers_->post(boost::bind(&sendNameChangeRequest, ncr));
+    } else {
+        CfgMgr::instance().getD2ClientMgr().sendRequest(ncr);
+    }
 }
 
 OptionPtr
@@ -1473,6 +1596,8 @@ Dhcpv6Srv::extendIA_NA(const Subnet6Ptr& subnet, const DuidPtr& duid,
         return (ia_rsp);
     }
 
+    // The lease manager is held until the lease has been extended.
+    Mutex::Locker lease_locker(LeaseMgrFactory::instance().getMutex());
     Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
                                                             *duid, ia->getIAID(),
                                                             subnet->getID());
@@ -1661,7 +1786,9 @@ Dhcpv6Srv::extendIA_PD(const Subnet6Ptr& subnet, const DuidPtr& duid,
         }
     }
 
-    // There is a subnet selected. Let's pick the lease.
+    // There is a subnet selected. Let's pick the lease. The lease manager
+    // is held until the lease has been extended.
+    Mutex::Locker lease_locker(LeaseMgrFactory::instance().getMutex());
     Lease6Ptr lease =
         LeaseMgrFactory::instance().getLease6(Lease::TYPE_PD,
                                               *duid, ia->getIAID(),
@@ -1839,8 +1966,9 @@ Dhcpv6Srv::extendLeases(const Pkt6Ptr& query, Pkt6Ptr& reply) {
     }
     DuidPtr duid(new DUID(opt_duid->getData()));
 
-    for (OptionCollection::iterator opt = query->options_.begin();
-         opt != query->options_.end(); ++opt) {
+    OptionCollection ias = getIAs(query);
+    for (OptionCollection::iterator opt = ias.begin(); opt != ias.end();
+         ++opt) {
         switch (opt->second->getType()) {
         case D6O_IA_NA: {
             OptionPtr answer_opt = extendIA_NA(subnet, duid, query, reply,
@@ -1904,8 +2032,9 @@ Dhcpv6Srv::releaseLeases(const Pkt6Ptr& release, Pkt6Ptr& reply) {
     // handled properly. Therefore the releaseIA_NA and releaseIA_PD options
     // may turn the status code to some error, but can't turn it back to success.
     int general_status = STATUS_Success;
-    for (OptionCollection::iterator opt = release->options_.begin();
-         opt != release->options_.end(); ++opt) {
+    OptionCollection ias = getIAs(release);
+    for (OptionCollection::iterator opt = ias.begin(); opt != ias.end();
+         ++opt) {
         switch (opt->second->getType()) {
         case D6O_IA_NA: {
             OptionPtr answer_opt = releaseIA_NA(duid, release, general_status,
@@ -1961,6 +2090,8 @@ Dhcpv6Srv::releaseIA_NA(const DuidPtr& duid, const Pkt6Ptr& query,
         return (ia_rsp);
     }
 
+    // The lease manager is held until the lease has been released.
+    Mutex::Locker lease_locker(LeaseMgrFactory::instance().getMutex());
     Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA,
                                                             release_addr->getAddress());
 
@@ -2113,6 +2244,8 @@ Dhcpv6Srv::releaseIA_PD(const DuidPtr& duid, const Pkt6Ptr& query,
         return (ia_rsp);
     }
 
+    // The lease manager is held until the lease has been released.
+    Mutex::Locker lease_locker(LeaseMgrFactory::instance().getMutex());
     Lease6Ptr lease = LeaseMgrFactory::instance().getLease6(Lease::TYPE_PD,
                                                             release_prefix->getAddress());
 
@@ -2410,22 +2543,18 @@ Dhcpv6Srv::unpackOptions(const OptionBuffer& buf,
     size_t offset = 0;
     size_t length = buf.size();
 
-    OptionDefContainer option_defs;
+    // The definitions are not copied, as this is done for every received
+    // packet.
+    const OptionDefContainer* option_defs = NULL;
+    OptionDefContainerPtr option_defs_ptr;
     if (option_space == "dhcp6") {
         // Get the list of stdandard option definitions.
-        option_defs = LibDHCP::getOptionDefs(Option::V6);
+        option_defs = &LibDHCP::getOptionDefs(Option::V6);
     } else if (!option_space.empty()) {
-        OptionDefContainerPtr option_defs_ptr =
-            CfgMgr::instance().getOptionDefs(option_space);
-        if (option_defs_ptr != NULL) {
-            option_defs = *option_defs_ptr;
-        }
+        option_defs_ptr = CfgMgr::instance().getOptionDefs(option_space);
+        option_defs = option_defs_ptr.get();
     }
 
-    // Get the search index #1. It allows to search for option definitions
-    // using option code.
-    const OptionDefContainerTypeIndex& idx = option_defs.get<1>();
-
     // The buffer being read comprises a set of options, each starting with
     // a two-byte type code and a two-byte length field.
     while (offset + 4 <= length) {
@@ -2457,9 +2586,14 @@ Dhcpv6Srv::unpackOptions(const OptionBuffer& buf,
         // code is non-unique within this container however at this point we
         // expect to get one option definition with the particular code. If more
         // are returned we report an error.
-        const OptionDefContainerTypeRange& range = idx.equal_range(opt_type);
-        // Get the number of returned option definitions for the option code.
-        size_t num_defs = distance(range.first, range.second);
+        OptionDefContainerTypeRange range;
+        size_t num_defs = 0;
+        if (option_defs) {
+            range = option_defs->get<1>().equal_range(opt_type);
+            // Get the number of returned option definitions for the option
+            // code.
+            num_defs = distance(range.first, range.second);
+        }
 
         OptionPtr opt;
         if (num_defs > 1) {
@@ -2570,6 +2704,8 @@ Dhcpv6Srv::generateFqdn(const Pkt6Ptr& answer) {
         // However, never update lease database for Advertise, just send
         // our notion of client's FQDN in the Client FQDN option.
         if (answer->getType() != DHCPV6_ADVERTISE) {
+            Mutex::Locker lease_locker(LeaseMgrFactory::instance().
+                                       getMutex());
             Lease6Ptr lease =
                 LeaseMgrFactory::instance().getLease6(Lease::TYPE_NA, addr);
             if (lease) {
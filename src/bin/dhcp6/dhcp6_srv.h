@@ -25,6 +25,7 @@
 #include <dhcp/pkt6.h>
 #include <dhcpsrv/alloc_engine.h>
 #include <dhcpsrv/d2_client_mgr.h>
+#include <dhcpsrv/packet_workers.h>
 #include <dhcpsrv/subnet.h>
 #include <hooks/callout_handle.h>
 
@@ -100,6 +101,20 @@ public:
     /// @brief Instructs the server to shut down.
     void shutdown();
 
+    /// @brief Sets the number of threads processing the packets.
+    ///
+    /// By default, the packets are processed by the thread calling @c run.
+    /// If the number is not 0, that thread only receives the packets, and
+    /// they are processed by the given number of worker threads, which are
+    /// started by @c run. The lease database and the hooks callouts are
+    /// used by one thread at a time, and the packets of a client are not
+    /// processed by two threads at once.
+    ///
+    /// @param thread_count Number of worker threads.
+    void setWorkerThreads(size_t thread_count) {
+        worker_threads_ = thread_count;
+    }
+
     /// @brief Get UDP port on which server should listen.
     ///
     /// Typically, server listens on UDP port 547. Other ports are only
@@ -557,6 +572,35 @@ protected:
     static std::string duidToString(const OptionPtr& opt);
 
 
+    /// @brief Processes a received packet.
+    ///
+    /// This is called by @c run for each received packet, in a worker
+    /// thread if the server uses them. It calls @c prepareQuery and then
+    /// @c processQuery, which is serialized with the processing of the
+    /// other packets of the client when workers are used.
+    ///
+    /// @param packet Received packet.
+    void processPacket(const Pkt6Ptr& packet);
+
+    /// @brief Parses and checks a received packet.
+    ///
+    /// Executes the buffer6_receive callouts, unpacks the packet and checks
+    /// its server identifier and destination address.
+    ///
+    /// @param [in,out] query Received packet. It may be replaced by the
+    /// callouts.
+    /// @return true if the packet should be processed, false if it should
+    /// be dropped.
+    bool prepareQuery(Pkt6Ptr& query);
+
+    /// @brief Generates and sends the response to a query.
+    ///
+    /// Executes the pkt6_receive callouts, processes the query according to
+    /// its type and sends the response, if any.
+    ///
+    /// @param query Query accepted by @c prepareQuery.
+    void processQuery(Pkt6Ptr query);
+
     /// @brief dummy wrapper around IfaceMgr::receive6
     ///
     /// This method is useful for testing purposes, where its replacement
@@ -671,6 +715,9 @@ private:
     /// UDP port number on which server listens.
     uint16_t port_;
 
+    /// Number of worker threads processing the packets (0 for none).
+    size_t worker_threads_;
+
 protected:
 
     /// Indicates if shutdown is in progress. Setting it to true will
@@ -680,6 +727,11 @@ protected:
     /// Holds a list of @c bundy::dhcp_ddns::NameChangeRequest objects, which
     /// are waiting for sending to bundy-dhcp-ddns module.
     std::queue<bundy::dhcp_ddns::NameChangeRequest> name_change_reqs_;
+
+    /// @brief Worker threads processing the packets.
+    ///
+    /// It is set by @c run while the workers exist, NULL otherwise.
+    PacketWorkers<Pkt6Ptr>* workers_;
 };
 
 }; // namespace bundy::dhcp
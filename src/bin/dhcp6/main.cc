@@ -40,11 +40,15 @@ const char* const DHCP6_NAME = "bundy-dhcp6";
 
 void
 usage() {
-    cerr << "Usage: " << DHCP6_NAME << " [-v] [-s] [-p number]" << endl;
+    cerr << "Usage: " << DHCP6_NAME << " [-a] [-v] [-s] [-p number]"
+         << " [-w number]" << endl;
+    cerr << "  -a: asynchronous logging" << endl;
     cerr << "  -v: verbose output" << endl;
     cerr << "  -s: stand-alone mode (don't connect to BUNDY)" << endl;
     cerr << "  -p number: specify non-standard port number 1-65535 "
          << "(useful for testing only)" << endl;
+    cerr << "  -w number: process packets in the given number of worker "
+         << "threads" << endl;
     exit(EXIT_FAILURE);
 }
 } // end of anonymous namespace
@@ -56,9 +60,17 @@ main(int argc, char* argv[]) {
                                          // useful for testing only.
     bool stand_alone = false;  // Should be connect to BUNDY msgq?
     bool verbose_mode = false; // Should server be verbose?
+    bool async_logging = false; // Should log messages be written
+                                // by a separate thread?
+    int worker_threads = 0;     // Number of threads processing packets,
+                                // 0 to process them in the main thread.
 
-    while ((ch = getopt(argc, argv, "vsp:")) != -1) {
+    while ((ch = getopt(argc, argv, "avsp:w:")) != -1) {
         switch (ch) {
+        case 'a':
+            async_logging = true;
+            break;
+
         case 'v':
             verbose_mode = true;
             break;
@@ -82,6 +94,21 @@ main(int argc, char* argv[]) {
             }
             break;
 
+        case 'w':
+            try {
+                worker_threads = boost::lexical_cast<int>(optarg);
+            } catch (const boost::bad_lexical_cast &) {
+                cerr << "Failed to parse number of worker threads: ["
+                     << optarg << "], 1-1024 allowed." << endl;
+                usage();
+            }
+            if (worker_threads <= 0 || worker_threads > 1024) {
+                cerr << "Failed to parse number of worker threads: ["
+                     << optarg << "], 1-1024 allowed." << endl;
+                usage();
+            }
+            break;
+
         default:
             usage();
         }
@@ -97,6 +124,9 @@ main(int argc, char* argv[]) {
     bundy::log::initLogger(DHCP6_NAME,
                          (verbose_mode ? bundy::log::DEBUG : bundy::log::INFO),
                          bundy::log::MAX_DEBUG_LEVEL, NULL, !stand_alone);
+    if (async_logging) {
+        bundy::log::LoggerManager::setAsync(true);
+    }
     LOG_INFO(dhcp6_logger, DHCP6_STARTING);
     LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_START_INFO)
               .arg(getpid()).arg(port_number).arg(verbose_mode ? "yes" : "no")
@@ -120,6 +150,7 @@ main(int argc, char* argv[]) {
         } else {
             LOG_DEBUG(dhcp6_logger, DBG_DHCP6_START, DHCP6_STANDALONE);
         }
+        server.setWorkerThreads(worker_threads);
         server.run();
         LOG_INFO(dhcp6_logger, DHCP6_SHUTDOWN);
 
@@ -459,6 +459,85 @@ class MsgQTest(unittest.TestCase):
         self.__msgq.process_command_send(sender, routing, data)
         check_delivered(rcpt_socket=another_recipiet)
 
+    def test_binary_wire_format(self):
+        """
+        Test the binary wire format is negotiated on getlname and the
+        messages are converted between the formats of the sender and the
+        recipients.
+        """
+        sent_messages = []
+        def fake_send_prepared_msg(socket, msg):
+            sent_messages.append((socket, msg))
+            return True
+        self.__msgq.send_prepared_msg = fake_send_prepared_msg
+        json_client = 1
+        binary_client = 2
+        self.__msgq.lnames = {'json': json_client, 'binary': binary_client}
+
+        def parse(msg):
+            (length, header_len) = struct.unpack('>IH', msg[:6])
+            return (msg[6:6 + header_len], msg[6 + header_len:])
+
+        # Only the client offering the format gets it confirmed
+        self.__msgq.process_command_getlname(json_client,
+                                             {'type': 'getlname'}, None)
+        self.__msgq.process_command_getlname(binary_client,
+                                             {'type': 'getlname',
+                                              'wire_format': 'binary'},
+                                             None)
+        self.assertEqual(set([binary_client]), self.__msgq.binary_sockets)
+        (header, payload) = parse(sent_messages[0][1])
+        self.assertEqual({'type': 'getlname'},
+                         bundy.cc.message.from_wire(header))
+        self.assertFalse(bundy.cc.message.is_binary(header))
+        (header, payload) = parse(sent_messages[1][1])
+        self.assertEqual({'type': 'getlname', 'wire_format': 'binary'},
+                         bundy.cc.message.from_wire(header))
+        self.assertTrue(bundy.cc.message.is_binary(header))
+        self.assertTrue(bundy.cc.message.is_binary(payload))
+        self.assertEqual({'lname': 'binary'},
+                         bundy.cc.message.from_wire(payload))
+        del sent_messages[:]
+
+        # A message is converted to the format of each recipient, whatever
+        # the format of the sender is.
+        routing = {'to': '*', 'from': 'sender', 'group': 'group',
+                   'instance': '*', 'seq': 42}
+        data = {'data': 'Just some data'}
+        self.__msgq.subs.find = lambda group, instance: [json_client,
+                                                         binary_client]
+        for sender_binary in [False, True]:
+            self.__msgq.process_command_send(3, routing,
+                bundy.cc.message.to_wire(data, sender_binary))
+            self.assertEqual(2, len(sent_messages))
+            for (sock, msg) in sent_messages:
+                (header, payload) = parse(msg)
+                self.assertEqual(sock == binary_client,
+                                 bundy.cc.message.is_binary(header))
+                self.assertEqual(sock == binary_client,
+                                 bundy.cc.message.is_binary(payload))
+                self.assertEqual(routing, bundy.cc.message.from_wire(header))
+                self.assertEqual(data, bundy.cc.message.from_wire(payload))
+            del sent_messages[:]
+
+        # Broken payload is passed as it is
+        self.__msgq.process_command_send(3, routing, b'{"broken')
+        self.assertEqual([b'{"broken', b'{"broken'],
+                         [parse(msg)[1] for (sock, msg) in sent_messages])
+
+        # The format is forgotten with the socket
+        class Sock:
+            def __init__(self, fileno):
+                self.fileno = lambda: fileno
+            def close(self):
+                pass
+        self.__msgq.members_notify = lambda event, params: None
+        sock = Sock(1)
+        self.__msgq.register_socket(sock)
+        self.__msgq.binary_sockets.add(sock)
+        self.__msgq.kill_socket(sock.fileno(), sock)
+        self.assertEqual(set([binary_client]), self.__msgq.binary_sockets)
+
 class DummySocket:
     """
     Dummy socket class.
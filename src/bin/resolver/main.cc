@@ -216,6 +216,11 @@ main(int argc, char* argv[]) {
         cache.update(root_a_rrset);
         cache.update(root_aaaa_rrset);
 
+        // Warm the cache up with what the previous run knew.  Anything
+        // wrong with the dump is logged, and we just start with (more of)
+        // an empty cache.
+        cache.load(RESOLVER_CACHE_DUMP_FILE);
+
         DNSService dns_service(io_service, lookup, answer);
         resolver->setDNSService(dns_service);
         LOG_DEBUG(resolver_logger, RESOLVER_DBG_INIT, RESOLVER_SERVICE_CREATED);
@@ -245,6 +250,9 @@ main(int argc, char* argv[]) {
 
         LOG_INFO(resolver_logger, RESOLVER_STARTED);
         io_service.run();
+
+        // Keep the cache for the next run
+        cache.dump(RESOLVER_CACHE_DUMP_FILE);
     } catch (const std::exception& ex) {
         LOG_FATAL(resolver_logger, RESOLVER_FAILED).arg(ex.what());
         ret = 1;
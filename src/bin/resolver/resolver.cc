@@ -82,6 +82,8 @@ public:
         client_timeout_(4000),
         lookup_timeout_(30000),
         retries_(3),
+        prefetch_min_hits_(5),
+        prefetch_ttl_fraction_(0.1),
         // we apply "reject all" (implicit default of the loader) ACL by
         // default:
         query_acl_(acl::dns::getRequestLoader().load(Element::fromJSON("[]"))),
@@ -192,6 +194,11 @@ public:
     /// Number of retries after timeout
     unsigned retries_;
 
+    /// Number of lookups before a cache entry is prefetched
+    uint32_t prefetch_min_hits_;
+    /// Part of the TTL remaining when a cache entry is prefetched
+    double prefetch_ttl_fraction_;
+
 private:
     /// ACL on incoming queries
     boost::shared_ptr<const RequestACL> query_acl_;
@@ -373,6 +380,8 @@ void
 Resolver::setCache(bundy::cache::ResolverCache& cache)
 {
     cache_ = &cache;
+    cache_->setPrefetchPolicy(impl_->prefetch_min_hits_,
+                              impl_->prefetch_ttl_fraction_);
 }
 
 
@@ -643,6 +652,31 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
             retries = retriesE->intValue();
             set_timeouts = true;
         }
+        bool set_prefetch(false);
+        int64_t prefetch_min_hits = impl_->prefetch_min_hits_;
+        double prefetch_ttl_fraction = impl_->prefetch_ttl_fraction_;
+        const ConstElementPtr
+            prefetch_min_hitsE(config->get("prefetch_min_hits")),
+            prefetch_ttl_fractionE(config->get("prefetch_ttl_fraction"));
+        if (prefetch_min_hitsE) {
+            prefetch_min_hits = prefetch_min_hitsE->intValue();
+            if (prefetch_min_hits < 0 || prefetch_min_hits > 0xffffffffLL) {
+                LOG_ERROR(resolver_logger, RESOLVER_PREFETCH_BAD_VALUE)
+                          .arg("prefetch_min_hits").arg(prefetch_min_hits);
+                bundy_throw(BadValue, "Prefetch hit count out of range");
+            }
+            set_prefetch = true;
+        }
+        if (prefetch_ttl_fractionE) {
+            prefetch_ttl_fraction = prefetch_ttl_fractionE->doubleValue();
+            if (!(prefetch_ttl_fraction >= 0 && prefetch_ttl_fraction <= 1)) {
+                LOG_ERROR(resolver_logger, RESOLVER_PREFETCH_BAD_VALUE)
+                          .arg("prefetch_ttl_fraction")
+                          .arg(prefetch_ttl_fraction);
+                bundy_throw(BadValue, "Prefetch TTL fraction out of range");
+            }
+            set_prefetch = true;
+        }
         // Everything OK, so commit the changes
         // listenAddresses can fail to bind, so try them first
         bool need_query_restart = false;
@@ -663,6 +697,9 @@ Resolver::updateConfig(ConstElementPtr config, bool startup) {
             setTimeouts(qtimeout, ctimeout, ltimeout, retries);
             need_query_restart = true;
         }
+        if (set_prefetch) {
+            setPrefetchPolicy(prefetch_min_hits, prefetch_ttl_fraction);
+        }
         if (query_acl) {
             setQueryACL(query_acl);
         }
@@ -750,6 +787,28 @@ Resolver::getRetries() const {
     return impl_->retries_;
 }
 
+void
+Resolver::setPrefetchPolicy(uint32_t min_hits, double ttl_fraction) {
+    LOG_DEBUG(resolver_logger, RESOLVER_DBG_CONFIG, RESOLVER_SET_PREFETCH)
+              .arg(min_hits).arg(ttl_fraction);
+
+    impl_->prefetch_min_hits_ = min_hits;
+    impl_->prefetch_ttl_fraction_ = ttl_fraction;
+    if (cache_ != NULL) {
+        cache_->setPrefetchPolicy(min_hits, ttl_fraction);
+    }
+}
+
+uint32_t
+Resolver::getPrefetchMinHits() const {
+    return (impl_->prefetch_min_hits_);
+}
+
+double
+Resolver::getPrefetchTTLFraction() const {
+    return (impl_->prefetch_ttl_fraction_);
+}
+
 AddressList
 Resolver::getListenAddresses() const {
     return (impl_->listen_);
@@ -234,6 +234,31 @@ public:
      */
     int getRetries() const;
 
+    /**
+     * \short Set options related to prefetching of the cache entries.
+     *
+     * A cached answer that was returned at least \c min_hits times is
+     * fetched again from the authoritative servers when a lookup finds
+     * less than \c ttl_fraction of its TTL remaining, so popular names
+     * don't drop out of the cache.  The options are passed to the cache
+     * set by \c setCache().
+     *
+     * \param min_hits The number of lookups before an entry is prefetched.
+     * \param ttl_fraction The part of the TTL that remains when the entry
+     *     is prefetched, 0 disables prefetching.
+     */
+    void setPrefetchPolicy(uint32_t min_hits = 5, double ttl_fraction = 0.1);
+
+    /**
+     * \brief Get the number of lookups before a cache entry is prefetched
+     */
+    uint32_t getPrefetchMinHits() const;
+
+    /**
+     * \brief Get the part of the TTL remaining when an entry is prefetched
+     */
+    double getPrefetchTTLFraction() const;
+
     /// Get the query ACL.
     ///
     /// \exception None
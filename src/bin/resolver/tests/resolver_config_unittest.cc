@@ -410,6 +410,41 @@ TEST_F(ResolverConfig, invalidTimeoutsConfig) {
         "}", "Negative number of retries");
 }
 
+TEST_F(ResolverConfig, prefetch) {
+    EXPECT_EQ(5, server.getPrefetchMinHits());
+    EXPECT_DOUBLE_EQ(0.1, server.getPrefetchTTLFraction());
+    server.setPrefetchPolicy(2, 0.5);
+    EXPECT_EQ(2, server.getPrefetchMinHits());
+    EXPECT_DOUBLE_EQ(0.5, server.getPrefetchTTLFraction());
+
+    ConstElementPtr config = Element::fromJSON("{"
+                                               "\"prefetch_min_hits\": 10,"
+                                               "\"prefetch_ttl_fraction\": 0.0"
+                                               "}");
+    ConstElementPtr result(server.updateConfig(config));
+    EXPECT_EQ(result->toWire(), bundy::config::createAnswer()->toWire());
+    EXPECT_EQ(10, server.getPrefetchMinHits());
+    EXPECT_DOUBLE_EQ(0, server.getPrefetchTTLFraction());
+}
+
+TEST_F(ResolverConfig, invalidPrefetchConfig) {
+    invalidTest("{"
+        "\"prefetch_min_hits\": \"error\""
+        "}", "Wrong prefetch hits element type");
+    invalidTest("{"
+        "\"prefetch_min_hits\": -1"
+        "}", "Negative prefetch hits");
+    invalidTest("{"
+        "\"prefetch_ttl_fraction\": \"error\""
+        "}", "Wrong prefetch fraction element type");
+    invalidTest("{"
+        "\"prefetch_ttl_fraction\": -0.1"
+        "}", "Negative prefetch fraction");
+    invalidTest("{"
+        "\"prefetch_ttl_fraction\": 1.5"
+        "}", "Too large prefetch fraction");
+}
+
 TEST_F(ResolverConfig, defaultQueryACL) {
     // If no configuration is loaded, the default ACL should reject everything.
     EXPECT_EQ(REJECT, server.getQueryACL().execute(createRequest("192.0.2.1")));
@@ -19,14 +19,23 @@
 #include <dns_service.h>
 
 #include <asiolink/io_service.h>
+#include <asiolink/io_error.h>
 
 #include <asio.hpp> // xxx_server.h requires this to be included first
 #include <tcp_server.h>
 #include <udp_server.h>
 #include <sync_udp_server.h>
 
+#include <boost/bind.hpp>
 #include <boost/foreach.hpp>
 
+#include <utility>
+#include <vector>
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
 using namespace bundy::asiolink;
 
 namespace bundy {
@@ -50,6 +59,12 @@ public:
     typedef boost::shared_ptr<TCPServer> TCPServerPtr;
     typedef boost::shared_ptr<DNSServer> DNSServerPtr;
     std::vector<DNSServerPtr> servers_;
+    // UDP workers (see DNSService::addUDPWorker()) and the servers running
+    // on them, along with the IOService of the worker.
+    typedef std::pair<IOService*, DNSLookup*> UDPWorker;
+    std::vector<UDPWorker> udp_workers_;
+    typedef std::pair<DNSServerPtr, IOService*> WorkerServer;
+    std::vector<WorkerServer> worker_servers_;
     DNSLookup* lookup_;
     DNSAnswer* answer_;
     size_t tcp_recv_timeout_;
@@ -63,12 +78,62 @@ public:
     // SyncUDPServer has different constructor signature so it cannot be
     // templated.
     void addSyncUDPServerFromFD(int fd, int af) {
+        if (!udp_workers_.empty()) {
+            addWorkerUDPServers(fd, af);
+            return;
+        }
         SyncUDPServerPtr server(SyncUDPServer::create(
                                     io_service_.get_io_service(), fd, af,
                                     lookup_));
         startServer(server);
     }
 
+    // Create a SyncUDPServer for each UDP worker.  The first one takes
+    // the given fd, and the others use a duplicate of it so each server
+    // can own (and close) its descriptor.  The kernel distributes packets
+    // arriving at the shared socket among the servers waiting on it.
+    void addWorkerUDPServers(int fd, int af) {
+        for (size_t i = 0; i < udp_workers_.size(); ++i) {
+            int server_fd = fd;
+            if (i > 0) {
+                server_fd = dup(fd);
+                if (server_fd < 0) {
+                    bundy_throw(IOError, "failed to duplicate UDP socket: " <<
+                                strerror(errno));
+                }
+            }
+            IOService& worker_service = *udp_workers_[i].first;
+            SyncUDPServerPtr server;
+            try {
+                server = SyncUDPServer::create(
+                    worker_service.get_io_service(), server_fd, af,
+                    udp_workers_[i].second);
+            } catch (...) {
+                if (i > 0) {
+                    close(server_fd);
+                }
+                throw;
+            }
+            // The worker may already be running its event loop, so let it
+            // start the server in its own thread.
+            worker_service.post(boost::bind(&DNSServiceImpl::startWorkerServer,
+                                            server));
+            worker_servers_.push_back(WorkerServer(server, &worker_service));
+        }
+    }
+
+    void clearServers() {
+        BOOST_FOREACH(const DNSServerPtr& s, servers_) {
+            s->stop();
+        }
+        servers_.clear();
+        // The servers of workers must be stopped in the worker's thread.
+        BOOST_FOREACH(const WorkerServer& s, worker_servers_) {
+            s.second->post(boost::bind(&DNSServer::stop, s.first));
+        }
+        worker_servers_.clear();
+    }
+
     void setTCPRecvTimeout(size_t timeout) {
         // Store it for future tcp connections
         tcp_recv_timeout_ = timeout;
@@ -80,6 +145,10 @@ public:
     }
 
 private:
+    static void startWorkerServer(DNSServerPtr server) {
+        (*server)();
+    }
+
     void startServer(DNSServerPtr server) {
         server->setTCPRecvTimeout(tcp_recv_timeout_);
         (*server)();
@@ -117,10 +186,27 @@ void DNSService::addServerUDPFromFD(int fd, int af, ServerFlag options) {
 
 void
 DNSService::clearServers() {
-    BOOST_FOREACH(const DNSServiceImpl::DNSServerPtr& s, impl_->servers_) {
-        s->stop();
+    impl_->clearServers();
+}
+
+void
+DNSService::addUDPWorker(IOService& io_service, DNSLookup* lookup) {
+    if (!lookup) {
+        bundy_throw(bundy::InvalidParameter,
+                    "null lookup callback given to a UDP worker");
     }
-    impl_->servers_.clear();
+    impl_->udp_workers_.push_back(DNSServiceImpl::UDPWorker(&io_service,
+                                                            lookup));
+}
+
+void
+DNSService::clearUDPWorkers() {
+    impl_->udp_workers_.clear();
+}
+
+size_t
+DNSService::getUDPWorkerCount() const {
+    return (impl_->udp_workers_.size());
 }
 
 void
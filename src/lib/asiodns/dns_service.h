@@ -84,6 +84,17 @@ public:
                                     ServerFlag options = SERVER_DEFAULT) = 0;
     virtual void clearServers() = 0;
 
+    /// \brief Add a worker to handle UDP queries in a separate thread.
+    ///
+    /// See \c DNSService::addUDPWorker() for details.
+    virtual void addUDPWorker(asiolink::IOService& io_service,
+                              DNSLookup* lookup) = 0;
+
+    /// \brief Remove all UDP workers.
+    ///
+    /// See \c DNSService::clearUDPWorkers() for details.
+    virtual void clearUDPWorkers() = 0;
+
     /// \brief Set the timeout for TCP DNS services
     ///
     /// The timeout is used for incoming TCP connections, so
@@ -185,8 +196,44 @@ public:
                                     ServerFlag options = SERVER_DEFAULT);
 
     /// \brief Remove all servers from the service
+    ///
+    /// Servers running on UDP workers (see \c addUDPWorker()) are stopped
+    /// asynchronously in the context of the worker's \c IOService; the
+    /// caller must keep the worker's event loop running until the stop
+    /// request is handled.
     void clearServers();
 
+    /// \brief Add a worker to handle UDP queries in a separate thread.
+    ///
+    /// Once one or more workers are added, UDP servers subsequently added
+    /// with the \c SERVER_SYNC_OK option are not run on the main
+    /// \c IOService of this object.  Instead, a separate server is created
+    /// for each worker on its \c io_service, sharing the same socket
+    /// (through a duplicated file descriptor), and queries received by that
+    /// server are passed to the worker's \c lookup.  The caller is
+    /// responsible for running the event loop of \c io_service in a
+    /// separate thread, and \c lookup must be safe to be called
+    /// concurrently with the lookups of other workers.
+    ///
+    /// Servers that have already been added are not affected, and UDP
+    /// servers without the \c SERVER_SYNC_OK option are always handled on
+    /// the main \c IOService.
+    ///
+    /// \param io_service The IOService of the worker.
+    /// \param lookup The lookup provider for the worker (must not be NULL).
+    /// \throw bundy::InvalidParameter lookup is NULL.
+    virtual void addUDPWorker(asiolink::IOService& io_service,
+                              DNSLookup* lookup);
+
+    /// \brief Remove all UDP workers.
+    ///
+    /// Servers that are already running on the workers are not affected;
+    /// the caller should normally call \c clearServers() first.
+    virtual void clearUDPWorkers();
+
+    /// \brief Return the number of UDP workers.
+    size_t getUDPWorkerCount() const;
+
     /// \brief Return the native \c io_service object used in this wrapper.
     ///
     /// This is a short term work around to support other BUNDY modules
@@ -27,6 +27,8 @@
 #include <boost/bind.hpp>
 
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -40,15 +42,81 @@ using namespace bundy::asiolink;
 namespace bundy {
 namespace asiodns {
 
+const size_t SyncUDPServer::DEFAULT_MAX_BATCH;
+
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+// Buffers for the batched mode.  Each slot holds one received packet
+// and its answer; the message header arrays are passed to recvmmsg() and
+// sendmmsg() directly.
+struct SyncUDPServer::BatchBuffers {
+    struct Slot {
+        uint8_t data[MAX_LENGTH];
+        struct sockaddr_storage from;
+        struct iovec recv_iov;
+        bundy::util::OutputBufferPtr output;
+    };
+
+    explicit BatchBuffers(size_t size) :
+        slots(size), recv_msgs(size), send_msgs(size), send_iovs(size)
+    {
+        for (size_t i = 0; i < size; ++i) {
+            Slot& slot = slots[i];
+            slot.output.reset(new bundy::util::OutputBuffer(0));
+            slot.recv_iov.iov_base = slot.data;
+            slot.recv_iov.iov_len = MAX_LENGTH;
+        }
+    }
+
+    // Reset the receive headers for the next recvmmsg(); the kernel
+    // overwrites the address lengths.
+    void prepareReceive() {
+        memset(&recv_msgs[0], 0, sizeof(recv_msgs[0]) * recv_msgs.size());
+        for (size_t i = 0; i < slots.size(); ++i) {
+            struct msghdr& hdr = recv_msgs[i].msg_hdr;
+            hdr.msg_name = &slots[i].from;
+            hdr.msg_namelen = sizeof(slots[i].from);
+            hdr.msg_iov = &slots[i].recv_iov;
+            hdr.msg_iovlen = 1;
+        }
+    }
+
+    // Queue the answer of the given slot at the given position of the
+    // send headers.
+    void prepareSend(size_t slot_id, size_t pos) {
+        Slot& slot = slots[slot_id];
+        send_iovs[pos].iov_base =
+            const_cast<void*>(slot.output->getData());
+        send_iovs[pos].iov_len = slot.output->getLength();
+        memset(&send_msgs[pos], 0, sizeof(send_msgs[pos]));
+        struct msghdr& hdr = send_msgs[pos].msg_hdr;
+        hdr.msg_name = &slot.from;
+        hdr.msg_namelen = recv_msgs[slot_id].msg_hdr.msg_namelen;
+        hdr.msg_iov = &send_iovs[pos];
+        hdr.msg_iovlen = 1;
+    }
+
+    std::vector<Slot> slots;
+    std::vector<struct mmsghdr> recv_msgs;
+    std::vector<struct mmsghdr> send_msgs;
+    std::vector<struct iovec> send_iovs;
+};
+#else
+// Batching isn't supported; this is just a placeholder.
+struct SyncUDPServer::BatchBuffers {
+};
+#endif
+
 SyncUDPServerPtr
 SyncUDPServer::create(asio::io_service& io_service, const int fd,
-                      const int af, DNSLookup* lookup)
+                      const int af, DNSLookup* lookup, size_t max_batch)
 {
-    return (SyncUDPServerPtr(new SyncUDPServer(io_service, fd, af, lookup)));
+    return (SyncUDPServerPtr(new SyncUDPServer(io_service, fd, af, lookup,
+                                               max_batch)));
 }
 
 SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
-                             const int af, DNSLookup* lookup) :
+                             const int af, DNSLookup* lookup,
+                             size_t max_batch) :
     output_buffer_(new bundy::util::OutputBuffer(0)),
     query_(new bundy::dns::Message(bundy::dns::Message::PARSE)),
     udp_endpoint_(sender_), lookup_callback_(lookup),
@@ -62,6 +130,10 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
         bundy_throw(InvalidParameter, "null lookup callback given to "
                   "SyncUDPServer");
     }
+    if (max_batch == 0) {
+        bundy_throw(InvalidParameter, "batch size of SyncUDPServer must "
+                  "not be 0");
+    }
     LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_FD_ADD_UDP).arg(fd);
     try {
         socket_.reset(new asio::ip::udp::socket(io_service));
@@ -73,10 +145,37 @@ SyncUDPServer::SyncUDPServer(asio::io_service& io_service, const int fd,
         bundy_throw(IOError, exception.what());
     }
     udp_socket_.reset(new UDPSocket<DummyIOCallback>(*socket_));
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+    if (max_batch > 1) {
+        batch_.reset(new BatchBuffers(max_batch));
+    }
+#endif
+}
+
+SyncUDPServer::~SyncUDPServer() {
+}
+
+size_t
+SyncUDPServer::getMaxBatch() const {
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+    if (batch_) {
+        return (batch_->slots.size());
+    }
+#endif
+    return (1);
 }
 
 void
 SyncUDPServer::scheduleRead() {
+    if (batch_) {
+        // In the batched mode we only wait for the socket to be readable
+        // and read the packets ourselves.
+        socket_->async_receive(
+            asio::null_buffers(),
+            boost::bind(&SyncUDPServer::handleReadBatch, shared_from_this(),
+                        _1));
+        return;
+    }
     socket_->async_receive_from(
         asio::mutable_buffers_1(data_, MAX_LENGTH), sender_,
         boost::bind(&SyncUDPServer::handleRead, shared_from_this(), _1, _2));
@@ -146,6 +245,113 @@ SyncUDPServer::handleRead(const asio::error_code& ec, const size_t length) {
     scheduleRead();
 }
 
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+void
+SyncUDPServer::handleReadBatch(const asio::error_code& ec) {
+    if (stopped_) {
+        // See handleRead().
+        assert(socket_ && !socket_->is_open());
+        return;
+    }
+    if (ec) {
+        using namespace asio::error;
+        const asio::error_code::value_type err_val = ec.value();
+
+        if (err_val == operation_aborted || err_val == bad_descriptor) {
+            return;
+        }
+        if (err_val != would_block && err_val != try_again &&
+            err_val != interrupted) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).arg(ec.message());
+        }
+        scheduleRead();
+        return;
+    }
+
+    // Receive whatever is available, up to the batch size, without
+    // blocking.
+    const int fd = socket_->native();
+    batch_->prepareReceive();
+    const int received = recvmmsg(fd, &batch_->recv_msgs[0],
+                                  batch_->recv_msgs.size(), MSG_DONTWAIT,
+                                  NULL);
+    if (received < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            LOG_ERROR(logger, ASIODNS_UDP_SYNC_RECEIVE_FAIL).
+                arg(strerror(errno));
+        }
+        scheduleRead();
+        return;
+    }
+
+    // Handle the packets in order, collecting the answers.
+    size_t n_answers = 0;
+    for (int i = 0; i < received; ++i) {
+        BatchBuffers::Slot& slot = batch_->slots[i];
+        const size_t length = batch_->recv_msgs[i].msg_len;
+        const socklen_t from_len = batch_->recv_msgs[i].msg_hdr.msg_namelen;
+        if (length == 0 || from_len > sender_.capacity()) {
+            continue;
+        }
+        memcpy(sender_.data(), &slot.from, from_len);
+        sender_.resize(from_len);
+
+        // See handleRead() about the buffers.
+        slot.output->clear();
+        done_ = false;
+        resume_called_ = false;
+
+        const IOMessage message(slot.data, length, *udp_socket_,
+                                udp_endpoint_);
+        (*lookup_callback_)(message, query_, answer_, slot.output, this);
+
+        if (!resume_called_) {
+            bundy_throw(bundy::Unexpected,
+                      "No resume called from the lookup callback");
+        }
+        if (stopped_) {
+            // The server was stopped in the callback; we must not touch
+            // the socket any more.
+            return;
+        }
+        if (done_) {
+            batch_->prepareSend(i, n_answers++);
+        }
+    }
+
+    // Send all the answers.  If sending one of them fails, log it and
+    // continue with the rest.
+    size_t sent = 0;
+    while (sent < n_answers) {
+        const int n = sendmmsg(fd, &batch_->send_msgs[sent],
+                               n_answers - sent, 0);
+        if (n > 0) {
+            sent += n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        const struct msghdr& hdr = batch_->send_msgs[sent].msg_hdr;
+        memcpy(sender_.data(), hdr.msg_name, hdr.msg_namelen);
+        sender_.resize(hdr.msg_namelen);
+        LOG_ERROR(logger, ASIODNS_UDP_SYNC_SEND_FAIL).
+            arg(sender_.address().to_string()).
+            arg(n < 0 ? strerror(errno) : "no packet sent");
+        ++sent;
+    }
+
+    // And schedule handling another socket.
+    scheduleRead();
+}
+#else
+void
+SyncUDPServer::handleReadBatch(const asio::error_code&) {
+    // batch_ is never set in this case.
+    assert(false);
+}
+#endif
+
 void
 SyncUDPServer::operator()(asio::error_code, size_t) {
     // To start the server, we just schedule reading of data when they
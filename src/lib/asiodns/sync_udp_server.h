@@ -63,9 +63,19 @@ private:
     ///
     /// This is hidden as private (see the class description).
     SyncUDPServer(asio::io_service& io_service, const int fd, const int af,
-                  DNSLookup* lookup);
+                  DNSLookup* lookup, size_t max_batch);
 
 public:
+    /// \brief The default maximum number of packets handled per wakeup.
+    ///
+    /// This is used only if the system supports \c recvmmsg() and
+    /// \c sendmmsg(); otherwise the server always handles one packet at
+    /// a time.
+    static const size_t DEFAULT_MAX_BATCH = 32;
+
+    /// \brief Destructor.
+    ~SyncUDPServer();
+
     /// \brief Factory of SyncUDPServer object in the form of shared_ptr.
     ///
     /// Due to the nature of this server, it's meaningless if the lookup
@@ -77,18 +87,29 @@ public:
     /// complete answer is built in the lookup callback (it's the user's
     /// responsibility to guarantee that condition).
     ///
+    /// If \c max_batch is larger than 1 and the system supports
+    /// \c recvmmsg() and \c sendmmsg(), the server receives up to
+    /// \c max_batch packets at once every time the socket becomes readable,
+    /// calls the lookup callback for each of them in order, and sends all
+    /// the answers with a single system call.  Buffers for the whole batch
+    /// are allocated on construction.  Otherwise packets are received and
+    /// answered one by one.
+    ///
     /// \param io_service the asio::io_service to work with
     /// \param fd the file descriptor of opened UDP socket
     /// \param af address family, either AF_INET or AF_INET6
     /// \param lookup the callbackprovider for DNS lookup events (must not be
     ///        NULL)
+    /// \param max_batch the maximum number of packets handled per wakeup
+    ///        (must not be 0)
     ///
     /// \throw bundy::InvalidParameter if af is neither AF_INET nor AF_INET6
-    /// \throw bundy::InvalidParameter lookup is NULL
+    /// \throw bundy::InvalidParameter lookup is NULL or max_batch is 0
     /// \throw bundy::asiolink::IOError when a low-level error happens, like the
     ///     fd is not a valid descriptor.
     static SyncUDPServerPtr create(asio::io_service& io_service, const int fd,
-                                   const int af, DNSLookup* lookup);
+                                   const int af, DNSLookup* lookup,
+                                   size_t max_batch = DEFAULT_MAX_BATCH);
 
     /// \brief Start the SyncUDPServer.
     ///
@@ -136,6 +157,11 @@ public:
     virtual DNSServer* clone() {
         bundy_throw(Unexpected, "SyncUDPServer can't be cloned.");
     }
+
+    /// \brief Return the number of packets handled per wakeup at most.
+    ///
+    /// This is 1 if batching is disabled or not supported by the system.
+    size_t getMaxBatch() const;
 private:
     // Internal state & buffers. We don't use the PIMPL idiom, as this class
     // isn't usually used directly anyway.
@@ -176,6 +202,11 @@ private:
     // Placeholder for error code object.  It will be passed to ASIO library
     // to have it set in case of error.
     asio::error_code ec_;
+    // Preallocated per packet buffers and message headers used in the
+    // batched mode; NULL if packets are handled one by one.  Details are
+    // hidden in the implementation as they depend on the system.
+    struct BatchBuffers;
+    boost::scoped_ptr<BatchBuffers> batch_;
 
     // Auxiliary functions
 
@@ -185,6 +216,10 @@ private:
     // Callback from the socket's read call (called when there's an error or
     // when a new packet comes).
     void handleRead(const asio::error_code& ec, const size_t length);
+    // Callback in the batched mode, called when the socket becomes readable
+    // (or on error).  It receives and handles as many packets as possible
+    // up to the batch size.
+    void handleReadBatch(const asio::error_code& ec);
 };
 
 } // namespace asiodns
@@ -23,9 +23,13 @@
 #include <asiodns/tcp_server.h>
 #include <asiodns/logger.h>
 
+#include <boost/bind.hpp>
+#include <boost/enable_shared_from_this.hpp>
+#include <boost/function.hpp>
 #include <boost/shared_array.hpp>
 
 #include <cassert>
+#include <deque>
 #include <unistd.h>             // for some IPC/network system calls
 #include <netinet/in.h>
 #include <sys/socket.h>
@@ -52,7 +56,7 @@ namespace asiodns {
 TCPServer::TCPServer(io_service& io_service, int fd, int af,
                      const DNSLookup* lookup,
                      const DNSAnswer* answer) :
-    io_(io_service), done_(false),
+    io_(io_service), query_length_(0), done_(false),
     lookup_callback_(lookup),
     answer_callback_(answer)
 {
@@ -74,31 +78,197 @@ TCPServer::TCPServer(io_service& io_service, int fd, int af,
     // Set it to some value. It should be set to the right one
     // immediately, but set it to something non-zero just in case.
     tcp_recv_timeout_.reset(new size_t(5000));
+    max_connections_.reset(new size_t(DEFAULT_MAX_CONNECTIONS));
+    max_pipelined_queries_.reset(new size_t(DEFAULT_MAX_PIPELINED_QUERIES));
+    connection_count_.reset(new size_t(0));
+    connections_.reset(new std::set<Connection*>);
 }
 
-namespace {
-// Called by the timeout_ deadline timer if the client takes too long.
-// If not aborted, cancels the given socket
-// (in which case TCPServer::operator() will be called to continue,
-// with an 'aborted' error code.)
-void doTimeOut(boost::shared_ptr<asio::ip::tcp::socket> socket,
-               const asio::error_code& error)
+const size_t TCPServer::DEFAULT_MAX_CONNECTIONS;
+const size_t TCPServer::DEFAULT_MAX_PIPELINED_QUERIES;
+
+/// The state of a single client connection.
+///
+/// The coroutine reading queries from the connection and the ones
+/// processing them share this object, and it lives as long as any of them
+/// (or a pending timer or write on it) does.  It keeps count of the
+/// queries in progress, sends the responses one after another in the
+/// order they are ready, and closes the connection once it's not used any
+/// more.  While it's open, it's registered in the set of connections of
+/// the server, so stopping the server can close it.  Everything runs in
+/// the thread of the io_service, so there's no locking.
+class TCPServer::Connection :
+    public boost::enable_shared_from_this<TCPServer::Connection>
 {
-    if (error != asio::error::operation_aborted) {
-        socket->cancel();
+public:
+    Connection(io_service& io, const boost::shared_ptr<tcp::socket>& socket,
+               const boost::shared_ptr<size_t>& max_queries,
+               const boost::shared_ptr<size_t>& connection_count,
+               const boost::shared_ptr<std::set<Connection*> >& connections) :
+        io_(io), socket_(socket), timer_(io), max_queries_(max_queries),
+        connection_count_(connection_count), connections_(connections),
+        timeout_(0), queries_(0), reading_(true), writing_(false),
+        closed_(false), lenbuf_(TCP_MESSAGE_LENGTHSIZE)
+    {
+        connections_->insert(this);
     }
-}
-}
 
-void
-TCPServer::operator()(asio::error_code ec, size_t length) {
-    /// Because the coroutine reentry block is implemented as
-    /// a switch statement, inline variable declarations are not
-    /// permitted.  Certain variables used below can be declared here.
+    ~Connection() {
+        close();
+    }
+
+    /// (Re)start the idle timer, before reading the next query.  It's not
+    /// started if timeout is 0.
+    void startIdleTimer(size_t timeout) {
+        timeout_ = timeout;
+        if (timeout_ > 0 && !closed_) {
+            timer_.expires_from_now(boost::posix_time::milliseconds(timeout_));
+            timer_.async_wait(boost::bind(&Connection::idleTimeout,
+                                          shared_from_this(),
+                                          asio::placeholders::error));
+        }
+    }
+
+    /// Whether another query can be read before some of those in progress
+    /// are done.
+    bool canRead() const {
+        return (*max_queries_ == 0 || queries_ < *max_queries_);
+    }
+
+    /// Keep the given reader until a query is done and another one can be
+    /// read.  It's dropped if the connection is closed meanwhile.
+    void pauseReading(const boost::function<void()>& reader) {
+        paused_reader_ = reader;
+    }
+
+    /// The reader read a query and starts processing it.
+    void queryStarted() {
+        ++queries_;
+    }
+
+    /// Processing of a query is done, its response (if any) has been
+    /// passed to send() already.
+    void queryDone() {
+        --queries_;
+        if (paused_reader_ && canRead()) {
+            io_.post(paused_reader_);
+            paused_reader_.clear();
+        }
+        closeIfUnused();
+    }
+
+    /// The reader stopped, because the client closed the connection or
+    /// something failed.  The connection is closed once the queries in
+    /// progress are answered.
+    void readDone() {
+        reading_ = false;
+        closeIfUnused();
+    }
+
+    /// Send a response.  If another one is being sent, it's queued after
+    /// that one.
+    void send(const OutputBufferPtr& response) {
+        if (closed_) {
+            return;
+        }
+        responses_.push_back(response);
+        if (!writing_) {
+            writeNext();
+        }
+    }
+
+    void close() {
+        if (closed_) {
+            return;
+        }
+        closed_ = true;
+        paused_reader_.clear();
+        --*connection_count_;
+        connections_->erase(this);
+
+        asio::error_code ec;
+        timer_.cancel(ec);
+        socket_->close(ec);
+        if (ec) {
+            // close() should be unlikely to fail, but we've seen it fail
+            // once, so we log the event (at the lowest level of debug).
+            LOG_DEBUG(logger, 0, ASIODNS_TCP_CLOSE_FAIL).arg(ec.message());
+        }
+    }
+
+    bool isClosed() const {
+        return (closed_);
+    }
+
+private:
+    void closeIfUnused() {
+        if (!reading_ && queries_ == 0 && !writing_) {
+            close();
+        }
+    }
+
+    // Called by the timer_ if no query came within the timeout.  The
+    // connection is only idle if nothing is being done on it; otherwise
+    // we wait another round.  Closing the socket makes the reader stop.
+    void idleTimeout(const asio::error_code& error) {
+        if (error == asio::error::operation_aborted || closed_) {
+            return;
+        }
+        if (queries_ > 0 || writing_) {
+            startIdleTimer(timeout_);
+        } else {
+            close();
+        }
+    }
+
+    void writeNext() {
+        writing_ = true;
+        const OutputBufferPtr& response = responses_.front();
+        lenbuf_.clear();
+        lenbuf_.writeUint16(response->getLength());
+        boost::array<const_buffer, 2> bufs;
+        bufs[0] = buffer(lenbuf_.getData(), lenbuf_.getLength());
+        bufs[1] = buffer(response->getData(), response->getLength());
+        async_write(*socket_, bufs,
+                    boost::bind(&Connection::writeDone, shared_from_this(),
+                                asio::placeholders::error));
+    }
+
+    void writeDone(const asio::error_code& error) {
+        writing_ = false;
+        responses_.pop_front();
+        if (closed_) {
+            return;
+        }
+        if (error) {
+            LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_TCP_WRITE_FAIL).
+                arg(error.message());
+            close();
+        } else if (!responses_.empty()) {
+            writeNext();
+        } else {
+            closeIfUnused();
+        }
+    }
 
-    boost::array<const_buffer,2> bufs;
-    OutputBuffer lenbuf(TCP_MESSAGE_LENGTHSIZE);
+    io_service& io_;
+    const boost::shared_ptr<tcp::socket> socket_;
+    asio::deadline_timer timer_;
+    const boost::shared_ptr<size_t> max_queries_;
+    const boost::shared_ptr<size_t> connection_count_;
+    const boost::shared_ptr<std::set<Connection*> > connections_;
+    size_t timeout_;
+    size_t queries_;
+    bool reading_;
+    bool writing_;
+    bool closed_;
+    boost::function<void()> paused_reader_;
+    std::deque<OutputBufferPtr> responses_;
+    OutputBuffer lenbuf_;
+};
 
+void
+TCPServer::operator()(asio::error_code ec, size_t length) {
     CORO_REENTER (this) {
         do {
             /// Create a socket to listen for connections (no-throw operation)
@@ -134,54 +304,83 @@ TCPServer::operator()(asio::error_code ec, size_t length) {
                 }
             } while (ec);
 
-            /// Fork the coroutine by creating a copy of this one and
-            /// scheduling it on the ASIO service queue.  The parent
-            /// will continue listening for DNS connections while the child
-            /// handles the one that has just arrived.
-            CORO_FORK io_.post(TCPServer(*this));
+            if (*max_connections_ > 0 &&
+                *connection_count_ >= *max_connections_) {
+                // Too many clients already, refuse this one.
+                LOG_DEBUG(logger, DBGLVL_TRACE_BASIC,
+                          ASIODNS_TCP_TOO_MANY_CONNECTIONS).
+                    arg(*max_connections_);
+                socket_->close(ec);
+            } else {
+                /// Fork the coroutine by creating a copy of this one and
+                /// scheduling it on the ASIO service queue.  The parent
+                /// will continue listening for DNS connections while the
+                /// child handles the one that has just arrived.
+                ++*connection_count_;
+                CORO_FORK io_.post(TCPServer(*this));
+            }
         } while (is_parent());
 
         // From this point, we'll simply return on error, which will
-        // immediately trigger destroying this object, cleaning up all
-        // resources including any open sockets.
-
-        /// Instantiate the data buffer that will be used by the
-        /// asynchronous read call.
-        data_.reset(new char[MAX_LENGTH]);
-
-        /// Start a timer to drop the connection if it is idle.  note that
-        // we pass a shared_ptr of the socket object so that it won't be
-        // destroyed at least until the timeout callback (including abort)
-        // is called.
-        if (*tcp_recv_timeout_ > 0) {
-            timeout_.reset(new asio::deadline_timer(io_)); // shouldn't throw
-            timeout_->expires_from_now( // consider any exception fatal.
-                boost::posix_time::milliseconds(*tcp_recv_timeout_));
-            timeout_->async_wait(boost::bind(&doTimeOut, socket_,
-                                             asio::placeholders::error));
-        }
+        // immediately trigger destroying this object.  The connection is
+        // closed when the last coroutine working on it is gone.
+        connection_.reset(new Connection(io_, socket_, max_pipelined_queries_,
+                                         connection_count_, connections_));
+
+        /// Read queries from the connection until the client closes it or
+        /// it's idle for too long.  Each of them is processed by a fork of
+        /// the coroutine, while the parent goes on reading the next one.
+        do {
+            // With the maximum number of queries in progress, wait until
+            // one of them is done.
+            if (!connection_->canRead()) {
+                CORO_YIELD connection_->pauseReading(
+                    boost::bind<void>(TCPServer(*this), asio::error_code(), 0));
+                if (connection_->isClosed()) {
+                    return;
+                }
+            }
 
-        /// Read the message, in two parts.  First, the message length:
-        CORO_YIELD async_read(*socket_, asio::buffer(data_.get(),
-                              TCP_MESSAGE_LENGTHSIZE), *this);
-        if (ec) {
-            LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_TCP_READLEN_FAIL).
-                arg(ec.message());
-            return;
-        }
+            /// Instantiate the data buffer that will be used by the
+            /// asynchronous read call.  Every query gets its own one, as
+            /// the previous one may still be in use.
+            data_.reset(new char[MAX_LENGTH]);
 
-        /// Now read the message itself. (This is done in a different scope
-        /// to allow inline variable declarations.)
-        CORO_YIELD {
-            InputBuffer dnsbuffer(data_.get(), length);
-            const uint16_t msglen = dnsbuffer.readUint16();
-            async_read(*socket_, asio::buffer(data_.get(), msglen), *this);
-        }
-        if (ec) {
-            LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_TCP_READDATA_FAIL).
-                arg(ec.message());
-            return;
-        }
+            /// Start the timer to drop the connection if it is idle.
+            connection_->startIdleTimer(*tcp_recv_timeout_);
+
+            /// Read the message, in two parts.  First, the message length:
+            CORO_YIELD async_read(*socket_, asio::buffer(data_.get(),
+                                  TCP_MESSAGE_LENGTHSIZE), *this);
+            if (ec) {
+                // End of file is the client closing the connection, the
+                // normal way to finish.
+                if (ec != asio::error::eof) {
+                    LOG_DEBUG(logger, DBGLVL_TRACE_BASIC,
+                              ASIODNS_TCP_READLEN_FAIL).arg(ec.message());
+                }
+                connection_->readDone();
+                return;
+            }
+
+            /// Now read the message itself. (This is done in a different
+            /// scope to allow inline variable declarations.)
+            CORO_YIELD {
+                InputBuffer dnsbuffer(data_.get(), length);
+                const uint16_t msglen = dnsbuffer.readUint16();
+                async_read(*socket_, asio::buffer(data_.get(), msglen), *this);
+            }
+            if (ec) {
+                LOG_DEBUG(logger, DBGLVL_TRACE_BASIC,
+                          ASIODNS_TCP_READDATA_FAIL).arg(ec.message());
+                connection_->readDone();
+                return;
+            }
+            query_length_ = length;
+
+            connection_->queryStarted();
+            CORO_FORK io_.post(TCPServer(*this));
+        } while (is_parent());
 
         // Create an \c IOMessage object to store the query.
         //
@@ -192,6 +391,7 @@ TCPServer::operator()(asio::error_code ec, size_t length) {
         if (ec) {
             LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_TCP_GETREMOTE_FAIL).
                 arg(ec.message());
+            connection_->queryDone();
             return;
         }
 
@@ -202,12 +402,13 @@ TCPServer::operator()(asio::error_code ec, size_t length) {
         // the underlying Boost TCP socket - DummyIOCallback is used.  This
         // provides the appropriate operator() but is otherwise functionless.
         iosock_.reset(new TCPSocket<DummyIOCallback>(*socket_));
-        io_message_.reset(new IOMessage(data_.get(), length, *iosock_,
+        io_message_.reset(new IOMessage(data_.get(), query_length_, *iosock_,
                                         *peer_));
 
         // If we don't have a DNS Lookup provider, there's no point in
         // continuing; we exit the coroutine permanently.
         if (lookup_callback_ == NULL) {
+            connection_->queryDone();
             return;
         }
 
@@ -226,17 +427,13 @@ TCPServer::operator()(asio::error_code ec, size_t length) {
         assert(!ec);
 
         // The 'done_' flag indicates whether we have an answer
-        // to send back.  If not, exit the coroutine permanently.
+        // to send back.  If not, close the connection and exit the
+        // coroutine permanently.  The query was either dropped, or the
+        // socket was handed over to someone else (like a zone transfer
+        // request), who must be the only one reading from it from now on.
         if (!done_) {
-            // Explicitly close() isn't necessary for most cases. But for the
-            // very connection, socket_ is shared with the original owner of
-            // the server object and would stay open.
-            // TODO: should we keep the connection open for a short time
-            // to see if new requests come in?
-            socket_->close(ec);
-            if (ec) {
-                LOG_DEBUG(logger, 0, ASIODNS_TCP_CLOSE_FAIL).arg(ec.message());
-            }
+            connection_->close();
+            connection_->queryDone();
             return;
         }
 
@@ -245,32 +442,11 @@ TCPServer::operator()(asio::error_code ec, size_t length) {
         (*answer_callback_)(*io_message_, query_message_, answer_message_,
                             respbuf_);
 
-        // Set up the response, beginning with two length bytes.
-        lenbuf.writeUint16(respbuf_->getLength());
-        bufs[0] = buffer(lenbuf.getData(), lenbuf.getLength());
-        bufs[1] = buffer(respbuf_->getData(), respbuf_->getLength());
-
-        // Begin an asynchronous send, and then yield.  When the
-        // send completes, we will resume immediately after this point
-        // (though we have nothing further to do, so the coroutine
-        // will simply exit at that time).
-        CORO_YIELD async_write(*socket_, bufs, *this);
-        if (ec) {
-            LOG_DEBUG(logger, DBGLVL_TRACE_BASIC, ASIODNS_TCP_WRITE_FAIL).
-                arg(ec.message());
-        }
-
-        // All done, cancel the timeout timer. if it throws, consider it fatal.
-        timeout_->cancel();
-
-        // TODO: should we keep the connection open for a short time
-        // to see if new requests come in?
-        socket_->close(ec);
-        if (ec) {
-            // close() should be unlikely to fail, but we've seen it fail once,
-            // so we log the event (at the lowest level of debug).
-            LOG_DEBUG(logger, 0, ASIODNS_TCP_CLOSE_FAIL).arg(ec.message());
-        }
+        // Send the response (possibly after the ones of other queries
+        // that are ready sooner).  We have nothing further to do, so the
+        // coroutine simply exits.
+        connection_->send(respbuf_);
+        connection_->queryDone();
     }
 }
 
@@ -301,6 +477,15 @@ void TCPServer::stop() {
             LOG_ERROR(logger, ASIODNS_TCP_CLEANUP_CLOSE_FAIL).arg(ec.message());
         }
     }
+
+    // Close the client connections, too.  Queries in progress on them are
+    // dropped.  (close() removes the connection from the set, so we iterate
+    // over a copy.)
+    const std::set<Connection*> connections(*connections_);
+    for (std::set<Connection*>::const_iterator it = connections.begin();
+         it != connections.end(); ++it) {
+        (*it)->close();
+    }
 }
 /// Post this coroutine on the ASIO service queue so that it will
 /// resume processing where it left off.  The 'done' parameter indicates
@@ -28,6 +28,8 @@
 #include "dns_lookup.h"
 #include "dns_answer.h"
 
+#include <set>
+
 namespace bundy {
 namespace asiodns {
 
@@ -35,6 +37,14 @@ namespace asiodns {
 ///
 /// This class inherits from both \c DNSServer and from \c coroutine,
 /// defined in coroutine.h.
+///
+/// Client connections are persistent (RFC 7766): queries are read from
+/// a connection until the client closes it or it stays idle for the
+/// receive timeout.  Several queries from the same connection can be
+/// processed at the same time, and each response is sent as soon as it's
+/// ready, so they may go out in a different order than the queries came
+/// in.  The number of connections and the number of queries in progress
+/// on each of them are limited.
 class TCPServer : public virtual DNSServer, public virtual coroutine {
 public:
     /// \brief Constructor
@@ -62,17 +72,50 @@ public:
     /// \brief Set the read timeout
     ///
     /// If the client does not send (all) query data within this
-    /// timeframe, the connection is dropped
+    /// timeframe, the connection is dropped.  This is also the idle
+    /// timeout of a connection; it's only closed once none of its queries
+    /// are in progress any more.
     ///
     /// \param timeout in milliseconds
     virtual void setTCPRecvTimeout(size_t timeout) {
         *tcp_recv_timeout_ = timeout;
     }
 
+    /// \brief Set the maximum number of open client connections
+    ///
+    /// Connections accepted over the limit are closed immediately.
+    ///
+    /// \param max The maximum number of connections, 0 means no limit
+    void setTCPMaxConnections(size_t max) {
+        *max_connections_ = max;
+    }
+
+    /// \brief Set the maximum number of queries in progress on a connection
+    ///
+    /// Once the limit is reached, no more data is read from the connection
+    /// until one of the queries is answered.
+    ///
+    /// \param max The maximum number of queries, 0 means no limit
+    void setTCPMaxPipelinedQueries(size_t max) {
+        *max_pipelined_queries_ = max;
+    }
+
+    /// \brief The default maximum number of open client connections
+    static const size_t DEFAULT_MAX_CONNECTIONS = 150;
+
+    /// \brief The default maximum number of queries in progress on a
+    /// connection
+    static const size_t DEFAULT_MAX_PIPELINED_QUERIES = 16;
+
 private:
     enum { MAX_LENGTH = 65535 };
     static const size_t TCP_MESSAGE_LENGTHSIZE = 2;
 
+    // The state of a single client connection, shared by the coroutine
+    // reading the queries from it and the ones processing them.  It's
+    // defined in the .cc file.
+    class Connection;
+
     // The ASIO service object
     asio::io_service& io_;
 
@@ -115,8 +158,14 @@ private:
     bundy::dns::MessagePtr query_message_;
     bundy::dns::MessagePtr answer_message_;
 
-    // The buffer into which the query packet is written
+    // The buffer into which the query packet is written, and the length
+    // of the query in it
     boost::shared_array<char>data_;
+    size_t query_length_;
+
+    // The client connection this coroutine works on.  Only set after
+    // the fork in the accept loop.
+    boost::shared_ptr<Connection> connection_;
 
     // State information that is entirely internal to a given instance
     // of the coroutine can be declared here.
@@ -129,16 +178,20 @@ private:
     boost::shared_ptr<bundy::asiolink::IOEndpoint> peer_;
     boost::shared_ptr<bundy::asiolink::IOSocket> iosock_;
 
-    // Timer used to timeout on tcp connections
-    // This is a shared pointer because we need to have something
-    // that outlives the operator() call and is copyable (for CORO_FORK)
-    // even though it is only set after fork
-    boost::shared_ptr<asio::deadline_timer> timeout_;
-
     // Timeout value to use in the timer;
     // this, too, is a pointer, so that it can be updated whithout restarting
     // the server
     boost::shared_ptr<size_t> tcp_recv_timeout_;
+
+    // The connection limits and the number of currently open connections;
+    // shared by all the copies of the coroutine, like the timeout above.
+    boost::shared_ptr<size_t> max_connections_;
+    boost::shared_ptr<size_t> max_pipelined_queries_;
+    boost::shared_ptr<size_t> connection_count_;
+
+    // The client connections which are open, so stop() can close them.
+    // A connection removes itself when it's closed.
+    boost::shared_ptr<std::set<Connection*> > connections_;
 };
 
 } // namespace asiodns
@@ -24,9 +24,12 @@
 #include <asiodns/dns_answer.h>
 #include <asiodns/dns_lookup.h>
 #include <string>
+#include <vector>
+#include <algorithm>
 #include <cstring>
 #include <cerrno>
 #include <csignal>
+#include <ctime>
 #include <unistd.h> //for alarm
 
 #include <boost/shared_ptr.hpp>
@@ -35,6 +38,7 @@
 
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <netinet/in.h>
 
 /// The following tests focus on stop interface for udp and
 /// tcp server, there are lots of things can be shared to test
@@ -367,6 +371,111 @@ class TCPClient : public SimpleClient {
     size_t send_data_len_delay_;
 };
 
+// \brief A TCP client sending all its queries at once over a single
+// connection, and then reading the responses.
+//
+// The callback is called when all the responses are read or the connection
+// fails; the connection is left open.
+class PipeliningClient {
+public:
+    PipeliningClient(asio::io_service& service,
+                     const ip::tcp::endpoint& server) :
+        socket_(service), server_(server), expected_(0)
+    {}
+
+    void sendQueries(const std::vector<std::string>& queries,
+                     const boost::function<void()>& callback)
+    {
+        callback_ = callback;
+        expected_ = queries.size();
+        for (size_t i = 0; i < queries.size(); ++i) {
+            // Include the terminating nul, like TCPClient
+            const size_t length = queries[i].size() + 1;
+            out_data_.push_back(length >> 8);
+            out_data_.push_back(length & 0xff);
+            out_data_.insert(out_data_.end(), queries[i].c_str(),
+                             queries[i].c_str() + length);
+        }
+        socket_.async_connect(server_,
+                              boost::bind(&PipeliningClient::connected, this,
+                                          _1));
+    }
+
+    const std::vector<std::string>& getResponses() const {
+        return (responses_);
+    }
+
+    void close() {
+        socket_.close();
+    }
+
+    // Wait until the server closes the connection, and set closed to true
+    // then.  It's not set if something else is read.
+    void waitForClose(bool* closed) {
+        async_read(socket_, buffer(length_data_, 1),
+                   boost::bind(&PipeliningClient::readClosed, closed, _1));
+    }
+
+private:
+    static void readClosed(bool* closed, const asio::error_code& error) {
+        *closed = (error == asio::error::eof);
+    }
+
+    void connected(const asio::error_code& error) {
+        if (error) {
+            callback_();
+            return;
+        }
+        async_write(socket_, buffer(out_data_),
+                    boost::bind(&PipeliningClient::written, this, _1));
+    }
+
+    void written(const asio::error_code& error) {
+        if (error) {
+            callback_();
+            return;
+        }
+        readLength();
+    }
+
+    void readLength() {
+        async_read(socket_, buffer(length_data_, 2),
+                   boost::bind(&PipeliningClient::lengthRead, this, _1));
+    }
+
+    void lengthRead(const asio::error_code& error) {
+        if (error) {
+            callback_();
+            return;
+        }
+        in_data_.resize((length_data_[0] << 8) | length_data_[1]);
+        async_read(socket_, buffer(in_data_),
+                   boost::bind(&PipeliningClient::dataRead, this, _1));
+    }
+
+    void dataRead(const asio::error_code& error) {
+        if (error || in_data_.empty()) {
+            callback_();
+            return;
+        }
+        responses_.push_back(std::string(&in_data_[0]));
+        if (responses_.size() < expected_) {
+            readLength();
+        } else {
+            callback_();
+        }
+    }
+
+    ip::tcp::socket socket_;
+    const ip::tcp::endpoint server_;
+    size_t expected_;
+    boost::function<void()> callback_;
+    std::vector<char> out_data_;
+    unsigned char length_data_[2];
+    std::vector<char> in_data_;
+    std::vector<std::string> responses_;
+};
+
 // \brief provide the context which including two clients and
 // two servers, UDP client will only communicate with UDP server, same for TCP
 // client
@@ -413,11 +522,17 @@ class DNSServerTestBase : public::testing::Test {
         void testStopServerByStopper(DNSServer& server, SimpleClient* client,
                                      ServerStopper* stopper)
         {
-            static const unsigned int IO_SERVICE_TIME_OUT = 5;
-            io_service_is_time_out = false;
             stopper->setServerToStop(server);
             server();
             client->sendDataThenWaitForFeedback(query_message);
+            runIOService();
+        }
+
+        // Run the io service until there's nothing more to do, or it's
+        // stopped by the timeout.
+        void runIOService() {
+            static const unsigned int IO_SERVICE_TIME_OUT = 5;
+            io_service_is_time_out = false;
             // Since thread hasn't been introduced into the tool box, using
             // signal to make sure run function will eventually return even
             // server stop failed
@@ -694,6 +809,107 @@ TYPED_TEST(DNSServerTest, stopTCPServeMoreThanOnce) {
     EXPECT_TRUE(this->serverStopSucceed());
 }
 
+void
+stopServerAndClose(DNSServer* server, PipeliningClient* client) {
+    server->stop();
+    client->close();
+}
+
+// Several queries sent at once over the same connection are all answered
+// on it.
+TEST_F(AsyncServerTest, TCPPipelining) {
+    PipeliningClient client(service, ip::tcp::endpoint(server_address_,
+                                                       server_port));
+    std::vector<std::string> queries;
+    queries.push_back("first");
+    queries.push_back("second");
+    queries.push_back("third");
+    // Only two at a time, the last one is read after one of them is done
+    tcp_server_->setTCPMaxPipelinedQueries(2);
+    (*tcp_server_)();
+    client.sendQueries(queries, boost::bind(stopServerAndClose,
+                                            tcp_server_.get(), &client));
+    runIOService();
+    EXPECT_TRUE(serverStopSucceed());
+
+    // The responses may come in any order
+    std::vector<std::string> responses = client.getResponses();
+    std::sort(responses.begin(), responses.end());
+    std::sort(queries.begin(), queries.end());
+    EXPECT_EQ(queries, responses);
+}
+
+void
+stopServerAndWait(DNSServer* server, PipeliningClient* first, bool* closed1,
+                  PipeliningClient* second, bool* closed2)
+{
+    server->stop();
+    first->waitForClose(closed1);
+    second->waitForClose(closed2);
+}
+
+void
+sendSecond(PipeliningClient* client, const boost::function<void()>& callback)
+{
+    client->sendQueries(std::vector<std::string>(1, query_message), callback);
+}
+
+// Stopping the server closes all the open connections, even if the clients
+// keep them open.  (The last accepted one is not enough.)
+TEST_F(AsyncServerTest, TCPStopClosesConnections) {
+    const ip::tcp::endpoint endpoint(server_address_, server_port);
+    PipeliningClient first(service, endpoint);
+    PipeliningClient second(service, endpoint);
+    // Longer than the timeout of runIOService(), so the connections aren't
+    // closed because they're idle.
+    tcp_server_->setTCPRecvTimeout(10000);
+    (*tcp_server_)();
+    bool closed1 = false;
+    bool closed2 = false;
+    first.sendQueries(std::vector<std::string>(1, query_message),
+                      boost::bind(sendSecond, &second,
+                                  boost::function<void()>(
+                                      boost::bind(stopServerAndWait,
+                                                  tcp_server_.get(),
+                                                  &first, &closed1,
+                                                  &second, &closed2))));
+    runIOService();
+    EXPECT_TRUE(serverStopSucceed());
+    EXPECT_EQ(std::vector<std::string>(1, query_message),
+              first.getResponses());
+    EXPECT_EQ(std::vector<std::string>(1, query_message),
+              second.getResponses());
+    EXPECT_TRUE(closed1);
+    EXPECT_TRUE(closed2);
+}
+
+void
+connectSecond(PipeliningClient* client, DNSServer* server,
+              PipeliningClient* first)
+{
+    client->sendQueries(std::vector<std::string>(1, query_message),
+                        boost::bind(stopServerAndClose, server, first));
+}
+
+// Connections over the limit are closed right away, while the open one
+// is kept.
+TEST_F(AsyncServerTest, TCPMaxConnections) {
+    const ip::tcp::endpoint endpoint(server_address_, server_port);
+    PipeliningClient first(service, endpoint);
+    PipeliningClient second(service, endpoint);
+    tcp_server_->setTCPMaxConnections(1);
+    (*tcp_server_)();
+    first.sendQueries(std::vector<std::string>(1, query_message),
+                      boost::bind(connectSecond, &second, tcp_server_.get(),
+                                  &first));
+    runIOService();
+    EXPECT_TRUE(serverStopSucceed());
+
+    EXPECT_EQ(std::vector<std::string>(1, query_message),
+              first.getResponses());
+    EXPECT_TRUE(second.getResponses().empty());
+}
+
 // It raises an exception when invalid address family is passed
 // The parameter here doesn't mean anything
 TYPED_TEST(DNSServerTestBase, invalidFamily) {
@@ -756,6 +972,112 @@ TEST_F(SyncServerTest, nullLookupCallback) {
                  bundy::InvalidParameter);
 }
 
+// Batch size of 0 is rejected.
+TEST_F(SyncServerTest, zeroBatchSize) {
+    EXPECT_THROW(SyncUDPServer::create(service, 0, AF_INET, lookup_, 0),
+                 bundy::InvalidParameter);
+}
+
+// A lookup callback that echoes back and counts the queries.
+class CountingEchoLookup : public DNSLookup {
+public:
+    CountingEchoLookup() : count_(0) {}
+    virtual void operator()(const IOMessage& io_message,
+                            bundy::dns::MessagePtr,
+                            bundy::dns::MessagePtr,
+                            bundy::util::OutputBufferPtr buffer,
+                            DNSServer* server) const
+    {
+        buffer->writeData(io_message.getData(), io_message.getDataSize());
+        ++count_;
+        server->resume(true);
+    }
+    mutable size_t count_;
+};
+
+// Open a UDP socket bound to an ephemeral port of ::1, and return the
+// port in the given endpoint.
+int
+getEphemeralUDPFd(ip::udp::endpoint& endpoint) {
+    const int sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == -1) {
+        return (-1);
+    }
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_loopback;
+    socklen_t addr_len = sizeof(addr);
+    if (bind(sock, reinterpret_cast<const struct sockaddr*>(&addr),
+             sizeof(addr)) == -1 ||
+        getsockname(sock, reinterpret_cast<struct sockaddr*>(&addr),
+                    &addr_len) == -1) {
+        close(sock);
+        return (-1);
+    }
+    endpoint = ip::udp::endpoint(ip::address::from_string(server_ip),
+                                 ntohs(addr.sin6_port));
+    return (sock);
+}
+
+// Send several queries at once and check all of them are answered, both
+// with and without batching.
+void
+checkMultipleQueries(asio::io_service& service, size_t max_batch) {
+    CountingEchoLookup lookup;
+    ip::udp::endpoint server_ep;
+    const int fd = getEphemeralUDPFd(server_ep);
+    ASSERT_NE(-1, fd) << strerror(errno);
+    SyncUDPServerPtr server(SyncUDPServer::create(service, fd, AF_INET6,
+                                                  &lookup, max_batch));
+    (*server)();
+
+    const size_t QUERY_COUNT = 10;
+    ip::udp::socket client(service, ip::udp::v6());
+    for (size_t i = 0; i < QUERY_COUNT; ++i) {
+        const char query[] = { 'q', static_cast<char>('0' + i) };
+        client.send_to(asio::buffer(query), server_ep);
+    }
+
+    const unsigned int IO_SERVICE_TIME_OUT = 5;
+    const time_t start = time(NULL);
+    while (lookup.count_ < QUERY_COUNT &&
+           time(NULL) - start < IO_SERVICE_TIME_OUT) {
+        service.poll();
+        usleep(1000);
+    }
+    EXPECT_EQ(QUERY_COUNT, lookup.count_);
+
+    // All answers should be sent back in the order of the queries.
+    for (size_t i = 0; i < lookup.count_; ++i) {
+        char answer[2];
+        ip::udp::endpoint sender;
+        EXPECT_EQ(2, client.receive_from(asio::buffer(answer), sender));
+        EXPECT_EQ('q', answer[0]);
+        EXPECT_EQ(static_cast<char>('0' + i), answer[1]);
+        EXPECT_EQ(server_ep, sender);
+    }
+    server->stop();
+}
+
+TEST_F(SyncServerTest, multipleQueries) {
+    checkMultipleQueries(service, 1);
+}
+
+TEST_F(SyncServerTest, multipleQueriesBatched) {
+    checkMultipleQueries(service, 4);
+}
+
+TEST_F(SyncServerTest, maxBatch) {
+    // The default server of the fixture uses the default batch size if
+    // supported.
+#if defined(HAVE_RECVMMSG) && defined(HAVE_SENDMMSG)
+    EXPECT_EQ(SyncUDPServer::DEFAULT_MAX_BATCH, udp_server_->getMaxBatch());
+#else
+    EXPECT_EQ(1, udp_server_->getMaxBatch());
+#endif
+}
+
 TEST_F(SyncServerTest, resetUDPServerBeforeEvent) {
     // Reset the UDP server object after starting and before it would get
     // an event from io_service (in this case abort event).  The following
@@ -20,6 +20,7 @@
 #include <asio.hpp>
 #include <asiolink/asiolink.h>
 #include <asiodns/asiodns.h>
+#include <asiodns/sync_udp_server.h>
 
 #include <boost/scoped_ptr.hpp>
 #include <boost/lexical_cast.hpp>
@@ -43,20 +44,23 @@ const char* const TEST_IPV6_ADDR = "::1";
 
 // A simple lookup callback for DNS services.  It records the pointer value of
 // to given output buffer each time the callback is called (up to two times)
-// for the main tests.  At the end of the second callback it stops the server.
+// for the main tests, and whether the server is a SyncUDPServer.  At the end
+// of the second callback it stops the server.
 // The sender of the data doesn't expect to get a response, so it simply
 // discards any received data.
 class TestLookup : public DNSLookup {
 public:
     TestLookup(bundy::util::OutputBuffer** b1, bundy::util::OutputBuffer** b2,
                IOService& io_service) :
-        first_buffer_(b1), second_buffer_(b2), io_service_(io_service)
+        first_buffer_(b1), second_buffer_(b2), io_service_(io_service),
+        sync_server_(false)
     {}
     void operator()(const IOMessage&, bundy::dns::MessagePtr,
                     bundy::dns::MessagePtr, bundy::util::OutputBufferPtr buffer,
                     DNSServer* server) const
     {
         server->resume(false);
+        sync_server_ = (dynamic_cast<SyncUDPServer*>(server) != NULL);
         if (*first_buffer_ == NULL) {
             *first_buffer_ = buffer.get();
         } else {
@@ -69,6 +73,7 @@ public:
     bundy::util::OutputBuffer** first_buffer_;
     bundy::util::OutputBuffer** second_buffer_;
     IOService& io_service_;
+    mutable bool sync_server_;
 };
 
 // A test fixture to check creation of UDP servers from a socket FD, changing
@@ -97,6 +102,10 @@ protected:
     }
 
     void runService() {
+        runService(io_service);
+    }
+
+    void runService(IOService& service) {
         io_service_is_time_out = false;
 
         // Send two UDP packets, which will be passed to the TestLookup
@@ -110,10 +119,10 @@ protected:
         // due to a bug.
         void (*prev_handler)(int) =
             std::signal(SIGALRM, UDPDNSServiceTest::stopIOService);
-        current_service = &io_service;
+        current_service = &service;
         alarm(IO_SERVICE_TIME_OUT);
-        io_service.run();
-        io_service.get_io_service().reset();
+        service.run();
+        service.get_io_service().reset();
         //cancel scheduled alarm
         alarm(0);
         std::signal(SIGALRM, prev_handler);
@@ -196,6 +205,7 @@ TEST_F(UDPDNSServiceTest, defaultUDPServerFromFD) {
     runService();
     EXPECT_TRUE(serverStopSucceed());
     EXPECT_NE(first_buffer_, second_buffer_);
+    EXPECT_FALSE(lookup.sync_server_);
 }
 
 TEST_F(UDPDNSServiceTest, explicitDefaultUDPServerFromFD) {
@@ -207,18 +217,51 @@ TEST_F(UDPDNSServiceTest, explicitDefaultUDPServerFromFD) {
     runService();
     EXPECT_TRUE(serverStopSucceed());
     EXPECT_NE(first_buffer_, second_buffer_);
+    EXPECT_FALSE(lookup.sync_server_);
 }
 
 TEST_F(UDPDNSServiceTest, syncUDPServerFromFD) {
     // If "SYNC_OK" option is specified, a synchronous server should be
-    // created.  It will reuse the output buffer, so the recorded two pointer
-    // should be identical.
+    // created.  (Its output buffers may or may not be identical depending on
+    // whether the two packets are received in one batch).
     dns_service.addServerUDPFromFD(getSocketFD(AF_INET6, TEST_IPV6_ADDR,
                                                TEST_SERVER_PORT),
                                    AF_INET6, DNSService::SERVER_SYNC_OK);
     runService();
     EXPECT_TRUE(serverStopSucceed());
-    EXPECT_EQ(first_buffer_, second_buffer_);
+    EXPECT_TRUE(lookup.sync_server_);
+}
+
+TEST_F(UDPDNSServiceTest, syncUDPServerOnWorker) {
+    // With a UDP worker, a synchronous server is created on the worker's
+    // IOService and queries are passed to the worker's lookup.  We run the
+    // worker's event loop in this thread for simplicity.
+    IOService worker_service;
+    bundy::util::OutputBuffer* worker_first = NULL;
+    bundy::util::OutputBuffer* worker_second = NULL;
+    TestLookup worker_lookup(&worker_first, &worker_second, worker_service);
+    dns_service.addUDPWorker(worker_service, &worker_lookup);
+    EXPECT_EQ(1, dns_service.getUDPWorkerCount());
+
+    dns_service.addServerUDPFromFD(getSocketFD(AF_INET6, TEST_IPV6_ADDR,
+                                               TEST_SERVER_PORT),
+                                   AF_INET6, DNSService::SERVER_SYNC_OK);
+    runService(worker_service);
+    EXPECT_TRUE(serverStopSucceed());
+    EXPECT_NE(static_cast<bundy::util::OutputBuffer*>(NULL), worker_first);
+    EXPECT_TRUE(worker_lookup.sync_server_);
+    // The main lookup isn't used.
+    EXPECT_EQ(static_cast<bundy::util::OutputBuffer*>(NULL), first_buffer_);
+
+    dns_service.clearServers();
+    dns_service.clearUDPWorkers();
+    EXPECT_EQ(0, dns_service.getUDPWorkerCount());
+}
+
+TEST_F(UDPDNSServiceTest, addUDPWorkerWithNullLookup) {
+    IOService worker_service;
+    EXPECT_THROW(dns_service.addUDPWorker(worker_service, NULL),
+                 bundy::InvalidParameter);
 }
 
 TEST_F(UDPDNSServiceTest, addUDPServerFromFDWithUnknownOption) {
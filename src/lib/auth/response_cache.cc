@@ -0,0 +1,333 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/response_cache.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/message.h>
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <util/buffer.h>
+#include <util/threads/sync.h>
+
+#include <boost/intrusive/list.hpp>
+#include <boost/scoped_array.hpp>
+
+#include <cctype>
+#include <cstring>
+#include <vector>
+
+using namespace bundy::dns;
+
+namespace bundy {
+namespace auth {
+
+namespace {
+// Offsets and sizes in the DNS header
+const size_t HEADER_LENGTH = 12;
+const size_t FLAGS_OFFSET = 2;
+
+// Upper bounds of the response size buckets: the classic limit, common
+// EDNS buffer sizes, and anything larger (e.g. TCP).
+const size_t SIZE_BUCKETS[] = { 512, 1232, 1452, 4096 };
+const size_t N_SIZE_BUCKETS = sizeof(SIZE_BUCKETS) / sizeof(SIZE_BUCKETS[0]);
+
+// Key flag bits, stored in the last byte of the key with the size bucket.
+const uint8_t KEY_EDNS = 0x01;
+const uint8_t KEY_DNSSEC_OK = 0x02;
+
+// Check whether the name (in wire format) is equal to or a subdomain of the
+// origin (also in wire format), ignoring case.
+bool
+isInZone(const uint8_t* name, size_t name_len, const uint8_t* origin,
+         size_t origin_len)
+{
+    size_t offset = 0;
+    while (name_len - offset >= origin_len) {
+        if (name_len - offset == origin_len) {
+            for (size_t i = 0; i < origin_len; ++i) {
+                if (std::tolower(name[offset + i]) !=
+                    std::tolower(origin[i])) {
+                    return (false);
+                }
+            }
+            return (true);
+        }
+        if (name[offset] == 0) {
+            break;
+        }
+        offset += name[offset] + 1;
+    }
+    return (false);
+}
+}
+
+const size_t ResponseCacheKey::MAX_LENGTH;
+
+ResponseCacheKey::ResponseCacheKey(const Name& qname, const RRType& qtype,
+                                   const RRClass& qclass, bool edns,
+                                   bool dnssec_ok, size_t length_limit)
+{
+    // We use the name data as it is (instead of the downcased one), since
+    // the response must have the query name in the original case.
+    const LabelSequence labels(qname);
+    const uint8_t* ndata = labels.getData(&name_length_);
+    std::memcpy(data_, ndata, name_length_);
+    size_t pos = name_length_;
+    data_[pos++] = qtype.getCode() >> 8;
+    data_[pos++] = qtype.getCode() & 0xff;
+    data_[pos++] = qclass.getCode() >> 8;
+    data_[pos++] = qclass.getCode() & 0xff;
+
+    size_t bucket = 0;
+    while (bucket < N_SIZE_BUCKETS && length_limit > SIZE_BUCKETS[bucket]) {
+        ++bucket;
+    }
+    data_[pos++] = (bucket << 2) | (edns ? KEY_EDNS : 0) |
+        (dnssec_ok ? KEY_DNSSEC_OK : 0);
+    length_ = pos;
+}
+
+uint32_t
+ResponseCacheKey::getHash(uint32_t seed) const {
+    // FNV-1a, with the seed mixed into the initial value.
+    uint32_t hash = 2166136261u ^ seed;
+    for (size_t i = 0; i < length_; ++i) {
+        hash ^= data_[i];
+        hash *= 16777619u;
+    }
+    return (hash);
+}
+
+namespace {
+typedef boost::intrusive::list_member_hook<
+    boost::intrusive::link_mode<boost::intrusive::auto_unlink> > HashHook;
+typedef boost::intrusive::list_member_hook<> LRUHook;
+
+struct CacheEntry {
+    CacheEntry() : key_length(0), name_length(0), hash(0) {}
+
+    bool matches(const ResponseCacheKey& key, uint32_t key_hash) const {
+        return (hash == key_hash && key_length == key.getLength() &&
+                std::memcmp(key_data, key.getData(), key_length) == 0);
+    }
+
+    uint8_t key_data[ResponseCacheKey::MAX_LENGTH];
+    size_t key_length;
+    size_t name_length;
+    uint32_t hash;
+    std::vector<uint8_t> response;
+    boost::shared_ptr<const Name> nxdomain_zone;
+    HashHook hash_hook;
+    LRUHook lru_hook;
+};
+
+typedef boost::intrusive::list<
+    CacheEntry,
+    boost::intrusive::member_hook<CacheEntry, HashHook,
+                                  &CacheEntry::hash_hook>,
+    boost::intrusive::constant_time_size<false> > Bucket;
+typedef boost::intrusive::list<
+    CacheEntry,
+    boost::intrusive::member_hook<CacheEntry, LRUHook,
+                                  &CacheEntry::lru_hook> > LRUList;
+}
+
+struct ResponseCache::ResponseCacheImpl {
+    ResponseCacheImpl(size_t max_entries, uint32_t hash_seed) :
+        max_entries_(max_entries), used_count_(0), hash_seed_(hash_seed)
+    {
+        // See RRLTable about the number of buckets.
+        size_t n_buckets = 1;
+        while (n_buckets < max_entries) {
+            n_buckets <<= 1;
+        }
+        bucket_mask_ = n_buckets - 1;
+        entries_.reset(new CacheEntry[max_entries]);
+        buckets_.reset(new Bucket[n_buckets]);
+        for (size_t i = 0; i < max_entries; ++i) {
+            lru_.push_back(entries_[i]);
+        }
+    }
+
+    CacheEntry* findEntry(const ResponseCacheKey& key, uint32_t hash) {
+        Bucket& bucket = buckets_[hash & bucket_mask_];
+        for (Bucket::iterator it = bucket.begin(); it != bucket.end(); ++it) {
+            if (it->matches(key, hash)) {
+                return (&*it);
+            }
+        }
+        return (NULL);
+    }
+
+    // Make the entry unused and the first one to be recycled.
+    void removeEntry(CacheEntry& entry) {
+        entry.hash_hook.unlink();
+        entry.nxdomain_zone.reset();
+        lru_.erase(lru_.iterator_to(entry));
+        lru_.push_back(entry);
+        --used_count_;
+    }
+
+    void touchEntry(CacheEntry& entry) {
+        lru_.erase(lru_.iterator_to(entry));
+        lru_.push_front(entry);
+    }
+
+    const size_t max_entries_;
+    size_t used_count_;
+    const uint32_t hash_seed_;
+    size_t bucket_mask_;
+    boost::scoped_array<CacheEntry> entries_;
+    boost::scoped_array<Bucket> buckets_;
+    LRUList lru_;
+    util::thread::Mutex mutex_;
+};
+
+ResponseCache::ResponseCache(size_t max_entries, uint32_t hash_seed) :
+    impl_(NULL)
+{
+    if (max_entries == 0) {
+        bundy_throw(InvalidParameter, "response cache size must be positive");
+    }
+    impl_ = new ResponseCacheImpl(max_entries, hash_seed);
+}
+
+ResponseCache::~ResponseCache() {
+    delete impl_;
+}
+
+bool
+ResponseCache::find(const ResponseCacheKey& key, size_t length_limit,
+                    uint16_t qid, uint16_t query_flags,
+                    util::OutputBuffer& buffer,
+                    boost::shared_ptr<const Name>* nxdomain_zone)
+{
+    const uint32_t hash = key.getHash(impl_->hash_seed_);
+    const size_t data_start = buffer.getLength();
+    {
+        util::thread::Mutex::Locker locker(impl_->mutex_);
+        CacheEntry* entry = impl_->findEntry(key, hash);
+        if (entry == NULL || entry->response.size() > length_limit) {
+            return (false);
+        }
+        impl_->touchEntry(*entry);
+        buffer.writeData(&entry->response[0], entry->response.size());
+        if (nxdomain_zone != NULL) {
+            *nxdomain_zone = entry->nxdomain_zone;
+        }
+    }
+
+    // Patch the header for this query.
+    static const uint16_t PRESERVED_FLAGS =
+        Message::HEADERFLAG_RD | Message::HEADERFLAG_CD;
+    const uint8_t* data = static_cast<const uint8_t*>(buffer.getData()) +
+        data_start;
+    const uint16_t flags = (data[FLAGS_OFFSET] << 8) | data[FLAGS_OFFSET + 1];
+    buffer.writeUint16At(qid, data_start);
+    buffer.writeUint16At((flags & ~PRESERVED_FLAGS) |
+                         (query_flags & PRESERVED_FLAGS),
+                         data_start + FLAGS_OFFSET);
+    return (true);
+}
+
+void
+ResponseCache::insert(const ResponseCacheKey& key, const void* data,
+                      size_t length, const Name* nxdomain_zone)
+{
+    if (length < HEADER_LENGTH) {
+        bundy_throw(InvalidParameter, "too short response for the response "
+                    "cache: " << length << " bytes");
+    }
+    // Prepare the zone name outside of the lock as it allocates memory.
+    boost::shared_ptr<const Name> zone;
+    if (nxdomain_zone != NULL) {
+        zone.reset(new Name(*nxdomain_zone));
+    }
+
+    const uint32_t hash = key.getHash(impl_->hash_seed_);
+    util::thread::Mutex::Locker locker(impl_->mutex_);
+    CacheEntry* entry = impl_->findEntry(key, hash);
+    if (entry == NULL) {
+        entry = &impl_->lru_.back();
+        if (entry->hash_hook.is_linked()) {
+            entry->hash_hook.unlink();
+        } else {
+            ++impl_->used_count_;
+        }
+        std::memcpy(entry->key_data, key.getData(), key.getLength());
+        entry->key_length = key.getLength();
+        entry->name_length = key.getNameLength();
+        entry->hash = hash;
+        impl_->buckets_[hash & impl_->bucket_mask_].push_front(*entry);
+    }
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    entry->response.assign(bytes, bytes + length);
+    entry->nxdomain_zone = zone;
+    impl_->touchEntry(*entry);
+}
+
+void
+ResponseCache::invalidate(const RRClass& rrclass, const Name& origin) {
+    const LabelSequence origin_labels(origin);
+    size_t origin_len;
+    const uint8_t* origin_data = origin_labels.getData(&origin_len);
+    const uint16_t rrclass_code = rrclass.getCode();
+
+    util::thread::Mutex::Locker locker(impl_->mutex_);
+    for (size_t i = 0; i < impl_->max_entries_; ++i) {
+        CacheEntry& entry = impl_->entries_[i];
+        if (!entry.hash_hook.is_linked()) {
+            continue;
+        }
+        const uint8_t* const class_data = entry.key_data +
+            entry.name_length + 2;
+        if (((class_data[0] << 8) | class_data[1]) != rrclass_code) {
+            continue;
+        }
+        if (isInZone(entry.key_data, entry.name_length, origin_data,
+                     origin_len)) {
+            impl_->removeEntry(entry);
+        }
+    }
+}
+
+void
+ResponseCache::clear() {
+    util::thread::Mutex::Locker locker(impl_->mutex_);
+    for (size_t i = 0; i < impl_->max_entries_; ++i) {
+        CacheEntry& entry = impl_->entries_[i];
+        if (entry.hash_hook.is_linked()) {
+            impl_->removeEntry(entry);
+        }
+    }
+}
+
+size_t
+ResponseCache::getEntryCount() const {
+    util::thread::Mutex::Locker locker(impl_->mutex_);
+    return (impl_->used_count_);
+}
+
+size_t
+ResponseCache::getMaxEntries() const {
+    return (impl_->max_entries_);
+}
+
+} // namespace auth
+} // namespace bundy
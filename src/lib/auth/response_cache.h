@@ -0,0 +1,193 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_RESPONSE_CACHE_H
+#define AUTH_RESPONSE_CACHE_H 1
+
+#include <dns/dns_fwd.h>
+#include <dns/name.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <cstddef>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace util {
+class OutputBuffer;
+}
+
+namespace auth {
+
+/// \brief Key of the response cache.
+///
+/// A key identifies the parameters of a query that determine the
+/// response from an authoritative server: the query name (case sensitive,
+/// since the response echoes it), type and class, whether the query has
+/// EDNS and the DO bit, and the maximum size of the response rounded down
+/// to a few common "buckets".
+///
+/// Constructing a key doesn't allocate memory.
+class ResponseCacheKey {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw None
+    ///
+    /// \param qname The query name.
+    /// \param qtype The query type.
+    /// \param qclass The query class.
+    /// \param edns Whether the query has EDNS.
+    /// \param dnssec_ok Whether the DO bit of the query is set.
+    /// \param length_limit The maximum size of the response.
+    ResponseCacheKey(const dns::Name& qname, const dns::RRType& qtype,
+                     const dns::RRClass& qclass, bool edns, bool dnssec_ok,
+                     size_t length_limit);
+
+    /// \brief Return the key data.
+    ///
+    /// \throw None
+    const uint8_t* getData() const { return (data_); }
+
+    /// \brief Return the length of the key data.
+    ///
+    /// \throw None
+    size_t getLength() const { return (length_); }
+
+    /// \brief Return the length of the query name part of the key data.
+    ///
+    /// \throw None
+    size_t getNameLength() const { return (name_length_); }
+
+    /// \brief Return a hash value of the key for the given seed.
+    ///
+    /// \throw None
+    uint32_t getHash(uint32_t seed) const;
+
+    /// \brief The maximum length of key data.
+    static const size_t MAX_LENGTH = dns::Name::MAX_WIRE + 5;
+
+private:
+    uint8_t data_[MAX_LENGTH];
+    size_t length_;
+    size_t name_length_;
+};
+
+/// \brief Cache of rendered responses.
+///
+/// This class stores rendered responses to normal queries in the wire
+/// format, so the same query can be answered by copying the data instead of
+/// looking up the data sources and rendering the response again.  A found
+/// response is copied to the caller's buffer with the ID and the RD and CD
+/// flags of the query patched in.
+///
+/// It's the caller's responsibility to store only responses that are the
+/// same for any query with the same key, i.e., responses that are not
+/// TSIG signed, not truncated and not modified by rate limiting.  When data
+/// of a zone is updated, the caller is also responsible for removing the
+/// responses for the zone by \c invalidate().
+///
+/// Entries are allocated on construction and recycled in the LRU order,
+/// so memory is only allocated when an entry needs more space for its
+/// response data than it had before.
+///
+/// This class is thread safe; all methods are serialized by an internal
+/// lock.
+class ResponseCache : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_entries is 0
+    /// \throw std::bad_alloc memory allocation failed.
+    ///
+    /// \param max_entries The maximum number of cached responses.
+    /// \param hash_seed A seed for key hashing.  In practice it should be
+    /// an unpredictable random value.
+    ResponseCache(size_t max_entries, uint32_t hash_seed);
+
+    /// \brief Destructor.
+    ~ResponseCache();
+
+    /// \brief Find the response for the given key.
+    ///
+    /// If a response is found and it's not larger than \c length_limit,
+    /// it's copied to \c buffer with the given ID, and the RD and CD flags
+    /// taken from \c query_flags (other bits of it are ignored).
+    /// If \c nxdomain_zone is non NULL and the response is NXDOMAIN, it will
+    /// be set to the name of the zone that the response was made from
+    /// (or NULL if unknown).
+    ///
+    /// \throw std::bad_alloc memory allocation for \c buffer failed.
+    ///
+    /// \return true if a response is found and copied; false otherwise.
+    bool find(const ResponseCacheKey& key, size_t length_limit, uint16_t qid,
+              uint16_t query_flags, util::OutputBuffer& buffer,
+              boost::shared_ptr<const dns::Name>* nxdomain_zone = NULL);
+
+    /// \brief Store a response for the given key.
+    ///
+    /// An existing response for the key is replaced.  If the cache is
+    /// full, the least recently used entry is removed.
+    ///
+    /// \throw bundy::InvalidParameter the data is shorter than the DNS
+    /// header.
+    /// \throw std::bad_alloc memory allocation failed.
+    ///
+    /// \param key The key of the query.
+    /// \param data The response data.
+    /// \param length The length of \c data.
+    /// \param nxdomain_zone The name of the zone for NXDOMAIN responses;
+    /// can be NULL.
+    void insert(const ResponseCacheKey& key, const void* data, size_t length,
+                const dns::Name* nxdomain_zone = NULL);
+
+    /// \brief Remove the responses for names at or under a zone origin.
+    ///
+    /// \throw None
+    ///
+    /// \param rrclass The class of the zone.
+    /// \param origin The origin of the zone; the root name removes all
+    /// responses of the class.
+    void invalidate(const dns::RRClass& rrclass, const dns::Name& origin);
+
+    /// \brief Remove all responses.
+    ///
+    /// \throw None
+    void clear();
+
+    /// \brief Return the number of cached responses.
+    ///
+    /// \throw None
+    size_t getEntryCount() const;
+
+    /// \brief Return the maximum number of cached responses.
+    ///
+    /// \throw None
+    size_t getMaxEntries() const;
+
+private:
+    struct ResponseCacheImpl;
+    ResponseCacheImpl* impl_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RESPONSE_CACHE_H
+
+// Local Variables:
+// mode: c++
+// End:
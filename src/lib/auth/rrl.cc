@@ -0,0 +1,172 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/rrl.h>
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+#include <auth/rrl_table.h>
+#include <auth/rrl_response_type.h>
+#include <auth/rrl_result.h>
+
+#include <exceptions/exceptions.h>
+
+#include <boost/bind.hpp>
+
+#include <ctime>
+
+#include <netinet/in.h>
+#include <stdint.h>
+
+using namespace bundy::auth::detail;
+
+namespace bundy {
+namespace auth {
+
+namespace {
+// Convert a prefix length to a bit mask of 32-bit word in network byte
+// order.  plen can be larger than 32, in which case all bits are set.
+uint32_t
+plenToMask(int plen) {
+    if (plen <= 0) {
+        return (0);
+    }
+    if (plen >= 32) {
+        return (0xffffffff);
+    }
+    return (htonl(0xffffffff << (32 - plen)));
+}
+}
+
+struct ResponseRateLimiter::ResponseRateLimiterImpl {
+    ResponseRateLimiterImpl(int window, int slip, size_t max_table_size,
+                            std::time_t now, uint32_t hash_seed) :
+        window_(window), slip_(slip),
+        hash_seed_(hash_seed), table_(max_table_size),
+        ts_bases_(now, boost::bind(&RRLTable::timestampBaseChanged, &table_,
+                                   _1))
+    {}
+
+    int rates_[RESPONSE_TYPE_MAX + 1];
+    const int window_;
+    const int slip_;
+    const uint32_t hash_seed_;
+    uint32_t ipv4_mask_;
+    uint32_t ipv6_masks_[4];
+    RRLTable table_;
+    RRLTimeStamps ts_bases_;
+};
+
+ResponseRateLimiter::ResponseRateLimiter(int responses_per_second,
+                                         int nxdomains_per_second,
+                                         int errors_per_second, int window,
+                                         int slip, size_t max_table_size,
+                                         int ipv4_prefixlen,
+                                         int ipv6_prefixlen, std::time_t now,
+                                         uint32_t hash_seed) :
+    impl_(NULL)
+{
+    if (responses_per_second < 0 || nxdomains_per_second < 0 ||
+        errors_per_second < 0) {
+        bundy_throw(InvalidParameter, "RRL rates must not be negative");
+    }
+    if (window < 1 || window > 3600) {
+        bundy_throw(InvalidParameter, "RRL window out of range: " << window);
+    }
+    if (slip < 0 || slip > 10) {
+        bundy_throw(InvalidParameter, "RRL slip out of range: " << slip);
+    }
+    if (ipv4_prefixlen < 0 || ipv4_prefixlen > 32) {
+        bundy_throw(InvalidParameter, "RRL IPv4 prefix length out of range: "
+                    << ipv4_prefixlen);
+    }
+    if (ipv6_prefixlen < 0 || ipv6_prefixlen > 128) {
+        bundy_throw(InvalidParameter, "RRL IPv6 prefix length out of range: "
+                    << ipv6_prefixlen);
+    }
+
+    impl_ = new ResponseRateLimiterImpl(window, slip, max_table_size, now,
+                                        hash_seed);
+    impl_->rates_[RESPONSE_QUERY] = responses_per_second;
+    impl_->rates_[RESPONSE_NXDOMAIN] = nxdomains_per_second;
+    impl_->rates_[RESPONSE_ERROR] = errors_per_second;
+    impl_->ipv4_mask_ = plenToMask(ipv4_prefixlen);
+    for (int i = 0; i < 4; ++i) {
+        impl_->ipv6_masks_[i] = plenToMask(ipv6_prefixlen - i * 32);
+    }
+}
+
+ResponseRateLimiter::~ResponseRateLimiter() {
+    delete impl_;
+}
+
+RRLResult
+ResponseRateLimiter::check(const asiolink::IOEndpoint& client, bool is_tcp,
+                           const dns::RRClass& qclass,
+                           const dns::RRType& qtype,
+                           const dns::LabelSequence* qname,
+                           ResponseType resp_type, std::time_t now)
+{
+    if (is_tcp) {
+        return (RRL_OK);
+    }
+    const int rate = impl_->rates_[resp_type];
+    if (rate == 0) {
+        return (RRL_OK);
+    }
+
+    const RRLKey key(client, qtype, qname, qclass, resp_type,
+                     impl_->ipv4_mask_, impl_->ipv6_masks_,
+                     impl_->hash_seed_);
+    RRLEntry* entry = impl_->table_.getEntry(key);
+    return (entry->updateBalance(impl_->ts_bases_, rate, impl_->slip_,
+                                 impl_->window_, now));
+}
+
+int
+ResponseRateLimiter::getResponseRate() const {
+    return (impl_->rates_[RESPONSE_QUERY]);
+}
+
+int
+ResponseRateLimiter::getNXDOMAINRate() const {
+    return (impl_->rates_[RESPONSE_NXDOMAIN]);
+}
+
+int
+ResponseRateLimiter::getErrorRate() const {
+    return (impl_->rates_[RESPONSE_ERROR]);
+}
+
+int
+ResponseRateLimiter::getWindow() const {
+    return (impl_->window_);
+}
+
+int
+ResponseRateLimiter::getSlip() const {
+    return (impl_->slip_);
+}
+
+size_t
+ResponseRateLimiter::getTableSize() const {
+    return (impl_->table_.getMaxEntries());
+}
+
+size_t
+ResponseRateLimiter::getEntryCount() const {
+    return (impl_->table_.getEntryCount());
+}
+
+} // namespace auth
+} // namespace bundy
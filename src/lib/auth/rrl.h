@@ -0,0 +1,139 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_RRL_H
+#define AUTH_RRL_H 1
+
+#include <auth/rrl_response_type.h>
+#include <auth/rrl_result.h>
+
+#include <dns/dns_fwd.h>
+#include <dns/labelsequence.h>
+
+#include <boost/noncopyable.hpp>
+
+#include <ctime>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace asiolink {
+class IOEndpoint;
+}
+
+namespace auth {
+
+/// \brief Response Rate Limiter.
+///
+/// This class implements DNS response rate limiting (RRL) to mitigate
+/// reflection and amplification attacks, following the design of the
+/// same feature of BIND 9.  Responses are accounted per "RRL key": a
+/// combination of the client's network prefix, the query name and type
+/// (for normal answers), the zone name (for NXDOMAIN), or just the client
+/// prefix (for errors).  Each key is allowed a configured number of
+/// responses per second for its response type; once the limit is exceeded
+/// responses are dropped, except that every "slip"-th of them should be
+/// replaced with a truncated (TC=1) response so legitimate clients can
+/// retry over TCP.
+///
+/// The \c check() method is designed to be called after the response
+/// has been built but before it's rendered, so rendering can be skipped
+/// entirely for dropped responses.  It doesn't allocate memory: all
+/// rate limiting state is preallocated on construction.
+///
+/// This class is not thread safe.
+class ResponseRateLimiter : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// For each response type the rate of 0 means responses of that type
+    /// are never limited.
+    ///
+    /// \throw bundy::InvalidParameter any of the parameters is invalid.
+    /// \throw std::bad_alloc memory allocation failed.
+    ///
+    /// \param responses_per_second Rate limit for normal (non error,
+    /// non NXDOMAIN) responses.
+    /// \param nxdomains_per_second Rate limit for NXDOMAIN responses.
+    /// \param errors_per_second Rate limit for error responses.
+    /// \param window The window of rate limiting in seconds (1-3600).
+    /// \param slip The ratio of slipped responses for limited ones; 0 means
+    /// all limited responses are dropped (0-10).
+    /// \param max_table_size The number of entries of the RRL table.
+    /// \param ipv4_prefixlen Prefix length to aggregate IPv4 clients (0-32).
+    /// \param ipv6_prefixlen Prefix length to aggregate IPv6 clients
+    /// (0-128); only up to 64 bits are used in practice.
+    /// \param now The current time.
+    /// \param hash_seed A seed for query name hashing.  In practice it
+    /// should be an unpredictable random value.
+    ResponseRateLimiter(int responses_per_second, int nxdomains_per_second,
+                        int errors_per_second, int window, int slip,
+                        size_t max_table_size, int ipv4_prefixlen,
+                        int ipv6_prefixlen, std::time_t now,
+                        uint32_t hash_seed);
+
+    /// \brief Destructor.
+    ~ResponseRateLimiter();
+
+    /// \brief Check whether the response should be limited.
+    ///
+    /// Responses over TCP are never limited (nor counted) as the
+    /// client address can't be spoofed.
+    ///
+    /// \throw bundy::Unexpected client is neither IPv4 nor IPv6 (shouldn't
+    /// happen in practice)
+    ///
+    /// \param client The client's end point.
+    /// \param is_tcp Whether the query was received over TCP.
+    /// \param qclass The query class.
+    /// \param qtype The query type.
+    /// \param qname The query name for \c RESPONSE_QUERY, or the zone name
+    /// for \c RESPONSE_NXDOMAIN; it can be NULL for \c RESPONSE_ERROR.
+    /// \param resp_type The type of the response.
+    /// \param now The current time.
+    ///
+    /// \return The result of rate limiting.
+    RRLResult check(const asiolink::IOEndpoint& client, bool is_tcp,
+                    const dns::RRClass& qclass, const dns::RRType& qtype,
+                    const dns::LabelSequence* qname,
+                    detail::ResponseType resp_type, std::time_t now);
+
+    /// \name Accessors for the configured parameters.
+    //@{
+    int getResponseRate() const;
+    int getNXDOMAINRate() const;
+    int getErrorRate() const;
+    int getWindow() const;
+    int getSlip() const;
+    size_t getTableSize() const;
+    //@}
+
+    /// \brief Return the number of entries currently in use.
+    ///
+    /// This is mainly intended for tests and statistics.
+    size_t getEntryCount() const;
+
+private:
+    struct ResponseRateLimiterImpl;
+    ResponseRateLimiterImpl* impl_;
+};
+
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,97 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/rrl_entry.h>
+#include <auth/rrl_result.h>
+#include <auth/rrl_timestamps.h>
+
+#include <ctime>
+#include <utility>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+int
+RRLEntry::getAge(const RRLTimeStamps& ts_bases, std::time_t now) const {
+    if (!timestamp_valid_) {
+        return (TIMESTAMP_FOREVER);
+    }
+    return (RRLTimeStamps::deltaTime(
+                ts_bases.getBaseByGen(timestamp_gen_) + timestamp_, now));
+}
+
+void
+RRLEntry::setTimestamp(RRLTimeStamps& ts_bases, std::time_t now) {
+    const std::pair<std::time_t, size_t> base = ts_bases.getCurrentBase(now);
+
+    // The current base can be slightly in the future of 'now' (see
+    // getCurrentBase()); we treat it as if 'now' were the base.
+    const int ts = now - base.first;
+    timestamp_ = ts < 0 ? 0 : ts;
+    timestamp_gen_ = base.second;
+    timestamp_valid_ = 1;
+}
+
+RRLResult
+RRLEntry::updateBalance(RRLTimeStamps& ts_bases, int rate, int slip,
+                        int window, std::time_t now)
+{
+    // Credit the entry for the time since the last response.  An entry
+    // older than the window is treated as if it were just created.  Time
+    // jumps into the recent past are treated as no time.
+    const int age = getAge(ts_bases, now);
+    if (age > 0) {
+        if (age > window) {
+            responses_ = rate;
+            slip_count_ = 0;
+        } else {
+            responses_ += rate * age;
+            if (responses_ > rate) {
+                responses_ = rate;
+                slip_count_ = 0;
+            }
+        }
+        setTimestamp(ts_bases, now);
+    }
+
+    // Debit the entry for this response.
+    if (--responses_ >= 0) {
+        return (RRL_OK);
+    }
+
+    // The response is limited.  Don't let the balance get too low so
+    // the client will recover within the window once it stops.
+    const int min_balance = -window * rate;
+    if (responses_ < min_balance) {
+        responses_ = min_balance;
+    }
+
+    // Drop this response unless it should slip.
+    if (slip != 0) {
+        if (slip_count_++ == 0) {
+            if (slip_count_ >= slip) {
+                slip_count_ = 0;
+            }
+            return (RRL_SLIP);
+        } else if (slip_count_ >= slip) {
+            slip_count_ = 0;
+        }
+    }
+    return (RRL_DROP);
+}
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
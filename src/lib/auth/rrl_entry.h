@@ -0,0 +1,186 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_RRL_ENTRY_H
+#define AUTH_RRL_ENTRY_H 1
+
+#include <auth/rrl_key.h>
+#include <auth/rrl_result.h>
+#include <auth/rrl_timestamps.h>
+
+#include <boost/intrusive/list.hpp>
+
+#include <ctime>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+/// \brief Number of timestamp bases used for RRL entries.
+///
+/// It must be small enough to fit in the bit field of \c RRLEntry.
+const size_t TIMESTAMP_BASES_COUNT = 4;
+
+/// \brief The range of timestamps (in seconds) that an entry can hold
+/// relative to its base.
+///
+/// It must be small enough to fit in the bit field of \c RRLEntry.
+const int TIMESTAMP_FOREVER = 1 << 12;
+
+/// \brief The timestamp bases type used with RRL entries.
+typedef RRLTimeStampBases<TIMESTAMP_BASES_COUNT, TIMESTAMP_FOREVER>
+RRLTimeStamps;
+
+/// \brief A single RRL entry.
+///
+/// An \c RRLEntry object keeps the rate limiting state for a single
+/// \c RRLKey: the current balance of response credits (the "token bucket"),
+/// the time it was last updated, and how many limited responses have been
+/// dropped since the last slip.
+///
+/// The timestamp is stored as a small offset from one of the bases
+/// maintained in \c RRLTimeStamps so the entry can be kept compact; an
+/// entry whose base has been recycled is simply considered to have no
+/// valid timestamp (and so is treated as if it was newly created).
+///
+/// Objects of this class are intended to be preallocated and reused by
+/// \c RRLTable, so it has public intrusive hooks for the table's hash
+/// buckets and LRU list and is default-constructible.  Its \c reset()
+/// method makes a used entry look like a freshly created one for a new key.
+class RRLEntry {
+public:
+    /// \brief Hook type for the hash bucket list.
+    ///
+    /// It's auto-unlink so an entry can be removed from its bucket without
+    /// knowing which bucket it belongs to.
+    typedef boost::intrusive::list_member_hook<
+        boost::intrusive::link_mode<boost::intrusive::auto_unlink> >
+    HashHook;
+
+    /// \brief Hook type for the LRU list.
+    typedef boost::intrusive::list_member_hook<> LRUHook;
+
+    /// \brief The default constructor.
+    ///
+    /// The constructed entry has an unspecified key and no valid timestamp.
+    ///
+    /// \throw None
+    RRLEntry() :
+        responses_(0), timestamp_(0), timestamp_gen_(0),
+        timestamp_valid_(0), slip_count_(0)
+    {}
+
+    /// \brief Make the entry a new one for the given key.
+    ///
+    /// \throw None
+    void reset(const RRLKey& key) {
+        key_ = key;
+        responses_ = 0;
+        timestamp_ = 0;
+        timestamp_gen_ = 0;
+        timestamp_valid_ = 0;
+        slip_count_ = 0;
+    }
+
+    /// \brief Return the key of the entry.
+    ///
+    /// \throw None
+    const RRLKey& getKey() const { return (key_); }
+
+    /// \brief Return the current balance of response credits.
+    ///
+    /// This is mainly intended for tests.
+    ///
+    /// \throw None
+    int getResponseBalance() const { return (responses_); }
+
+    /// \brief Return the number of seconds since the entry was last updated.
+    ///
+    /// If the entry doesn't have a valid timestamp, or the timestamp seems
+    /// to be in the distant future, \c TIMESTAMP_FOREVER is returned.
+    ///
+    /// \throw None
+    int getAge(const RRLTimeStamps& ts_bases, std::time_t now) const;
+
+    /// \brief Set the timestamp of the entry to the given time.
+    ///
+    /// This may result in creating a new timestamp base in \c ts_bases.
+    ///
+    /// \throw None unless the base change callback of \c ts_bases throws.
+    void setTimestamp(RRLTimeStamps& ts_bases, std::time_t now);
+
+    /// \brief Invalidate the timestamp of the entry if it's for the given
+    /// base generation.
+    ///
+    /// This is expected to be called when the timestamp base of the
+    /// generation is about to be reused.
+    ///
+    /// \throw None
+    void invalidateTimestamp(size_t gen) {
+        if (timestamp_gen_ == gen) {
+            timestamp_valid_ = 0;
+        }
+    }
+
+    /// \brief Update the entry for a new response and decide what to do.
+    ///
+    /// The entry is first credited for the time elapsed since the last
+    /// update at the rate of \c rate responses per second (up to \c rate),
+    /// and then debited by one for the new response.  If the balance stays
+    /// non negative, \c RRL_OK is returned.  Otherwise the response is
+    /// limited: the balance is kept from going below <code>-window *
+    /// rate</code>, and \c RRL_SLIP is returned for every \c slip limited
+    /// responses (if \c slip is non 0); \c RRL_DROP is returned in all other
+    /// cases.
+    ///
+    /// \throw None unless the base change callback of \c ts_bases throws.
+    ///
+    /// \param ts_bases Timestamp bases used for the entry.
+    /// \param rate Allowed responses per second; must be positive.
+    /// \param slip The ratio of slipped responses for limited responses.
+    /// \param window The window of rate limiting in seconds.
+    /// \param now The current time.
+    RRLResult updateBalance(RRLTimeStamps& ts_bases, int rate, int slip,
+                            int window, std::time_t now);
+
+    /// \brief Hook for the bucket of \c RRLTable.
+    HashHook hash_hook_;
+
+    /// \brief Hook for the LRU list of \c RRLTable.
+    LRUHook lru_hook_;
+
+private:
+    RRLKey key_;
+    int32_t responses_;
+    uint16_t timestamp_ : 12;      // seconds since the base of timestamp_gen_
+    uint16_t timestamp_gen_ : 2;   // generation ID of the timestamp base
+    uint16_t timestamp_valid_ : 1; // 1 iff timestamp_ is valid
+    uint8_t slip_count_;           // limited responses since the last slip
+};
+
+// Make sure the bit fields can hold the possible range of values.
+BOOST_STATIC_ASSERT(TIMESTAMP_BASES_COUNT <= (1 << 2));
+BOOST_STATIC_ASSERT(TIMESTAMP_FOREVER <= (1 << 12));
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_ENTRY_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,100 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/rrl_table.h>
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+
+#include <exceptions/exceptions.h>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+RRLTable::RRLTable(size_t max_entries) :
+    max_entries_(max_entries), used_count_(0), bucket_mask_(0)
+{
+    if (max_entries == 0) {
+        bundy_throw(InvalidParameter, "RRL table size must be positive");
+    }
+
+    // Use a power of 2 for the number of buckets so we can use a bit mask
+    // instead of modulo.  Keep the load factor at most 1.
+    size_t n_buckets = 1;
+    while (n_buckets < max_entries) {
+        n_buckets <<= 1;
+    }
+    bucket_mask_ = n_buckets - 1;
+
+    entries_.reset(new RRLEntry[max_entries]);
+    buckets_.reset(new Bucket[n_buckets]);
+
+    // Initially all entries are unused and in the LRU list; the unused
+    // entries are at the tail so they'll be used first.
+    for (size_t i = 0; i < max_entries; ++i) {
+        lru_.push_back(entries_[i]);
+    }
+}
+
+RRLEntry*
+RRLTable::findEntryInBucket(const RRLKey& key, const Bucket& bucket) const {
+    for (Bucket::const_iterator it = bucket.begin(); it != bucket.end();
+         ++it) {
+        if (it->getKey() == key) {
+            return (const_cast<RRLEntry*>(&*it));
+        }
+    }
+    return (NULL);
+}
+
+const RRLEntry*
+RRLTable::findEntry(const RRLKey& key) const {
+    return (findEntryInBucket(key, buckets_[key.getHash() & bucket_mask_]));
+}
+
+RRLEntry*
+RRLTable::getEntry(const RRLKey& key) {
+    Bucket& bucket = buckets_[key.getHash() & bucket_mask_];
+    RRLEntry* entry = findEntryInBucket(key, bucket);
+    if (entry == NULL) {
+        // Recycle the least recently used entry (which may be a never-used
+        // one).  Since the bucket hook is auto-unlink we can remove it from
+        // its current bucket (if any) without knowing the bucket.
+        entry = &lru_.back();
+        if (entry->hash_hook_.is_linked()) {
+            entry->hash_hook_.unlink();
+        } else {
+            ++used_count_;
+        }
+        entry->reset(key);
+        bucket.push_front(*entry);
+    }
+
+    // Make it the most recently used one.
+    lru_.erase(lru_.iterator_to(*entry));
+    lru_.push_front(*entry);
+
+    return (entry);
+}
+
+void
+RRLTable::timestampBaseChanged(size_t gen) {
+    for (size_t i = 0; i < max_entries_; ++i) {
+        entries_[i].invalidateTimestamp(gen);
+    }
+}
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
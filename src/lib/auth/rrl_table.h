@@ -0,0 +1,120 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef AUTH_RRL_TABLE_H
+#define AUTH_RRL_TABLE_H 1
+
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+#include <cstddef>
+
+namespace bundy {
+namespace auth {
+namespace detail {
+
+/// \brief The table of RRL entries.
+///
+/// This class manages a fixed number of \c RRLEntry objects that are
+/// allocated on construction, so no memory allocation happens while
+/// handling queries.  Entries are looked up by \c RRLKey via a hash table
+/// of intrusive lists, and are also linked in an LRU list; when a new key
+/// needs an entry and all entries are in use, the least recently used one
+/// is recycled.
+///
+/// The table should be sized large enough to hold all clients (or client
+/// networks) that are actively being limited; if it's too small, an
+/// attacker's entry can be recycled before its penalty expires.
+///
+/// This class is not thread safe.
+class RRLTable : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw bundy::InvalidParameter max_entries is 0
+    /// \throw std::bad_alloc memory allocation failed
+    ///
+    /// \param max_entries The number of entries to be allocated.
+    explicit RRLTable(size_t max_entries);
+
+    /// \brief Return the entry for the given key, creating one if necessary.
+    ///
+    /// If there's no entry for the key in the table, an unused entry or
+    /// (if all entries are in use) the least recently used one will be reset
+    /// for the key and returned.  In either case the returned entry becomes
+    /// the most recently used one.
+    ///
+    /// \throw None
+    RRLEntry* getEntry(const RRLKey& key);
+
+    /// \brief Find the entry for the given key without creating a new one.
+    ///
+    /// Unlike \c getEntry(), the LRU list won't be updated.
+    ///
+    /// \throw None
+    ///
+    /// \return A pointer to the entry if found; NULL otherwise.
+    const RRLEntry* findEntry(const RRLKey& key) const;
+
+    /// \brief Invalidate timestamps for the given base generation.
+    ///
+    /// This is expected to be used as the base change callback of
+    /// \c RRLTimeStamps.
+    ///
+    /// \throw None
+    void timestampBaseChanged(size_t gen);
+
+    /// \brief Return the number of entries that have been used for some key.
+    ///
+    /// \throw None
+    size_t getEntryCount() const { return (used_count_); }
+
+    /// \brief Return the number of (preallocated) entries in the table.
+    ///
+    /// \throw None
+    size_t getMaxEntries() const { return (max_entries_); }
+
+private:
+    typedef boost::intrusive::list<
+        RRLEntry,
+        boost::intrusive::member_hook<RRLEntry, RRLEntry::HashHook,
+                                      &RRLEntry::hash_hook_>,
+        boost::intrusive::constant_time_size<false> > Bucket;
+    typedef boost::intrusive::list<
+        RRLEntry,
+        boost::intrusive::member_hook<RRLEntry, RRLEntry::LRUHook,
+                                      &RRLEntry::lru_hook_> > LRUList;
+
+    RRLEntry* findEntryInBucket(const RRLKey& key, const Bucket& bucket) const;
+
+    const size_t max_entries_;
+    size_t used_count_;
+    size_t bucket_mask_;
+    boost::scoped_array<RRLEntry> entries_;
+    boost::scoped_array<Bucket> buckets_;
+    LRUList lru_;
+};
+
+} // namespace detail
+} // namespace auth
+} // namespace bundy
+
+#endif // AUTH_RRL_TABLE_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -0,0 +1,205 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/response_cache.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/message.h>
+#include <dns/name.h>
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <util/buffer.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/shared_ptr.hpp>
+
+#include <cstring>
+#include <vector>
+
+using namespace bundy::auth;
+using namespace bundy::dns;
+using bundy::util::OutputBuffer;
+
+namespace {
+
+// A fake response: ID 0, QR/AA/RD set, then some body data.
+const uint8_t RESPONSE[] = {
+    0x00, 0x00, 0x85, 0x00, 0x00, 0x01, 0x00, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0xde, 0xad, 0xbe, 0xef
+};
+
+class ResponseCacheTest : public ::testing::Test {
+protected:
+    ResponseCacheTest() :
+        cache_(3, 0), buffer_(0),
+        key_(Name("www.example.com"), RRType::A(), RRClass::IN(), true,
+             false, 4096)
+    {}
+
+    ResponseCacheKey createKey(const char* name,
+                               const RRClass& rrclass = RRClass::IN())
+    {
+        return (ResponseCacheKey(Name(name), RRType::A(), rrclass, true,
+                                 false, 4096));
+    }
+
+    bool find(const ResponseCacheKey& key) {
+        buffer_.clear();
+        return (cache_.find(key, 4096, 0x1234, 0, buffer_));
+    }
+
+    ResponseCache cache_;
+    OutputBuffer buffer_;
+    const ResponseCacheKey key_;
+};
+
+TEST_F(ResponseCacheTest, construct) {
+    EXPECT_EQ(3, cache_.getMaxEntries());
+    EXPECT_EQ(0, cache_.getEntryCount());
+    EXPECT_THROW(ResponseCache(0, 0), bundy::InvalidParameter);
+}
+
+TEST_F(ResponseCacheTest, key) {
+    // Keys differ if any of the parameters differ, including the case of
+    // the query name.
+    const ResponseCacheKey key2(Name("WWW.example.com"), RRType::A(),
+                                RRClass::IN(), true, false, 4096);
+    EXPECT_EQ(key_.getLength(), key2.getLength());
+    EXPECT_NE(0, std::memcmp(key_.getData(), key2.getData(),
+                             key_.getLength()));
+    const ResponseCacheKey key3(Name("www.example.com"), RRType::A(),
+                                RRClass::IN(), true, true, 4096);
+    EXPECT_NE(0, std::memcmp(key_.getData(), key3.getData(),
+                             key_.getLength()));
+    const ResponseCacheKey key4(Name("www.example.com"), RRType::A(),
+                                RRClass::IN(), false, false, 4096);
+    EXPECT_NE(0, std::memcmp(key_.getData(), key4.getData(),
+                             key_.getLength()));
+
+    // Limits in the same bucket make the same key, but not in different ones.
+    const ResponseCacheKey key5(Name("www.example.com"), RRType::A(),
+                                RRClass::IN(), true, false, 4000);
+    EXPECT_EQ(0, std::memcmp(key_.getData(), key5.getData(),
+                             key_.getLength()));
+    const ResponseCacheKey key6(Name("www.example.com"), RRType::A(),
+                                RRClass::IN(), true, false, 512);
+    EXPECT_NE(0, std::memcmp(key_.getData(), key6.getData(),
+                             key_.getLength()));
+    EXPECT_EQ(key_.getHash(0), key5.getHash(0));
+    EXPECT_NE(key_.getHash(0), key_.getHash(1));
+}
+
+TEST_F(ResponseCacheTest, insertAndFind) {
+    EXPECT_FALSE(find(key_));
+
+    cache_.insert(key_, RESPONSE, sizeof(RESPONSE));
+    EXPECT_EQ(1, cache_.getEntryCount());
+
+    // The ID is replaced; RD is cleared as the query doesn't have it, and CD
+    // is set.
+    buffer_.clear();
+    ASSERT_TRUE(cache_.find(key_, 4096, 0x1234, Message::HEADERFLAG_CD |
+                            Message::HEADERFLAG_QR, buffer_));
+    ASSERT_EQ(sizeof(RESPONSE), buffer_.getLength());
+    std::vector<uint8_t> expected(RESPONSE, RESPONSE + sizeof(RESPONSE));
+    expected[0] = 0x12;
+    expected[1] = 0x34;
+    expected[2] = 0x84;
+    expected[3] = 0x10;
+    EXPECT_EQ(0, std::memcmp(&expected[0], buffer_.getData(),
+                             expected.size()));
+
+    // Too large for the limit.
+    EXPECT_FALSE(cache_.find(key_, sizeof(RESPONSE) - 1, 0, 0, buffer_));
+
+    // Replacing an existing one doesn't consume a new entry.
+    cache_.insert(key_, RESPONSE, sizeof(RESPONSE) - 4);
+    EXPECT_EQ(1, cache_.getEntryCount());
+    EXPECT_TRUE(find(key_));
+    EXPECT_EQ(sizeof(RESPONSE) - 4, buffer_.getLength());
+
+    EXPECT_THROW(cache_.insert(key_, RESPONSE, 11), bundy::InvalidParameter);
+}
+
+TEST_F(ResponseCacheTest, nxdomainZone) {
+    boost::shared_ptr<const Name> zone;
+    cache_.insert(key_, RESPONSE, sizeof(RESPONSE));
+    ASSERT_TRUE(cache_.find(key_, 4096, 0, 0, buffer_, &zone));
+    EXPECT_FALSE(zone);
+
+    const Name origin("example.com");
+    cache_.insert(key_, RESPONSE, sizeof(RESPONSE), &origin);
+    ASSERT_TRUE(cache_.find(key_, 4096, 0, 0, buffer_, &zone));
+    ASSERT_TRUE(zone);
+    EXPECT_EQ(origin, *zone);
+}
+
+TEST_F(ResponseCacheTest, recycle) {
+    cache_.insert(createKey("a.example"), RESPONSE, sizeof(RESPONSE));
+    cache_.insert(createKey("b.example"), RESPONSE, sizeof(RESPONSE));
+    cache_.insert(createKey("c.example"), RESPONSE, sizeof(RESPONSE));
+    EXPECT_EQ(3, cache_.getEntryCount());
+
+    // Make "a" most recently used, then "b" will be removed for a new one.
+    EXPECT_TRUE(find(createKey("a.example")));
+    cache_.insert(createKey("d.example"), RESPONSE, sizeof(RESPONSE));
+    EXPECT_EQ(3, cache_.getEntryCount());
+    EXPECT_TRUE(find(createKey("a.example")));
+    EXPECT_FALSE(find(createKey("b.example")));
+    EXPECT_TRUE(find(createKey("c.example")));
+    EXPECT_TRUE(find(createKey("d.example")));
+}
+
+TEST_F(ResponseCacheTest, invalidate) {
+    cache_.insert(createKey("example.com"), RESPONSE, sizeof(RESPONSE));
+    cache_.insert(createKey("WWW.Example.COM"), RESPONSE, sizeof(RESPONSE));
+    cache_.insert(createKey("example.org"), RESPONSE, sizeof(RESPONSE));
+
+    // Different class; nothing happens.
+    cache_.invalidate(RRClass::CH(), Name("example.com"));
+    EXPECT_EQ(3, cache_.getEntryCount());
+
+    // A name that isn't at a label boundary doesn't match.
+    cache_.invalidate(RRClass::IN(), Name("ample.com"));
+    EXPECT_EQ(3, cache_.getEntryCount());
+
+    // The origin and names under it are removed, ignoring case.
+    cache_.invalidate(RRClass::IN(), Name("EXAMPLE.com"));
+    EXPECT_EQ(1, cache_.getEntryCount());
+    EXPECT_FALSE(find(createKey("example.com")));
+    EXPECT_FALSE(find(createKey("WWW.Example.COM")));
+    EXPECT_TRUE(find(createKey("example.org")));
+
+    // The removed entries are reused for new ones.
+    cache_.insert(createKey("a.example"), RESPONSE, sizeof(RESPONSE));
+    cache_.insert(createKey("b.example"), RESPONSE, sizeof(RESPONSE));
+    EXPECT_EQ(3, cache_.getEntryCount());
+    EXPECT_TRUE(find(createKey("example.org")));
+
+    // Root removes everything of the class.
+    cache_.insert(createKey("c.example", RRClass::CH()), RESPONSE,
+                  sizeof(RESPONSE));
+    cache_.invalidate(RRClass::IN(), Name::ROOT_NAME());
+    EXPECT_EQ(1, cache_.getEntryCount());
+    EXPECT_TRUE(find(createKey("c.example", RRClass::CH())));
+
+    cache_.clear();
+    EXPECT_EQ(0, cache_.getEntryCount());
+    EXPECT_FALSE(find(createKey("c.example", RRClass::CH())));
+}
+
+}
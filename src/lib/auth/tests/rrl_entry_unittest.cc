@@ -0,0 +1,150 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+#include <auth/rrl_result.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_address.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <ctime>
+
+#include <netinet/in.h>
+
+using namespace bundy::auth;
+using namespace bundy::auth::detail;
+using namespace bundy::dns;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOAddress;
+
+namespace {
+
+const uint32_t MASK6[4] = { 0xffffffff, 0xffffffff, 0, 0 };
+
+class RRLEntryTest : public ::testing::Test {
+protected:
+    RRLEntryTest() :
+        ep_(IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.1"), 53210)),
+        qname_("example.com"), qlabels_(qname_),
+        ts_bases_(NOW, boost::bind(&RRLEntryTest::callback, this, _1)),
+        callback_gen_(TIMESTAMP_BASES_COUNT)
+    {
+        entry_.reset(RRLKey(*ep_, RRType::A(), &qlabels_, RRClass::IN(),
+                            RESPONSE_QUERY, 0xffffffff, MASK6, 0));
+    }
+
+    void callback(size_t gen) { callback_gen_ = gen; }
+
+    static const std::time_t NOW = 1000;
+    boost::scoped_ptr<const IOEndpoint> ep_;
+    const Name qname_;
+    const LabelSequence qlabels_;
+    RRLTimeStamps ts_bases_;
+    size_t callback_gen_;
+    RRLEntry entry_;
+};
+
+const std::time_t RRLEntryTest::NOW;
+
+TEST_F(RRLEntryTest, timestamp) {
+    // A new entry doesn't have a valid timestamp.
+    EXPECT_EQ(TIMESTAMP_FOREVER, entry_.getAge(ts_bases_, NOW));
+
+    entry_.setTimestamp(ts_bases_, NOW);
+    EXPECT_EQ(0, entry_.getAge(ts_bases_, NOW));
+    EXPECT_EQ(10, entry_.getAge(ts_bases_, NOW + 10));
+
+    // Invalidating a different generation doesn't affect the entry.
+    entry_.invalidateTimestamp(1);
+    EXPECT_EQ(10, entry_.getAge(ts_bases_, NOW + 10));
+    entry_.invalidateTimestamp(0);
+    EXPECT_EQ(TIMESTAMP_FOREVER, entry_.getAge(ts_bases_, NOW + 10));
+
+    // Setting a timestamp far from the base creates a new base.
+    entry_.setTimestamp(ts_bases_, NOW + TIMESTAMP_FOREVER);
+    EXPECT_EQ(1, callback_gen_);
+    EXPECT_EQ(5, entry_.getAge(ts_bases_, NOW + TIMESTAMP_FOREVER + 5));
+}
+
+TEST_F(RRLEntryTest, updateBalanceNoSlip) {
+    // A new entry starts with the full credits (rate).  The balance
+    // is debited for each response.
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 10, 0, 15, NOW));
+    }
+    EXPECT_EQ(0, entry_.getResponseBalance());
+
+    // Then responses will be dropped.
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 10, 0, 15, NOW));
+    EXPECT_EQ(-1, entry_.getResponseBalance());
+
+    // The balance doesn't go below -window * rate.
+    for (int i = 0; i < 200; ++i) {
+        entry_.updateBalance(ts_bases_, 10, 0, 15, NOW);
+    }
+    EXPECT_EQ(-150, entry_.getResponseBalance());
+
+    // After 10 seconds the balance gets 100 credits, not enough to answer.
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 10, 0, 15, NOW + 10));
+    EXPECT_EQ(-51, entry_.getResponseBalance());
+
+    // After another 6 seconds it's credited again up to the rate.
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 10, 0, 15, NOW + 16));
+    EXPECT_EQ(8, entry_.getResponseBalance());
+
+    // If the entry is older than the window, it's just reset to the rate.
+    for (int i = 0; i < 20; ++i) {
+        entry_.updateBalance(ts_bases_, 10, 0, 15, NOW + 16);
+    }
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 10, 0, 15, NOW + 32));
+    EXPECT_EQ(9, entry_.getResponseBalance());
+}
+
+TEST_F(RRLEntryTest, updateBalanceSlip) {
+    // Consume the credits.
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 1, 2, 15, NOW));
+
+    // With slip = 2, every other limited response slips, starting with
+    // the first one.
+    EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 2, 15, NOW));
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 2, 15, NOW));
+    EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 2, 15, NOW));
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 2, 15, NOW));
+
+    // With slip = 1, all limited responses slip.
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 1, 15, NOW));
+    }
+
+    // With slip = 3: slip, drop, drop, slip...
+    entry_.reset(entry_.getKey());
+    EXPECT_EQ(RRL_OK, entry_.updateBalance(ts_bases_, 1, 3, 15, NOW));
+    EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 3, 15, NOW));
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 3, 15, NOW));
+    EXPECT_EQ(RRL_DROP, entry_.updateBalance(ts_bases_, 1, 3, 15, NOW));
+    EXPECT_EQ(RRL_SLIP, entry_.updateBalance(ts_bases_, 1, 3, 15, NOW));
+}
+
+}
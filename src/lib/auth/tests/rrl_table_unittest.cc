@@ -0,0 +1,112 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/rrl_table.h>
+#include <auth/rrl_entry.h>
+#include <auth/rrl_key.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_address.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <string>
+
+#include <netinet/in.h>
+
+using namespace bundy::auth::detail;
+using namespace bundy::dns;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOAddress;
+
+namespace {
+
+const uint32_t MASK6[4] = { 0xffffffff, 0xffffffff, 0, 0 };
+
+// Create a key that only differs in the client address for the given ID.
+RRLKey
+createKey(int id) {
+    const std::string addr = "192.0.2." + boost::lexical_cast<std::string>(id);
+    boost::scoped_ptr<const IOEndpoint> ep(
+        IOEndpoint::create(IPPROTO_UDP, IOAddress(addr), 53210));
+    return (RRLKey(*ep, RRType::A(), NULL, RRClass::IN(), RESPONSE_QUERY,
+                   0xffffffff, MASK6, 0));
+}
+
+TEST(RRLTableTest, badConstruct) {
+    EXPECT_THROW(RRLTable(0), bundy::InvalidParameter);
+}
+
+TEST(RRLTableTest, getEntry) {
+    RRLTable table(3);
+    EXPECT_EQ(3, table.getMaxEntries());
+    EXPECT_EQ(0, table.getEntryCount());
+
+    const RRLKey key1 = createKey(1);
+    EXPECT_EQ(static_cast<const RRLEntry*>(NULL), table.findEntry(key1));
+
+    // Getting an entry for a new key creates it.
+    RRLEntry* entry1 = table.getEntry(key1);
+    ASSERT_NE(static_cast<RRLEntry*>(NULL), entry1);
+    EXPECT_TRUE(entry1->getKey() == key1);
+    EXPECT_EQ(1, table.getEntryCount());
+    EXPECT_EQ(entry1, table.findEntry(key1));
+
+    // Getting it again returns the same entry.
+    EXPECT_EQ(entry1, table.getEntry(key1));
+    EXPECT_EQ(1, table.getEntryCount());
+
+    RRLEntry* entry2 = table.getEntry(createKey(2));
+    RRLEntry* entry3 = table.getEntry(createKey(3));
+    EXPECT_NE(entry1, entry2);
+    EXPECT_NE(entry2, entry3);
+    EXPECT_EQ(3, table.getEntryCount());
+
+    // Make entry1 most recently used, then a new key will recycle the least
+    // recently used one, entry2.
+    table.getEntry(key1);
+    EXPECT_EQ(entry2, table.getEntry(createKey(4)));
+    EXPECT_EQ(3, table.getEntryCount());
+    EXPECT_EQ(static_cast<const RRLEntry*>(NULL),
+              table.findEntry(createKey(2)));
+    EXPECT_EQ(entry1, table.findEntry(key1));
+    EXPECT_EQ(entry3, table.findEntry(createKey(3)));
+    EXPECT_EQ(entry2, table.findEntry(createKey(4)));
+}
+
+TEST(RRLTableTest, timestampBaseChanged) {
+    RRLTable table(2);
+    RRLTimeStamps ts_bases(100, boost::bind(&RRLTable::timestampBaseChanged,
+                                            &table, _1));
+    RRLEntry* entry = table.getEntry(createKey(1));
+    entry->setTimestamp(ts_bases, 100);
+    EXPECT_EQ(0, entry->getAge(ts_bases, 100));
+
+    // Updating the base 4 times will recycle the base of the entry.
+    for (int i = 1; i <= 4; ++i) {
+        ts_bases.getCurrentBase(100 + i * TIMESTAMP_FOREVER);
+    }
+    EXPECT_EQ(TIMESTAMP_FOREVER, entry->getAge(ts_bases, 100));
+}
+
+}
@@ -0,0 +1,175 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <auth/rrl.h>
+#include <auth/rrl_response_type.h>
+#include <auth/rrl_result.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/rrtype.h>
+#include <dns/rrclass.h>
+
+#include <asiolink/io_endpoint.h>
+#include <asiolink/io_address.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/scoped_ptr.hpp>
+
+#include <ctime>
+
+#include <netinet/in.h>
+
+using namespace bundy::auth;
+using namespace bundy::auth::detail;
+using namespace bundy::dns;
+using bundy::asiolink::IOEndpoint;
+using bundy::asiolink::IOAddress;
+
+namespace {
+
+const std::time_t NOW = 1000;
+
+class RRLTest : public ::testing::Test {
+protected:
+    RRLTest() :
+        rrl_(5, 2, 1, 15, 0, 100, 24, 56, NOW, 0),
+        qname_("www.example.com"), qlabels_(qname_),
+        zname_("example.com"), zlabels_(zname_)
+    {}
+
+    // Shortcut for check() with common parameters
+    RRLResult check(const char* addr, ResponseType resp_type,
+                    std::time_t now = NOW, bool is_tcp = false)
+    {
+        ep_.reset(IOEndpoint::create(is_tcp ? IPPROTO_TCP : IPPROTO_UDP,
+                                     IOAddress(addr), 53210));
+        const LabelSequence* qlabels = NULL;
+        if (resp_type == RESPONSE_QUERY) {
+            qlabels = &qlabels_;
+        } else if (resp_type == RESPONSE_NXDOMAIN) {
+            qlabels = &zlabels_;
+        }
+        return (rrl_.check(*ep_, is_tcp, RRClass::IN(), RRType::A(), qlabels,
+                           resp_type, now));
+    }
+
+    ResponseRateLimiter rrl_;
+    boost::scoped_ptr<const IOEndpoint> ep_;
+    const Name qname_;
+    const LabelSequence qlabels_;
+    const Name zname_;
+    const LabelSequence zlabels_;
+};
+
+TEST_F(RRLTest, construct) {
+    EXPECT_EQ(5, rrl_.getResponseRate());
+    EXPECT_EQ(2, rrl_.getNXDOMAINRate());
+    EXPECT_EQ(1, rrl_.getErrorRate());
+    EXPECT_EQ(15, rrl_.getWindow());
+    EXPECT_EQ(0, rrl_.getSlip());
+    EXPECT_EQ(100, rrl_.getTableSize());
+    EXPECT_EQ(0, rrl_.getEntryCount());
+
+    // Some invalid parameters
+    EXPECT_THROW(ResponseRateLimiter(-1, 0, 0, 15, 2, 100, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, -1, 0, 15, 2, 100, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, -1, 15, 2, 100, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, 0, 0, 2, 100, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, 0, 3601, 2, 100, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, 0, 15, 11, 100, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, 0, 15, 2, 100, 33, 56, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, 0, 15, 2, 100, 24, 129, NOW, 0),
+                 bundy::InvalidParameter);
+    EXPECT_THROW(ResponseRateLimiter(5, 0, 0, 15, 2, 0, 24, 56, NOW, 0),
+                 bundy::InvalidParameter);
+}
+
+TEST_F(RRLTest, checkQuery) {
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_QUERY));
+    }
+    EXPECT_EQ(RRL_DROP, check("192.0.2.1", RESPONSE_QUERY));
+    EXPECT_EQ(1, rrl_.getEntryCount());
+
+    // Clients in the same /24 share the limit.
+    EXPECT_EQ(RRL_DROP, check("192.0.2.200", RESPONSE_QUERY));
+
+    // But not one in a different network.
+    EXPECT_EQ(RRL_OK, check("192.0.1.1", RESPONSE_QUERY));
+    EXPECT_EQ(2, rrl_.getEntryCount());
+
+    // Responses of a different type are limited separately.
+    EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_NXDOMAIN));
+
+    // A second later the client is credited again.
+    EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_QUERY, NOW + 1));
+
+    // TCP is never limited.
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_QUERY, NOW + 1, true));
+    }
+}
+
+TEST_F(RRLTest, checkIPv6) {
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(RRL_OK, check("2001:db8::1", RESPONSE_QUERY));
+    }
+    // Clients in the same /56 share the limit.
+    EXPECT_EQ(RRL_DROP, check("2001:db8:0:ff::1", RESPONSE_QUERY));
+    EXPECT_EQ(RRL_OK, check("2001:db8:0:100::1", RESPONSE_QUERY));
+}
+
+TEST_F(RRLTest, checkNXDOMAINAndError) {
+    EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_NXDOMAIN));
+    EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_NXDOMAIN));
+    EXPECT_EQ(RRL_DROP, check("192.0.2.1", RESPONSE_NXDOMAIN));
+
+    EXPECT_EQ(RRL_OK, check("192.0.2.1", RESPONSE_ERROR));
+    EXPECT_EQ(RRL_DROP, check("192.0.2.1", RESPONSE_ERROR));
+}
+
+TEST_F(RRLTest, checkUnlimited) {
+    // A rate of 0 means responses of that type are not limited.
+    ResponseRateLimiter rrl(0, 0, 0, 15, 2, 100, 24, 56, NOW, 0);
+    ep_.reset(IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.1"), 53210));
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(RRL_OK, rrl.check(*ep_, false, RRClass::IN(), RRType::A(),
+                                    &qlabels_, RESPONSE_QUERY, NOW));
+    }
+    EXPECT_EQ(0, rrl.getEntryCount());
+}
+
+TEST_F(RRLTest, checkSlip) {
+    ResponseRateLimiter rrl(1, 0, 0, 15, 2, 100, 24, 56, NOW, 0);
+    ep_.reset(IOEndpoint::create(IPPROTO_UDP, IOAddress("192.0.2.1"), 53210));
+    EXPECT_EQ(RRL_OK, rrl.check(*ep_, false, RRClass::IN(), RRType::A(),
+                                &qlabels_, RESPONSE_QUERY, NOW));
+    EXPECT_EQ(RRL_SLIP, rrl.check(*ep_, false, RRClass::IN(), RRType::A(),
+                                  &qlabels_, RESPONSE_QUERY, NOW));
+    EXPECT_EQ(RRL_DROP, rrl.check(*ep_, false, RRClass::IN(), RRType::A(),
+                                  &qlabels_, RESPONSE_QUERY, NOW));
+}
+
+}
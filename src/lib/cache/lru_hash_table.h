@@ -0,0 +1,427 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef LRU_HASH_TABLE_H
+#define LRU_HASH_TABLE_H
+
+#include <nsas/hash.h>
+#include <nsas/hash_key.h>
+#include <nsas/hash_table.h>
+#include <util/lru_list.h>
+#include <util/threads/sync.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <list>
+#include <vector>
+
+#include <time.h>
+
+namespace bundy {
+namespace cache {
+
+/// \brief Hash table with a built-in LRU list, split into shards
+///
+/// This is a combination of \c bundy::nsas::HashTable and
+/// \c bundy::util::LruList, which the caches used to maintain separately
+/// (and keep in sync by hand).  The table holds at most \c max_size
+/// objects; when it gets over the limit, the least recently used objects
+/// are dropped.
+///
+/// The table is split into several shards, each of them with its own
+/// hash buckets, LRU list and mutex.  Each key belongs to exactly one
+/// shard, so operations on keys in different shards can run in parallel
+/// without any contention.  The price is that the LRU order is kept only
+/// within each shard and each of them holds at most its share of
+/// \c max_size objects, so the table as a whole is only approximately
+/// LRU.  Small tables (less than \c MIN_SHARD_SIZE objects per shard)
+/// use fewer shards, down to a single one, which behaves as an exact LRU.
+///
+/// Objects may be stale before they fall off the LRU list (cache entries
+/// expire, for example).  If an \c Expired check is given, such objects
+/// are dropped in preference to the least recently used ones when room
+/// is needed.  To keep the operations cheap, only the
+/// \c EXPIRED_SCAN_LIMIT least recently used objects of the shard are
+/// checked.
+///
+/// The objects are expected to be \c bundy::nsas::NsasEntry (or to have
+/// the same interface for the LRU list iterator).
+template <typename T>
+class LruHashTable : boost::noncopyable {
+public:
+    /// \brief Check whether an object is stale
+    ///
+    /// Function object telling if an object can be dropped in preference
+    /// to the least recently used one.
+    class Expired {
+    public:
+        /// \brief Virtual Destructor
+        virtual ~Expired() {}
+
+        /// \brief Check the object
+        ///
+        /// \param object The object to check.
+        /// \return true if the object is stale.
+        virtual bool operator()(const T& object) const = 0;
+    };
+
+    /// \brief Default number of shards
+    static const uint32_t DEFAULT_SHARDS = 16;
+
+    /// \brief Minimal number of objects per shard
+    ///
+    /// Tables smaller than this per shard are split into fewer shards.
+    static const uint32_t MIN_SHARD_SIZE = 1024;
+
+    /// \brief Number of the oldest objects checked for being expired
+    static const uint32_t EXPIRED_SCAN_LIMIT = 8;
+
+    /// \brief Constructor
+    ///
+    /// \param compare Compare object used to compare an object with a key,
+    /// as in \c bundy::nsas::HashTable.  It should be created via "new", as
+    /// the ownership passes to the table.
+    /// \param max_size Maximum number of objects in the table.
+    /// \param table_size Total number of hash buckets in the table.
+    /// \param expired Check for stale objects, or NULL if there's no such
+    /// thing.  The ownership passes to the table as well.
+    /// \param shards Maximum number of shards (see the class description).
+    LruHashTable(bundy::nsas::HashTableCompare<T>* compare, uint32_t max_size,
+                 uint32_t table_size = 1009, Expired* expired = NULL,
+                 uint32_t shards = DEFAULT_SHARDS);
+
+    /// \brief Get Object
+    ///
+    /// Returns the object with the given key.  Unless it's stale, it is
+    /// also marked as the most recently used one in its shard.
+    ///
+    /// \param key Key of the object.
+    /// \return Shared pointer to the object or NULL if it's not there.
+    boost::shared_ptr<T> get(const bundy::nsas::HashKey& key);
+
+    /// \brief Add Object
+    ///
+    /// Adds the object to the table as the most recently used one, and
+    /// drops an expired or the least recently used object of its shard if
+    /// the shard gets over its limit.  If there's an object with the same
+    /// key already, it is either replaced or the addition fails, depending
+    /// on the \c replace parameter.
+    ///
+    /// \param object The object to be added.
+    /// \param key Key of the object.
+    /// \param replace Whether an existing object with the same key should
+    /// be replaced.
+    /// \return true if the object was added, false otherwise.
+    bool add(boost::shared_ptr<T>& object, const bundy::nsas::HashKey& key,
+             bool replace = false);
+
+    /// \brief Remove Object
+    ///
+    /// \param key Key of the object.
+    /// \return true if the object was removed, false if it was not found.
+    bool remove(const bundy::nsas::HashKey& key);
+
+    /// \brief Remove Object if it's still the given one
+    ///
+    /// Like the other version, but the object is removed only if it is
+    /// the given one.  This is for dropping an object found stale by
+    /// \c get(): another thread may have replaced it by a fresh one with
+    /// \c add() in the meantime, which must be kept.
+    ///
+    /// \param key Key of the object.
+    /// \param object The object to be removed.
+    /// \return true if the object was removed, false if the key was not
+    /// found or it is another object.
+    bool remove(const bundy::nsas::HashKey& key,
+                const boost::shared_ptr<T>& object);
+
+    /// \brief Remove all the objects
+    void clear();
+
+    /// \brief Get all the objects
+    ///
+    /// Appends all the objects in the table to the given vector, without
+    /// touching them.  Each shard is locked while it is being copied, so
+    /// the result is consistent within a shard.  The objects of each shard
+    /// come from the least recently used one to the most recently used
+    /// one, so adding them back in this order restores the LRU order.
+    ///
+    /// \param objects The vector to append the objects to.
+    void snapshot(std::vector<boost::shared_ptr<T> >& objects) const;
+
+    /// \brief Number of objects in the table
+    ///
+    /// The shards are not locked, so the value may be slightly outdated if
+    /// other threads modify the table at the same time.
+    uint32_t size() const;
+
+    /// \brief Maximum number of objects in the table
+    uint32_t getMaxSize() const {
+        return (shard_max_size_ * shard_count_);
+    }
+
+    /// \brief Number of shards the table is split into
+    uint32_t getShardCount() const {
+        return (shard_count_);
+    }
+
+private:
+    typedef typename bundy::util::LruList<T>::lru_list List;
+
+    struct Shard {
+        Shard() : count_(0) {}
+        bundy::util::thread::Mutex mutex_;
+        std::vector<List> buckets_;
+        List lru_;
+        uint32_t count_;
+    };
+
+    // Internal parts, expect the shard to be already locked
+    typename List::iterator find(List& bucket,
+                                 const bundy::nsas::HashKey& key);
+    void erase(Shard& shard, List& bucket, typename List::iterator it);
+    void evict(Shard& shard);
+
+    // The number of shards for the table of given size (see the class
+    // description)
+    static uint32_t calculateShardCount(uint32_t max_size, uint32_t shards) {
+        const uint32_t count = max_size / MIN_SHARD_SIZE;
+        if (count < 1 || shards < 1) {
+            return (1);
+        }
+        return (count < shards ? count : shards);
+    }
+
+    // Find the shard and bucket of the key
+    Shard& getShard(uint32_t hash) {
+        return (shards_[hash % shard_count_]);
+    }
+    List& getBucket(Shard& shard, uint32_t hash) {
+        return (shard.buckets_[hash / shard_count_]);
+    }
+
+    const uint32_t shard_count_;
+    const uint32_t shard_max_size_;
+    const uint32_t buckets_per_shard_;
+    bundy::nsas::Hash hash_;
+    boost::scoped_array<Shard> shards_;
+    boost::shared_ptr<bundy::nsas::HashTableCompare<T> > compare_;
+    boost::shared_ptr<Expired> expired_;
+};
+
+template <typename T>
+const uint32_t LruHashTable<T>::DEFAULT_SHARDS;
+template <typename T>
+const uint32_t LruHashTable<T>::MIN_SHARD_SIZE;
+template <typename T>
+const uint32_t LruHashTable<T>::EXPIRED_SCAN_LIMIT;
+
+/// \brief Expired check based on the expire time of the object
+///
+/// The object is considered stale if its \c getExpireTime() is not in
+/// the future.  This is what the cache entries use.
+template <typename T>
+class ExpireTimeCheck : public LruHashTable<T>::Expired {
+public:
+    virtual bool operator()(const T& object) const {
+        return (object.getExpireTime() <= time(NULL));
+    }
+};
+
+template <typename T>
+LruHashTable<T>::LruHashTable(bundy::nsas::HashTableCompare<T>* compare,
+                              uint32_t max_size, uint32_t table_size,
+                              Expired* expired, uint32_t shards) :
+    shard_count_(calculateShardCount(max_size, shards)),
+    shard_max_size_((max_size + shard_count_ - 1) / shard_count_),
+    buckets_per_shard_(table_size / shard_count_ > 0 ?
+                       table_size / shard_count_ : 1),
+    hash_(buckets_per_shard_ * shard_count_, MAX_KEY_LENGTH),
+    shards_(new Shard[shard_count_]), compare_(compare), expired_(expired)
+{
+    for (uint32_t i = 0; i < shard_count_; ++i) {
+        shards_[i].buckets_.resize(buckets_per_shard_);
+    }
+}
+
+template <typename T>
+typename LruHashTable<T>::List::iterator
+LruHashTable<T>::find(List& bucket, const bundy::nsas::HashKey& key) {
+    typename List::iterator it;
+    for (it = bucket.begin(); it != bucket.end(); ++it) {
+        if ((*compare_)(it->get(), key)) {
+            break;
+        }
+    }
+    return (it);
+}
+
+template <typename T>
+void
+LruHashTable<T>::erase(Shard& shard, List& bucket,
+                       typename List::iterator it)
+{
+    const boost::shared_ptr<T> object(*it);
+    shard.lru_.erase(object->getLruIterator());
+    object->invalidateIterator();
+    bucket.erase(it);
+    --shard.count_;
+}
+
+template <typename T>
+void
+LruHashTable<T>::evict(Shard& shard) {
+    // Look for an expired object among the oldest ones first, drop the
+    // least recently used one if there's none.
+    typename List::iterator victim = shard.lru_.begin();
+    if (expired_) {
+        typename List::iterator it = shard.lru_.begin();
+        for (uint32_t i = 0; i < EXPIRED_SCAN_LIMIT && it != shard.lru_.end();
+             ++i, ++it) {
+            if ((*expired_)(**it)) {
+                victim = it;
+                break;
+            }
+        }
+    }
+    const bundy::nsas::HashKey key = (*victim)->hashKey();
+    List& bucket = getBucket(shard, hash_(key));
+    erase(shard, bucket, find(bucket, key));
+}
+
+template <typename T>
+boost::shared_ptr<T>
+LruHashTable<T>::get(const bundy::nsas::HashKey& key) {
+    const uint32_t hash = hash_(key);
+    Shard& shard = getShard(hash);
+    bundy::util::thread::Mutex::Locker locker(shard.mutex_);
+    List& bucket = getBucket(shard, hash);
+    const typename List::iterator it = find(bucket, key);
+    if (it == bucket.end()) {
+        return (boost::shared_ptr<T>());
+    }
+    if (!expired_ || !(*expired_)(**it)) {
+        shard.lru_.splice(shard.lru_.end(), shard.lru_,
+                          (*it)->getLruIterator());
+    }
+    return (*it);
+}
+
+template <typename T>
+bool
+LruHashTable<T>::add(boost::shared_ptr<T>& object,
+                     const bundy::nsas::HashKey& key, bool replace)
+{
+    const uint32_t hash = hash_(key);
+    Shard& shard = getShard(hash);
+    bundy::util::thread::Mutex::Locker locker(shard.mutex_);
+    List& bucket = getBucket(shard, hash);
+    const typename List::iterator it = find(bucket, key);
+    if (it != bucket.end()) {
+        if (!replace) {
+            return (false);
+        }
+        erase(shard, bucket, it);
+    }
+
+    bucket.push_back(object);
+    object->setLruIterator(shard.lru_.insert(shard.lru_.end(), object));
+    ++shard.count_;
+    while (shard.count_ > shard_max_size_) {
+        evict(shard);
+    }
+    return (true);
+}
+
+template <typename T>
+bool
+LruHashTable<T>::remove(const bundy::nsas::HashKey& key) {
+    const uint32_t hash = hash_(key);
+    Shard& shard = getShard(hash);
+    bundy::util::thread::Mutex::Locker locker(shard.mutex_);
+    List& bucket = getBucket(shard, hash);
+    const typename List::iterator it = find(bucket, key);
+    if (it == bucket.end()) {
+        return (false);
+    }
+    erase(shard, bucket, it);
+    return (true);
+}
+
+template <typename T>
+bool
+LruHashTable<T>::remove(const bundy::nsas::HashKey& key,
+                        const boost::shared_ptr<T>& object)
+{
+    const uint32_t hash = hash_(key);
+    Shard& shard = getShard(hash);
+    bundy::util::thread::Mutex::Locker locker(shard.mutex_);
+    List& bucket = getBucket(shard, hash);
+    const typename List::iterator it = find(bucket, key);
+    if (it == bucket.end() || *it != object) {
+        return (false);
+    }
+    erase(shard, bucket, it);
+    return (true);
+}
+
+template <typename T>
+void
+LruHashTable<T>::clear() {
+    for (uint32_t i = 0; i < shard_count_; ++i) {
+        Shard& shard = shards_[i];
+        bundy::util::thread::Mutex::Locker locker(shard.mutex_);
+        for (typename List::iterator it = shard.lru_.begin();
+             it != shard.lru_.end(); ++it) {
+            (*it)->invalidateIterator();
+        }
+        shard.lru_.clear();
+        for (uint32_t j = 0; j < buckets_per_shard_; ++j) {
+            shard.buckets_[j].clear();
+        }
+        shard.count_ = 0;
+    }
+}
+
+template <typename T>
+void
+LruHashTable<T>::snapshot(std::vector<boost::shared_ptr<T> >& objects) const {
+    objects.reserve(objects.size() + size());
+    for (uint32_t i = 0; i < shard_count_; ++i) {
+        Shard& shard = shards_[i];
+        bundy::util::thread::Mutex::Locker locker(shard.mutex_);
+        objects.insert(objects.end(), shard.lru_.begin(), shard.lru_.end());
+    }
+}
+
+template <typename T>
+uint32_t
+LruHashTable<T>::size() const {
+    uint32_t count = 0;
+    for (uint32_t i = 0; i < shard_count_; ++i) {
+        count += shards_[i].count_;
+    }
+    return (count);
+}
+
+} // namespace cache
+} // namespace bundy
+
+#endif // LRU_HASH_TABLE_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -16,8 +16,7 @@
 #include <config.h>
 
 #include <nsas/nsas_entry_compare.h>
-#include <nsas/hash_table.h>
-#include <nsas/hash_deleter.h>
+#include <dns/rcode.h>
 #include "message_cache.h"
 #include "message_utility.h"
 #include "cache_entry_key.h"
@@ -28,6 +27,7 @@ namespace cache {
 
 using namespace bundy::nsas;
 using namespace bundy::dns;
+using namespace bundy::util;
 using namespace std;
 using namespace MessageUtility;
 
@@ -37,17 +37,19 @@ MessageCache::MessageCache(const RRsetCachePtr& rrset_cache,
     message_class_(message_class),
     rrset_cache_(rrset_cache),
     negative_soa_cache_(negative_soa_cache),
-    message_table_(new NsasEntryCompare<MessageEntry>, cache_size),
-    message_lru_((3 * cache_size),
-                  new HashDeleter<MessageEntry>(message_table_))
+    message_table_(new NsasEntryCompare<MessageEntry>, 3 * cache_size,
+                   cache_size, new ExpireTimeCheck<MessageEntry>),
+    negative_name_table_(new NsasEntryCompare<NegativeNameEntry>,
+                         3 * cache_size, cache_size,
+                         new ExpireTimeCheck<NegativeNameEntry>),
+    prefetch_min_hits_(0),
+    prefetch_ttl_fraction_(0)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_MESSAGES_INIT).arg(cache_size).
         arg(RRClass(message_class));
 }
 
 MessageCache::~MessageCache() {
-    // Destroy all the message entries in the cache.
-    message_lru_.clear();
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_MESSAGES_DEINIT);
 }
 
@@ -59,24 +61,63 @@ MessageCache::lookup(const bundy::dns::Name& qname,
     std::string entry_name = genCacheEntryName(qname, qtype);
     HashKey entry_key = HashKey(entry_name, RRClass(message_class_));
     MessageEntryPtr msg_entry = message_table_.get(entry_key);
+    const time_t now = time(NULL);
     if(msg_entry) {
         // Check whether the message entry has expired.
-       if (msg_entry->getExpireTime() > time(NULL)) {
+       if (msg_entry->getExpireTime() > now) {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_FOUND).
                 arg(entry_name);
-            message_lru_.touch(msg_entry);
-            return (msg_entry->genMessage(time(NULL), response));
+            if (!msg_entry->genMessage(now, response)) {
+                return (false);
+            }
+            if (msg_entry->countHit(now, prefetch_min_hits_,
+                                    prefetch_ttl_fraction_)) {
+                LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_PREFETCH).
+                    arg(entry_name).arg(msg_entry->getHits());
+                bundy::util::thread::Mutex::Locker locker(prefetch_mutex_);
+                prefetch_questions_.push_back(QuestionPtr(
+                    new Question(qname, RRClass(message_class_), qtype)));
+            }
+            return (true);
         } else {
-            // message entry expires, remove it from hash table and lru list.
+            // message entry expires, remove it from the table.
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_EXPIRED).
                 arg(entry_name);
-            message_table_.remove(entry_key);
-            message_lru_.remove(msg_entry);
-            return (false);
+            message_table_.remove(entry_key, msg_entry);
+            return (lookupNegativeName(qname, now, response));
        }
     }
 
     LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_UNKNOWN).arg(entry_name);
+    return (lookupNegativeName(qname, now, response));
+}
+
+bool
+MessageCache::lookupNegativeName(const Name& qname, const time_t time_now,
+                                 Message& response)
+{
+    // The names below a nonexistent name don't exist either, so look
+    // for the query name and all its ancestors (but the root).
+    const RRClass name_class(message_class_);
+    for (unsigned int level = 0; level + 1 < qname.getLabelCount();
+         ++level) {
+        const string name_text = qname.split(level).toText();
+        const HashKey name_key(name_text, name_class);
+        NegativeNameEntryPtr name_entry = negative_name_table_.get(name_key);
+        if (!name_entry) {
+            continue;
+        }
+        if (name_entry->getExpireTime() <= time_now) {
+            negative_name_table_.remove(name_key, name_entry);
+            continue;
+        }
+        if (name_entry->genMessage(time_now, *negative_soa_cache_,
+                                   response)) {
+            LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_NEGATIVE_NAME).
+                arg(qname).arg(name_text);
+            return (true);
+        }
+    }
     return (false);
 }
 
@@ -98,23 +139,94 @@ MessageCache::update(const Message& msg) {
                                                (*iter)->getType());
     HashKey entry_key = HashKey(entry_name, RRClass(message_class_));
 
-    // The simplest way to update is removing the old message entry directly.
-    // We have find the existed message entry, since we need to delete it
-    // from lru list too.
-    // TODO, but there should be a better way, since we here have to remove and
-    // add the message entry, maybe there is one way to touch it once.
-    MessageEntryPtr old_msg_entry = message_table_.get(entry_key);
-    if (old_msg_entry) {
-        LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_MESSAGES_REMOVE).
-            arg((*iter)->getName()).arg((*iter)->getType()).
-            arg((*iter)->getClass());
-        message_lru_.remove(old_msg_entry);
-    }
-
+    // The old message entry (if any) is replaced.
     MessageEntryPtr msg_entry(new MessageEntry(msg, rrset_cache_,
                                                negative_soa_cache_));
-    message_lru_.add(msg_entry);
-    return (message_table_.add(msg_entry, entry_key, true));
+    if (!message_table_.add(msg_entry, entry_key, true)) {
+        return (false);
+    }
+
+    // An NXDOMAIN for the query name itself holds for any type.  With a
+    // CNAME chain, it's the target that doesn't exist; those are left
+    // to the message entry.
+    if (msg.getRcode() == Rcode::NXDOMAIN() &&
+        msg.getRRCount(Message::SECTION_ANSWER) == 0) {
+        for (RRsetIterator it = msg.beginSection(Message::SECTION_AUTHORITY);
+             it != msg.endSection(Message::SECTION_AUTHORITY); ++it) {
+            if ((*it)->getType() == RRType::SOA()) {
+                LOG_DEBUG(logger, DBG_TRACE_DATA,
+                          CACHE_MESSAGES_NEGATIVE_NAME_UPDATE).
+                    arg((*iter)->getName()).arg((*iter)->getClass());
+                NegativeNameEntryPtr name_entry(
+                    new NegativeNameEntry((*iter)->getName(), message_class_,
+                                          (*it)->getName(),
+                                          msg_entry->getExpireTime()));
+                negative_name_table_.add(name_entry, name_entry->hashKey(),
+                                         true);
+                break;
+            }
+        }
+    }
+    return (true);
+}
+
+void
+MessageCache::setPrefetchPolicy(uint32_t min_hits, double ttl_fraction) {
+    prefetch_min_hits_ = min_hits;
+    prefetch_ttl_fraction_ = ttl_fraction;
+}
+
+void
+MessageCache::getPrefetchQuestions(vector<QuestionPtr>& questions) {
+    bundy::util::thread::Mutex::Locker locker(prefetch_mutex_);
+    questions.insert(questions.end(), prefetch_questions_.begin(),
+                     prefetch_questions_.end());
+    prefetch_questions_.clear();
+}
+
+uint32_t
+MessageCache::dump(OutputBuffer& buffer) const {
+    vector<MessageEntryPtr> entries;
+    message_table_.snapshot(entries);
+
+    const time_t now = time(NULL);
+    vector<MessageEntryPtr> live_entries;
+    live_entries.reserve(entries.size());
+    for (vector<MessageEntryPtr>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+        if ((*it)->getExpireTime() > now) {
+            live_entries.push_back(*it);
+        }
+    }
+
+    buffer.writeUint32(live_entries.size());
+    for (vector<MessageEntryPtr>::const_iterator it = live_entries.begin();
+         it != live_entries.end(); ++it) {
+        (*it)->toWire(buffer);
+    }
+    return (live_entries.size());
+}
+
+uint32_t
+MessageCache::load(InputBuffer& buffer) {
+    const uint32_t count = buffer.readUint32();
+    const time_t now = time(NULL);
+    uint32_t loaded = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        MessageEntryPtr msg_entry(new MessageEntry(buffer, rrset_cache_,
+                                                   negative_soa_cache_));
+        if (msg_entry->getClass() != message_class_) {
+            bundy_throw(BadCacheDump, "Message of class " <<
+                        RRClass(msg_entry->getClass()) <<
+                        " in cache dump of class " <<
+                        RRClass(message_class_));
+        }
+        if (msg_entry->getExpireTime() > now &&
+            message_table_.add(msg_entry, msg_entry->hashKey())) {
+            ++loaded;
+        }
+    }
+    return (loaded);
 }
 
 } // namespace cache
@@ -16,11 +16,14 @@
 #define MESSAGE_CACHE_H
 
 #include <string>
+#include <vector>
 #include <boost/shared_ptr.hpp>
 #include <dns/message.h>
+#include <dns/question.h>
+#include <util/threads/sync.h>
 #include "message_entry.h"
-#include <nsas/hash_table.h>
-#include <util/lru_list.h>
+#include "negative_name_entry.h"
+#include "lru_hash_table.h"
 #include "rrset_cache.h"
 
 namespace bundy {
@@ -30,8 +33,8 @@ namespace cache {
 /// The object of MessageCache represents the cache for class-specific
 /// messages.
 ///
-/// \todo The message cache class should provide the interfaces for
-///       loading, dumping and resizing.
+/// \todo The message cache class should provide the interface for
+///       resizing.
 class MessageCache {
 // Noncopyable
 private:
@@ -57,6 +60,10 @@ public:
     /// \param message generated response message if the message entry
     ///        can be found.
     ///
+    /// If there's no message for the query, but the query name or one
+    /// of its ancestors is known not to exist (see \c update()), an
+    /// NXDOMAIN answer is generated.
+    ///
     /// \return return true if the message can be found in cache, or else,
     /// return false.
     //TODO Maybe some user just want to get the message_entry.
@@ -67,7 +74,64 @@ public:
     /// \brief Update the message in the cache with the new one.
     /// If the message doesn't exist in the cache, it will be added
     /// directly.
+    ///
+    /// If the message is an NXDOMAIN response for the query name itself
+    /// (without a CNAME or DNAME chain in the answer section), the name
+    /// is remembered as nonexistent for all the query types, and for the
+    /// names below it, until the negative answer expires.
     bool update(const bundy::dns::Message& msg);
+
+    /// \brief Set when popular messages should be prefetched.
+    ///
+    /// Each successful lookup of a message is counted.  Once a message
+    /// has been looked up at least \c min_hits times, and at most
+    /// \c ttl_fraction of its TTL is left, its question is queued for
+    /// prefetching (see \c getPrefetchQuestions()).  The refreshed answer
+    /// replaces the message in the cache, so it doesn't expire while
+    /// it's popular.
+    ///
+    /// Prefetching is disabled by default (and when \c ttl_fraction is 0).
+    ///
+    /// \param min_hits The minimal number of lookups of a message.
+    /// \param ttl_fraction The fraction of the TTL (between 0 and 1).
+    void setPrefetchPolicy(uint32_t min_hits, double ttl_fraction);
+
+    /// \brief Get the questions of the messages due for prefetching.
+    ///
+    /// Moves the questions queued since the last call to the given
+    /// vector.  A message is queued again only if it still wasn't
+    /// refreshed a while later (see \c MessageEntry::countHit()).  The
+    /// caller is expected to resolve them again and \c update() the
+    /// cache with the answers.
+    ///
+    /// \param questions The vector to append the questions to.
+    void getPrefetchQuestions(std::vector<bundy::dns::QuestionPtr>& questions);
+
+    /// \brief Dump the cache
+    ///
+    /// Writes the number of the unexpired message entries (as a 32-bit
+    /// integer) followed by the entries themselves (see
+    /// \c MessageEntry::toWire()), from the least recently used one.
+    /// The RRsets the messages refer to are not dumped, the RRset caches
+    /// need to be dumped separately.
+    ///
+    /// \param buffer The buffer to write the dump to.
+    /// \return The number of the dumped entries.
+    uint32_t dump(bundy::util::OutputBuffer& buffer) const;
+
+    /// \brief Load the cache from a dump
+    ///
+    /// Reads the entries written by \c dump() and adds them to the cache,
+    /// skipping the expired ones and the ones already in the cache.  The
+    /// RRset caches should be loaded first, as a message entry can't be
+    /// used without its RRsets.
+    ///
+    /// \param buffer The buffer to read the dump from.
+    /// \return The number of the entries added to the cache.
+    /// \throw BadCacheDump if the data is broken or of another class.
+    /// \throw bundy::Exception Other exceptions from libutil and libdns if
+    /// the data is truncated or a name in it is broken.
+    uint32_t load(bundy::util::InputBuffer& buffer);
 protected:
     /// \brief Get the hash key for the message entry in the cache.
     /// \param name query name of the message.
@@ -76,13 +140,32 @@ protected:
     bundy::nsas::HashKey getEntryHashKey(const bundy::dns::Name& name,
                                        const bundy::dns::RRType& type) const;
 
+    /// \brief Generate an NXDOMAIN answer from the negative name entries.
+    ///
+    /// \param qname The query name.
+    /// \param time_now The current time.
+    /// \param message The message to fill in.
+    /// \return true if the query name or one of its ancestors is known
+    ///         not to exist, false otherwise.
+    bool lookupNegativeName(const bundy::dns::Name& qname,
+                            const time_t time_now,
+                            bundy::dns::Message& message);
+
     // Make these variants be protected for easy unittest.
 protected:
     uint16_t message_class_; // The class of the message cache.
     RRsetCachePtr rrset_cache_;
     RRsetCachePtr negative_soa_cache_;
-    bundy::nsas::HashTable<MessageEntry> message_table_;
-    bundy::util::LruList<MessageEntry> message_lru_;
+    LruHashTable<MessageEntry> message_table_;
+    // The nonexistent names, for all query types
+    LruHashTable<NegativeNameEntry> negative_name_table_;
+
+private:
+    uint32_t prefetch_min_hits_;
+    double prefetch_ttl_fraction_;
+    // The questions of the messages due for prefetching
+    std::vector<bundy::dns::QuestionPtr> prefetch_questions_;
+    bundy::util::thread::Mutex prefetch_mutex_;
 };
 
 typedef boost::shared_ptr<MessageCache> MessageCachePtr;
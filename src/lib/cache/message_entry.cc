@@ -16,6 +16,7 @@
 
 #include <limits>
 #include <dns/message.h>
+#include <dns/rcode.h>
 #include <nsas/nsas_entry.h>
 #include "message_entry.h"
 #include "message_utility.h"
@@ -24,6 +25,7 @@
 
 using namespace bundy::dns;
 using namespace bundy::nsas;
+using namespace bundy::util;
 using namespace std;
 
 // Put file scope functions in unnamed namespace.
@@ -81,13 +83,94 @@ MessageEntry::MessageEntry(const bundy::dns::Message& msg,
     rrset_cache_(rrset_cache),
     negative_soa_cache_(negative_soa_cache),
     headerflag_aa_(false),
-    headerflag_tc_(false)
+    headerflag_tc_(false),
+    nxdomain_(false),
+    hits_(0),
+    prefetch_time_(0)
 {
     initMessageEntry(msg);
     entry_name_ = genCacheEntryName(query_name_, query_type_);
     hash_key_ptr_ = new HashKey(entry_name_, RRClass(query_class_));
 }
 
+// Header flags of a dumped message entry
+static const uint8_t DUMP_FLAG_AA = 0x01;
+static const uint8_t DUMP_FLAG_TC = 0x02;
+static const uint8_t DUMP_FLAG_NXDOMAIN = 0x04;
+
+// Which cache a dumped RRset reference points to
+static const uint8_t DUMP_RRSET_CACHE = 0;
+static const uint8_t DUMP_NEGATIVE_SOA_CACHE = 1;
+
+MessageEntry::MessageEntry(InputBuffer& buffer,
+                           const RRsetCachePtr& rrset_cache,
+                           const RRsetCachePtr& negative_soa_cache):
+    expire_time_(buffer.readUint32()),
+    rrset_cache_(rrset_cache),
+    negative_soa_cache_(negative_soa_cache),
+    hits_(0),
+    prefetch_time_(0)
+{
+    const uint8_t flags = buffer.readUint8();
+    headerflag_aa_ = ((flags & DUMP_FLAG_AA) != 0);
+    headerflag_tc_ = ((flags & DUMP_FLAG_TC) != 0);
+    nxdomain_ = ((flags & DUMP_FLAG_NXDOMAIN) != 0);
+
+    query_count_ = 1;
+    query_name_ = Name(buffer).toText();
+    query_type_ = buffer.readUint16();
+    query_class_ = buffer.readUint16();
+
+    answer_count_ = buffer.readUint16();
+    authority_count_ = buffer.readUint16();
+    additional_count_ = buffer.readUint16();
+    const int entry_count = answer_count_ + authority_count_ +
+        additional_count_;
+    for (int index = 0; index < entry_count; ++index) {
+        const Name name(buffer);
+        const RRType type(buffer.readUint16());
+        const uint8_t cache = buffer.readUint8();
+        if (cache == DUMP_RRSET_CACHE) {
+            rrsets_.push_back(RRsetRef(name, type, rrset_cache_.get()));
+        } else if (cache == DUMP_NEGATIVE_SOA_CACHE) {
+            rrsets_.push_back(RRsetRef(name, type,
+                                       negative_soa_cache_.get()));
+        } else {
+            bundy_throw(BadCacheDump, "Unknown RRset cache in cache dump: "
+                        << static_cast<unsigned int>(cache));
+        }
+    }
+
+    // The original TTL isn't dumped, what's left of it is the best guess
+    const time_t now = time(NULL);
+    lifetime_ = expire_time_ > now ? expire_time_ - now : 0;
+
+    entry_name_ = genCacheEntryName(query_name_, query_type_);
+    hash_key_ptr_ = new HashKey(entry_name_, RRClass(query_class_));
+}
+
+void
+MessageEntry::toWire(OutputBuffer& buffer) const {
+    buffer.writeUint32(expire_time_);
+    buffer.writeUint8((headerflag_aa_ ? DUMP_FLAG_AA : 0) |
+                      (headerflag_tc_ ? DUMP_FLAG_TC : 0) |
+                      (nxdomain_ ? DUMP_FLAG_NXDOMAIN : 0));
+    Name(query_name_).toWire(buffer);
+    buffer.writeUint16(query_type_);
+    buffer.writeUint16(query_class_);
+
+    buffer.writeUint16(answer_count_);
+    buffer.writeUint16(authority_count_);
+    buffer.writeUint16(additional_count_);
+    for (vector<RRsetRef>::const_iterator it = rrsets_.begin();
+         it != rrsets_.end(); ++it) {
+        it->name_.toWire(buffer);
+        buffer.writeUint16(it->type_.getCode());
+        buffer.writeUint8(it->cache_ == negative_soa_cache_.get() ?
+                          DUMP_NEGATIVE_SOA_CACHE : DUMP_RRSET_CACHE);
+    }
+}
+
 bool
 MessageEntry::getRRsetEntries(vector<RRsetEntryPtr>& rrset_entry_vec,
                               const time_t time_now)
@@ -130,6 +213,29 @@ MessageEntry::addRRset(bundy::dns::Message& message,
     }
 }
 
+const time_t MessageEntry::PREFETCH_RETRY_INTERVAL;
+
+bool
+MessageEntry::countHit(const time_t time_now, uint32_t min_hits,
+                       double ttl_fraction)
+{
+    ++hits_;
+    if (ttl_fraction <= 0 || hits_ < min_hits || time_now >= expire_time_) {
+        return (false);
+    }
+    if (expire_time_ - time_now > lifetime_ * ttl_fraction) {
+        return (false);
+    }
+    // If the last refresh was requested recently, it's probably still in
+    // progress; otherwise it failed or was dropped, so we try again.
+    if (prefetch_time_ != 0 &&
+        time_now - prefetch_time_ < PREFETCH_RETRY_INTERVAL) {
+        return (false);
+    }
+    prefetch_time_ = time_now;
+    return (true);
+}
+
 bool
 MessageEntry::genMessage(const time_t& time_now,
                          bundy::dns::Message& msg)
@@ -154,6 +260,7 @@ MessageEntry::genMessage(const time_t& time_now,
         // resolver cache
         msg.setHeaderFlag(Message::HEADERFLAG_AA, false);
         msg.setHeaderFlag(Message::HEADERFLAG_TC, headerflag_tc_);
+        msg.setRcode(nxdomain_ ? Rcode::NXDOMAIN() : Rcode::NOERROR());
 
         addRRset(msg, rrset_entry_vec, Message::SECTION_ANSWER);
         addRRset(msg, rrset_entry_vec, Message::SECTION_AUTHORITY);
@@ -307,6 +414,7 @@ MessageEntry::initMessageEntry(const bundy::dns::Message& msg) {
     //TODO better way to cache the header flags?
     headerflag_aa_ = msg.getHeaderFlag(Message::HEADERFLAG_AA);
     headerflag_tc_ = msg.getHeaderFlag(Message::HEADERFLAG_TC);
+    nxdomain_ = (msg.getRcode() == Rcode::NXDOMAIN());
 
     // We only cache the first question in question section.
     // TODO, do we need to support muptiple questions?
@@ -340,6 +448,7 @@ MessageEntry::initMessageEntry(const bundy::dns::Message& msg) {
     }
 
     expire_time_ = time(NULL) + min_ttl;
+    lifetime_ = min_ttl;
 }
 
 } // namespace cache
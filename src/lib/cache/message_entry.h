@@ -19,6 +19,7 @@
 #include <dns/message.h>
 #include <dns/rrset.h>
 #include <nsas/nsas_entry.h>
+#include <util/buffer.h>
 #include "rrset_cache.h"
 #include "rrset_entry.h"
 
@@ -74,15 +75,44 @@ public:
                  const RRsetCachePtr& rrset_cache,
                  const RRsetCachePtr& negative_soa_cache);
 
+    /// \brief Initialize the message entry from a cache dump.
+    ///
+    /// Reads the entry in the format written by \c toWire().  The RRsets
+    /// of the message are not part of it, they are expected to be loaded
+    /// into the RRset caches separately.
+    ///
+    /// \param buffer The buffer to read the entry from.
+    /// \param rrset_cache the cache with the RRsets of the message.
+    /// \param negative_soa_cache the cache with the SOA RRsets of
+    ///        negative responses.
+    /// \throw BadCacheDump if the data is broken.
+    /// \throw bundy::Exception Other exceptions from libutil and libdns if
+    /// the data is truncated or a name in it is broken.
+    MessageEntry(bundy::util::InputBuffer& buffer,
+                 const RRsetCachePtr& rrset_cache,
+                 const RRsetCachePtr& negative_soa_cache);
+
     ~MessageEntry() { delete hash_key_ptr_; };
 
+    /// \brief Dump the message entry.
+    ///
+    /// Writes the question, the cached header flags and RCODE, the
+    /// expiration time
+    /// (as an absolute time) and the references to the RRsets of the
+    /// message to the buffer.  The RRsets themselves are dumped by their
+    /// caches.
+    ///
+    /// \param buffer The buffer to write the entry to.
+    void toWire(bundy::util::OutputBuffer& buffer) const;
+
     /// \brief generate one dns message according
     ///        the rrsets information of the message.
     ///
     /// \param time_now set the ttl of each rrset in the message
     ///        as "expire_time - time_now" (expire_time is the
     ///        expiration time of the rrset).
-    /// \param response generated dns message.
+    /// \param response generated dns message.  Its RCODE is set to that
+    ///        of the cached message (NOERROR or NXDOMAIN).
     /// \return return true if the response message can be generated
     ///         from the cached information, or else, return false.
     bool genMessage(const time_t& time_now, bundy::dns::Message& response);
@@ -100,6 +130,47 @@ public:
         return (expire_time_);
     }
 
+    /// \brief Get the class of the message entry.
+    uint16_t getClass() const {
+        return (query_class_);
+    }
+
+    /// \brief Count a lookup of the message entry.
+    ///
+    /// Each successful lookup of the entry should be counted, so popular
+    /// entries can be refreshed before they expire.  This tells when
+    /// that's due: when the entry has been looked up at least
+    /// \c min_hits times and at most \c ttl_fraction of its lifetime is
+    /// left.  The refreshed answer replaces the entry by a new one.  Until
+    /// then, this returns true at most once every
+    /// \c PREFETCH_RETRY_INTERVAL seconds, so another refresh is requested
+    /// if the previous one failed or was dropped.
+    ///
+    /// \param time_now The current time.
+    /// \param min_hits The minimal number of lookups to refresh the entry.
+    /// \param ttl_fraction The fraction of the lifetime at which to refresh
+    ///        the entry.  If it's 0 (or less), entries are never refreshed.
+    /// \return true if the entry should be refreshed now.
+    ///
+    /// \note The counting is not synchronized.  If several threads look
+    /// the entry up at the same time, a hit may get lost or (rarely) the
+    /// refresh requested twice, neither of which does any harm.
+    bool countHit(const time_t time_now, uint32_t min_hits,
+                  double ttl_fraction);
+
+    /// \brief The minimal number of seconds between two refreshes of
+    /// the entry requested by \c countHit().
+    ///
+    /// It's about the time the resolver may take to get an answer, so
+    /// a refresh is normally finished (or failed) before another one is
+    /// requested.
+    static const time_t PREFETCH_RETRY_INTERVAL = 10;
+
+    /// \brief Get the number of lookups counted by \c countHit().
+    uint32_t getHits() const {
+        return (hits_);
+    }
+
     /// \short Protected memebers, so they can be accessed by tests.
     //@{
 protected:
@@ -190,6 +261,11 @@ private:
     //TODO, there should be a better way to cache these header flags
     bool headerflag_aa_; // Whether AA bit is set.
     bool headerflag_tc_; // Whether TC bit is set.
+    bool nxdomain_; // Whether the RCODE is NXDOMAIN.
+
+    uint32_t lifetime_; // The TTL of the message when it was cached.
+    uint32_t hits_; // Number of the lookups of the message.
+    time_t prefetch_time_; // When a prefetch was last requested (0 if not).
 };
 
 typedef boost::shared_ptr<MessageEntry> MessageEntryPtr;
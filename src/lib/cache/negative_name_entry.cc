@@ -0,0 +1,67 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dns/rcode.h>
+#include <dns/rrclass.h>
+#include <dns/rrtype.h>
+#include "negative_name_entry.h"
+#include "rrset_entry.h"
+
+using namespace bundy::dns;
+using namespace bundy::nsas;
+
+namespace bundy {
+namespace cache {
+
+NegativeNameEntry::NegativeNameEntry(const Name& name, uint16_t name_class,
+                                     const Name& soa_name,
+                                     time_t expire_time) :
+    name_(name),
+    entry_name_(name.toText()),
+    name_class_(name_class),
+    soa_name_(soa_name),
+    expire_time_(expire_time)
+{}
+
+bool
+NegativeNameEntry::genMessage(const time_t time_now,
+                              RRsetCache& negative_soa_cache,
+                              Message& msg) const
+{
+    if (time_now >= expire_time_) {
+        return (false);
+    }
+    RRsetEntryPtr soa_entry = negative_soa_cache.lookup(soa_name_,
+                                                        RRType::SOA());
+    if (!soa_entry || time_now >= soa_entry->getExpireTime()) {
+        return (false);
+    }
+
+    // As with the cached messages, the answer isn't authoritative.
+    msg.setHeaderFlag(Message::HEADERFLAG_AA, false);
+    msg.setHeaderFlag(Message::HEADERFLAG_TC, false);
+    msg.setRcode(Rcode::NXDOMAIN());
+    msg.addRRset(Message::SECTION_AUTHORITY, soa_entry->getRRset());
+    return (true);
+}
+
+HashKey
+NegativeNameEntry::hashKey() const {
+    return (HashKey(entry_name_, RRClass(name_class_)));
+}
+
+} // namespace cache
+} // namespace bundy
@@ -0,0 +1,96 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef NEGATIVE_NAME_ENTRY_H
+#define NEGATIVE_NAME_ENTRY_H
+
+#include <string>
+#include <boost/shared_ptr.hpp>
+#include <dns/name.h>
+#include <dns/message.h>
+#include <nsas/nsas_entry.h>
+#include "rrset_cache.h"
+
+namespace bundy {
+namespace cache {
+
+/// \brief Negative Name Entry
+///
+/// The object of NegativeNameEntry records that a name doesn't exist,
+/// as learned from an NXDOMAIN response.  Unlike a message entry, it is
+/// not specific to the query type, and it covers the names below the
+/// nonexistent one as well (RFC 8020), so the cache can answer those
+/// queries without asking upstream again.
+///
+/// The entry refers to the SOA RRset of the response in the negative
+/// SOA cache, which is put into the authority section of the generated
+/// answers.
+class NegativeNameEntry : public bundy::nsas::NsasEntry<NegativeNameEntry> {
+private:
+    NegativeNameEntry(const NegativeNameEntry&);
+    NegativeNameEntry& operator=(const NegativeNameEntry&);
+public:
+    /// \brief Constructor
+    ///
+    /// \param name The nonexistent name.
+    /// \param name_class The class of the name.
+    /// \param soa_name The owner name of the SOA RRset of the response.
+    /// \param expire_time When the negative answer expires.
+    NegativeNameEntry(const bundy::dns::Name& name, uint16_t name_class,
+                      const bundy::dns::Name& soa_name, time_t expire_time);
+
+    /// \brief Generate an NXDOMAIN answer
+    ///
+    /// Sets the RCODE of the message to NXDOMAIN and adds the SOA RRset
+    /// to its authority section.
+    ///
+    /// \param time_now The current time.
+    /// \param negative_soa_cache The cache the SOA RRset is in.
+    /// \param msg The message (in RENDER mode, with the question
+    ///        section already) to fill in.
+    /// \return false if the entry or its SOA RRset has expired, true
+    ///         otherwise.
+    bool genMessage(const time_t time_now, RRsetCache& negative_soa_cache,
+                    bundy::dns::Message& msg) const;
+
+    /// \brief Get the hash key of the entry
+    ///
+    /// The key is made from the name only, so it can be found for any
+    /// query type.
+    bundy::nsas::HashKey hashKey() const;
+
+    /// \brief Get the nonexistent name
+    const bundy::dns::Name& getName() const {
+        return (name_);
+    }
+
+    /// \brief Get the expiration time of the entry
+    time_t getExpireTime() const {
+        return (expire_time_);
+    }
+
+private:
+    const bundy::dns::Name name_;
+    const std::string entry_name_; // The text of the name, for the hash key
+    const uint16_t name_class_;
+    const bundy::dns::Name soa_name_;
+    const time_t expire_time_;
+};
+
+typedef boost::shared_ptr<NegativeNameEntry> NegativeNameEntryPtr;
+
+} // namespace cache
+} // namespace bundy
+
+#endif // NEGATIVE_NAME_ENTRY_H
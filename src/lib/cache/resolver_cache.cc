@@ -16,14 +16,33 @@
 
 #include "resolver_cache.h"
 #include "dns/message.h"
+#include "dns/rcode.h"
 #include "rrset_cache.h"
 #include "logger.h"
+#include <util/buffer.h>
 #include <string>
 #include <algorithm>
+#include <fstream>
+#include <iterator>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 
 using namespace bundy::dns;
+using namespace bundy::util;
 using namespace std;
 
+namespace {
+
+// The cache dump file starts with a magic number and a format version,
+// followed by the number of classes.  Each class is the class code, the
+// length of its data and the data as written by ResolverClassCache::dump().
+const uint32_t DUMP_MAGIC = 0x42524344; // "BRCD"
+const uint16_t DUMP_VERSION = 1;
+
+}
+
 namespace bundy {
 namespace cache {
 
@@ -88,6 +107,7 @@ ResolverClassCache::lookup(const bundy::dns::Name& qname,
     if (rrset_ptr) {
         LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RESOLVER_LOCAL_MSG).
             arg(qname).arg(qtype);
+        response.setRcode(Rcode::NOERROR());
         response.addRRset(Message::SECTION_ANSWER, rrset_ptr);
         return (true);
     }
@@ -156,6 +176,32 @@ ResolverClassCache::update(const bundy::dns::ConstRRsetPtr& rrset_ptr) {
     return (true);
 }
 
+void
+ResolverClassCache::setPrefetchPolicy(uint32_t min_hits,
+                                      double ttl_fraction)
+{
+    messages_cache_->setPrefetchPolicy(min_hits, ttl_fraction);
+}
+
+void
+ResolverClassCache::getPrefetchQuestions(vector<QuestionPtr>& questions) {
+    messages_cache_->getPrefetchQuestions(questions);
+}
+
+uint32_t
+ResolverClassCache::dump(OutputBuffer& buffer) const {
+    // The RRsets go first, so they are in place when the messages
+    // referring to them are loaded.
+    return (rrsets_cache_->dump(buffer) + negative_soa_cache_->dump(buffer) +
+            messages_cache_->dump(buffer));
+}
+
+uint32_t
+ResolverClassCache::load(InputBuffer& buffer) {
+    const uint32_t rrsets = rrsets_cache_->load(buffer);
+    const uint32_t negative_soas = negative_soa_cache_->load(buffer);
+    return (rrsets + negative_soas + messages_cache_->load(buffer));
+}
 
 ResolverCache::ResolverCache()
 {
@@ -261,6 +307,124 @@ ResolverCache::update(const bundy::dns::ConstRRsetPtr& rrset_ptr) {
     }
 }
 
+void
+ResolverCache::setPrefetchPolicy(uint32_t min_hits, double ttl_fraction) {
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        class_caches_[i]->setPrefetchPolicy(min_hits, ttl_fraction);
+    }
+}
+
+void
+ResolverCache::getPrefetchQuestions(vector<QuestionPtr>& questions) {
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        class_caches_[i]->getPrefetchQuestions(questions);
+    }
+}
+
+bool
+ResolverCache::dump(const std::string& filename) const {
+    OutputBuffer buffer(0);
+    buffer.writeUint32(DUMP_MAGIC);
+    buffer.writeUint16(DUMP_VERSION);
+    buffer.writeUint16(class_caches_.size());
+    uint32_t count = 0;
+    for (std::vector<ResolverClassCache*>::size_type i = 0;
+         i < class_caches_.size(); ++i) {
+        OutputBuffer class_buffer(0);
+        count += class_caches_[i]->dump(class_buffer);
+        buffer.writeUint16(class_caches_[i]->getClass().getCode());
+        buffer.writeUint32(class_buffer.getLength());
+        buffer.writeData(class_buffer.getData(), class_buffer.getLength());
+    }
+
+    const string tmp_filename = filename + ".tmp";
+    ofstream out(tmp_filename.c_str(), ios::out | ios::binary | ios::trunc);
+    out.write(static_cast<const char*>(buffer.getData()), buffer.getLength());
+    out.close();
+    if (!out) {
+        LOG_WARN(logger, CACHE_RESOLVER_DUMP_FAILED).arg(filename).
+            arg("can't write " + tmp_filename);
+        std::remove(tmp_filename.c_str());
+        return (false);
+    }
+    if (std::rename(tmp_filename.c_str(), filename.c_str()) != 0) {
+        LOG_WARN(logger, CACHE_RESOLVER_DUMP_FAILED).arg(filename).
+            arg(strerror(errno));
+        std::remove(tmp_filename.c_str());
+        return (false);
+    }
+
+    LOG_INFO(logger, CACHE_RESOLVER_DUMPED).arg(count).arg(filename);
+    return (true);
+}
+
+bool
+ResolverCache::load(const std::string& filename) {
+    ifstream in(filename.c_str(), ios::in | ios::binary);
+    if (!in) {
+        if (errno == ENOENT) {
+            LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RESOLVER_NO_DUMP).
+                arg(filename);
+            return (true);
+        }
+        LOG_WARN(logger, CACHE_RESOLVER_LOAD_FAILED).arg(filename).
+            arg(strerror(errno));
+        return (false);
+    }
+    const vector<char> data((istreambuf_iterator<char>(in)),
+                            istreambuf_iterator<char>());
+    if (in.bad()) {
+        LOG_WARN(logger, CACHE_RESOLVER_LOAD_FAILED).arg(filename).
+            arg("read error");
+        return (false);
+    }
+
+    uint32_t count = 0;
+    try {
+        InputBuffer buffer(data.empty() ? NULL : &data[0], data.size());
+        if (buffer.readUint32() != DUMP_MAGIC) {
+            bundy_throw(BadCacheDump, "not a resolver cache dump");
+        }
+        const uint16_t version = buffer.readUint16();
+        if (version != DUMP_VERSION) {
+            bundy_throw(BadCacheDump, "unsupported cache dump version " <<
+                        version);
+        }
+        const uint16_t class_count = buffer.readUint16();
+        for (uint16_t i = 0; i < class_count; ++i) {
+            const RRClass cache_class(buffer.readUint16());
+            const uint32_t length = buffer.readUint32();
+            const size_t position = buffer.getPosition();
+            if (length > buffer.getLength() - position) {
+                bundy_throw(BadCacheDump, "truncated cache dump of class " <<
+                            cache_class);
+            }
+            ResolverClassCache* cc = getClassCache(cache_class);
+            if (cc) {
+                InputBuffer class_buffer(&data[position], length);
+                count += cc->load(class_buffer);
+                if (class_buffer.getPosition() != length) {
+                    bundy_throw(BadCacheDump, "trailing garbage in cache "
+                                "dump of class " << cache_class);
+                }
+            } else {
+                LOG_DEBUG(logger, DBG_TRACE_BASIC,
+                          CACHE_RESOLVER_LOAD_UNKNOWN_CLASS).arg(cache_class);
+            }
+            buffer.setPosition(position + length);
+        }
+    } catch (const bundy::Exception& ex) {
+        LOG_WARN(logger, CACHE_RESOLVER_LOAD_FAILED).arg(filename).
+            arg(ex.what());
+        return (false);
+    }
+
+    LOG_INFO(logger, CACHE_RESOLVER_LOADED).arg(count).arg(filename);
+    return (true);
+}
+
 ResolverClassCache*
 ResolverCache::getClassCache(const bundy::dns::RRClass& cache_class) const {
     for (std::vector<ResolverClassCache*>::size_type i = 0;
@@ -21,6 +21,7 @@
 #include <dns/rrclass.h>
 #include <dns/message.h>
 #include <exceptions/exceptions.h>
+#include <util/buffer.h>
 #include "message_cache.h"
 #include "rrset_cache.h"
 #include "local_zone_data.h"
@@ -77,8 +78,8 @@ public:
 /// \note Public interaction with the cache should be through ResolverCache,
 /// not directly with this one. (TODO: make this private/hidden/local to the .cc?)
 ///
-/// \todo The resolver cache class should provide the interfaces for
-///       loading, dumping and resizing.
+/// \todo The resolver cache class should provide the interface for
+///       resizing.
 class ResolverClassCache {
 public:
     /// \brief Default Constructor.
@@ -104,7 +105,10 @@ public:
     ///        MessageNoQeustionSection will be thrown if it has
     ///        no question section). If the message can be found
     ///        in cache, rrsets for the message will be added to
-    ///        different sections(answer, authority, additional).
+    ///        different sections(answer, authority, additional),
+    ///        and the RCODE will be set (NOERROR or NXDOMAIN).  An
+    ///        NXDOMAIN cached for the name or one of its ancestors
+    ///        answers queries of any type.
     /// \return return true if the message can be found, or else,
     ///         return false.
     bool lookup(const bundy::dns::Name& qname,
@@ -136,11 +140,6 @@ public:
     /// \note the function doesn't do any message validation check,
     ///       the user should make sure the message is valid, and of
     ///       the right class
-    /// TODO: Share the NXDOMAIN info between different type queries
-    ///       current implementation can only cache for the type that
-    ///       user quired, for example, if user query A record of
-    ///       a.example. and the server replied with NXDOMAIN, this
-    ///       should be cached for all the types queries of a.example.
     bool update(const bundy::dns::Message& msg);
 
     /// \brief Update the rrset in the cache with the new one.
@@ -165,6 +164,33 @@ public:
     /// \return The RRClass of this cache
     const bundy::dns::RRClass& getClass() const;
 
+    /// \brief Set when popular messages should be prefetched
+    ///
+    /// See \c MessageCache::setPrefetchPolicy().
+    void setPrefetchPolicy(uint32_t min_hits, double ttl_fraction);
+
+    /// \brief Get the questions of the messages due for prefetching
+    ///
+    /// See \c MessageCache::getPrefetchQuestions().
+    void getPrefetchQuestions(std::vector<bundy::dns::QuestionPtr>& questions);
+
+    /// \brief Dump the cache
+    ///
+    /// Writes the RRset, negative SOA and message caches to the buffer.
+    /// The local zone data are not dumped.
+    ///
+    /// \param buffer The buffer to write the dump to.
+    /// \return The number of the dumped entries.
+    uint32_t dump(bundy::util::OutputBuffer& buffer) const;
+
+    /// \brief Load the cache from a dump written by \c dump()
+    ///
+    /// \param buffer The buffer to read the dump from.
+    /// \return The number of the entries added to the cache.
+    /// \throw bundy::Exception if the dump is broken (see
+    /// \c RRsetCache::load()).
+    uint32_t load(bundy::util::InputBuffer& buffer);
+
 private:
     /// \brief Update rrset cache.
     ///
@@ -228,7 +254,10 @@ public:
     ///        MessageNoQeustionSection will be thrown if it has
     ///        no question section). If the message can be found
     ///        in cache, rrsets for the message will be added to
-    ///        different sections(answer, authority, additional).
+    ///        different sections(answer, authority, additional),
+    ///        and the RCODE will be set (NOERROR or NXDOMAIN).  An
+    ///        NXDOMAIN cached for the name or one of its ancestors
+    ///        answers queries of any type.
     /// \return return true if the message can be found, or else,
     ///         return false.
     bool lookup(const bundy::dns::Name& qname,
@@ -303,6 +332,68 @@ public:
     ///
     bool update(const bundy::dns::ConstRRsetPtr& rrset_ptr);
 
+    /// \name Prefetch Interfaces
+    ///
+    /// Popular messages can be resolved again shortly before they expire,
+    /// so the clients asking for them don't run into a cache miss and
+    /// wait for the whole resolution once per TTL.  The cache counts the
+    /// lookups and tells which questions are due; resolving them is up
+    /// to the user of the cache.
+    //@{
+    /// \brief Set when popular messages should be prefetched
+    ///
+    /// Once a message has been looked up at least \c min_hits times, and
+    /// at most \c ttl_fraction of its TTL is left, it is due for
+    /// prefetching.  Prefetching is disabled by default (and when
+    /// \c ttl_fraction is 0).  The policy applies to all the classes.
+    ///
+    /// \param min_hits The minimal number of lookups of a message.
+    /// \param ttl_fraction The fraction of the TTL (between 0 and 1).
+    void setPrefetchPolicy(uint32_t min_hits, double ttl_fraction);
+
+    /// \brief Get the questions of the messages due for prefetching
+    ///
+    /// Moves the questions that became due since the last call to the
+    /// given vector.  The caller should resolve them (bypassing the
+    /// cache, as the old answers are still there) and \c update() the
+    /// cache with the answers, which replace the old messages.
+    ///
+    /// \param questions The vector to append the questions to.
+    void getPrefetchQuestions(std::vector<bundy::dns::QuestionPtr>& questions);
+    //@}
+
+    /// \name Dump Interfaces
+    ///
+    /// The content of the cache can be dumped to a file and loaded back
+    /// from it, so a restarted resolver doesn't have to start with an
+    /// empty cache.  The RRsets (in wire format, with their absolute
+    /// expiration time and trust level) and the message entries of all
+    /// the classes are dumped; the local zone data are not.
+    //@{
+    /// \brief Dump the cache to a file
+    ///
+    /// The file is written under a temporary name first and renamed when
+    /// complete, so an existing dump is never left half-overwritten.
+    /// Failures are logged.
+    ///
+    /// \param filename The file to write the dump to.
+    /// \return true if the cache was dumped, false otherwise.
+    bool dump(const std::string& filename) const;
+
+    /// \brief Load the cache from a file
+    ///
+    /// Adds the entries dumped by \c dump() to the cache.  The entries
+    /// that have expired since the dump are skipped, and so are the ones
+    /// already in the cache and the classes the cache isn't configured
+    /// for.  A missing file is not an error (there's simply nothing to
+    /// load); other failures are logged, and the entries loaded before
+    /// the failure are kept.
+    ///
+    /// \param filename The file to read the dump from.
+    /// \return true if the whole file was loaded, false otherwise.
+    bool load(const std::string& filename);
+    //@}
+
 private:
     /// \brief Returns the class-specific subcache
     ///
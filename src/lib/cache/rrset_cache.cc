@@ -17,12 +17,12 @@
 #include "rrset_cache.h"
 #include "logger.h"
 #include <string>
+#include <vector>
 #include <nsas/nsas_entry_compare.h>
-#include <nsas/hash_table.h>
-#include <nsas/hash_deleter.h>
 
 using namespace bundy::nsas;
 using namespace bundy::dns;
+using namespace bundy::util;
 using namespace std;
 
 namespace bundy {
@@ -31,9 +31,8 @@ namespace cache {
 RRsetCache::RRsetCache(uint32_t cache_size,
                        uint16_t rrset_class):
     class_(rrset_class),
-    rrset_table_(new NsasEntryCompare<RRsetEntry>, cache_size),
-    rrset_lru_((3 * cache_size),
-                  new HashDeleter<RRsetEntry>(rrset_table_))
+    rrset_table_(new NsasEntryCompare<RRsetEntry>, 3 * cache_size,
+                 cache_size, new ExpireTimeCheck<RRsetEntry>)
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CACHE_RRSET_INIT).arg(cache_size).
         arg(RRClass(rrset_class));
@@ -51,16 +50,14 @@ RRsetCache::lookup(const bundy::dns::Name& qname,
                                                        RRClass(class_)));
     if (entry_ptr) {
         if (entry_ptr->getExpireTime() > time(NULL)) {
-            // Only touch the non-expired rrset entries
-            rrset_lru_.touch(entry_ptr);
+            // The table has already touched the non-expired entry
             return (entry_ptr);
         } else {
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_EXPIRED).arg(qname).
                 arg(qtype).arg(RRClass(class_));
             // the rrset entry has expired, so just remove it from
-            // hash table and lru list.
-            rrset_table_.remove(entry_ptr->hashKey());
-            rrset_lru_.remove(entry_ptr);
+            // the table.
+            rrset_table_.remove(entry_ptr->hashKey(), entry_ptr);
         }
     }
 
@@ -86,20 +83,63 @@ RRsetCache::update(const bundy::dns::AbstractRRset& rrset,
             // existed rrset entry is more authoritative, just return it
             return (entry_ptr);
         } else {
+            // The old rrset entry is replaced below.
             LOG_DEBUG(logger, DBG_TRACE_DATA, CACHE_RRSET_REMOVE_OLD).
                 arg(rrset.getName()).arg(rrset.getType()).
                 arg(rrset.getClass());
-            // Remove the old rrset entry from the lru list.
-            rrset_lru_.remove(entry_ptr);
         }
     }
 
     entry_ptr.reset(new RRsetEntry(rrset, level));
     rrset_table_.add(entry_ptr, entry_ptr->hashKey(), true);
-    rrset_lru_.add(entry_ptr);
     return (entry_ptr);
 }
 
+uint32_t
+RRsetCache::dump(OutputBuffer& buffer) const {
+    vector<RRsetEntryPtr> entries;
+    rrset_table_.snapshot(entries);
+
+    // Only the unexpired entries are worth dumping, and the count goes
+    // first.
+    const time_t now = time(NULL);
+    vector<RRsetEntryPtr> live_entries;
+    live_entries.reserve(entries.size());
+    for (vector<RRsetEntryPtr>::const_iterator it = entries.begin();
+         it != entries.end(); ++it) {
+        if ((*it)->getExpireTime() > now) {
+            live_entries.push_back(*it);
+        }
+    }
+
+    buffer.writeUint32(live_entries.size());
+    for (vector<RRsetEntryPtr>::const_iterator it = live_entries.begin();
+         it != live_entries.end(); ++it) {
+        (*it)->toWire(buffer);
+    }
+    return (live_entries.size());
+}
+
+uint32_t
+RRsetCache::load(InputBuffer& buffer) {
+    const uint32_t count = buffer.readUint32();
+    const time_t now = time(NULL);
+    uint32_t loaded = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        RRsetEntryPtr entry_ptr(new RRsetEntry(buffer));
+        if (entry_ptr->hashKey().class_code != RRClass(class_)) {
+            bundy_throw(BadCacheDump, "RRset of class " <<
+                        entry_ptr->hashKey().class_code <<
+                        " in cache dump of class " << RRClass(class_));
+        }
+        if (entry_ptr->getExpireTime() > now &&
+            rrset_table_.add(entry_ptr, entry_ptr->hashKey())) {
+            ++loaded;
+        }
+    }
+    return (loaded);
+}
+
 } // namespace cache
 } // namespace bundy
 
@@ -16,9 +16,7 @@
 #define RRSET_CACHE_H
 
 #include <cache/rrset_entry.h>
-#include <nsas/hash_table.h>
-
-#include <util/lru_list.h>
+#include <cache/lru_hash_table.h>
 
 namespace bundy {
 namespace cache {
@@ -29,8 +27,8 @@ class RRsetEntry;
 /// The object of RRsetCache represented the cache for class-specific
 /// RRsets.
 ///
-/// \todo The rrset cache class should provide the interfaces for
-///       loading, dumping and resizing.
+/// \todo The rrset cache class should provide the interface for
+///       resizing.
 class RRsetCache{
     ///
     /// \name Constructors and Destructor
@@ -47,9 +45,7 @@ public:
     /// \param cache_size the size of rrset cache.
     /// \param rrset_class the class of rrset cache.
     RRsetCache(uint32_t cache_size, uint16_t rrset_class);
-    virtual ~RRsetCache() {
-        rrset_lru_.clear(); // Clear the rrset entries in the list.
-    }
+    virtual ~RRsetCache() {}
     //@}
 
     /// \brief Look up rrset in cache.
@@ -74,11 +70,34 @@ public:
     RRsetEntryPtr update(const bundy::dns::AbstractRRset& rrset,
                          const RRsetTrustLevel& level);
 
+    /// \brief Dump the cache
+    ///
+    /// Writes the number of the unexpired entries in the cache (as a
+    /// 32-bit integer) followed by the entries themselves (see
+    /// \c RRsetEntry::toWire()), from the least recently used one.
+    ///
+    /// \param buffer The buffer to write the dump to.
+    /// \return The number of the dumped entries.
+    uint32_t dump(bundy::util::OutputBuffer& buffer) const;
+
+    /// \brief Load the cache from a dump
+    ///
+    /// Reads the entries written by \c dump() and adds them to the cache.
+    /// The entries that have expired in the meantime are skipped, and so
+    /// are the ones already in the cache (which are newer).  The LRU order
+    /// of the dumped cache is kept.
+    ///
+    /// \param buffer The buffer to read the dump from.
+    /// \return The number of the entries added to the cache.
+    /// \throw BadCacheDump if the data is broken or of another class.
+    /// \throw bundy::Exception Other exceptions from libutil and libdns if
+    /// the data is truncated or a name or RDATA in it is broken.
+    uint32_t load(bundy::util::InputBuffer& buffer);
+
     /// \short Protected memebers, so they can be accessed by tests.
 protected:
     uint16_t class_; // The class of the rrset cache.
-    bundy::nsas::HashTable<RRsetEntry> rrset_table_;
-    bundy::util::LruList<RRsetEntry> rrset_lru_;
+    LruHashTable<RRsetEntry> rrset_table_;
 };
 
 typedef boost::shared_ptr<RRsetCache> RRsetCachePtr;
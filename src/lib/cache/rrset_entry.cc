@@ -22,6 +22,35 @@
 
 using namespace bundy::dns;
 using namespace bundy::nsas;
+using namespace bundy::util;
+
+namespace {
+
+// The RDATA of an RRset in a cache dump: their count, followed by each of
+// them prefixed by its length.
+void
+writeRdatas(OutputBuffer& buffer, const AbstractRRset& rrset) {
+    buffer.writeUint16(rrset.getRdataCount());
+    for (RdataIteratorPtr it = rrset.getRdataIterator(); !it->isLast();
+         it->next()) {
+        const size_t pos = buffer.getLength();
+        buffer.writeUint16(0);
+        it->getCurrent().toWire(buffer);
+        buffer.writeUint16At(buffer.getLength() - pos - 2, pos);
+    }
+}
+
+void
+readRdatas(InputBuffer& buffer, AbstractRRset& rrset) {
+    const uint16_t count = buffer.readUint16();
+    for (uint16_t i = 0; i < count; ++i) {
+        const uint16_t length = buffer.readUint16();
+        rrset.addRdata(rdata::createRdata(rrset.getType(), rrset.getClass(),
+                                          buffer, length));
+    }
+}
+
+}
 
 namespace bundy {
 namespace cache {
@@ -37,6 +66,55 @@ RRsetEntry::RRsetEntry(const bundy::dns::AbstractRRset& rrset,
     rrsetCopy(rrset, *(rrset_.get()));
 }
 
+RRsetEntry::RRsetEntry(InputBuffer& buffer) :
+    expire_time_(buffer.readUint32()),
+    // The real key is set below, once the name is known
+    hash_key_(HashKey(entry_name_, RRClass::IN()))
+{
+    const uint8_t level = buffer.readUint8();
+    if (level > RRSET_TRUST_PRIM_ZONE_NONGLUE) {
+        bundy_throw(BadCacheDump, "Unknown RRset trust level in cache dump: "
+                    << static_cast<unsigned int>(level));
+    }
+    trust_level_ = static_cast<RRsetTrustLevel>(level);
+
+    const Name name(buffer);
+    const RRType type(buffer.readUint16());
+    const RRClass rrclass(buffer.readUint16());
+    const time_t now = time(NULL);
+    const RRTTL ttl(now < expire_time_ ? expire_time_ - now : 0);
+    rrset_.reset(new RRset(name, rrclass, type, ttl));
+    readRdatas(buffer, *rrset_);
+
+    RRsetPtr sigs(new RRset(name, rrclass, RRType::RRSIG(), ttl));
+    readRdatas(buffer, *sigs);
+    if (sigs->getRdataCount() > 0) {
+        rrset_->addRRsig(sigs);
+    }
+
+    entry_name_ = genCacheEntryName(name, type);
+    hash_key_ = HashKey(entry_name_, rrclass);
+}
+
+void
+RRsetEntry::toWire(OutputBuffer& buffer) const {
+    // Expiration time and trust level, then the owner name, type, class
+    // and the RDATA of the RRset and of its RRSIGs.  The TTL is implied
+    // by the expiration time.
+    buffer.writeUint32(expire_time_);
+    buffer.writeUint8(trust_level_);
+    rrset_->getName().toWire(buffer);
+    buffer.writeUint16(rrset_->getType().getCode());
+    buffer.writeUint16(rrset_->getClass().getCode());
+    writeRdatas(buffer, *rrset_);
+    const RRsetPtr sigs = rrset_->getRRsig();
+    if (sigs) {
+        writeRdatas(buffer, *sigs);
+    } else {
+        buffer.writeUint16(0);
+    }
+}
+
 bundy::dns::RRsetPtr
 RRsetEntry::getRRset() {
     updateTTL();
@@ -20,11 +20,24 @@
 #include <dns/rrttl.h>
 #include <nsas/nsas_entry.h>
 #include <nsas/fetchable.h>
+#include <util/buffer.h>
+#include <exceptions/exceptions.h>
 #include "cache_entry_key.h"
 
 namespace bundy {
 namespace cache {
 
+/// \brief A cache dump is malformed
+///
+/// Thrown when data being loaded into the cache (see
+/// \c ResolverCache::load()) is not what a cache has dumped.
+class BadCacheDump : public bundy::Exception {
+public:
+    BadCacheDump(const char* file, size_t line, const char* what) :
+        bundy::Exception(file, line, what)
+    {}
+};
+
 /// \enum RRsetTrustLevel
 /// For detail of RRset trustworthiness, please refer to
 /// RFC 2181 section 5.4.1.
@@ -76,6 +89,18 @@ public:
     RRsetEntry(const bundy::dns::AbstractRRset& rrset,
                const RRsetTrustLevel& level);
 
+    /// \brief Constructor from a cache dump
+    ///
+    /// Reads the entry in the format written by \c toWire().  The TTL of
+    /// the RRset is set according to the dumped expiration time, so it
+    /// may be zero if the entry has expired since it was dumped.
+    ///
+    /// \param buffer The buffer to read the entry from.
+    /// \throw BadCacheDump if the data is broken.
+    /// \throw bundy::Exception Other exceptions from libutil and libdns if
+    /// the data is truncated or a name or RDATA in it is broken.
+    explicit RRsetEntry(bundy::util::InputBuffer& buffer);
+
     /// The destructor.
     ~RRsetEntry() {}
     //@}
@@ -113,6 +138,16 @@ public:
     RRsetTrustLevel getTrustLevel() const {
         return (trust_level_);
     }
+
+    /// \brief Dump the entry
+    ///
+    /// Writes the entry to the buffer in a compact binary format, which
+    /// can be read by the constructor from a buffer.  The expiration time
+    /// is stored as an absolute time, so the entry keeps expiring while
+    /// it's dumped.  The RRSIGs of the RRset are dumped too.
+    ///
+    /// \param buffer The buffer to write the entry to.
+    void toWire(bundy::util::OutputBuffer& buffer) const;
 private:
     /// \brief Update TTL according to expiration time
     void updateTTL();
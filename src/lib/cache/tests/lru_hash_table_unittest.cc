@@ -0,0 +1,222 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <cache/lru_hash_table.h>
+#include <nsas/nsas_entry.h>
+#include <nsas/nsas_entry_compare.h>
+#include <dns/rrclass.h>
+
+#include <gtest/gtest.h>
+#include <boost/lexical_cast.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace bundy::cache;
+using namespace bundy::nsas;
+using namespace bundy::dns;
+using boost::lexical_cast;
+using std::string;
+
+namespace {
+
+// A minimal entry for the table
+class TestEntry : public NsasEntry<TestEntry> {
+public:
+    TestEntry(const string& name, time_t expire = 0) :
+        name_(name), expire_(expire == 0 ? time(NULL) + 3600 : expire)
+    {}
+    virtual HashKey hashKey() const {
+        return (HashKey(name_, RRClass::IN()));
+    }
+    time_t getExpireTime() const {
+        return (expire_);
+    }
+private:
+    const string name_;
+    const time_t expire_;
+};
+
+typedef boost::shared_ptr<TestEntry> TestEntryPtr;
+
+TestEntryPtr
+addEntry(LruHashTable<TestEntry>& table, const string& name,
+         time_t expire = 0)
+{
+    TestEntryPtr entry(new TestEntry(name, expire));
+    EXPECT_TRUE(table.add(entry, entry->hashKey()));
+    return (entry);
+}
+
+bool
+hasEntry(LruHashTable<TestEntry>& table, const string& name) {
+    return (table.get(HashKey(name, RRClass::IN())) != NULL);
+}
+
+TEST(LruHashTableTest, addGetRemove) {
+    LruHashTable<TestEntry> table(new NsasEntryCompare<TestEntry>, 10);
+    EXPECT_EQ(0, table.size());
+    EXPECT_EQ(1, table.getShardCount());
+    EXPECT_EQ(10, table.getMaxSize());
+
+    const TestEntryPtr entry1 = addEntry(table, "one");
+    addEntry(table, "two");
+    EXPECT_EQ(2, table.size());
+    EXPECT_EQ(entry1, table.get(entry1->hashKey()));
+    EXPECT_FALSE(hasEntry(table, "three"));
+
+    // Adding the same key fails unless it's a replacement
+    TestEntryPtr entry1b(new TestEntry("one"));
+    EXPECT_FALSE(table.add(entry1b, entry1b->hashKey()));
+    EXPECT_EQ(entry1, table.get(entry1->hashKey()));
+    EXPECT_TRUE(table.add(entry1b, entry1b->hashKey(), true));
+    EXPECT_EQ(entry1b, table.get(entry1->hashKey()));
+    EXPECT_FALSE(entry1->iteratorValid());
+    EXPECT_EQ(2, table.size());
+
+    EXPECT_TRUE(table.remove(entry1->hashKey()));
+    EXPECT_FALSE(table.remove(entry1->hashKey()));
+    EXPECT_FALSE(entry1b->iteratorValid());
+    EXPECT_FALSE(hasEntry(table, "one"));
+    EXPECT_EQ(1, table.size());
+
+    // Removing a given object fails if it was replaced by another one
+    const TestEntryPtr entry2 = table.get(HashKey("two", RRClass::IN()));
+    TestEntryPtr entry2b(new TestEntry("two"));
+    EXPECT_TRUE(table.add(entry2b, entry2b->hashKey(), true));
+    EXPECT_FALSE(table.remove(entry2->hashKey(), entry2));
+    EXPECT_EQ(entry2b, table.get(entry2->hashKey()));
+    EXPECT_TRUE(table.remove(entry2->hashKey(), entry2b));
+    EXPECT_FALSE(table.remove(entry2->hashKey(), entry2b));
+    EXPECT_FALSE(hasEntry(table, "two"));
+    EXPECT_EQ(0, table.size());
+    addEntry(table, "two");
+
+    table.clear();
+    EXPECT_EQ(0, table.size());
+    EXPECT_FALSE(hasEntry(table, "two"));
+}
+
+TEST(LruHashTableTest, lru) {
+    LruHashTable<TestEntry> table(new NsasEntryCompare<TestEntry>, 3);
+    addEntry(table, "one");
+    addEntry(table, "two");
+    addEntry(table, "three");
+
+    // Touch the oldest one, so the second one is dropped next
+    EXPECT_TRUE(hasEntry(table, "one"));
+    addEntry(table, "four");
+    EXPECT_EQ(3, table.size());
+    EXPECT_FALSE(hasEntry(table, "two"));
+    EXPECT_TRUE(hasEntry(table, "three"));
+    EXPECT_TRUE(hasEntry(table, "one"));
+    EXPECT_TRUE(hasEntry(table, "four"));
+
+    // Now "three" is the least recently used one
+    addEntry(table, "five");
+    EXPECT_FALSE(hasEntry(table, "three"));
+}
+
+TEST(LruHashTableTest, expiredFirst) {
+    LruHashTable<TestEntry> table(new NsasEntryCompare<TestEntry>, 3, 1009,
+                                  new ExpireTimeCheck<TestEntry>);
+    addEntry(table, "one");
+    addEntry(table, "expired", time(NULL) - 1);
+    addEntry(table, "three");
+
+    // The expired entry is not touched by get, and it's dropped before
+    // the least recently used one.
+    EXPECT_TRUE(hasEntry(table, "expired"));
+    addEntry(table, "four");
+    EXPECT_FALSE(hasEntry(table, "expired"));
+    EXPECT_TRUE(hasEntry(table, "one"));
+
+    // Without an expired entry, the least recently used one is dropped.
+    addEntry(table, "five");
+    EXPECT_FALSE(hasEntry(table, "three"));
+}
+
+TEST(LruHashTableTest, snapshot) {
+    LruHashTable<TestEntry> table(new NsasEntryCompare<TestEntry>, 10);
+    std::vector<TestEntryPtr> entries;
+    table.snapshot(entries);
+    EXPECT_TRUE(entries.empty());
+
+    const TestEntryPtr entry1 = addEntry(table, "one");
+    const TestEntryPtr entry2 = addEntry(table, "two");
+    const TestEntryPtr entry3 = addEntry(table, "three");
+    EXPECT_TRUE(hasEntry(table, "one"));
+
+    // From the least recently used one, appended to what's there.  The
+    // snapshot doesn't touch the entries.
+    entries.push_back(entry3);
+    table.snapshot(entries);
+    ASSERT_EQ(4, entries.size());
+    EXPECT_EQ(entry3, entries[0]);
+    EXPECT_EQ(entry2, entries[1]);
+    EXPECT_EQ(entry3, entries[2]);
+    EXPECT_EQ(entry1, entries[3]);
+    entries.clear();
+    table.snapshot(entries);
+    EXPECT_EQ(entry2, entries[0]);
+
+    // All the shards are included
+    const uint32_t max_size = 4 * LruHashTable<TestEntry>::MIN_SHARD_SIZE;
+    LruHashTable<TestEntry> sharded(new NsasEntryCompare<TestEntry>,
+                                    max_size, max_size / 2, NULL, 4);
+    for (int i = 0; i < 100; ++i) {
+        addEntry(sharded, lexical_cast<string>(i));
+    }
+    entries.clear();
+    sharded.snapshot(entries);
+    EXPECT_EQ(100, entries.size());
+}
+
+TEST(LruHashTableTest, shards) {
+    // Small tables use a single shard, big ones are split up to the limit
+    EXPECT_EQ(1, LruHashTable<TestEntry>(new NsasEntryCompare<TestEntry>,
+                                         1).getShardCount());
+    EXPECT_EQ(1, LruHashTable<TestEntry>(new NsasEntryCompare<TestEntry>,
+                                         1000, 1009, NULL,
+                                         0).getShardCount());
+    EXPECT_EQ(2, LruHashTable<TestEntry>(
+                  new NsasEntryCompare<TestEntry>,
+                  2 * LruHashTable<TestEntry>::MIN_SHARD_SIZE).
+              getShardCount());
+    EXPECT_EQ(LruHashTable<TestEntry>::DEFAULT_SHARDS,
+              LruHashTable<TestEntry>(new NsasEntryCompare<TestEntry>,
+                                      30000).getShardCount());
+
+    // Fill a sharded table over its limit.  Each shard drops its own
+    // entries, so the size is kept and the newest entries are all there.
+    const uint32_t max_size = 4 * LruHashTable<TestEntry>::MIN_SHARD_SIZE;
+    LruHashTable<TestEntry> table(new NsasEntryCompare<TestEntry>, max_size,
+                                  max_size / 2, NULL, 4);
+    EXPECT_EQ(4, table.getShardCount());
+    EXPECT_EQ(max_size, table.getMaxSize());
+    for (uint32_t i = 0; i < 2 * max_size; ++i) {
+        addEntry(table, lexical_cast<string>(i));
+    }
+    EXPECT_GE(max_size, table.size());
+    EXPECT_LT(max_size / 2, table.size());
+    for (uint32_t i = 2 * max_size - 10; i < 2 * max_size; ++i) {
+        EXPECT_TRUE(hasEntry(table, lexical_cast<string>(i)));
+    }
+    EXPECT_FALSE(hasEntry(table, "0"));
+}
+
+}
@@ -42,7 +42,7 @@ public:
     {}
 
     uint16_t messages_count() {
-        return message_lru_.size();
+        return message_table_.size();
     }
 };
 
@@ -58,11 +58,7 @@ public:
     void removeRRsetEntry(Name& name, const RRType& type) {
         const string entry_name = genCacheEntryName(name, type);
         HashKey entry_key = HashKey(entry_name, RRClass(class_));
-        RRsetEntryPtr rrset_entry = rrset_table_.get(entry_key);
-        if (rrset_entry) {
-            rrset_lru_.remove(rrset_entry);
-            rrset_table_.remove(entry_key);
-        }
+        rrset_table_.remove(entry_key);
     }
 };
 
@@ -127,6 +123,50 @@ TEST_F(MessageCacheTest, testLookup) {
     EXPECT_EQ(message_cache_->messages_count(), 2);
 }
 
+TEST_F(MessageCacheTest, prefetch) {
+    messageFromFile(message_parse, "message_fromWire4");
+    EXPECT_TRUE(message_cache_->update(message_parse));
+    const Name qname("example.com.");
+    vector<QuestionPtr> questions;
+
+    // Disabled by default
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_TRUE(message_cache_->lookup(qname, RRType::SOA(),
+                                           message_render));
+    }
+    message_cache_->getPrefetchQuestions(questions);
+    EXPECT_TRUE(questions.empty());
+
+    // Due on the third lookup (the whole TTL counts as the end of it here),
+    // but only queued once.
+    message_cache_->setPrefetchPolicy(3, 1.0);
+    EXPECT_TRUE(message_cache_->update(message_parse));
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::SOA(), message_render));
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::SOA(), message_render));
+    message_cache_->getPrefetchQuestions(questions);
+    EXPECT_TRUE(questions.empty());
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::SOA(), message_render));
+    EXPECT_TRUE(message_cache_->lookup(qname, RRType::SOA(), message_render));
+    message_cache_->getPrefetchQuestions(questions);
+    ASSERT_EQ(1, questions.size());
+    EXPECT_EQ(Question(qname, RRClass::IN(), RRType::SOA()).toText(),
+              questions[0]->toText());
+
+    // The queue was emptied
+    questions.clear();
+    message_cache_->getPrefetchQuestions(questions);
+    EXPECT_TRUE(questions.empty());
+
+    // The prefetched answer replaces the message, which is counted anew
+    EXPECT_TRUE(message_cache_->update(message_parse));
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_TRUE(message_cache_->lookup(qname, RRType::SOA(),
+                                           message_render));
+    }
+    message_cache_->getPrefetchQuestions(questions);
+    EXPECT_EQ(1, questions.size());
+}
+
 TEST_F(MessageCacheTest, testUpdate) {
     messageFromFile(message_parse, "message_fromWire4");
     EXPECT_TRUE(message_cache_->update(message_parse));
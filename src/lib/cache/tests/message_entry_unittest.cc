@@ -280,6 +280,46 @@ TEST_F(MessageEntryTest, testGenMessage) {
     EXPECT_EQ(7, msg.getRRCount(Message::SECTION_ADDITIONAL));
 }
 
+TEST_F(MessageEntryTest, testCountHit) {
+    messageFromFile(message_parse, "message_fromWire3");
+    DerivedMessageEntry message_entry(message_parse, rrset_cache_,
+                                      negative_soa_cache_);
+    const time_t now = time(NULL);
+    const time_t expire_time = message_entry.getExpireTime();
+    const time_t lifetime = expire_time - now;
+    ASSERT_LT(20, lifetime);
+
+    // Not popular enough yet, and then not close enough to the expiration
+    EXPECT_FALSE(message_entry.countHit(now, 2, 0.1));
+    EXPECT_FALSE(message_entry.countHit(now, 2, 0.1));
+    EXPECT_FALSE(message_entry.countHit(expire_time - lifetime / 5, 2, 0.1));
+    // Now it's due, but only once
+    const time_t due_time = expire_time - lifetime / 20;
+    EXPECT_TRUE(message_entry.countHit(due_time, 2, 0.1));
+    EXPECT_FALSE(message_entry.countHit(due_time, 2, 0.1));
+    EXPECT_FALSE(message_entry.countHit(
+        due_time + MessageEntry::PREFETCH_RETRY_INTERVAL - 1, 2, 0.1));
+    EXPECT_EQ(6, message_entry.getHits());
+
+    // Never due when disabled or expired
+    DerivedMessageEntry message_entry2(message_parse, rrset_cache_,
+                                       negative_soa_cache_);
+    EXPECT_FALSE(message_entry2.countHit(expire_time - 1, 0, 0));
+    EXPECT_FALSE(message_entry2.countHit(expire_time, 0, 1));
+    EXPECT_TRUE(message_entry2.countHit(expire_time - 1, 0, 1));
+
+    // If the entry hasn't been replaced a while after the refresh was
+    // requested, the refresh failed, so it's due again.
+    DerivedMessageEntry message_entry3(message_parse, rrset_cache_,
+                                       negative_soa_cache_);
+    const time_t retry_time = now + MessageEntry::PREFETCH_RETRY_INTERVAL;
+    ASSERT_LT(retry_time, expire_time);
+    EXPECT_TRUE(message_entry3.countHit(now, 0, 1));
+    EXPECT_FALSE(message_entry3.countHit(retry_time - 1, 0, 1));
+    EXPECT_TRUE(message_entry3.countHit(retry_time, 0, 1));
+    EXPECT_FALSE(message_entry3.countHit(retry_time, 0, 1));
+}
+
 TEST_F(MessageEntryTest, testMaxTTL) {
     messageFromFile(message_parse, "message_large_ttl.wire");
 
@@ -171,6 +171,72 @@ TEST_F(NegativeCacheTest, testNXDOMAINCname){
     EXPECT_EQ(soa_ttl.getValue(), 600);
 }
 
+// Generate a message for the question and look it up in the cache
+bool
+lookupNegative(ResolverCache& cache, const Name& qname, const RRType& qtype,
+               Message& msg)
+{
+    msg.addQuestion(Question(qname, RRClass::IN(), qtype));
+    return (cache.lookup(qname, qtype, RRClass::IN(), msg));
+}
+
+TEST_F(NegativeCacheTest, testNXDOMAINSharing){
+    // NXDOMAIN response for nonexist.example.com/A
+    Message msg_nxdomain(Message::PARSE);
+    messageFromFile(msg_nxdomain, "message_nxdomain_with_soa.wire");
+    cache->update(msg_nxdomain);
+
+    // It holds for the other types of the name, and the names below it
+    const char* const names[] = {"nonexist.example.com.",
+                                 "a.b.nonexist.example.com."};
+    const RRType types[] = {RRType::MX(), RRType::AAAA(), RRType::NS()};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+        for (size_t j = 0; j < sizeof(types) / sizeof(types[0]); ++j) {
+            SCOPED_TRACE(string(names[i]) + "/" + types[j].toText());
+            Message msg(Message::RENDER);
+            EXPECT_TRUE(lookupNegative(*cache, Name(names[i]), types[j],
+                                       msg));
+            EXPECT_EQ(Rcode::NXDOMAIN(), msg.getRcode());
+            EXPECT_FALSE(msg.getHeaderFlag(Message::HEADERFLAG_AA));
+            EXPECT_EQ(0, msg.getRRCount(Message::SECTION_ANSWER));
+            ASSERT_EQ(1, msg.getRRCount(Message::SECTION_AUTHORITY));
+            RRsetIterator iter = msg.beginSection(Message::SECTION_AUTHORITY);
+            EXPECT_EQ(RRType::SOA(), (*iter)->getType());
+            EXPECT_EQ(Name("example.com."), (*iter)->getName());
+            EXPECT_GE((*iter)->getTTL().getValue(), 86399);
+        }
+    }
+
+    // The cached message of the query type itself is NXDOMAIN too
+    Message msg_a(Message::RENDER);
+    EXPECT_TRUE(lookupNegative(*cache, Name("nonexist.example.com."),
+                               RRType::A(), msg_a));
+    EXPECT_EQ(Rcode::NXDOMAIN(), msg_a.getRcode());
+
+    // But not the names above it or next to it
+    Message msg_above(Message::RENDER);
+    EXPECT_FALSE(lookupNegative(*cache, Name("example.com."), RRType::A(),
+                                msg_above));
+    Message msg_next(Message::RENDER);
+    EXPECT_FALSE(lookupNegative(*cache, Name("other.example.com."),
+                                RRType::A(), msg_next));
+}
+
+TEST_F(NegativeCacheTest, testNXDOMAINCnameNotShared){
+    // The NXDOMAIN is for the end of the CNAME chain, not the query name,
+    // so it's only cached for the query.
+    Message msg_nxdomain_cname(Message::PARSE);
+    messageFromFile(msg_nxdomain_cname, "message_nxdomain_cname.wire");
+    cache->update(msg_nxdomain_cname);
+
+    Message msg_mx(Message::RENDER);
+    EXPECT_FALSE(lookupNegative(*cache, Name("a.example.org."), RRType::MX(),
+                                msg_mx));
+    Message msg_target(Message::RENDER);
+    EXPECT_FALSE(lookupNegative(*cache, Name("c.example.org."), RRType::A(),
+                                msg_target));
+}
+
 TEST_F(NegativeCacheTest, testNoerrorNodata){
     // NODATA/NOERROR response for MX type query of example.com
     Message msg_nodata(Message::PARSE);
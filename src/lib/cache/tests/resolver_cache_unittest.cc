@@ -14,6 +14,8 @@
 
 #include <config.h>
 #include <string>
+#include <fstream>
+#include <cstdio>
 #include <gtest/gtest.h>
 #include <dns/rrset.h>
 #include "resolver_cache.h"
@@ -26,6 +28,8 @@ using namespace std;
 
 namespace {
 
+const char* const DUMP_FILE = TEST_DATA_BUILDDIR "/resolver_cache.dump";
+
 class ResolverCacheTest: public testing::Test {
 public:
     ResolverCacheTest() {
@@ -39,6 +43,7 @@ public:
 
     ~ResolverCacheTest() {
         delete cache;
+        std::remove(DUMP_FILE);
     }
 
     ResolverCache* cache;
@@ -125,4 +130,67 @@ TEST_F(ResolverCacheTest, testLookupClosestRRset) {
     EXPECT_FALSE(rrset_ptr);
 }
 
+TEST_F(ResolverCacheTest, dumpLoad) {
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire3");
+    cache->update(msg);
+    EXPECT_TRUE(cache->dump(DUMP_FILE));
+
+    // The default cache has no CH class, that part of the dump is skipped
+    ResolverCache loaded;
+    EXPECT_TRUE(loaded.load(DUMP_FILE));
+
+    const Name qname("example.com.");
+    Message expected(Message::RENDER);
+    expected.addQuestion(Question(qname, RRClass::IN(), RRType::SOA()));
+    EXPECT_TRUE(cache->lookup(qname, RRType::SOA(), RRClass::IN(),
+                              expected));
+    Message response(Message::RENDER);
+    response.addQuestion(Question(qname, RRClass::IN(), RRType::SOA()));
+    EXPECT_TRUE(loaded.lookup(qname, RRType::SOA(), RRClass::IN(),
+                              response));
+    for (int section = Message::SECTION_ANSWER;
+         section <= Message::SECTION_ADDITIONAL; ++section) {
+        const Message::Section sect = static_cast<Message::Section>(section);
+        EXPECT_EQ(sectionRRsetCount(expected, sect),
+                  sectionRRsetCount(response, sect));
+    }
+    EXPECT_EQ(cache->lookup(qname, RRType::NS(), RRClass::IN())->toText(),
+              loaded.lookup(qname, RRType::NS(), RRClass::IN())->toText());
+}
+
+TEST_F(ResolverCacheTest, loadBrokenDump) {
+    // A missing dump is fine, it just means an empty cache
+    std::remove(DUMP_FILE);
+    EXPECT_TRUE(cache->load(DUMP_FILE));
+
+    // Something else than a dump
+    {
+        std::ofstream out(DUMP_FILE);
+        out << "This is not a cache dump";
+    }
+    EXPECT_FALSE(cache->load(DUMP_FILE));
+
+    // A truncated dump
+    Message msg(Message::PARSE);
+    messageFromFile(msg, "message_fromWire3");
+    cache->update(msg);
+    EXPECT_TRUE(cache->dump(DUMP_FILE));
+    string data;
+    {
+        std::ifstream in(DUMP_FILE);
+        data.assign((std::istreambuf_iterator<char>(in)),
+                    std::istreambuf_iterator<char>());
+    }
+    {
+        std::ofstream out(DUMP_FILE);
+        out << data.substr(0, data.size() - 10);
+    }
+    ResolverCache loaded;
+    EXPECT_FALSE(loaded.load(DUMP_FILE));
+
+    // Dumping to a place that can't be written fails
+    EXPECT_FALSE(cache->dump(TEST_DATA_BUILDDIR "/nonexistent/cache.dump"));
+}
+
 }
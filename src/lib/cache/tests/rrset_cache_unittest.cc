@@ -24,9 +24,11 @@
 #include <dns/rrtype.h>
 #include <dns/rrttl.h>
 #include <dns/rrset.h>
+#include <util/buffer.h>
 
 using namespace bundy::cache;
 using namespace bundy::dns;
+using namespace bundy::util;
 using namespace std;
 
 namespace {
@@ -124,4 +126,54 @@ TEST_F(RRsetCacheTest, cacheLruBehavior) {
     EXPECT_FALSE(cache_.lookup(name4, RRType::A()));
 }
 
+TEST_F(RRsetCacheTest, dumpLoad) {
+    Name name1("1.example.com.");
+    Name name2("2.example.com.");
+    Name name3("3.example.com.");
+    updateRRsetCache(cache_, name1);
+    updateRRsetCache(cache_, name2, 20, RRSET_TRUST_PRIM_GLUE);
+    // The expired one isn't dumped
+    updateRRsetCache(cache_, name3, 0);
+
+    OutputBuffer buffer(0);
+    EXPECT_EQ(2, cache_.dump(buffer));
+
+    // The dumped entries are loaded with their trust level, and the LRU
+    // order is kept (name1 is the oldest, so it's dropped first).
+    RRsetCache cache(1, RRClass::IN().getCode());
+    InputBuffer ibuffer(buffer.getData(), buffer.getLength());
+    EXPECT_EQ(2, cache.load(ibuffer));
+    EXPECT_EQ(buffer.getLength(), ibuffer.getPosition());
+    EXPECT_FALSE(cache.lookup(name3, RRType::A()));
+    EXPECT_EQ(RRSET_TRUST_PRIM_GLUE,
+              cache.lookup(name2, RRType::A())->getTrustLevel());
+    updateRRsetCache(cache, name3);
+    updateRRsetCache(cache, name_);
+    EXPECT_FALSE(cache.lookup(name1, RRType::A()));
+    EXPECT_TRUE(cache.lookup(name2, RRType::A()));
+
+    // Entries that expired after the dump are skipped, and so are the ones
+    // already in the cache.
+    buffer.clear();
+    buffer.writeUint32(3);
+    RRsetEntry(RRset(name1, RRClass::IN(), RRType::A(), RRTTL(0)),
+               RRSET_TRUST_ADDITIONAL_AA).toWire(buffer);
+    RRsetEntry(RRset(name2, RRClass::IN(), RRType::A(), RRTTL(20)),
+               RRSET_TRUST_ADDITIONAL_AA).toWire(buffer);
+    Name name4("4.example.com.");
+    RRsetEntry(RRset(name4, RRClass::IN(), RRType::A(), RRTTL(20)),
+               RRSET_TRUST_ADDITIONAL_AA).toWire(buffer);
+    InputBuffer ibuffer2(buffer.getData(), buffer.getLength());
+    EXPECT_EQ(1, cache.load(ibuffer2));
+    EXPECT_FALSE(cache.lookup(name1, RRType::A()));
+    EXPECT_EQ(RRSET_TRUST_PRIM_GLUE,
+              cache.lookup(name2, RRType::A())->getTrustLevel());
+    EXPECT_TRUE(cache.lookup(name4, RRType::A()));
+
+    // A dump of another class is refused
+    RRsetCache ch_cache(1, RRClass::CH().getCode());
+    InputBuffer ibuffer3(buffer.getData(), buffer.getLength());
+    EXPECT_THROW(ch_cache.load(ibuffer3), BadCacheDump);
+}
+
 }
@@ -22,9 +22,12 @@
 #include <dns/rrtype.h>
 #include <dns/rrttl.h>
 #include <dns/rrset.h>
+#include <dns/rdataclass.h>
+#include <util/buffer.h>
 
 using namespace bundy::cache;
 using namespace bundy::dns;
+using namespace bundy::util;
 using namespace std;
 
 namespace {
@@ -99,5 +102,57 @@ TEST_F(RRsetEntryTest, getExpireTime){
     EXPECT_EQ(exp_time, rrset_entry.getExpireTime());
 }
 
+TEST_F(RRsetEntryTest, toWire) {
+    RRsetPtr signed_rrset(new RRset(name, RRClass::IN(), RRType::A(),
+                                    RRTTL(TEST_TTL)));
+    signed_rrset->addRdata(rdata::in::A("192.0.2.1"));
+    signed_rrset->addRdata(rdata::in::A("192.0.2.2"));
+    signed_rrset->addRRsig(rdata::createRdata(
+        RRType::RRSIG(), RRClass::IN(),
+        "A 5 3 3600 20000101000000 20000201000000 12345 example.com. "
+        "FAKEFAKEFAKE"));
+    const RRsetEntry entry(*signed_rrset, RRSET_TRUST_ANSWER_AA);
+
+    OutputBuffer buffer(0);
+    entry.toWire(buffer);
+    InputBuffer ibuffer(buffer.getData(), buffer.getLength());
+    RRsetEntry loaded(ibuffer);
+    EXPECT_EQ(buffer.getLength(), ibuffer.getPosition());
+
+    EXPECT_EQ(RRSET_TRUST_ANSWER_AA, loaded.getTrustLevel());
+    EXPECT_EQ(entry.getExpireTime(), loaded.getExpireTime());
+    EXPECT_EQ(genCacheEntryName(name, RRType::A()),
+              string(loaded.hashKey().key, loaded.hashKey().keylen));
+    EXPECT_EQ(RRClass::IN(), loaded.hashKey().class_code);
+    EXPECT_EQ(signed_rrset->toText(), loaded.getRRset()->toText());
+    ASSERT_TRUE(loaded.getRRset()->getRRsig());
+    EXPECT_EQ(signed_rrset->getRRsig()->toText(),
+              loaded.getRRset()->getRRsig()->toText());
+
+    // Unsigned RRsets work too, of course
+    buffer.clear();
+    rrset_entry.toWire(buffer);
+    InputBuffer ibuffer2(buffer.getData(), buffer.getLength());
+    RRsetEntry loaded2(ibuffer2);
+    EXPECT_EQ(trust_level, loaded2.getTrustLevel());
+    EXPECT_FALSE(loaded2.getRRset()->getRRsig());
+}
+
+TEST_F(RRsetEntryTest, fromBrokenWire) {
+    OutputBuffer buffer(0);
+    rrset_entry.toWire(buffer);
+
+    // Truncated data
+    for (size_t len = 0; len < buffer.getLength(); ++len) {
+        InputBuffer ibuffer(buffer.getData(), len);
+        EXPECT_THROW(RRsetEntry entry(ibuffer), bundy::Exception);
+    }
+
+    // Unknown trust level
+    buffer.writeUint8At(RRSET_TRUST_PRIM_ZONE_NONGLUE + 1, 4);
+    InputBuffer ibuffer(buffer.getData(), buffer.getLength());
+    EXPECT_THROW(RRsetEntry entry(ibuffer), BadCacheDump);
+}
+
 }   // namespace
 
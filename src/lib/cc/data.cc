@@ -15,6 +15,7 @@
 #include <config.h>
 
 #include <cc/data.h>
+#include <cc/proto_defs.h>
 
 #include <cstring>
 #include <cassert>
@@ -32,10 +33,274 @@
 
 #include <cmath>
 
+#include <stdint.h>
+
 using namespace std;
 
 namespace {
 const char* const WHITESPACE = " \b\f\n\r\t";
+
+// The binary wire format.  The data start with BINARY_WIRE_MARKER (which
+// can never start JSON text), followed by one encoded value:
+//
+//  value := TAG_NULL | TAG_FALSE | TAG_TRUE
+//         | TAG_INTEGER varint        (zigzag encoded 64-bit integer)
+//         | TAG_REAL 8 bytes          (IEEE 754 double in network order)
+//         | TAG_STRING varint bytes   (length followed by the UTF-8 data)
+//         | TAG_INTERNED 1 byte       (index in the interned strings)
+//         | TAG_LIST varint value*    (count followed by the elements)
+//         | TAG_MAP varint (string value)*  (count followed by key/values)
+//
+// where varint is an unsigned LEB128 integer, and the keys of map are
+// encoded as TAG_STRING or TAG_INTERNED values.  The interned strings are
+// the (space separated) bundy::cc::CC_WIRE_INTERNED_STRINGS; they are the
+// most common keys and values in the messages, which are encoded in two
+// bytes this way.  The same format is implemented in bundy.cc.message
+// for Python.
+const uint8_t BINARY_WIRE_MARKER = 0xbc;
+enum BinaryWireTag {
+    TAG_NULL = 0,
+    TAG_FALSE = 1,
+    TAG_TRUE = 2,
+    TAG_INTEGER = 3,
+    TAG_REAL = 4,
+    TAG_STRING = 5,
+    TAG_INTERNED = 6,
+    TAG_LIST = 7,
+    TAG_MAP = 8
+};
+
+// The table of interned strings, in both directions.
+class InternedStrings {
+public:
+    InternedStrings() {
+        std::istringstream iss(bundy::cc::CC_WIRE_INTERNED_STRINGS);
+        std::string str;
+        while (iss >> str) {
+            assert(strings_.size() <= 0xff);
+            indexes_[str] = strings_.size();
+            strings_.push_back(str);
+        }
+    }
+    // Return the index of the string, or -1 if it's not interned.
+    int find(const std::string& str) const {
+        const std::map<std::string, uint8_t>::const_iterator it =
+            indexes_.find(str);
+        return (it == indexes_.end() ? -1 : it->second);
+    }
+    const std::vector<std::string>& getStrings() const { return (strings_); }
+private:
+    std::vector<std::string> strings_;
+    std::map<std::string, uint8_t> indexes_;
+};
+
+const InternedStrings&
+getInternedStrings() {
+    static const InternedStrings interned;
+    return (interned);
+}
+
+void
+writeVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+void
+writeBinaryString(std::string& out, const std::string& str) {
+    const int index = getInternedStrings().find(str);
+    if (index >= 0) {
+        out.push_back(TAG_INTERNED);
+        out.push_back(static_cast<char>(index));
+    } else {
+        out.push_back(TAG_STRING);
+        writeVarint(out, str.size());
+        out.append(str);
+    }
+}
+
+void
+writeBinary(std::string& out, const bundy::data::Element& element) {
+    using bundy::data::Element;
+    using bundy::data::ConstElementPtr;
+
+    switch (element.getType()) {
+    case Element::null:
+        out.push_back(TAG_NULL);
+        break;
+    case Element::boolean:
+        out.push_back(element.boolValue() ? TAG_TRUE : TAG_FALSE);
+        break;
+    case Element::integer: {
+        const int64_t value = element.intValue();
+        out.push_back(TAG_INTEGER);
+        writeVarint(out, (static_cast<uint64_t>(value) << 1) ^
+                    static_cast<uint64_t>(value >> 63));
+        break;
+    }
+    case Element::real: {
+        const double value = element.doubleValue();
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        out.push_back(TAG_REAL);
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<char>((bits >> shift) & 0xff));
+        }
+        break;
+    }
+    case Element::string:
+        writeBinaryString(out, element.stringValue());
+        break;
+    case Element::list: {
+        const std::vector<ConstElementPtr>& list = element.listValue();
+        out.push_back(TAG_LIST);
+        writeVarint(out, list.size());
+        for (std::vector<ConstElementPtr>::const_iterator it = list.begin();
+             it != list.end(); ++it) {
+            writeBinary(out, **it);
+        }
+        break;
+    }
+    case Element::map: {
+        const std::map<std::string, ConstElementPtr>& map =
+            element.mapValue();
+        out.push_back(TAG_MAP);
+        writeVarint(out, map.size());
+        for (std::map<std::string, ConstElementPtr>::const_iterator it =
+                 map.begin(); it != map.end(); ++it) {
+            writeBinaryString(out, it->first);
+            writeBinary(out, *it->second);
+        }
+        break;
+    }
+    default:
+        bundy_throw(bundy::data::TypeError,
+                    "unexpected element type in binary wire conversion: " <<
+                    element.getType());
+    }
+}
+
+// A helper to parse the binary wire format.
+class BinaryWireReader {
+public:
+    BinaryWireReader(const uint8_t* data, size_t length) :
+        cp_(data), end_(data + length)
+    {}
+
+    bool atEnd() const { return (cp_ == end_); }
+
+    uint8_t readByte() {
+        if (cp_ == end_) {
+            bundy_throw(bundy::data::JSONError, "binary wire data too short");
+        }
+        return (*cp_++);
+    }
+
+    uint64_t readVarint() {
+        uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = readByte();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return (value);
+            }
+        }
+        bundy_throw(bundy::data::JSONError, "binary wire varint too long");
+    }
+
+    // Read the size of data or the number of elements, whichever it is,
+    // at least one byte per unit should follow.
+    size_t readCount() {
+        const uint64_t count = readVarint();
+        if (count > static_cast<uint64_t>(end_ - cp_)) {
+            bundy_throw(bundy::data::JSONError,
+                        "binary wire count exceeds the data");
+        }
+        return (count);
+    }
+
+    std::string readString(uint8_t tag) {
+        if (tag == TAG_INTERNED) {
+            const uint8_t index = readByte();
+            const std::vector<std::string>& strings =
+                getInternedStrings().getStrings();
+            if (index >= strings.size()) {
+                bundy_throw(bundy::data::JSONError,
+                            "unknown interned string in binary wire: " <<
+                            static_cast<unsigned int>(index));
+            }
+            return (strings[index]);
+        } else if (tag == TAG_STRING) {
+            const size_t length = readCount();
+            const std::string str(reinterpret_cast<const char*>(cp_), length);
+            cp_ += length;
+            return (str);
+        }
+        bundy_throw(bundy::data::JSONError,
+                    "binary wire string expected, tag: " <<
+                    static_cast<unsigned int>(tag));
+    }
+
+    bundy::data::ElementPtr readElement() {
+        using bundy::data::Element;
+        using bundy::data::ElementPtr;
+
+        const uint8_t tag = readByte();
+        switch (tag) {
+        case TAG_NULL:
+            return (Element::create());
+        case TAG_FALSE:
+            return (Element::create(false));
+        case TAG_TRUE:
+            return (Element::create(true));
+        case TAG_INTEGER: {
+            const uint64_t value = readVarint();
+            return (Element::create(static_cast<long long int>(
+                                        (value >> 1) ^ (~(value & 1) + 1))));
+        }
+        case TAG_REAL: {
+            uint64_t bits = 0;
+            for (int i = 0; i < 8; ++i) {
+                bits = (bits << 8) | readByte();
+            }
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return (Element::create(value));
+        }
+        case TAG_STRING:
+        case TAG_INTERNED:
+            return (Element::create(readString(tag)));
+        case TAG_LIST: {
+            const size_t count = readCount();
+            ElementPtr list = Element::createList();
+            for (size_t i = 0; i < count; ++i) {
+                list->add(readElement());
+            }
+            return (list);
+        }
+        case TAG_MAP: {
+            const size_t count = readCount();
+            ElementPtr map = Element::createMap();
+            for (size_t i = 0; i < count; ++i) {
+                const std::string key = readString(readByte());
+                map->set(key, readElement());
+            }
+            return (map);
+        }
+        default:
+            bundy_throw(bundy::data::JSONError,
+                        "unknown binary wire tag: " <<
+                        static_cast<unsigned int>(tag));
+        }
+    }
+
+private:
+    const uint8_t* cp_;
+    const uint8_t* const end_;
+};
 } // end anonymous namespace
 
 namespace bundy {
@@ -60,6 +325,14 @@ Element::toWire(std::ostream& ss) const {
     toJSON(ss);
 }
 
+std::string
+Element::toBinaryWire() const {
+    std::string out;
+    out.push_back(BINARY_WIRE_MARKER);
+    writeBinary(out, *this);
+    return (out);
+}
+
 bool
 Element::getValue(int64_t&) const {
     return (false);
@@ -780,14 +1053,33 @@ MapElement::find(const std::string& id) const {
 
 ElementPtr
 Element::fromWire(const std::string& s) {
+    return (fromWire(s.data(), s.size()));
+}
+
+ElementPtr
+Element::fromWire(const void* data, size_t length) {
+    const uint8_t* const cp = static_cast<const uint8_t*>(data);
+    if (length > 0 && cp[0] == BINARY_WIRE_MARKER) {
+        BinaryWireReader reader(cp + 1, length - 1);
+        ElementPtr element = reader.readElement();
+        if (!reader.atEnd()) {
+            bundy_throw(JSONError, "trailing garbage in binary wire data");
+        }
+        return (element);
+    }
     std::stringstream ss;
-    ss << s;
+    ss.write(static_cast<const char*>(data), length);
     int line = 0, pos = 0;
     return (fromJSON(ss, "<wire>", line, pos));
 }
 
 ElementPtr
-Element::fromWire(std::stringstream& in, int) {
+Element::fromWire(std::stringstream& in, int length) {
+    if (length > 0 && in.peek() == BINARY_WIRE_MARKER) {
+        std::vector<char> data(length);
+        in.read(&data[0], length);
+        return (fromWire(&data[0], in.gcount()));
+    }
     //
     // Check protocol version
     //
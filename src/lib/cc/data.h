@@ -107,6 +107,18 @@ public:
     std::string toWire() const;
     void toWire(std::ostream& out) const;
 
+    /// Returns the binary wire format for the Element and all its child
+    /// elements.
+    ///
+    /// This is a more compact alternative to the JSON based wire format
+    /// of \c toWire(), which is also much cheaper to parse.  The
+    /// \c fromWire() functions recognize both formats.  As the other end
+    /// of a connection may not understand it, the binary format is only
+    /// used where it has been negotiated (see \c bundy::cc::Session).
+    ///
+    /// \return std::string containing the element in binary wire format
+    std::string toBinaryWire() const;
+
     /// \name pure virtuals, every derived class must implement these
 
     /// \return true if the other ElementPtr has the same type and value
@@ -358,7 +370,8 @@ public:
 
     /// These function pparse the wireformat at the given stringstream
     /// (of the given length). If there is a parse error an exception
-    /// of the type bundy::cc::DecodeError is raised.
+    /// of the type JSONError is raised.  The data can be in either JSON
+    /// or binary wire format (see \c toBinaryWire()).
 
     //@{
     /// Creates an Element from the wire format in the given
@@ -378,6 +391,13 @@ public:
     /// \param s The input string
     /// \return ElementPtr with the data that is parsed.
     static ElementPtr fromWire(const std::string& s);
+
+    /// Creates an Element from the wire format in the given buffer.
+    ///
+    /// \param data The start of the wire format data
+    /// \param length The length of the data in bytes
+    /// \return ElementPtr with the data that is parsed.
+    static ElementPtr fromWire(const void* data, size_t length);
     //@}
 };
 
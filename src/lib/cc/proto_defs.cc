@@ -53,6 +53,14 @@ const char *const CC_PAYLOAD_LNAME = "lname";
 const char *const CC_PAYLOAD_RESULT = "result";
 const char *const CC_PAYLOAD_COMMAND = "command";
 const char *const CC_PAYLOAD_NOTIFICATION = "notification";
+// Negotiation of the binary wire format; the client offers it in the
+// header of the getlname command, and the msgq confirms it in the header
+// of the answer.  Both sides then use it for all the messages they send.
+const char* const CC_HEADER_WIRE_FORMAT = "wire_format";
+const char* const CC_WIRE_FORMAT_BINARY = "binary";
+// The strings encoded as one byte in the binary wire format, separated by
+// spaces.  Never remove or reorder them, only append new ones.
+const char* const CC_WIRE_INTERNED_STRINGS = "type from to group instance seq want_answer reply send subscribe unsubscribe getlname ping pong stop * lname result command notification wire_format binary ConfigManager Init Stats Cmdctl";
 
 }
 }
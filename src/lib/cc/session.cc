@@ -74,7 +74,7 @@ namespace cc {
 class SessionImpl {
 public:
     SessionImpl(io_service& io_service) :
-        sequence_(-1), queue_(Element::createList()),
+        sequence_(-1), queue_(Element::createList()), binary_wire_(false),
         io_service_(io_service), socket_(io_service_), data_length_(0),
         timeout_(MSGQ_DEFAULT_TIMEOUT)
     {}
@@ -93,6 +93,7 @@ public:
     long int sequence_; // the next sequence number to use
     std::string lname_;
     ElementPtr queue_;
+    bool binary_wire_;  // whether to send in the binary wire format
 
 private:
     void internalRead(const asio::error_code& error,
@@ -140,6 +141,7 @@ SessionImpl::disconnect() {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, CC_DISCONNECT);
     socket_.close();
     data_length_ = 0;
+    binary_wire_ = false;
 }
 
 void
@@ -325,13 +327,22 @@ Session::establish(const char* socket_file) {
     //
     // send a request for our local name, and wait for a response
     //
+    // We also offer the binary wire format here.  If the msgq supports it,
+    // it says so in the answer, and we use it from then on.
+    //
     ElementPtr get_lname_msg(Element::createMap());
     get_lname_msg->set(CC_HEADER_TYPE, Element::create(CC_COMMAND_GET_LNAME));
+    get_lname_msg->set(CC_HEADER_WIRE_FORMAT,
+                       Element::create(CC_WIRE_FORMAT_BINARY));
     sendmsg(get_lname_msg);
 
     ConstElementPtr routing, msg;
     recvmsg(routing, msg, false);
 
+    ConstElementPtr wire_format = routing->get(CC_HEADER_WIRE_FORMAT);
+    impl_->binary_wire_ = wire_format &&
+        wire_format->getType() == Element::string &&
+        wire_format->stringValue() == CC_WIRE_FORMAT_BINARY;
     impl_->lname_ = msg->get(CC_PAYLOAD_LNAME)->stringValue();
     LOG_DEBUG(logger, DBG_TRACE_DETAILED, CC_LNAME_RECEIVED).arg(impl_->lname_);
 
@@ -343,32 +354,49 @@ Session::establish(const char* socket_file) {
 // Convert to wire format and send this via the stream socket with its length
 // prefix.
 //
+namespace {
+// Build the whole message to be sent in one write.  The payload can be
+// NULL (not even a null element).
+std::string
+buildMessage(ConstElementPtr header, ConstElementPtr payload, bool binary) {
+    const std::string header_wire = binary ? header->toBinaryWire() :
+        header->toWire();
+    if (header_wire.length() > 0xffff) {
+        bundy_throw(SessionError, "Envelope too large");
+    }
+    std::string body_wire;
+    if (payload) {
+        body_wire = binary ? payload->toBinaryWire() : payload->toWire();
+    }
+    const uint32_t length_net =
+        htonl(2 + header_wire.length() + body_wire.length());
+    const uint16_t header_length_net = htons(header_wire.length());
+
+    std::string message;
+    message.reserve(sizeof(length_net) + sizeof(header_length_net) +
+                    header_wire.length() + body_wire.length());
+    message.append(reinterpret_cast<const char*>(&length_net),
+                   sizeof(length_net));
+    message.append(reinterpret_cast<const char*>(&header_length_net),
+                   sizeof(header_length_net));
+    message.append(header_wire);
+    message.append(body_wire);
+    return (message);
+}
+}
+
 void
 Session::sendmsg(ConstElementPtr header) {
-    std::string header_wire = header->toWire();
-    unsigned int length = 2 + header_wire.length();
-    unsigned int length_net = htonl(length);
-    unsigned short header_length = header_wire.length();
-    unsigned short header_length_net = htons(header_length);
-
-    impl_->writeData(&length_net, sizeof(length_net));
-    impl_->writeData(&header_length_net, sizeof(header_length_net));
-    impl_->writeData(header_wire.data(), header_length);
+    const std::string message =
+        buildMessage(header, ConstElementPtr(), impl_->binary_wire_);
+    impl_->writeData(message.data(), message.length());
 }
 
 void
 Session::sendmsg(ConstElementPtr header, ConstElementPtr payload) {
-    std::string header_wire = header->toWire();
-    std::string body_wire = payload->toWire();
-    unsigned int length = 2 + header_wire.length() + body_wire.length();
-    unsigned int length_net = htonl(length);
-    unsigned short header_length = header_wire.length();
-    unsigned short header_length_net = htons(header_length);
-
-    impl_->writeData(&length_net, sizeof(length_net));
-    impl_->writeData(&header_length_net, sizeof(header_length_net));
-    impl_->writeData(header_wire.data(), header_length);
-    impl_->writeData(body_wire.data(), body_wire.length());
+    const std::string message =
+        buildMessage(header, payload, impl_->binary_wire_);
+    impl_->writeData(message.data(), message.length());
 }
 
 bool
@@ -416,18 +444,10 @@ Session::recvmsg(ConstElementPtr& env, ConstElementPtr& msg,
     std::vector<char> buffer(length);
     impl_->readData(&buffer[0], length);
 
-    std::string header_wire = std::string(&buffer[0], header_length);
-    std::string body_wire = std::string(&buffer[0] + header_length,
-                                        length - header_length);
-    std::stringstream header_wire_stream;
-    header_wire_stream << header_wire;
-    ConstElementPtr l_env =
-        Element::fromWire(header_wire_stream, header_length);
-    
-    std::stringstream body_wire_stream;
-    body_wire_stream << body_wire;
-    ConstElementPtr l_msg =
-        Element::fromWire(body_wire_stream, length - header_length);
+    // Either of the binary and JSON wire formats can be used here.
+    ConstElementPtr l_env = Element::fromWire(&buffer[0], header_length);
+    ConstElementPtr l_msg = Element::fromWire(&buffer[0] + header_length,
+                                              length - header_length);
     if ((seq == -1 &&
          !l_env->contains(CC_HEADER_REPLY)
         ) || (
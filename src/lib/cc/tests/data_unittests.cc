@@ -678,6 +678,56 @@ TEST(Element, to_and_from_wire) {
     EXPECT_THROW(Element::fromJSON("[ \"a\": \"b\" ]"), bundy::data::JSONError);
 }
 
+TEST(Element, to_and_from_binary_wire) {
+    // Some known encodings, including interned strings
+    EXPECT_EQ(string("\xbc\x00", 2), Element::create()->toBinaryWire());
+    EXPECT_EQ(string("\xbc\x02"), Element::create(true)->toBinaryWire());
+    EXPECT_EQ(string("\xbc\x03\x03"), Element::create(-2)->toBinaryWire());
+    EXPECT_EQ(string("\xbc\x03\x80\x01"),
+              Element::create(64)->toBinaryWire());
+    EXPECT_EQ(string("\xbc\x05\x03""abc"),
+              Element::create("abc")->toBinaryWire());
+    EXPECT_EQ(string("\xbc\x08\x01\x06\x00\x06\x08", 7),
+              Element::fromJSON("{\"type\": \"send\"}")->toBinaryWire());
+
+    // Round trips of all types of elements
+    const char* const texts[] = {
+        "null", "true", "false", "0", "1", "-1", "9223372036854775807",
+        "-9223372036854775808", "1.5", "-0.25", "\"\"", "\"a string\"",
+        "\"\xc3\xa9t\xc3\xa9\"", "[]", "{}", "[ 1, \"a\", [ null ], {} ]",
+        "{ \"type\": \"send\", \"group\": \"Stats\", \"seq\": 4, "
+        "\"nested\": { \"list\": [ 1.1, true, \"*\" ] } }",
+        NULL
+    };
+    for (size_t i = 0; texts[i] != NULL; ++i) {
+        SCOPED_TRACE(texts[i]);
+        const ConstElementPtr element = Element::fromJSON(texts[i]);
+        const string wire = element->toBinaryWire();
+        EXPECT_TRUE(element->equals(*Element::fromWire(wire)));
+        EXPECT_TRUE(element->equals(*Element::fromWire(wire.data(),
+                                                       wire.size())));
+        std::stringstream ss;
+        ss << wire;
+        EXPECT_TRUE(element->equals(*Element::fromWire(ss, wire.size())));
+    }
+
+    // The JSON format is still recognized by the same functions.
+    EXPECT_EQ("[ 1 ]", Element::fromWire("[ 1 ]", 5)->str());
+
+    // Broken binary data
+    EXPECT_THROW(Element::fromWire("\xbc"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x09"), JSONError);
+    EXPECT_THROW(Element::fromWire(string("\xbc\x00\x00", 3)), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x03\x80"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x04\x01\x02"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x05\x04""abc"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x06\xff"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x07\x02\x02"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x08\x01\x02\x02"), JSONError);
+    EXPECT_THROW(Element::fromWire("\xbc\x07\xff\xff\xff\xff\x0f"),
+                 JSONError);
+}
+
 ConstElementPtr
 efs(const std::string& str) {
     return (Element::fromJSON(str));
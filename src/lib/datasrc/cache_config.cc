@@ -54,6 +54,19 @@ getSegmentTypeFromConf(const Element& conf) {
     }
     return (conf.get("cache-type")->stringValue());
 }
+
+size_t
+getLoadThreadsFromConf(const Element& conf) {
+    if (!conf.contains("cache-load-threads")) {
+        return (0);
+    }
+    const int64_t threads = conf.get("cache-load-threads")->intValue();
+    if (threads < 0) {
+        bundy_throw(CacheConfigError, "Negative cache-load-threads: " <<
+                    threads);
+    }
+    return (threads);
+}
 }
 
 CacheConfig::CacheConfig(const std::string& datasrc_type,
@@ -62,6 +75,7 @@ CacheConfig::CacheConfig(const std::string& datasrc_type,
                          bool allowed) :
     enabled_(allowed && getEnabledFromConf(datasrc_conf)),
     segment_type_(getSegmentTypeFromConf(datasrc_conf)),
+    load_threads_(getLoadThreadsFromConf(datasrc_conf)),
     datasrc_client_(datasrc_client)
 {
     ConstElementPtr params = datasrc_conf.get("params");
@@ -127,10 +141,10 @@ namespace {
 memory::ZoneDataLoader*
 createLoaderFromFile(util::MemorySegment& segment, const dns::RRClass& rrclass,
                      const dns::Name& name, const std::string& filename,
-                     memory::ZoneData* old_data)
+                     size_t load_threads, memory::ZoneData* old_data)
 {
     return (new memory::ZoneDataLoader(segment, rrclass, name, filename,
-                                       old_data));
+                                       old_data, load_threads));
 }
 
 memory::ZoneDataLoader*
@@ -159,7 +173,7 @@ CacheConfig::getLoaderCreator(const dns::RRClass& rrclass,
     if (!found->second.empty()) {
         // This is "MasterFiles" data source.
         return (boost::bind(createLoaderFromFile, _1, rrclass, zone_name,
-                            found->second, _2));
+                            found->second, load_threads_, _2));
     }
 
     // Otherwise there must be a "source" data source (ensured by constructor)
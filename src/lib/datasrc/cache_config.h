@@ -109,6 +109,10 @@ public:
     /// used for the cache.  It's given via the "cache-type" configuration
     /// item if defined; otherwise it defaults to "local".
     ///
+    /// The number of threads to parse master files of the "MasterFiles"
+    /// type is given via the optional "cache-load-threads" item.  If it's
+    /// 0 (the default) or 1, master files are loaded sequentially.
+    ///
     /// \throw InvalidParameter Program error at the caller side rather than
     /// in the configuration (see above)
     /// \throw CacheConfigError There is a semantics error in the given
@@ -147,6 +151,11 @@ public:
     /// \throw None
     const std::string& getSegmentType() const { return (segment_type_); }
 
+    /// \brief Return the number of threads to parse master files.
+    ///
+    /// \throw None
+    size_t getLoadThreads() const { return (load_threads_); }
+
     /// \brief Return a \c LoadAction functor to load zone data into memory.
     ///
     /// This method returns an appropriate \c LoadAction functor that can be
@@ -232,6 +241,7 @@ public:
 private:
     const bool enabled_; // if the use of in-memory zone table is enabled
     const std::string segment_type_;
+    const size_t load_threads_;
     // client of underlying data source, will be NULL for MasterFile datasrc
     const DataSourceClient* datasrc_client_;
 
@@ -1242,6 +1242,8 @@ public:
         accessor_(accessor),
         class_(rrclass),
         ready_(true),
+        started_(false),
+        data_ready_(false),
         separate_rrs_(separate_rrs)
     {
         // Get the zone
@@ -1269,8 +1271,10 @@ public:
                       zone_name.toText());
         }
 
-        // Prepare data for the next time
-        getData();
+        // We don't fetch the first row until it's needed.  Getting it can
+        // be as expensive as sorting the entire zone in the database, and
+        // some users only need the SOA (e.g., the in-memory data source
+        // updates its copy with the journal if the serial is different).
     }
 
     virtual ~DatabaseIterator() {
@@ -1287,6 +1291,10 @@ public:
         if (!ready_) {
             bundy_throw(bundy::Unexpected, "Iterating past the zone end");
         }
+        if (!started_) {
+            getData();
+            started_ = true;
+        }
         if (!data_ready_) {
             // At the end of zone
             accessor_->commit();
@@ -1375,7 +1383,7 @@ private:
     // SOA of the zone, if any (it should normally exist)
     ConstRRsetPtr soa_;
     // Status
-    bool ready_, data_ready_;
+    bool ready_, started_, data_ready_;
     // Data of the next row
     string name_txt_, rtype_txt_, ttl_txt_;
     // RDATA of the next row
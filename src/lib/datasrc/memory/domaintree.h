@@ -36,6 +36,8 @@
 
 #include <ostream>
 #include <algorithm>
+#include <deque>
+#include <vector>
 #include <cassert>
 
 namespace bundy {
@@ -167,6 +169,21 @@ private:
         labels.serialize(getLabelsData(), labels_capacity_);
     }
 
+    /// \brief Hint the CPU to start loading a node into the cache.
+    ///
+    /// This loads the node itself and the beginning of its labels, which
+    /// are what a name comparison in \c DomainTree::find() reads first.
+    /// It doesn't dereference \c node, so it can be NULL; it's a no-op
+    /// in that case or if the compiler doesn't support prefetching.
+    static void prefetch(const DomainTreeNode<T>* node) {
+#ifdef __GNUC__
+        if (node != NULL) {
+            __builtin_prefetch(node);
+            __builtin_prefetch(node->getLabelsData());
+        }
+#endif
+    }
+
 public:
     /// Node flags.
     ///
@@ -1265,6 +1282,7 @@ public:
                         DomainTree<T>* tree,
                         DataDeleter deleter)
     {
+        tree->releasePendingNodes(mem_sgmt);
         tree->removeAllNodes(mem_sgmt, deleter);
         tree->~DomainTree<T>();
         mem_sgmt.deallocate(tree, sizeof(DomainTree<T>));
@@ -1721,6 +1739,45 @@ public:
         std::swap(root_, other.root_);
         std::swap(node_count_, other.node_count_);
     }
+
+    /// \brief Reallocate all nodes of the tree in a lookup-friendly order.
+    ///
+    /// Nodes are allocated in the order of insertion, so the nodes compared
+    /// in a single \c find() on a large tree tend to be scattered across
+    /// the memory segment, and most of the comparisons cause a cache miss.
+    /// This method copies every node to newly allocated memory, one subtree
+    /// (the nodes that form a single red-black tree) after another, and
+    /// in breadth-first order within each subtree.  The upper part of a
+    /// subtree, which almost every search through it visits, is then packed
+    /// in consecutive memory.  This relies on the memory segment placing
+    /// consecutive allocations close to each other, which is the case for
+    /// the segment implementations we have.
+    ///
+    /// This is intended to be called once the tree is fully built, e.g.,
+    /// after loading a zone.  The structure of the tree and the node data
+    /// don't change, but since all nodes are reallocated, any pointer to
+    /// a node and any \c DomainTreeNodeChain taken before the call become
+    /// invalid.  The \c node parameter can be used to keep track of one
+    /// node.
+    ///
+    /// This method temporarily needs memory for another copy of all the
+    /// nodes.  They are all allocated before the tree is modified, so if
+    /// an exception is thrown the tree remains unchanged.  The copies made
+    /// by then are released on the next call to this method or on
+    /// \c destroy().  In case of \c MemorySegmentGrown, the caller can
+    /// simply call this method again after getting the possibly relocated
+    /// address of the tree (see \c insert()).
+    ///
+    /// \throw std::bad_alloc Memory allocation fails.
+    /// \throw MemorySegmentGrown The memory segment has grown.
+    ///
+    /// \param mem_sgmt The \c MemorySegment object used to insert the nodes
+    /// (which was also used for creating the tree due to the requirement of
+    /// \c insert()).
+    /// \param node If non NULL, it must point to a pointer to a node of
+    /// this tree, which will be updated to the new address of the node.
+    void relayout(util::MemorySegment& mem_sgmt,
+                  DomainTreeNode<T>** node = NULL);
     //@}
 
 private:
@@ -1773,10 +1830,19 @@ private:
                      const bundy::dns::LabelSequence& new_prefix,
                      const bundy::dns::LabelSequence& new_suffix);
 
+    /// \brief Release the node copies left by an interrupted \c relayout().
+    void releasePendingNodes(util::MemorySegment& mem_sgmt);
+
     //@}
 
     typename DomainTreeNode<T>::DomainTreeNodePtr root_;
 
+    /// New nodes allocated by \c relayout() that are not yet part of the
+    /// tree, chained by their parent_ pointers.  It's kept in the tree
+    /// so they can be released even if the allocation is interrupted by
+    /// \c MemorySegmentGrown (and the addresses we had are invalidated).
+    typename DomainTreeNode<T>::DomainTreeNodePtr pending_nodes_;
+
     /// the node count of current tree.
     ///
     /// Note: uint32_t may look awkward, but we intentionally choose it so
@@ -1792,6 +1858,7 @@ private:
 template <typename T>
 DomainTree<T>::DomainTree(bool returnEmptyNode) :
     root_(NULL),
+    pending_nodes_(NULL),
     node_count_(0),
     needsReturnEmptyNode_(returnEmptyNode)
 {
@@ -1857,6 +1924,13 @@ DomainTree<T>::findImpl(TT* tree,
     dns::LabelSequence target_labels(target_labels_orig);
 
     while (node != NULL) {
+        // The name comparison below is relatively expensive.  Start loading
+        // the nodes we may visit next so the cache misses on them overlap
+        // with it.
+        DomainTreeNode<T>::prefetch(node->getLeft());
+        DomainTreeNode<T>::prefetch(node->getRight());
+        DomainTreeNode<T>::prefetch(node->getDown());
+
         node_path.last_compared_ = node;
         node_path.last_comparison_ = target_labels.compare(node->getLabels());
         const bundy::dns::NameComparisonResult::NameRelation relation =
@@ -2373,6 +2447,108 @@ DomainTree<T>::removeAllNodes(util::MemorySegment& mem_sgmt,
     root_ = NULL;
 }
 
+template <typename T>
+void
+DomainTree<T>::releasePendingNodes(util::MemorySegment& mem_sgmt) {
+    while (pending_nodes_) {
+        DomainTreeNode<T>* node = pending_nodes_.get();
+        pending_nodes_ = node->parent_;
+        DomainTreeNode<T>::destroy(mem_sgmt, node);
+    }
+}
+
+template <typename T>
+void
+DomainTree<T>::relayout(util::MemorySegment& mem_sgmt,
+                        DomainTreeNode<T>** node)
+{
+    releasePendingNodes(mem_sgmt);
+
+    // List the current nodes in the new order: subtrees in breadth-first
+    // order of the tree of subtrees, and the nodes of each subtree in its
+    // own breadth-first order.
+    std::vector<DomainTreeNode<T>*> old_nodes;
+    old_nodes.reserve(node_count_);
+    std::deque<DomainTreeNode<T>*> subtrees;
+    if (root_) {
+        subtrees.push_back(root_.get());
+    }
+    while (!subtrees.empty()) {
+        size_t i = old_nodes.size();
+        old_nodes.push_back(subtrees.front());
+        subtrees.pop_front();
+        for (; i < old_nodes.size(); ++i) {
+            DomainTreeNode<T>* const current = old_nodes[i];
+            if (current->getLeft() != NULL) {
+                old_nodes.push_back(current->getLeft());
+            }
+            if (current->getRight() != NULL) {
+                old_nodes.push_back(current->getRight());
+            }
+            if (current->getDown() != NULL) {
+                subtrees.push_back(current->getDown());
+            }
+        }
+    }
+
+    // Allocate all the copies first.  This is the only part that can
+    // throw; we keep them in pending_nodes_ until they replace the
+    // current ones, so they won't be leaked even if it's interrupted.
+    for (size_t i = 0; i < old_nodes.size(); ++i) {
+        DomainTreeNode<T>* const new_node =
+            DomainTreeNode<T>::create(mem_sgmt, old_nodes[i]->getLabels());
+        new_node->parent_ = pending_nodes_;
+        pending_nodes_ = new_node;
+    }
+    std::vector<DomainTreeNode<T>*> new_nodes(old_nodes.size());
+    for (size_t i = new_nodes.size(); i > 0; --i) {
+        new_nodes[i - 1] = pending_nodes_.get();
+        pending_nodes_ = pending_nodes_->parent_;
+    }
+
+    // Copy everything but the labels, with the links still pointing to
+    // the old nodes.  Then let the parent_ of each old node point to its
+    // copy, and use it to convert the links.
+    for (size_t i = 0; i < old_nodes.size(); ++i) {
+        const DomainTreeNode<T>* const old_node = old_nodes[i];
+        DomainTreeNode<T>* const new_node = new_nodes[i];
+        new_node->parent_ = old_node->parent_;
+        new_node->left_ = old_node->left_;
+        new_node->right_ = old_node->right_;
+        new_node->down_ = old_node->down_;
+        new_node->data_ = old_node->data_;
+        new_node->flags_ = old_node->flags_;
+    }
+    for (size_t i = 0; i < old_nodes.size(); ++i) {
+        old_nodes[i]->parent_ = new_nodes[i];
+    }
+    for (size_t i = 0; i < new_nodes.size(); ++i) {
+        DomainTreeNode<T>* const new_node = new_nodes[i];
+        if (new_node->parent_) {
+            new_node->parent_ = new_node->parent_->parent_;
+        }
+        if (new_node->left_) {
+            new_node->left_ = new_node->left_->parent_;
+        }
+        if (new_node->right_) {
+            new_node->right_ = new_node->right_->parent_;
+        }
+        if (new_node->down_) {
+            new_node->down_ = new_node->down_->parent_;
+        }
+    }
+    if (root_) {
+        root_ = root_->parent_;
+    }
+    if (node != NULL && *node != NULL) {
+        *node = (*node)->getParent();
+    }
+
+    for (size_t i = 0; i < old_nodes.size(); ++i) {
+        DomainTreeNode<T>::destroy(mem_sgmt, old_nodes[i]);
+    }
+}
+
 template <typename T>
 void
 DomainTree<T>::nodeFission(util::MemorySegment& mem_sgmt,
@@ -0,0 +1,588 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/parallel_master_loader.h>
+#include <datasrc/memory/util_internal.h>
+
+#include <exceptions/exceptions.h>
+
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <dns/master_loader.h>
+#include <dns/rdataclass.h>
+#include <dns/rrcollator.h>
+#include <dns/rrttl.h>
+
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <vector>
+
+using namespace bundy::dns;
+using bundy::util::thread::CondVar;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+namespace detail {
+
+namespace {
+// A part of the master file to be parsed by a worker thread.
+struct Chunk {
+    Chunk() : first_line(1), prefix_lines(0) {}
+    std::string text;
+    size_t first_line;          // line number of the first line in the file
+    size_t prefix_lines;        // number of the lines we prepended to text
+};
+
+// An error or warning found in a chunk.  They are reported in the thread
+// calling loadIncremental(), so the order of the reports and the effect of
+// an error are the same as those of the sequential loader.
+struct Issue {
+    Issue(bool is_error_param, const std::string& source_param,
+          size_t line_param, const std::string& reason_param) :
+        is_error(is_error_param), source(source_param), line(line_param),
+        reason(reason_param)
+    {}
+    bool is_error;
+    std::string source;
+    size_t line;
+    std::string reason;
+};
+
+// The result of parsing a chunk.
+struct ChunkResult {
+    ChunkResult() : failed(false) {}
+    std::vector<ConstRRsetPtr> rrsets;
+    std::vector<Issue> issues;
+    bool failed;
+    std::string error;
+};
+typedef boost::shared_ptr<ChunkResult> ChunkResultPtr;
+
+void
+addRRset(std::vector<ConstRRsetPtr>* rrsets, const RRsetPtr& rrset) {
+    rrsets->push_back(rrset);
+}
+
+// Whether the RRs of the two RRsets would have been collated into one RRset
+// if they were parsed in one chunk.  See dns::RRCollator.
+bool
+isSameRRset(const ConstRRsetPtr& rrset1, const ConstRRsetPtr& rrset2) {
+    if (rrset1->getType() != rrset2->getType() ||
+        rrset1->getClass() != rrset2->getClass() ||
+        rrset1->getName() != rrset2->getName()) {
+        return (false);
+    }
+    return (rrset1->getType() != RRType::RRSIG() ||
+            getCoveredType(rrset1) == getCoveredType(rrset2));
+}
+
+ConstRRsetPtr
+mergeRRsets(const ConstRRsetPtr& rrset1, const ConstRRsetPtr& rrset2) {
+    const RRsetPtr merged(new RRset(rrset1->getName(), rrset1->getClass(),
+                                    rrset1->getType(),
+                                    std::min(rrset1->getTTL(),
+                                             rrset2->getTTL())));
+    for (RdataIteratorPtr it = rrset1->getRdataIterator(); !it->isLast();
+         it->next()) {
+        merged->addRdata(it->getCurrent());
+    }
+    for (RdataIteratorPtr it = rrset2->getRdataIterator(); !it->isLast();
+         it->next()) {
+        merged->addRdata(it->getCurrent());
+    }
+    return (merged);
+}
+
+void
+addIssue(std::vector<Issue>* issues, bool is_error, const Chunk* chunk,
+         const std::string& stream_name, const std::string& file_name,
+         const std::string& source, size_t line, const std::string& reason)
+{
+    // Issues in the chunk itself are reported as if they were found in the
+    // master file; those in $INCLUDEd files are left intact.
+    if (source == stream_name) {
+        issues->push_back(Issue(is_error, file_name,
+                                line - chunk->prefix_lines +
+                                chunk->first_line - 1, reason));
+    } else {
+        issues->push_back(Issue(is_error, source, line, reason));
+    }
+}
+}
+
+class ParallelMasterLoader::Impl {
+public:
+    Impl(const std::string& master_file, const Name& zone_origin,
+         const RRClass& zone_class, const MasterLoaderCallbacks& callbacks,
+         const AddRRsetCallback& add_callback, size_t n_threads,
+         size_t chunk_size, const ChunkHook& chunk_hook);
+    ~Impl();
+    bool loadIncremental(size_t count_limit);
+
+private:
+    void run();
+    bool readChunk(Chunk& chunk);
+    bool processLine(const std::string& line, bool may_split);
+    void processDirective(const std::string& line);
+    void parseChunk(const Chunk& chunk, ChunkResult& result) const;
+    bool nextResult();
+    bool passRRset(const ConstRRsetPtr& rrset);
+    void stop();
+
+    const std::string master_file_;
+    const Name zone_origin_;
+    const RRClass zone_class_;
+    const MasterLoaderCallbacks callbacks_;
+    const AddRRsetCallback add_callback_;
+    const size_t chunk_size_;
+    const ChunkHook chunk_hook_;
+    const size_t max_pending_;
+
+    // The following are protected by mutex_.
+    Mutex mutex_;
+    CondVar space_cond_;        // signaled when a result is consumed
+    CondVar result_cond_;       // signaled when a result is available
+    std::ifstream input_;
+    bool input_done_;
+    bool stopping_;
+    size_t read_count_;         // number of chunks read from the file
+    size_t consume_count_;      // number of chunks passed to the caller
+    std::map<size_t, ChunkResultPtr> results_;
+    std::string read_error_;
+    size_t failed_seq_;         // first chunk whose result couldn't be made
+
+    // The splitter state, also protected by mutex_.
+    size_t line_count_;
+    std::string pending_line_;
+    bool has_pending_line_;
+    size_t paren_depth_;
+    bool split_ok_;
+    Name current_origin_;
+    std::string default_ttl_;
+
+    // The consumer state, only used in the thread calling loadIncremental().
+    ChunkResultPtr current_;
+    size_t current_pos_;
+    ConstRRsetPtr last_rrset_;  // not yet passed to add_callback_
+    bool done_;
+
+    std::vector<boost::shared_ptr<Thread> > threads_;
+};
+
+ParallelMasterLoader::Impl::Impl(const std::string& master_file,
+                                 const Name& zone_origin,
+                                 const RRClass& zone_class,
+                                 const MasterLoaderCallbacks& callbacks,
+                                 const AddRRsetCallback& add_callback,
+                                 size_t n_threads, size_t chunk_size,
+                                 const ChunkHook& chunk_hook) :
+    master_file_(master_file), zone_origin_(zone_origin),
+    zone_class_(zone_class), callbacks_(callbacks),
+    add_callback_(add_callback), chunk_size_(chunk_size),
+    chunk_hook_(chunk_hook),
+    max_pending_(n_threads * 2), input_(master_file.c_str()),
+    input_done_(false), stopping_(false), read_count_(0), consume_count_(0),
+    failed_seq_(std::numeric_limits<size_t>::max()), line_count_(0),
+    has_pending_line_(false), paren_depth_(0),
+    split_ok_(true), current_origin_(zone_origin), current_pos_(0),
+    done_(false)
+{
+    if (n_threads == 0) {
+        bundy_throw(BadValue, "no thread for parallel master file loader");
+    }
+    if (!input_) {
+        const std::string reason = "Failed to open master file: " +
+            master_file;
+        callbacks_.error(master_file, 0, reason);
+        bundy_throw(MasterLoaderError, reason.c_str());
+    }
+    try {
+        for (size_t i = 0; i < n_threads; ++i) {
+            threads_.push_back(boost::shared_ptr<Thread>(
+                new Thread(boost::bind(&Impl::run, this))));
+        }
+    } catch (...) {
+        stop();
+        throw;
+    }
+}
+
+ParallelMasterLoader::Impl::~Impl() {
+    stop();
+}
+
+void
+ParallelMasterLoader::Impl::stop() {
+    {
+        Mutex::Locker locker(mutex_);
+        stopping_ = true;
+        space_cond_.signal();
+    }
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        try {
+            threads_[i]->wait();
+        } catch (const Thread::UncaughtException&) {
+            // Errors in parsing are caught in the thread, so it can only be
+            // something like bad_alloc.  There's nothing we can do about it
+            // here, and we shouldn't throw from the destructor anyway.
+        }
+    }
+    threads_.clear();
+}
+
+// The main loop of the worker threads.  A worker reads the next chunk from
+// the file and parses it, until the end of the file.  To bound the memory
+// footprint, it waits while too many results are waiting to be consumed.
+void
+ParallelMasterLoader::Impl::run() {
+    while (true) {
+        Chunk chunk;
+        size_t seq;
+        {
+            Mutex::Locker locker(mutex_);
+            while (!stopping_ && !input_done_ &&
+                   read_count_ - consume_count_ >= max_pending_) {
+                space_cond_.wait(mutex_);
+            }
+            if (stopping_ || input_done_) {
+                // Let another waiting thread (if any) notice it, too.
+                space_cond_.signal();
+                return;
+            }
+            try {
+                if (!readChunk(chunk)) {
+                    input_done_ = true;
+                }
+            } catch (const std::exception& ex) {
+                read_error_ = ex.what();
+                input_done_ = true;
+            }
+            if (input_done_) {
+                result_cond_.signal();
+                if (chunk.text.empty()) {
+                    continue;
+                }
+            }
+            seq = read_count_++;
+        }
+
+        // Errors in parsing are stored in the result, so what we can get
+        // here is something like bad_alloc in making or storing the result.
+        // The consumer would then wait for the result forever, so we make it
+        // fail when it reaches this chunk instead, and stop reading the file.
+        ChunkResultPtr result;
+        bool failed = false;
+        try {
+            result.reset(new ChunkResult);
+            if (chunk_hook_) {
+                chunk_hook_(seq);
+            }
+            parseChunk(chunk, *result);
+        } catch (const std::exception&) {
+            failed = true;
+        }
+
+        Mutex::Locker locker(mutex_);
+        if (!failed) {
+            try {
+                results_[seq] = result;
+            } catch (const std::exception&) {
+                failed = true;
+            }
+        }
+        if (failed) {
+            if (seq < failed_seq_) {
+                failed_seq_ = seq;
+            }
+            input_done_ = true;
+            space_cond_.signal();
+        }
+        result_cond_.signal();
+    }
+}
+
+// Read the next chunk from the master file.  It returns false if the end
+// of the file is reached.
+bool
+ParallelMasterLoader::Impl::readChunk(Chunk& chunk) {
+    if (read_count_ > 0) {
+        std::ostringstream prefix;
+        prefix << "$ORIGIN " << current_origin_ << "\n";
+        ++chunk.prefix_lines;
+        if (!default_ttl_.empty()) {
+            prefix << "$TTL " << default_ttl_ << "\n";
+            ++chunk.prefix_lines;
+        }
+        chunk.text = prefix.str();
+    }
+    chunk.first_line = line_count_ + 1;
+
+    const size_t prefix_len = chunk.text.size();
+    std::string line;
+    while (true) {
+        if (has_pending_line_) {
+            line.swap(pending_line_);
+            has_pending_line_ = false;
+        } else if (!std::getline(input_, line)) {
+            if (input_.bad()) {
+                bundy_throw(MasterLoaderError, "Failed to read master file: "
+                            << master_file_);
+            }
+            return (false);
+        } else if (!input_.eof()) {
+            // Keep the newline, but don't add one at the end of the file
+            // if there's none, so the parser sees exactly what it would see
+            // in the sequential load.
+            line.push_back('\n');
+        }
+        const size_t len = chunk.text.size() - prefix_len;
+        if (processLine(line, len > 0 && len >= chunk_size_)) {
+            // This line starts the next chunk.
+            pending_line_.swap(line);
+            has_pending_line_ = true;
+            return (true);
+        }
+        ++line_count_;
+        chunk.text.append(line);
+    }
+}
+
+// Examine a line in the master file and update the splitter state.  If
+// may_split is true and the chunk can end just before the line, it returns
+// true without updating the state (it will be updated when the line is
+// examined again for the next chunk).
+//
+// A chunk may begin at a line that starts a new RR with an explicit owner
+// name.  The origin and default TTL are passed to the next chunk as the
+// $ORIGIN and $TTL directives, but if there's no $TTL before the line, the
+// TTL of an RR without the TTL can depend on the previous RR; so it doesn't
+// split the file in that case.  $INCLUDE can change the default TTL, so it
+// stops splitting after $INCLUDE.
+bool
+ParallelMasterLoader::Impl::processLine(const std::string& line,
+                                        bool may_split)
+{
+    if (paren_depth_ == 0 && !line.empty()) {
+        const char c = line[0];
+        if (c == '$') {
+            processDirective(line);
+        } else if (may_split && split_ok_ && !default_ttl_.empty() &&
+                   c != ' ' && c != '\t' && c != ';' && c != '\n' &&
+                   c != '\r') {
+            return (true);
+        }
+    }
+
+    // Track parentheses, which make an RR span multiple lines.  Those
+    // in quoted strings or comments don't count.  A quoted string can't
+    // span lines.
+    bool escaped = false;
+    bool in_quotes = false;
+    for (std::string::const_iterator it = line.begin(); it != line.end();
+         ++it) {
+        if (escaped) {
+            escaped = false;
+        } else if (*it == '\\') {
+            escaped = true;
+        } else if (in_quotes) {
+            in_quotes = (*it != '"');
+        } else if (*it == '"') {
+            in_quotes = true;
+        } else if (*it == ';') {
+            break;
+        } else if (*it == '(') {
+            ++paren_depth_;
+        } else if (*it == ')' && paren_depth_ > 0) {
+            --paren_depth_;
+        }
+    }
+    return (false);
+}
+
+// Process a $ORIGIN or $TTL directive to keep track of the parser state.
+// Anything we don't understand (including errors that the parser will
+// report) stops further splitting.
+void
+ParallelMasterLoader::Impl::processDirective(const std::string& line) {
+    std::istringstream iss(line.substr(0, line.find(';')));
+    std::string directive, value, extra;
+    iss >> directive >> value >> extra;
+    try {
+        if (value.empty() || !extra.empty() ||
+            value.find_first_of("()\"") != std::string::npos) {
+            split_ok_ = false;
+        } else if (directive == "$ORIGIN") {
+            current_origin_ = Name(value.c_str(), value.size(),
+                                   &current_origin_);
+        } else if (directive == "$TTL") {
+            default_ttl_ = RRTTL(value).toText();
+        } else {
+            split_ok_ = false;
+        }
+    } catch (const bundy::Exception&) {
+        split_ok_ = false;
+    }
+}
+
+void
+ParallelMasterLoader::Impl::parseChunk(const Chunk& chunk,
+                                       ChunkResult& result) const
+{
+    try {
+        std::istringstream input(chunk.text);
+        std::ostringstream stream_name;
+        stream_name << "stream-" << &input;
+        const MasterLoaderCallbacks callbacks(
+            boost::bind(&addIssue, &result.issues, true, &chunk,
+                        stream_name.str(), master_file_, _1, _2, _3),
+            boost::bind(&addIssue, &result.issues, false, &chunk,
+                        stream_name.str(), master_file_, _1, _2, _3));
+        RRCollator collator(boost::bind(&addRRset, &result.rrsets, _1));
+        MasterLoader loader(input, zone_origin_, zone_class_, callbacks,
+                            collator.getCallback());
+        loader.load();
+        collator.flush();
+    } catch (const std::exception& ex) {
+        result.failed = true;
+        result.error = ex.what();
+    }
+}
+
+// Get the result of the next chunk to current_, waiting for it if
+// necessary.  It returns false if there are no more chunks.
+bool
+ParallelMasterLoader::Impl::nextResult() {
+    Mutex::Locker locker(mutex_);
+    while (true) {
+        const std::map<size_t, ChunkResultPtr>::iterator it =
+            results_.find(consume_count_);
+        if (it != results_.end()) {
+            current_ = it->second;
+            current_pos_ = 0;
+            results_.erase(it);
+            ++consume_count_;
+            space_cond_.signal();
+            return (true);
+        }
+        if (consume_count_ == failed_seq_) {
+            done_ = true;
+            bundy_throw(MasterLoaderError,
+                        "Failed to process a chunk of master file " <<
+                        master_file_);
+        }
+        if (input_done_ && consume_count_ == read_count_) {
+            if (!read_error_.empty()) {
+                done_ = true;
+                bundy_throw(MasterLoaderError, read_error_.c_str());
+            }
+            return (false);
+        }
+        result_cond_.wait(mutex_);
+    }
+}
+
+// Pass the RRset to the callback.  Like RRCollator, the last RRset is held
+// until the next one arrives, as RRs of the same RRset may have been split
+// into the two chunks.  It returns true iff an RRset is passed.
+bool
+ParallelMasterLoader::Impl::passRRset(const ConstRRsetPtr& rrset) {
+    if (!last_rrset_) {
+        last_rrset_ = rrset;
+        return (false);
+    }
+    if (isSameRRset(last_rrset_, rrset)) {
+        last_rrset_ = mergeRRsets(last_rrset_, rrset);
+        return (false);
+    }
+    add_callback_(last_rrset_);
+    last_rrset_ = rrset;
+    return (true);
+}
+
+bool
+ParallelMasterLoader::Impl::loadIncremental(size_t count_limit) {
+    if (done_) {
+        bundy_throw(InvalidOperation, "Master file load is already completed");
+    }
+    size_t count = 0;
+    while (count < count_limit) {
+        if (!current_) {
+            if (!nextResult()) {
+                done_ = true;
+                if (last_rrset_) {
+                    add_callback_(last_rrset_);
+                    last_rrset_.reset();
+                }
+                return (true);
+            }
+            for (std::vector<Issue>::const_iterator it =
+                     current_->issues.begin();
+                 it != current_->issues.end(); ++it) {
+                if (it->is_error) {
+                    callbacks_.error(it->source, it->line, it->reason);
+                } else {
+                    callbacks_.warning(it->source, it->line, it->reason);
+                }
+            }
+        }
+        while (count < count_limit &&
+               current_pos_ < current_->rrsets.size()) {
+            if (passRRset(current_->rrsets[current_pos_++])) {
+                ++count;
+            }
+        }
+        if (current_pos_ == current_->rrsets.size()) {
+            const ChunkResultPtr result = current_;
+            current_.reset();
+            if (result->failed) {
+                done_ = true;
+                bundy_throw(MasterLoaderError, result->error.c_str());
+            }
+        }
+    }
+    return (false);
+}
+
+ParallelMasterLoader::ParallelMasterLoader(
+    const std::string& master_file, const Name& zone_origin,
+    const RRClass& zone_class, const MasterLoaderCallbacks& callbacks,
+    const AddRRsetCallback& add_callback, size_t n_threads,
+    size_t chunk_size, const ChunkHook& chunk_hook) :
+    impl_(new Impl(master_file, zone_origin, zone_class, callbacks,
+                   add_callback, n_threads, chunk_size, chunk_hook))
+{}
+
+ParallelMasterLoader::~ParallelMasterLoader() {
+    delete impl_;
+}
+
+bool
+ParallelMasterLoader::loadIncremental(size_t count_limit) {
+    return (impl_->loadIncremental(count_limit));
+}
+
+} // namespace detail
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
@@ -0,0 +1,120 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_PARALLEL_MASTER_LOADER_H
+#define DATASRC_MEMORY_PARALLEL_MASTER_LOADER_H 1
+
+#include <dns/master_loader_callbacks.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <string>
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+namespace detail {
+
+/// \brief A master file loader that parses the file in multiple threads.
+///
+/// This class works like \c dns::MasterLoader combined with
+/// \c dns::RRCollator, but it splits the master file into chunks at record
+/// boundaries and lexes and parses the chunks in separate worker threads.
+/// The resulting RRsets are passed to the callback in the thread calling
+/// \c loadIncremental(), in the order of the file, so the caller can
+/// build zone data with them without worrying about locking.
+///
+/// A chunk starts at a line that has an explicit owner name, outside of
+/// any parentheses.  The \c $ORIGIN and default TTL in effect at that point
+/// are passed to the parser of the chunk, so the result is the same as
+/// that of loading the whole file sequentially.  But as an implicit TTL
+/// can depend on the previous RR if there's no \c $TTL, the file is only
+/// split after the first \c $TTL directive; a file without it is loaded
+/// in a single chunk (which still overlaps parsing and the callback).
+///
+/// Errors and warnings found in a chunk are reported via the given
+/// callbacks in the thread calling \c loadIncremental(), with the file name
+/// and the line number in the file, like \c dns::MasterLoader.  If a chunk
+/// has an error, \c loadIncremental() throws \c dns::MasterLoaderError
+/// after passing the RRsets of the preceding chunks.
+class ParallelMasterLoader : boost::noncopyable {
+public:
+    /// \brief Type of the callback for the loaded RRsets.
+    typedef boost::function<void(const dns::ConstRRsetPtr&)> AddRRsetCallback;
+
+    /// \brief Type of the hook called before parsing each chunk.
+    typedef boost::function<void(size_t)> ChunkHook;
+
+    /// \brief Constructor.
+    ///
+    /// It starts the worker threads.
+    ///
+    /// \throw dns::MasterLoaderError The file can't be opened.
+    ///
+    /// \param master_file The master file to load.
+    /// \param zone_origin The origin of the zone.
+    /// \param zone_class The RR class of the zone.
+    /// \param callbacks Callbacks for errors and warnings.
+    /// \param add_callback Called for each loaded RRset in the thread calling
+    /// \c loadIncremental().
+    /// \param n_threads The number of worker threads.  Must be positive.
+    /// \param chunk_size The approximate size of a chunk in bytes.
+    /// \param chunk_hook If non-empty, called in a worker thread with the
+    /// sequence number of each chunk before the chunk is parsed.  It's
+    /// meant for tests: an exception from it is handled like running out
+    /// of memory in the worker, which makes the load fail at that chunk.
+    ParallelMasterLoader(const std::string& master_file,
+                         const dns::Name& zone_origin,
+                         const dns::RRClass& zone_class,
+                         const dns::MasterLoaderCallbacks& callbacks,
+                         const AddRRsetCallback& add_callback,
+                         size_t n_threads,
+                         size_t chunk_size = DEFAULT_CHUNK_SIZE,
+                         const ChunkHook& chunk_hook = ChunkHook());
+
+    /// \brief Destructor.
+    ///
+    /// Stops and joins the worker threads, even if the load isn't completed.
+    ~ParallelMasterLoader();
+
+    /// \brief Pass up to the given number of RRsets to the callback.
+    ///
+    /// \throw dns::MasterLoaderError There's an error in the file.
+    ///
+    /// \param count_limit The number of RRsets to be passed in this call.
+    /// \return true if all RRsets of the file have been passed.
+    bool loadIncremental(size_t count_limit);
+
+    /// \brief The default size of a chunk (4MB).
+    static const size_t DEFAULT_CHUNK_SIZE = 4 * 1024 * 1024;
+
+private:
+    class Impl;
+    Impl* impl_;
+};
+
+} // namespace detail
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_MEMORY_PARALLEL_MASTER_LOADER_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -23,6 +23,7 @@
 #include "rdataset.h"
 #include "rdata_serialization.h"
 #include "zone_data.h"
+#include "zone_name_index.h"
 #include "segment_object_holder.h"
 
 #include <boost/bind.hpp>
@@ -167,6 +168,11 @@ NSEC3Data::removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node) {
     nsec3_tree_->remove(mem_sgmt, node, nullDeleter);
 }
 
+void
+NSEC3Data::relayout(util::MemorySegment& mem_sgmt) {
+    nsec3_tree_->relayout(mem_sgmt);
+}
+
 namespace {
 // A helper to convert a TTL value in network byte order and set it in
 // ZoneData::min_ttl_.  We can use util::OutputBuffer, but copy the logic
@@ -186,7 +192,7 @@ setTTLInNetOrder(uint32_t val, uint32_t* result) {
 }
 
 ZoneData::ZoneData(ZoneTree* zone_tree, ZoneNode* origin_node) :
-    zone_tree_(zone_tree), origin_node_(origin_node),
+    zone_tree_(zone_tree), origin_node_(origin_node), name_index_(NULL),
     min_ttl_(0)          // tentatively set to silence static checkers
 {
     setTTLInNetOrder(RRTTL::MAX_TTL().getValue(), &min_ttl_);
@@ -223,6 +229,7 @@ void
 ZoneData::destroy(util::MemorySegment& mem_sgmt, ZoneData* zone_data,
                   RRClass zone_class)
 {
+    zone_data->clearNameIndex(mem_sgmt);
     ZoneTree::destroy(mem_sgmt, zone_data->zone_tree_.get(),
                       boost::bind(rdataSetDeleter, zone_class, &mem_sgmt,
                                   _1));
@@ -265,9 +272,38 @@ ZoneData::removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node) {
     if (node == getOriginNode()) {
         return;
     }
+    // Removing a node can also remove or reallocate other nodes as a result
+    // of fusing them, which could be in the index.
+    clearNameIndex(mem_sgmt);
     zone_tree_->remove(mem_sgmt, node, nullDeleter);
 }
 
+void
+ZoneData::relayout(util::MemorySegment& mem_sgmt) {
+    clearNameIndex(mem_sgmt);
+    if (nsec3_data_) {
+        nsec3_data_->relayout(mem_sgmt);
+    }
+    ZoneNode* origin_node = origin_node_.get();
+    zone_tree_->relayout(mem_sgmt, &origin_node);
+    origin_node_ = origin_node;
+}
+
+void
+ZoneData::buildNameIndex(util::MemorySegment& mem_sgmt) {
+    ZoneNameIndex* index = ZoneNameIndex::create(mem_sgmt, *this);
+    clearNameIndex(mem_sgmt);
+    name_index_ = index;
+}
+
+void
+ZoneData::clearNameIndex(util::MemorySegment& mem_sgmt) {
+    if (name_index_) {
+        ZoneNameIndex::destroy(mem_sgmt, name_index_.get());
+        name_index_ = NULL;
+    }
+}
+
 void
 ZoneData::setMinTTL(uint32_t min_ttl_val) {
     setTTLInNetOrder(min_ttl_val, &min_ttl_);
@@ -45,6 +45,8 @@ typedef DomainTree<RdataSet> ZoneTree;
 typedef DomainTreeNode<RdataSet> ZoneNode;
 typedef DomainTreeNodeChain<RdataSet> ZoneChain;
 
+class ZoneNameIndex;
+
 /// \brief NSEC3 data for a DNS zone.
 ///
 /// This class encapsulates a set of NSEC3 related data for a zone
@@ -235,6 +237,12 @@ public:
     /// See ZoneData version of the method for other details.
     void removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node);
 
+    /// \brief Reallocate the NSEC3 nodes for faster lookups.
+    ///
+    /// This works just like ZoneData::relayout() but in the NSEC3Data.
+    /// See ZoneData version of the method for other details.
+    void relayout(util::MemorySegment& mem_sgmt);
+
 private:
     // Common subroutine for the public versions of create().
     static NSEC3Data* create(util::MemorySegment& mem_sgmt,
@@ -405,9 +413,8 @@ private:
     // backward compatible as possible.  And it can be helpful in practice
     // for file-mapped data.
 private:
-    // Set in the origin node (which always exists at the same address)
-    // to indicate whether the zone is signed or not.  Internal use,
-    // so defined as private.
+    // Set in the origin node (which always exists) to indicate whether
+    // the zone is signed or not.  Internal use, so defined as private.
     static const ZoneNode::Flags DNSSEC_SIGNED = ZoneNode::FLAG_USER1;
 
 public:
@@ -567,6 +574,14 @@ public:
     ///
     /// \throw none
     const void* getMinTTLData() const { return (&min_ttl_); }
+
+    /// \brief Return the exact match name index of the zone.
+    ///
+    /// This method returns the index built by the latest call to
+    /// \c buildNameIndex() if it's still valid; otherwise it returns NULL.
+    ///
+    /// \throw none
+    const ZoneNameIndex* getNameIndex() const { return (name_index_.get()); }
     //@}
 
     ///
@@ -639,6 +654,58 @@ public:
     /// \param node The node to be removed.
     void removeNode(util::MemorySegment& mem_sgmt, ZoneNode* node);
 
+    /// \brief Reallocate the zone nodes for faster lookups.
+    ///
+    /// This reallocates the nodes of the zone tree and, if associated, the
+    /// \c NSEC3Data in the order that makes \c find() on the trees access
+    /// less scattered memory.  See \c DomainTree::relayout() for details.
+    /// It's intended to be called once after all data of the zone are
+    /// loaded; it's a waste of time to call it on data that will be
+    /// modified afterwards.
+    ///
+    /// Any \c ZoneNode pointer taken before the call becomes invalid;
+    /// the origin node is kept track of.  If an exception is thrown, the
+    /// zone data remain valid.  Addresses allocated from \c mem_sgmt could
+    /// be relocated if \c util::MemorySegmentGrown is thrown, and the caller
+    /// can retry the call with the updated address of the \c ZoneData.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt Memory segment in which the zone data were allocated.
+    void relayout(util::MemorySegment& mem_sgmt);
+
+    /// \brief Build the exact match name index of the zone.
+    ///
+    /// This builds a \c ZoneNameIndex for the current content of the zone
+    /// and associates it with the zone data, replacing any existing one.
+    /// Like \c relayout(), it's intended to be called once after all data
+    /// of the zone are loaded.  The index is discarded when the zone data
+    /// are modified in a way that could make it inconsistent: when a node
+    /// is removed by \c removeNode(), when \c clearNameIndex() is called
+    /// (the caller must do this when it sets \c ZoneNode::FLAG_CALLBACK on
+    /// a node), and on \c relayout().
+    ///
+    /// If an exception is thrown, the existing index, if any, is kept
+    /// intact.  Addresses allocated from \c mem_sgmt could be relocated if
+    /// \c util::MemorySegmentGrown is thrown, and the caller can retry the
+    /// call with the updated address of the \c ZoneData.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt Memory segment in which the zone data were allocated.
+    void buildNameIndex(util::MemorySegment& mem_sgmt);
+
+    /// \brief Discard the exact match name index of the zone, if any.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt Memory segment in which the zone data were allocated.
+    void clearNameIndex(util::MemorySegment& mem_sgmt);
+
     /// \brief Specify whether or not the zone is signed in terms of DNSSEC.
     ///
     /// The zone will be considered "signed" (in that subsequent calls to
@@ -713,8 +780,9 @@ public:
 
 private:
     const boost::interprocess::offset_ptr<ZoneTree> zone_tree_;
-    const boost::interprocess::offset_ptr<ZoneNode> origin_node_;
+    boost::interprocess::offset_ptr<ZoneNode> origin_node_;
     boost::interprocess::offset_ptr<NSEC3Data> nsec3_data_;
+    boost::interprocess::offset_ptr<ZoneNameIndex> name_index_;
     uint32_t min_ttl_;
 };
 
@@ -16,6 +16,7 @@
 #include <datasrc/memory/zone_data_loader.h>
 #include <datasrc/memory/zone_data_updater.h>
 #include <datasrc/memory/logger.h>
+#include <datasrc/memory/parallel_master_loader.h>
 #include <datasrc/memory/segment_object_holder.h>
 #include <datasrc/memory/util_internal.h>
 #include <datasrc/memory/rrset_collection.h>
@@ -43,6 +44,7 @@ namespace bundy {
 namespace datasrc {
 namespace memory {
 
+using detail::ParallelMasterLoader;
 using detail::SegmentObjectHolder;
 using detail::getCoveredType;
 
@@ -397,6 +399,29 @@ ZoneDataLoader::ZoneDataLoaderImpl::finishUpdate() {
         arg(zone_name_).arg(rrclass_).arg(new_serial->getValue()).
         arg(loaded_data->isSigned() ? " (DNSSEC signed)" : "");
 
+    // Now that the zone is complete, reallocate the nodes in the order
+    // that makes lookups faster.  When we've applied diffs to the existing
+    // data, it's not worth it; most of the nodes are placed this way already.
+    if (!isDataReused()) {
+        while (true) {
+            try {
+                data_holder_->get()->relayout(mem_sgmt_);
+                break;
+            } catch (const util::MemorySegmentGrown&) {}
+        }
+    }
+
+    // Build the exact match index, unless the existing one is still valid
+    // for the updated data.
+    if (data_holder_->get()->getNameIndex() == NULL) {
+        while (true) {
+            try {
+                data_holder_->get()->buildNameIndex(mem_sgmt_);
+                break;
+            } catch (const util::MemorySegmentGrown&) {}
+        }
+    }
+
     loaded_data_ = data_holder_->release();
 }
 
@@ -430,17 +455,17 @@ class MasterFileLoader : public ZoneDataLoader::ZoneDataLoaderImpl {
 public:
     MasterFileLoader(util::MemorySegment& mem_sgmt, const dns::RRClass& rrclass,
                      const dns::Name& zone_name, const std::string& zone_file,
-                     ZoneData* old_data) :
+                     ZoneData* old_data, size_t load_threads) :
         ZoneDataLoader::ZoneDataLoaderImpl(mem_sgmt, rrclass, zone_name,
                                            old_data, NULL),
-        zone_file_(zone_file)
+        zone_file_(zone_file), load_threads_(load_threads)
     {}
     virtual ~MasterFileLoader() {}
     virtual bool isDataReused() const { return (false); }
 
 protected:
     virtual void initUpdate(ZoneData* const zone_data) {
-        if (master_loader_) {
+        if (master_loader_ || parallel_loader_) {
             return;             // already initialized
         }
 
@@ -456,6 +481,29 @@ protected:
         ZoneDataUpdaterHelper::LoadCallback update_helper_callback =
             boost::bind(&ZoneDataUpdaterHelper::updateFromLoad,
                         update_helper_.get(), _1, _2);
+
+        // With multiple threads, parsing is done in the worker threads of
+        // ParallelMasterLoader.  RRsets are still added to the zone data in
+        // this thread as the memory segment isn't thread safe.
+        if (load_threads_ > 1) {
+            LOG_DEBUG(logger, DBG_TRACE_BASIC,
+                      DATASRC_MEMORY_MEM_LOAD_PARALLEL).arg(zone_name_).
+                arg(rrclass_).arg(zone_file_).arg(load_threads_);
+            try {
+                parallel_loader_.reset(
+                    new ParallelMasterLoader(
+                        zone_file_, zone_name_, rrclass_,
+                        createMasterLoaderCallbacks(zone_name_, rrclass_,
+                                                    &load_ok_),
+                        boost::bind(update_helper_callback, _1,
+                                    ZoneDataUpdaterHelper::ADD),
+                        load_threads_));
+            } catch (const dns::MasterLoaderError& e) {
+                bundy_throw(ZoneLoaderException, e.what());
+            }
+            return;
+        }
+
         rrcollator_.reset(
             new dns::RRCollator(boost::bind(update_helper_callback, _1,
                                             ZoneDataUpdaterHelper::ADD)));
@@ -469,6 +517,9 @@ protected:
 
     virtual bool updateRRsets(size_t count_limit) {
         try {
+            if (parallel_loader_) {
+                return (parallel_loader_->loadIncremental(count_limit));
+            }
             if (!master_loader_->loadIncremental(count_limit)) {
                 return (false);
             }
@@ -482,8 +533,10 @@ protected:
 private:
     bool load_ok_; // we actually don't use it; only need a placeholder
     const std::string zone_file_;
+    const size_t load_threads_;
     boost::scoped_ptr<dns::RRCollator> rrcollator_;
     boost::scoped_ptr<dns::MasterLoader> master_loader_;
+    boost::scoped_ptr<ParallelMasterLoader> parallel_loader_;
 };
 
 // Zone iterator (of a data source) based loader implementation.
@@ -676,14 +729,14 @@ ZoneDataLoader::ZoneDataLoader(util::MemorySegment& mem_sgmt,
                                const dns::RRClass& rrclass,
                                const dns::Name& zone_name,
                                const std::string& zone_file,
-                               ZoneData* old_data) :
+                               ZoneData* old_data, size_t load_threads) :
     impl_(NULL)                 // defer until logging to avoid leak
 {
     LOG_DEBUG(logger, DBG_TRACE_BASIC, DATASRC_MEMORY_MEM_LOAD_FROM_FILE).
         arg(zone_name).arg(rrclass).arg(zone_file);
 
     impl_ = new MasterFileLoader(mem_sgmt, rrclass, zone_name, zone_file,
-                                 old_data);
+                                 old_data, load_threads);
 }
 
 ZoneDataLoader::ZoneDataLoader(util::MemorySegment& mem_sgmt,
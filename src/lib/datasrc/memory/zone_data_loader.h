@@ -58,11 +58,14 @@ public:
     /// \param zone_file Filename which contains the zone data for \c zone_name.
     /// \param old_data If non-NULL, zone data currently being used.  Also
     /// in that case, its origin name must be equal to \c zone_name.
+    /// \param load_threads If larger than 1, the number of threads to parse
+    /// the file in parallel.  Otherwise the file is parsed in the calling
+    /// thread.
     ZoneDataLoader(util::MemorySegment& mem_sgmt,
                    const dns::RRClass& rrclass,
                    const dns::Name& zone_name,
                    const std::string& zone_file,
-                   ZoneData* old_data = NULL);
+                   ZoneData* old_data = NULL, size_t load_threads = 0);
 
     /// \brief Constructor for loading from a given data source.
     ///
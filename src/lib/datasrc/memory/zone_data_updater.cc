@@ -339,11 +339,15 @@ ZoneDataUpdater::addRdataSet(const Name& name, const RRType& rrtype,
         // If this RRset creates a zone cut at this node, mark the node
         // indicating the need for callback in find().  Note that we do this
         // only when non RRSIG RRset of that type is added.
+        // Names below the new zone cut may be in the exact match index,
+        // which would then bypass the cut, so the index must go.
         if (rrset && rrtype == RRType::NS() && !is_origin) {
             node->setFlag(ZoneNode::FLAG_CALLBACK);
+            zone_data_->clearNameIndex(mem_sgmt_);
             // If it is DNAME, we have a callback as well here
         } else if (rrset && rrtype == RRType::DNAME()) {
             node->setFlag(ZoneNode::FLAG_CALLBACK);
+            zone_data_->clearNameIndex(mem_sgmt_);
         }
 
         // If we've added NSEC3PARAM at zone origin, set up NSEC3
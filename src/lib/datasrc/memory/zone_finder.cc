@@ -16,6 +16,7 @@
 #include <datasrc/memory/domaintree.h>
 #include <datasrc/memory/treenode_rrset.h>
 #include <datasrc/memory/rdata_serialization.h>
+#include <datasrc/memory/zone_name_index.h>
 
 #include <datasrc/zone_finder.h>
 #include <datasrc/exceptions.h>
@@ -475,6 +476,19 @@ FindNodeResult findNode(const ZoneData& zone_data,
                         ZoneFinder::FindOptions options,
                         bool out_of_zone_ok = false)
 {
+    // Most queries are for names that exist in the zone.  If the name is in
+    // the exact match index, the search in the tree would result in the
+    // node without encountering a zone cut or DNAME, so we can skip it.
+    // node_path isn't used in this case (it's only needed for an empty node
+    // or a non-exact match).
+    const ZoneNameIndex* name_index = zone_data.getNameIndex();
+    if (name_index != NULL) {
+        const ZoneNode* node = name_index->find(name_labels);
+        if (node != NULL && !node->isEmpty()) {
+            return (FindNodeResult(ZoneFinder::SUCCESS, node, NULL));
+        }
+    }
+
     const ZoneNode* node = NULL;
     FindState state((options & ZoneFinder::FIND_GLUE_OK) != 0);
 
@@ -0,0 +1,213 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <util/memory_segment.h>
+
+#include <dns/labelsequence.h>
+
+#include "zone_data.h"
+#include "zone_name_index.h"
+
+#include <cassert>
+#include <limits>
+#include <new>                  // for the placement new
+
+using namespace bundy::dns;
+using boost::interprocess::offset_ptr;
+
+namespace bundy {
+namespace datasrc {
+namespace memory {
+
+// A slot of the open addressing hash table.  A slot is unused iff node is
+// NULL.  name_offset is the offset of the serialized name of the node from
+// the beginning of the name data area.
+struct ZoneNameIndex::Slot {
+    uint32_t hash;
+    uint32_t name_offset;
+    offset_ptr<const ZoneNode> node;
+};
+
+namespace {
+// Whether a search for the name of the node in the zone tree ends in an
+// exact match without being stopped by a zone cut or DNAME on the way, and
+// whether the node has data.  Only such nodes are indexed.
+bool
+isIndexable(const ZoneNode* node) {
+    if (node->isEmpty()) {
+        return (false);
+    }
+    for (const ZoneNode* upper = node->getUpperNode(); upper != NULL;
+         upper = upper->getUpperNode()) {
+        if (upper->getFlag(ZoneNode::FLAG_CALLBACK)) {
+            return (false);
+        }
+    }
+    return (true);
+}
+
+inline uint32_t
+getNameHash(const LabelSequence& labels) {
+    return (static_cast<uint32_t>(labels.getFullHash(false, 0)));
+}
+
+// Call the given functor for each indexable node of the zone in the DNSSEC
+// order.
+template <typename Functor>
+void
+forEachIndexableNode(const ZoneData& zone_data, Functor& functor) {
+    const ZoneTree& tree = zone_data.getZoneTree();
+    uint8_t labels_buf[LabelSequence::MAX_SERIALIZED_LENGTH];
+    const LabelSequence origin_labels =
+        zone_data.getOriginNode()->getAbsoluteLabels(labels_buf);
+
+    ZoneChain node_path;
+    const ZoneNode* node = NULL;
+    const ZoneTree::Result result =
+        tree.find<void*>(origin_labels, &node, node_path, NULL, NULL);
+    // The zone tree always returns the origin, even if it's empty.
+    assert(result == ZoneTree::EXACTMATCH);
+    while (node != NULL) {
+        if (isIndexable(node)) {
+            functor(node, node->getAbsoluteLabels(labels_buf));
+        }
+        node = tree.nextNode(node_path);
+    }
+}
+
+struct NameCounter {
+    NameCounter() : name_count(0), name_data_len(0) {}
+    void operator()(const ZoneNode*, const LabelSequence& labels) {
+        ++name_count;
+        name_data_len += labels.getSerializedLength();
+    }
+    size_t name_count;
+    size_t name_data_len;
+};
+
+// Insert the nodes into the hash table and serialize their names into the
+// name data area.  It's a template so it can handle the slot type, which
+// is private to ZoneNameIndex.
+template <typename SlotType>
+struct NameInserter {
+    NameInserter(SlotType* slots, uint32_t slot_count, uint8_t* name_data) :
+        slots_(slots), mask_(slot_count - 1), name_data_(name_data),
+        name_offset_(0)
+    {}
+    void operator()(const ZoneNode* node, const LabelSequence& labels) {
+        const uint32_t hash = getNameHash(labels);
+        uint32_t i = hash & mask_;
+        while (slots_[i].node) {
+            i = (i + 1) & mask_;
+        }
+        const size_t name_len = labels.getSerializedLength();
+        labels.serialize(name_data_ + name_offset_, name_len);
+        slots_[i].hash = hash;
+        slots_[i].name_offset = name_offset_;
+        slots_[i].node = node;
+        name_offset_ += name_len;
+    }
+    SlotType* const slots_;
+    const uint32_t mask_;
+    uint8_t* const name_data_;
+    uint32_t name_offset_;
+};
+}
+
+ZoneNameIndex::ZoneNameIndex(uint32_t slot_count, uint32_t name_count,
+                             size_t alloc_size) :
+    slot_count_(slot_count), name_count_(name_count), alloc_size_(alloc_size)
+{}
+
+const ZoneNameIndex::Slot*
+ZoneNameIndex::getSlots() const {
+    return (reinterpret_cast<const Slot*>(this + 1));
+}
+
+ZoneNameIndex::Slot*
+ZoneNameIndex::getSlots() {
+    return (reinterpret_cast<Slot*>(this + 1));
+}
+
+const uint8_t*
+ZoneNameIndex::getNameData() const {
+    return (reinterpret_cast<const uint8_t*>(getSlots() + slot_count_));
+}
+
+uint8_t*
+ZoneNameIndex::getNameData() {
+    return (reinterpret_cast<uint8_t*>(getSlots() + slot_count_));
+}
+
+ZoneNameIndex*
+ZoneNameIndex::create(util::MemorySegment& mem_sgmt,
+                      const ZoneData& zone_data)
+{
+    NameCounter counter;
+    forEachIndexableNode(zone_data, counter);
+
+    // Keep the load factor at most 0.5 so unsuccessful searches (which
+    // are common for names below zone cuts, wildcards, etc) end soon.
+    size_t slot_count = 2;
+    while (slot_count < counter.name_count * 2) {
+        slot_count <<= 1;
+    }
+    if (slot_count > std::numeric_limits<uint32_t>::max() ||
+        counter.name_data_len > std::numeric_limits<uint32_t>::max()) {
+        return (NULL);
+    }
+
+    const size_t alloc_size = sizeof(ZoneNameIndex) +
+        sizeof(Slot) * slot_count + counter.name_data_len;
+    void* p = mem_sgmt.allocate(alloc_size);
+    ZoneNameIndex* index = new(p) ZoneNameIndex(slot_count,
+                                                counter.name_count,
+                                                alloc_size);
+    Slot* slots = index->getSlots();
+    for (size_t i = 0; i < slot_count; ++i) {
+        new(&slots[i]) Slot();
+    }
+
+    NameInserter<Slot> inserter(slots, slot_count, index->getNameData());
+    forEachIndexableNode(zone_data, inserter);
+    assert(inserter.name_offset_ == counter.name_data_len);
+
+    return (index);
+}
+
+void
+ZoneNameIndex::destroy(util::MemorySegment& mem_sgmt, ZoneNameIndex* index) {
+    const size_t alloc_size = index->alloc_size_;
+    index->~ZoneNameIndex();
+    mem_sgmt.deallocate(index, alloc_size);
+}
+
+const ZoneNode*
+ZoneNameIndex::find(const LabelSequence& labels) const {
+    const uint32_t hash = getNameHash(labels);
+    const uint32_t mask = slot_count_ - 1;
+    const Slot* const slots = getSlots();
+    for (uint32_t i = hash & mask; slots[i].node; i = (i + 1) & mask) {
+        if (slots[i].hash == hash &&
+            labels.equals(LabelSequence(getNameData() +
+                                        slots[i].name_offset))) {
+            return (slots[i].node.get());
+        }
+    }
+    return (NULL);
+}
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
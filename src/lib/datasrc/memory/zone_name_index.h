@@ -0,0 +1,132 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef DATASRC_MEMORY_ZONE_NAME_INDEX_H
+#define DATASRC_MEMORY_ZONE_NAME_INDEX_H 1
+
+#include <util/memory_segment.h>
+
+#include <datasrc/memory/zone_data.h>
+
+#include <boost/interprocess/offset_ptr.hpp>
+#include <boost/noncopyable.hpp>
+
+#include <stdint.h>
+
+namespace bundy {
+namespace dns {
+class LabelSequence;
+}
+
+namespace datasrc {
+namespace memory {
+
+/// \brief A hash index of the names of a zone for exact match lookups.
+///
+/// Most queries to a zone are for names that exist in the zone.  For such a
+/// query \c DomainTree::find() still has to descend the tree from the zone
+/// origin, comparing the query name with a node at each step.  This class
+/// maps the absolute names of zone nodes to the nodes with a hash table,
+/// so such lookups can be done without depending on the size of the zone.
+///
+/// Only nodes for which an exact match in the tree is the complete answer
+/// of the search are indexed: non-empty nodes that don't have a zone cut
+/// or DNAME above them (i.e., no ancestor has \c ZoneNode::FLAG_CALLBACK).
+/// A lookup that fails in the index therefore doesn't mean the name
+/// doesn't exist; the caller must fall back to the tree for such names,
+/// e.g., for delegations, wildcards and NXDOMAIN.
+///
+/// The index is built from complete zone data and is a read-only snapshot
+/// of it.  It must be discarded if a node of the zone is removed or a new
+/// zone cut or DNAME is added (new names that are not in the index are
+/// harmless).  \c ZoneData takes care of it; see \c ZoneData::buildNameIndex().
+///
+/// Like other zone data, this class is designed to be stored in a memory
+/// segment that can be shared by multiple processes.  All data of the index,
+/// including the hash table and the names, are stored in a single memory
+/// block allocated from the segment.
+class ZoneNameIndex : boost::noncopyable {
+private:
+    struct Slot;
+
+    /// \brief The constructor.
+    ///
+    /// An object of this class is always expected to be created by the
+    /// allocator (\c create()), so the constructor is hidden as private.
+    ZoneNameIndex(uint32_t slot_count, uint32_t name_count,
+                  size_t alloc_size);
+
+public:
+    /// \brief Allocate and construct \c ZoneNameIndex for the given zone.
+    ///
+    /// The whole index is allocated in a single call to
+    /// \c MemorySegment::allocate(), so if it throws (including
+    /// \c util::MemorySegmentGrown), nothing is left allocated.
+    ///
+    /// \throw util::MemorySegmentGrown The memory segment has grown, possibly
+    ///     relocating data.
+    /// \throw std::bad_alloc Memory allocation fails.
+    ///
+    /// \param mem_sgmt A \c MemorySegment from which memory for the index
+    /// is allocated.
+    /// \param zone_data The zone data to be indexed.
+    /// \return The index, or NULL if the zone is too large to be indexed.
+    static ZoneNameIndex* create(util::MemorySegment& mem_sgmt,
+                                 const ZoneData& zone_data);
+
+    /// \brief Destruct and deallocate \c ZoneNameIndex.
+    ///
+    /// \throw none
+    ///
+    /// \param mem_sgmt The \c MemorySegment that allocated memory for
+    /// \c index.
+    /// \param index A non NULL pointer to a valid \c ZoneNameIndex object
+    /// that was originally created by the \c create() method.
+    static void destroy(util::MemorySegment& mem_sgmt, ZoneNameIndex* index);
+
+    /// \brief Find the node of the given name.
+    ///
+    /// The comparison is case insensitive.
+    ///
+    /// \throw none
+    ///
+    /// \param labels An absolute label sequence to be found.
+    /// \return The node of the name if it's indexed; NULL otherwise.
+    const ZoneNode* find(const dns::LabelSequence& labels) const;
+
+    /// \brief Return the number of indexed names.
+    ///
+    /// \throw none
+    size_t getNameCount() const { return (name_count_); }
+
+private:
+    const Slot* getSlots() const;
+    Slot* getSlots();
+    const uint8_t* getNameData() const;
+    uint8_t* getNameData();
+
+    const uint32_t slot_count_;
+    const uint32_t name_count_;
+    const size_t alloc_size_;
+};
+
+} // namespace memory
+} // namespace datasrc
+} // namespace bundy
+
+#endif // DATASRC_MEMORY_ZONE_NAME_INDEX_H
+
+// Local Variables:
+// mode: c++
+// End:
@@ -311,4 +311,29 @@ TEST_F(CacheConfigTest, getSegmentType) {
                  bundy::data::TypeError);
 }
 
+TEST_F(CacheConfigTest, getLoadThreads) {
+    // By default master files are loaded sequentially.
+    EXPECT_EQ(0, CacheConfig("MasterFiles", 0,
+                             *master_config_, true).getLoadThreads());
+
+    ConstElementPtr config(Element::fromJSON("{\"cache-enable\": true,"
+                                             " \"cache-load-threads\": 4,"
+                                             " \"params\": {}}" ));
+    EXPECT_EQ(4,
+              CacheConfig("MasterFiles", 0, *config, true).getLoadThreads());
+
+    // Wrong types or values are rejected at construction time.
+    ConstElementPtr badconfig(Element::fromJSON(
+                                  "{\"cache-enable\": true,"
+                                  " \"cache-load-threads\": \"4\","
+                                  " \"params\": {}}"));
+    EXPECT_THROW(CacheConfig("MasterFiles", 0, *badconfig, true),
+                 bundy::data::TypeError);
+    badconfig = Element::fromJSON("{\"cache-enable\": true,"
+                                  " \"cache-load-threads\": -1,"
+                                  " \"params\": {}}");
+    EXPECT_THROW(CacheConfig("MasterFiles", 0, *badconfig, true),
+                 CacheConfigError);
+}
+
 }
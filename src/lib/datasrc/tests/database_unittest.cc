@@ -233,7 +233,9 @@ class MockAccessor : public NopAccessor {
                      NameCompare > Domains;
 
 public:
-    MockAccessor() : rollbacked_(false), did_transaction_(false) {
+    MockAccessor() :
+        iterated_rows_(0), rollbacked_(false), did_transaction_(false)
+    {
         readonly_records_ = &readonly_records_master_;
         update_records_ = &update_records_master_;
         nsec3_namespace_ = &nsec3_namespace_master_;
@@ -377,11 +379,14 @@ private:
     private:
         int step;
         const Domains& domains_;
+        size_t* const iterated_rows_;
     public:
-        MockIteratorContext(const Domains& domains) :
-            step(0), domains_(domains)
+        MockIteratorContext(const Domains& domains, size_t* iterated_rows) :
+            step(0), domains_(domains), iterated_rows_(iterated_rows)
         { }
         virtual bool getNext(string (&data)[COLUMN_COUNT]) {
+            ++*iterated_rows_;
+
             // A special case: if the given set of domains is already empty,
             // we always return false.
             if (domains_.empty()) {
@@ -493,7 +498,8 @@ public:
     virtual IteratorContextPtr getAllRecords(int id) const {
         if (id == READONLY_ZONE_ID) {
             return (IteratorContextPtr(new MockIteratorContext(
-                                           *readonly_records_)));
+                                           *readonly_records_,
+                                           &iterated_rows_)));
         } else if (id == 13) {
             return (IteratorContextPtr());
         } else if (id == 0) {
@@ -676,6 +682,11 @@ public:
         return (latest_clone_);
     }
 
+    // The number of getNext() calls on the contexts of getAllRecords().
+    size_t getIteratedRows() const {
+        return (iterated_rows_);
+    }
+
     virtual std::string findPreviousName(int id, const std::string& rname)
         const
     {
@@ -827,6 +838,9 @@ private:
     // The columns that were most recently added via addRecordToZone()
     string columns_lastadded_[ADD_COLUMN_COUNT];
 
+    // See getIteratedRows()
+    mutable size_t iterated_rows_;
+
     // Whether rollback operation has been performed for the database.
     // Not useful except for purely testing purpose.
     bool rollbacked_;
@@ -1447,6 +1461,21 @@ TEST_F(MockDatabaseClientTest, nullIteratorContext) {
                  bundy::Unexpected);
 }
 
+// Creating an iterator only to get the SOA (as the in-memory loader does
+// before applying journal diffs) shouldn't start iterating the whole zone.
+// Works for the mock accessor only.
+TEST_F(MockDatabaseClientTest, iteratorSOAOnly) {
+    const MockAccessor& mock_accessor =
+        dynamic_cast<const MockAccessor&>(*current_accessor_);
+    ZoneIteratorPtr it(client_->getIterator(Name("example.org")));
+    EXPECT_TRUE(it->getSOA());
+    EXPECT_EQ(0, mock_accessor.getLatestClone()->getIteratedRows());
+
+    // The iteration starts with the first call to getNextRRset().
+    EXPECT_TRUE(it->getNextRRset());
+    EXPECT_LT(0, mock_accessor.getLatestClone()->getIteratedRows());
+}
+
 // It doesn't crash or anything if the zone is completely empty.
 // Works for the mock accessor only.
 TEST_F(MockDatabaseClientTest, emptyIterator) {
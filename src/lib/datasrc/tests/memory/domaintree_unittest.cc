@@ -26,6 +26,7 @@
 #include <dns/rrttl.h>
 
 #include <datasrc/memory/domaintree.h>
+#include <datasrc/tests/memory/memory_segment_mock.h>
 
 #include <dns/tests/unittest_util.h>
 
@@ -1656,6 +1657,77 @@ TEST_F(DomainTreeTest, swap) {
     ASSERT_EQ(str1.str(), out.str());
 }
 
+TEST_F(DomainTreeTest, relayout) {
+    std::ostringstream str1;
+    dtree.dumpTree(str1);
+
+    // Keep track of one of the nodes.
+    EXPECT_EQ(TestDomainTree::EXACTMATCH, dtree.find(Name("z.d.e.f"), &dtnode));
+    const TestDomainTreeNode* const old_node = dtnode;
+    dtree.relayout(mem_sgmt_, &dtnode);
+    EXPECT_NE(old_node, dtnode);
+    EXPECT_EQ(Name("z"), dtnode->getName());
+    EXPECT_EQ(5, *dtnode->getData());
+
+    // The structure and data of the tree don't change.
+    EXPECT_EQ(15, dtree.getNodeCount());
+    std::ostringstream str2;
+    dtree.dumpTree(str2);
+    EXPECT_EQ(str1.str(), str2.str());
+    for (int i = 0; i < name_count; ++i) {
+        EXPECT_EQ(TestDomainTree::EXACTMATCH,
+                  dtree.find(Name(domain_names[i]), &cdtnode));
+        EXPECT_EQ(i + 1, *cdtnode->getData());
+    }
+    TestDomainTreeNodeChain node_path;
+    EXPECT_EQ(TestDomainTree::EXACTMATCH,
+              dtree.find(Name(ordered_names[0]), &cdtnode, node_path));
+    for (int i = 0; i < ordered_names_count; ++i) {
+        ASSERT_NE(static_cast<void*>(NULL), cdtnode);
+        EXPECT_EQ(Name(ordered_names[i]), node_path.getAbsoluteName());
+        cdtnode = dtree.nextNode(node_path);
+    }
+    EXPECT_EQ(static_cast<void*>(NULL), cdtnode);
+
+    // The tree can still be modified.
+    EXPECT_EQ(TestDomainTree::SUCCESS,
+              dtree.insert(mem_sgmt_, Name("m.w.y.d.e.f"), &dtnode));
+    EXPECT_EQ(16, dtree.getNodeCount());
+
+    // An empty tree is fine too.
+    TreeHolder tree_holder(mem_sgmt_, TestDomainTree::create(mem_sgmt_));
+    tree_holder.get()->relayout(mem_sgmt_);
+    EXPECT_EQ(0, tree_holder.get()->getNodeCount());
+}
+
+TEST_F(DomainTreeTest, relayoutException) {
+    test::MemorySegmentMock mem_sgmt;
+    TestDomainTree* tree = TestDomainTree::create(mem_sgmt);
+    for (int i = 0; i < name_count; ++i) {
+        tree->insert(mem_sgmt, Name(domain_names[i]), &dtnode);
+        dtnode->setData(new int(i + 1));
+    }
+    std::ostringstream str1;
+    tree->dumpTree(str1);
+
+    // An interrupted relayout leaves the tree intact, and it can be retried.
+    mem_sgmt.setThrowCount(5);
+    EXPECT_THROW(tree->relayout(mem_sgmt), std::bad_alloc);
+    std::ostringstream str2;
+    tree->dumpTree(str2);
+    EXPECT_EQ(str1.str(), str2.str());
+    tree->relayout(mem_sgmt);
+    std::ostringstream str3;
+    tree->dumpTree(str3);
+    EXPECT_EQ(str1.str(), str3.str());
+
+    // The copies made by an interrupted relayout are released on destroy.
+    mem_sgmt.setThrowCount(10);
+    EXPECT_THROW(tree->relayout(mem_sgmt), std::bad_alloc);
+    TestDomainTree::destroy(mem_sgmt, tree, deleteData);
+    EXPECT_TRUE(mem_sgmt.allMemoryDeallocated());
+}
+
 // Matching in the "root zone" may be special (e.g. there's no parent,
 // any domain names should be considered a subdomain of it), so it makes
 // sense to test cases with the root zone explicitly.
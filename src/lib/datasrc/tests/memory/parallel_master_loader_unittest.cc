@@ -0,0 +1,288 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/parallel_master_loader.h>
+
+#include <exceptions/exceptions.h>
+
+#include <dns/master_loader.h>
+#include <dns/name.h>
+#include <dns/rrclass.h>
+#include <dns/rrcollator.h>
+#include <dns/rrset.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <fstream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace bundy::dns;
+using bundy::datasrc::memory::detail::ParallelMasterLoader;
+
+namespace {
+
+const char* const ZONE_FILE = TEST_DATA_BUILDDIR "/parallel-load.zone";
+
+class ParallelMasterLoaderTest : public ::testing::Test {
+protected:
+    ParallelMasterLoaderTest() :
+        origin_("example.org"),
+        callbacks_(boost::bind(&ParallelMasterLoaderTest::addIssue, this,
+                               &errors_, _1, _2, _3),
+                   boost::bind(&ParallelMasterLoaderTest::addIssue, this,
+                               &warnings_, _1, _2, _3))
+    {}
+
+    void addIssue(std::vector<std::string>* issues, const std::string& source,
+                  size_t line, const std::string& reason)
+    {
+        issues->push_back(source + ":" +
+                          boost::lexical_cast<std::string>(line) + ": " +
+                          reason);
+    }
+
+    void addRRset(std::vector<std::string>* rrsets,
+                  const ConstRRsetPtr& rrset)
+    {
+        rrsets->push_back(rrset->toText());
+    }
+
+    void writeZone(const std::string& text) {
+        std::ofstream ofs(ZONE_FILE);
+        ofs << text;
+    }
+
+    // Load the zone file with the sequential loader and return the RRsets
+    // in text.
+    std::vector<std::string> loadSequential() {
+        std::vector<std::string> rrsets;
+        RRCollator collator(boost::bind(&ParallelMasterLoaderTest::addRRset,
+                                        this, &rrsets, _1));
+        MasterLoader loader(ZONE_FILE, origin_, RRClass::IN(), callbacks_,
+                            collator.getCallback());
+        loader.load();
+        collator.flush();
+        return (rrsets);
+    }
+
+    ParallelMasterLoader* createLoader(
+        size_t n_threads, size_t chunk_size,
+        const ParallelMasterLoader::ChunkHook& chunk_hook =
+        ParallelMasterLoader::ChunkHook())
+    {
+        return (new ParallelMasterLoader(
+                    ZONE_FILE, origin_, RRClass::IN(), callbacks_,
+                    boost::bind(&ParallelMasterLoaderTest::addRRset, this,
+                                &rrsets_, _1),
+                    n_threads, chunk_size, chunk_hook));
+    }
+
+    const Name origin_;
+    std::vector<std::string> errors_;
+    std::vector<std::string> warnings_;
+    std::vector<std::string> rrsets_;
+    const MasterLoaderCallbacks callbacks_;
+};
+
+// A zone with directives and RRs that make splitting the file tricky.
+const char* const TEST_ZONE =
+    "example.org. 3600 IN SOA ns.example.org. admin.example.org. 1 7200 3600 "
+    "2592000 1200\n"
+    "example.org. 3600 IN NS ns.example.org.\n"
+    "$TTL 1h\n"
+    "ns A 192.0.2.1\n"
+    "   AAAA 2001:db8::1\n"
+    "; a comment (\n"
+    "www 300 IN A 192.0.2.2\n"
+    "www MX 10 (\n"
+    "  mail.example.org. ; comment )\n"
+    "  )\n"
+    "txt TXT \"quoted ; ( text\"\n"
+    "txt TXT \"\\\"escaped (\"\n"
+    "$ORIGIN sub.example.org.\n"
+    "a A 192.0.2.3\n"
+    "\n"
+    "b A 192.0.2.4\n"
+    "$ORIGIN deeper\n"
+    "c A 192.0.2.5\n"
+    "$TTL 7200\n"
+    "@ A 192.0.2.6\n"
+    "www.example.org. AAAA 2001:db8::2\n";
+
+TEST_F(ParallelMasterLoaderTest, load) {
+    writeZone(TEST_ZONE);
+    const std::vector<std::string> expected = loadSequential();
+    EXPECT_TRUE(errors_.empty());
+    // There's a warning about the relative $ORIGIN.  The parallel loader
+    // should report it in the same way.
+    const std::vector<std::string> expected_warnings = warnings_;
+    EXPECT_EQ(1, expected_warnings.size());
+
+    // Try various chunk sizes (1 makes every possible split) and numbers of
+    // threads.  The results should be identical.
+    const size_t chunk_sizes[] = { 1, 20, 100, 1000000 };
+    for (size_t i = 0; i < sizeof(chunk_sizes) / sizeof(chunk_sizes[0]);
+         ++i) {
+        for (size_t n_threads = 1; n_threads <= 4; ++n_threads) {
+            SCOPED_TRACE("chunk size " +
+                         boost::lexical_cast<std::string>(chunk_sizes[i]) +
+                         ", threads " +
+                         boost::lexical_cast<std::string>(n_threads));
+            rrsets_.clear();
+            warnings_.clear();
+            boost::scoped_ptr<ParallelMasterLoader> loader(
+                createLoader(n_threads, chunk_sizes[i]));
+            EXPECT_TRUE(loader->loadIncremental(1000));
+            EXPECT_EQ(expected, rrsets_);
+            EXPECT_TRUE(errors_.empty());
+            EXPECT_EQ(expected_warnings, warnings_);
+        }
+    }
+}
+
+TEST_F(ParallelMasterLoaderTest, loadIncremental) {
+    writeZone(TEST_ZONE);
+    const std::vector<std::string> expected = loadSequential();
+
+    // Like RRCollator, the last RRset is passed on completion.
+    boost::scoped_ptr<ParallelMasterLoader> loader(createLoader(3, 1));
+    for (size_t i = 0; i < expected.size() - 1; ++i) {
+        EXPECT_FALSE(loader->loadIncremental(1));
+        EXPECT_EQ(i + 1, rrsets_.size());
+    }
+    EXPECT_TRUE(loader->loadIncremental(1));
+    EXPECT_EQ(expected, rrsets_);
+
+    // Once completed, it can't be continued.
+    EXPECT_THROW(loader->loadIncremental(1), bundy::InvalidOperation);
+}
+
+TEST_F(ParallelMasterLoaderTest, noTTL) {
+    // Without $TTL, the TTL of an RR can depend on the previous one.  The
+    // file isn't split, but should still be loaded correctly.
+    writeZone("example.org. 3600 IN SOA ns.example.org. admin.example.org. "
+              "1 7200 3600 2592000 1200\n"
+              "a 300 A 192.0.2.1\n"
+              "b A 192.0.2.2\n"
+              "c A 192.0.2.3\n");
+    const std::vector<std::string> expected = loadSequential();
+    const size_t n_warnings = warnings_.size();
+
+    boost::scoped_ptr<ParallelMasterLoader> loader(createLoader(2, 1));
+    EXPECT_TRUE(loader->loadIncremental(100));
+    EXPECT_EQ(expected, rrsets_);
+    EXPECT_EQ(n_warnings * 2, warnings_.size());
+}
+
+TEST_F(ParallelMasterLoaderTest, error) {
+    // An error in a later chunk is reported with the correct line number,
+    // after passing the RRsets before it (except the last one, which could
+    // have been collated with the next RR, like the sequential load).
+    writeZone("$TTL 3600\n"
+              "example.org. SOA ns.example.org. admin.example.org. "
+              "1 7200 3600 2592000 1200\n"
+              "a A 192.0.2.1\n"
+              "b A 192.0.2.2\n"
+              "c A bad-address\n"
+              "d A 192.0.2.4\n"
+              "e A bad-address\n");
+
+    boost::scoped_ptr<ParallelMasterLoader> loader(createLoader(2, 1));
+    EXPECT_THROW(loader->loadIncremental(100), MasterLoaderError);
+    EXPECT_EQ(2, rrsets_.size());
+    ASSERT_EQ(1, errors_.size());
+    EXPECT_EQ(0, errors_[0].find(std::string(ZONE_FILE) + ":5: "))
+        << errors_[0];
+    EXPECT_THROW(loader->loadIncremental(1), bundy::InvalidOperation);
+}
+
+// Make the worker fail at the given chunk as if it ran out of memory.
+void
+failChunk(size_t failed_seq, size_t seq) {
+    if (seq == failed_seq) {
+        throw std::bad_alloc();
+    }
+}
+
+TEST_F(ParallelMasterLoaderTest, chunkFailure) {
+    // If a worker can't make the result of a chunk, the load fails when
+    // it reaches the chunk, instead of waiting for the result forever.
+    std::ostringstream zone;
+    zone << "$TTL 3600\n";
+    for (size_t i = 0; i < 100; ++i) {
+        zone << "name" << i << " A 192.0.2.1\n";
+    }
+    writeZone(zone.str());
+
+    // With the chunk size of 1, the first chunk has the $TTL and each of
+    // the others has one RR.  The RRsets of the chunks before the failed
+    // one are passed, except the last one, which is held for collation.
+    const size_t failed_seqs[] = { 0, 5 };
+    const size_t passed_counts[] = { 0, 3 };
+    for (size_t i = 0; i < sizeof(failed_seqs) / sizeof(failed_seqs[0]);
+         ++i) {
+        for (size_t n_threads = 1; n_threads <= 3; ++n_threads) {
+            SCOPED_TRACE("failed chunk " +
+                         boost::lexical_cast<std::string>(failed_seqs[i]) +
+                         ", threads " +
+                         boost::lexical_cast<std::string>(n_threads));
+            rrsets_.clear();
+            boost::scoped_ptr<ParallelMasterLoader> loader(
+                createLoader(n_threads, 1,
+                             boost::bind(&failChunk, failed_seqs[i], _1)));
+            EXPECT_THROW(loader->loadIncremental(1000), MasterLoaderError);
+            EXPECT_EQ(passed_counts[i], rrsets_.size());
+            EXPECT_THROW(loader->loadIncremental(1), bundy::InvalidOperation);
+        }
+    }
+}
+
+TEST_F(ParallelMasterLoaderTest, noFile) {
+    EXPECT_THROW(ParallelMasterLoader(TEST_DATA_BUILDDIR "/no-such-file",
+                                      origin_, RRClass::IN(), callbacks_,
+                                      ParallelMasterLoader::AddRRsetCallback(),
+                                      2),
+                 MasterLoaderError);
+    EXPECT_EQ(1, errors_.size());
+}
+
+TEST_F(ParallelMasterLoaderTest, emptyFile) {
+    writeZone("");
+    boost::scoped_ptr<ParallelMasterLoader> loader(createLoader(2, 1));
+    EXPECT_TRUE(loader->loadIncremental(100));
+    EXPECT_TRUE(rrsets_.empty());
+}
+
+TEST_F(ParallelMasterLoaderTest, stopInTheMiddle) {
+    // Destroying the loader before completion stops the threads.
+    std::ostringstream zone;
+    zone << "$TTL 3600\n";
+    for (size_t i = 0; i < 1000; ++i) {
+        zone << "name" << i << " A 192.0.2.1\n";
+    }
+    writeZone(zone.str());
+    boost::scoped_ptr<ParallelMasterLoader> loader(createLoader(4, 16));
+    EXPECT_FALSE(loader->loadIncremental(10));
+    EXPECT_EQ(10, rrsets_.size());
+    loader.reset();
+}
+
+}
@@ -276,6 +276,31 @@ TEST_F(ZoneDataLoaderTest, zoneMinTTL) {
     EXPECT_EQ(RRTTL(1200), RRTTL(b));
 }
 
+TEST_F(ZoneDataLoaderTest, loadWithThreads) {
+    // Loading with parser threads should result in the same zone data as
+    // the sequential load.
+    const char* const zone_file = TEST_DATA_DIR "/example.org-nsec3-signed.zone";
+    ZoneData* const seq_data =
+        ZoneDataLoader(mem_sgmt_, zclass_, Name("example.org"),
+                       zone_file).load();
+    ZoneDataLoader loader(mem_sgmt_, zclass_, Name("example.org"), zone_file,
+                          NULL, 4);
+    zone_data_ = checkLoad(loader, true);
+    ASSERT_NE(static_cast<ZoneData*>(NULL), zone_data_);
+    EXPECT_TRUE(zone_data_->isNSEC3Signed());
+    EXPECT_EQ(seq_data->getZoneTree().getNodeCount(),
+              zone_data_->getZoneTree().getNodeCount());
+    bundy::util::InputBuffer b(zone_data_->getMinTTLData(), sizeof(uint32_t));
+    EXPECT_EQ(RRTTL(1200), RRTTL(b));
+    ZoneData::destroy(mem_sgmt_, seq_data, zclass_);
+
+    // Errors are reported the same way as the sequential load.
+    EXPECT_THROW(ZoneDataLoader(mem_sgmt_, zclass_, Name("example.org"),
+                                TEST_DATA_DIR "/no-such-file.zone", NULL,
+                                4).load(),
+                 ZoneLoaderException);
+}
+
 void
 ZoneDataLoaderTest::loadFromDataSourceCommon(bool incremental) {
     const Name origin("example.com");
@@ -269,6 +269,43 @@ TEST_F(ZoneDataTest, isSigned) {
     EXPECT_FALSE(zone_data_->isSigned());
 }
 
+TEST_F(ZoneDataTest, relayout) {
+    ZoneNode* node = NULL;
+    zone_data_->insertName(mem_sgmt_, a_rrset_->getName(), &node);
+    RdataSet* rdataset_a =
+        RdataSet::create(mem_sgmt_, encoder_, a_rrset_, ConstRRsetPtr());
+    node->setData(rdataset_a);
+    zone_data_->setSigned(true);
+
+    NSEC3Data* nsec3_data = NSEC3Data::create(mem_sgmt_, zname_, param_rdata_);
+    zone_data_->setNSEC3Data(nsec3_data);
+    nsec3_data->insertName(mem_sgmt_, nsec3_rrset_->getName(), &node);
+    RdataSet* rdataset_nsec3 =
+        RdataSet::create(mem_sgmt_, encoder_, nsec3_rrset_, ConstRRsetPtr());
+    node->setData(rdataset_nsec3);
+
+    const ZoneNode* const old_origin = zone_data_->getOriginNode();
+    zone_data_->relayout(mem_sgmt_);
+
+    // The origin node has moved with its flags, and the data can be found
+    // as before.
+    EXPECT_NE(old_origin, zone_data_->getOriginNode());
+    EXPECT_EQ(LabelSequence(zname_), zone_data_->getOriginNode()->getLabels());
+    EXPECT_TRUE(zone_data_->isSigned());
+    checkFindRdataSet(zone_data_->getZoneTree(), a_rrset_->getName(),
+                      RRType::A(), rdataset_a);
+    checkFindRdataSet(nsec3_data->getNSEC3Tree(), nsec3_rrset_->getName(),
+                      RRType::NSEC3(), rdataset_nsec3);
+
+    // A failed attempt doesn't break the data, nor leak memory (which would
+    // be caught in TearDown()).
+    mem_sgmt_.setThrowCount(2);
+    EXPECT_THROW(zone_data_->relayout(mem_sgmt_), std::bad_alloc);
+    EXPECT_EQ(LabelSequence(zname_), zone_data_->getOriginNode()->getLabels());
+    checkFindRdataSet(zone_data_->getZoneTree(), a_rrset_->getName(),
+                      RRType::A(), rdataset_a);
+}
+
 // A simple wrapper to reconstruct an RRTTL object from wire-format TTL
 // data (32 bits)
 RRTTL
@@ -26,6 +26,7 @@
 
 #include <datasrc/memory/zone_finder.h>
 #include <datasrc/memory/zone_data_updater.h>
+#include <datasrc/memory/zone_name_index.h>
 #include <datasrc/memory/rdata_serialization.h>
 #include <datasrc/memory/zone_table_segment.h>
 #include <datasrc/memory/memory_client.h>
@@ -91,13 +92,16 @@ protected:
                           ConstRRsetPtr expected_nsec,
                           ZoneFinder::FindResultFlags expected_flags =
                           ZoneFinder::RESULT_DEFAULT);
+    void delegationNSCheck();
+    void glueCheck();
 
     InMemoryZoneFinderTest() :
         class_(RRClass::IN()),
         origin_("example.org"),
         zone_data_(ZoneData::create(mem_sgmt_, origin_)),
         zone_finder_(*zone_data_, class_),
-        updater_(new ZoneDataUpdater(mem_sgmt_, class_, origin_, *zone_data_))
+        updater_(new ZoneDataUpdater(mem_sgmt_, class_, origin_, *zone_data_)),
+        use_name_index_(false)
     {
         // Build test RRsets.  Below, we construct an RRset for
         // each textual RR(s) of zone_data, and assign it to the corresponding
@@ -224,6 +228,9 @@ protected:
     memory::ZoneData* zone_data_;
     memory::InMemoryZoneFinder zone_finder_;
     boost::scoped_ptr<ZoneDataUpdater> updater_;
+    // If true, the exact match index is rebuilt for the current zone data
+    // before each search, so the search uses it.
+    bool use_name_index_;
 
     // Placeholder for storing RRsets to be checked with rrsetsCheck()
     vector<ConstRRsetPtr> actual_rrsets_;
@@ -311,6 +318,7 @@ protected:
         if (zone_finder == NULL) {
             zone_finder = &zone_finder_;
         }
+        prepareFind();
         // The whole block is inside, because we need to check the result and
         // we can't assign to FindResult
         EXPECT_NO_THROW({
@@ -345,6 +353,14 @@ protected:
     }
 
 private:
+    void prepareFind() {
+        if (use_name_index_) {
+            zone_data_->buildNameIndex(mem_sgmt_);
+            ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL),
+                      zone_data_->getNameIndex());
+        }
+    }
+
     void findTestCommon(const Name& name, ZoneFinder::Result result,
                         ZoneFinderContextPtr find_result,
                         bool check_answer,
@@ -430,6 +446,7 @@ protected:
         if (finder == NULL) {
             finder = &zone_finder_;
         }
+        prepareFind();
         std::vector<ConstRRsetPtr> target;
         ZoneFinderContextPtr find_result(finder->findAll(name, target,
                                                          options));
@@ -542,7 +559,8 @@ TEST_F(InMemoryZoneFinderTest, DNAMEUnderNS) {
 }
 
 // Test adding child zones and zone cut handling
-TEST_F(InMemoryZoneFinderTest, delegationNS) {
+void
+InMemoryZoneFinderTest::delegationNSCheck() {
     // add in-zone data
     EXPECT_NO_THROW(addToZoneData(rr_ns_));
 
@@ -570,6 +588,10 @@ TEST_F(InMemoryZoneFinderTest, delegationNS) {
              ZoneFinder::DELEGATION, true, rr_child_ns_);
 }
 
+TEST_F(InMemoryZoneFinderTest, delegationNS) {
+    delegationNSCheck();
+}
+
 TEST_F(InMemoryZoneFinderTest, delegationWithDS) {
     // Similar setup to the previous one, but with DS RR at the delegation
     // point.
@@ -627,7 +649,8 @@ TEST_F(InMemoryZoneFinderTest, findAny) {
                 NULL, rr_child_ns_);
 }
 
-TEST_F(InMemoryZoneFinderTest, glue) {
+void
+InMemoryZoneFinderTest::glueCheck() {
     // install zone data:
     // a zone cut
     EXPECT_NO_THROW(addToZoneData(rr_child_ns_));
@@ -680,6 +703,10 @@ TEST_F(InMemoryZoneFinderTest, glue) {
              NULL, ZoneFinder::FIND_GLUE_OK);
 }
 
+TEST_F(InMemoryZoneFinderTest, glue) {
+    glueCheck();
+}
+
 TEST_F(InMemoryZoneFinderTest, findAtOrigin) {
     // Add origin NS.
     rr_ns_->addRRsig(createRdata(RRType::RRSIG(), RRClass::IN(),
@@ -1631,6 +1658,45 @@ TEST_F(InMemoryZoneFinderTest, NSECNonExistentTest) {
 }
 
 /// \brief NSEC3 specific tests fixture for the InMemoryZoneFinder class
+// Run some of the above tests with the exact match index.  The results must
+// be the same as those using the tree only.
+class InMemoryZoneFinderIndexTest : public InMemoryZoneFinderTest {
+protected:
+    InMemoryZoneFinderIndexTest() {
+        use_name_index_ = true;
+    }
+};
+
+TEST_F(InMemoryZoneFinderIndexTest, find) {
+    findCheck();
+}
+
+TEST_F(InMemoryZoneFinderIndexTest, findNSECSignedWithDNSSEC) {
+    findCheck(ZoneFinder::RESULT_NSEC_SIGNED, ZoneFinder::FIND_DNSSEC);
+}
+
+TEST_F(InMemoryZoneFinderIndexTest, delegationNS) {
+    delegationNSCheck();
+}
+
+TEST_F(InMemoryZoneFinderIndexTest, glue) {
+    glueCheck();
+}
+
+TEST_F(InMemoryZoneFinderIndexTest, emptyNodeNSEC) {
+    emptyNodeCheck(ZoneFinder::RESULT_NSEC_SIGNED);
+}
+
+TEST_F(InMemoryZoneFinderIndexTest, wildcard) {
+    wildcardCheck();
+}
+
+TEST_F(InMemoryZoneFinderIndexTest, cancelWildcard) {
+    addToZoneData(rr_wild_);
+    addToZoneData(rr_not_wild_);
+    doCancelWildcardCheck();
+}
+
 class InMemoryZoneFinderNSEC3Test : public InMemoryZoneFinderTest {
 public:
     InMemoryZoneFinderNSEC3Test() {
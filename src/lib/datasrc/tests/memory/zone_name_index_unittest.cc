@@ -0,0 +1,196 @@
+// Copyright (C) 2013  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <datasrc/memory/zone_name_index.h>
+#include <datasrc/memory/zone_data.h>
+#include <datasrc/memory/zone_data_updater.h>
+
+#include <testutils/dnsmessage_test.h>
+#include <datasrc/tests/memory/memory_segment_mock.h>
+
+#include <dns/name.h>
+#include <dns/labelsequence.h>
+#include <dns/rrclass.h>
+#include <dns/rrset.h>
+
+#include <gtest/gtest.h>
+
+#include <boost/lexical_cast.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <new>                  // for bad_alloc
+
+using namespace bundy::dns;
+using namespace bundy::datasrc::memory;
+using namespace bundy::datasrc::memory::test;
+using bundy::testutils::textToRRset;
+
+namespace {
+
+class ZoneNameIndexTest : public ::testing::Test {
+protected:
+    ZoneNameIndexTest() :
+        zname_("example.org"),
+        zone_data_(ZoneData::create(mem_sgmt_, zname_)),
+        updater_(new ZoneDataUpdater(mem_sgmt_, RRClass::IN(), zname_,
+                                     *zone_data_)),
+        index_(NULL)
+    {
+        addRRset("example.org. 3600 IN NS ns.example.org.");
+        addRRset("www.example.org. 3600 IN A 192.0.2.1");
+        // b.example.org is an empty non-terminal.
+        addRRset("a.b.example.org. 3600 IN A 192.0.2.2");
+        addRRset("child.example.org. 3600 IN NS ns.child.example.org.");
+        addRRset("ns.child.example.org. 3600 IN A 192.0.2.3");
+        addRRset("dname.example.org. 3600 IN DNAME example.com.");
+        addRRset("x.dname.example.org. 3600 IN A 192.0.2.4");
+    }
+    ~ZoneNameIndexTest() {
+        if (index_ != NULL) {
+            ZoneNameIndex::destroy(mem_sgmt_, index_);
+        }
+        updater_.reset();
+        ZoneData::destroy(mem_sgmt_, zone_data_, RRClass::IN());
+        // detect any memory leak in the test memory segment
+        EXPECT_TRUE(mem_sgmt_.allMemoryDeallocated());
+    }
+
+    void addRRset(const char* text) {
+        updater_->add(textToRRset(text), ConstRRsetPtr());
+    }
+
+    const ZoneNode* findInIndex(const char* name) const {
+        return (index_->find(LabelSequence(Name(name))));
+    }
+
+    MemorySegmentMock mem_sgmt_;
+    const Name zname_;
+    ZoneData* zone_data_;
+    boost::scoped_ptr<ZoneDataUpdater> updater_;
+    ZoneNameIndex* index_;
+};
+
+TEST_F(ZoneNameIndexTest, find) {
+    index_ = ZoneNameIndex::create(mem_sgmt_, *zone_data_);
+    ASSERT_NE(static_cast<ZoneNameIndex*>(NULL), index_);
+
+    // The origin, www, a.b, and child and dname themselves.
+    EXPECT_EQ(5, index_->getNameCount());
+    const char* const indexed_names[] = {
+        "example.org", "www.example.org", "a.b.example.org",
+        "child.example.org", "dname.example.org"
+    };
+    for (size_t i = 0; i < sizeof(indexed_names) / sizeof(indexed_names[0]);
+         ++i) {
+        SCOPED_TRACE(indexed_names[i]);
+        const ZoneNode* node = findInIndex(indexed_names[i]);
+        EXPECT_EQ(zone_data_->findName(Name(indexed_names[i])), node);
+        EXPECT_NE(static_cast<const ZoneNode*>(NULL), node);
+    }
+
+    // Lookups are case insensitive.
+    EXPECT_EQ(zone_data_->findName(Name("www.example.org")),
+              findInIndex("WWW.Example.ORG"));
+
+    // Empty nodes, names below a zone cut or DNAME, and nonexistent names
+    // aren't found.
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              findInIndex("b.example.org"));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              findInIndex("ns.child.example.org"));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              findInIndex("x.dname.example.org"));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              findInIndex("nosuch.example.org"));
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL), findInIndex("www.example"));
+}
+
+TEST_F(ZoneNameIndexTest, manyNames) {
+    // Enough names to have many collisions in the table.
+    for (int i = 0; i < 1000; ++i) {
+        const std::string name = "host" + boost::lexical_cast<std::string>(i) +
+            ".example.org.";
+        addRRset((name + " 3600 IN A 192.0.2.1").c_str());
+    }
+    index_ = ZoneNameIndex::create(mem_sgmt_, *zone_data_);
+    EXPECT_EQ(1005, index_->getNameCount());
+    for (int i = 0; i < 1000; ++i) {
+        const Name name("host" + boost::lexical_cast<std::string>(i) +
+                        ".example.org");
+        EXPECT_EQ(zone_data_->findName(name),
+                  index_->find(LabelSequence(name)));
+    }
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL),
+              findInIndex("host1000.example.org"));
+}
+
+TEST_F(ZoneNameIndexTest, emptyZone) {
+    updater_.reset();
+    ZoneData::destroy(mem_sgmt_, zone_data_, RRClass::IN());
+    zone_data_ = ZoneData::create(mem_sgmt_, zname_);
+
+    index_ = ZoneNameIndex::create(mem_sgmt_, *zone_data_);
+    EXPECT_EQ(0, index_->getNameCount());
+    EXPECT_EQ(static_cast<const ZoneNode*>(NULL), findInIndex("example.org"));
+}
+
+TEST_F(ZoneNameIndexTest, zoneData) {
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+    zone_data_->buildNameIndex(mem_sgmt_);
+    const ZoneNameIndex* index = zone_data_->getNameIndex();
+    ASSERT_NE(static_cast<const ZoneNameIndex*>(NULL), index);
+    EXPECT_EQ(5, index->getNameCount());
+
+    // Failure in building a new index keeps the existing one.
+    mem_sgmt_.setThrowCount(1);
+    EXPECT_THROW(zone_data_->buildNameIndex(mem_sgmt_), std::bad_alloc);
+    EXPECT_EQ(index, zone_data_->getNameIndex());
+
+    // Adding normal data doesn't affect the index.
+    addRRset("www.example.org. 3600 IN AAAA 2001:db8::1");
+    addRRset("new.example.org. 3600 IN A 192.0.2.5");
+    EXPECT_EQ(index, zone_data_->getNameIndex());
+
+    // A new zone cut or DNAME invalidates it.
+    addRRset("www.example.org. 3600 IN NS ns.example.net.");
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+    zone_data_->buildNameIndex(mem_sgmt_);
+    EXPECT_EQ(6, zone_data_->getNameIndex()->getNameCount());
+    addRRset("new.example.org. 3600 IN DNAME example.com.");
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // So does removing a node.
+    zone_data_->buildNameIndex(mem_sgmt_);
+    ZoneNode* node = NULL;
+    zone_data_->insertName(mem_sgmt_, Name("empty.example.org"), &node);
+    EXPECT_NE(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+    zone_data_->removeNode(mem_sgmt_, node);
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // And relayout.
+    zone_data_->buildNameIndex(mem_sgmt_);
+    zone_data_->relayout(mem_sgmt_);
+    EXPECT_EQ(static_cast<const ZoneNameIndex*>(NULL),
+              zone_data_->getNameIndex());
+
+    // ZoneData::destroy() releases the index; the fixture checks it.
+    zone_data_->buildNameIndex(mem_sgmt_);
+}
+
+}
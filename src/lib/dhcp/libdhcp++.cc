@@ -45,6 +45,9 @@ std::map<unsigned short, Option::Factory*> LibDHCP::v6factories_;
 // Static container with DHCPv4 option definitions.
 OptionDefContainer LibDHCP::v4option_defs_;
 
+// Static table of DHCPv4 option definitions indexed by option code.
+OptionDefinitionPtr LibDHCP::v4option_def_table_[256];
+
 // Static container with DHCPv6 option definitions.
 OptionDefContainer LibDHCP::v6option_defs_;
 
@@ -129,6 +132,13 @@ LibDHCP::getOptionDef(const Option::Universe u, const uint16_t code) {
     return (OptionDefinitionPtr());
 }
 
+const OptionDefinitionPtr&
+LibDHCP::getStdOptionDef4(const uint8_t code) {
+    // Make sure the definitions and the table are initialized.
+    getOptionDefs(Option::V4);
+    return (v4option_def_table_[code]);
+}
+
 OptionDefinitionPtr
 LibDHCP::getVendorOptionDef(const Option::Universe u, const uint32_t vendor_id,
                             const uint16_t code) {
@@ -215,19 +225,16 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
     size_t offset = 0;
     size_t length = buf.size();
 
-    // Get the list of standard option definitions.
-    OptionDefContainer option_defs;
+    // Get the list of standard option definitions. It's not copied, as
+    // this is done for every received packet.
+    const OptionDefContainer* option_defs = NULL;
     if (option_space == "dhcp6") {
-        option_defs = LibDHCP::getOptionDefs(Option::V6);
+        option_defs = &LibDHCP::getOptionDefs(Option::V6);
     }
     // @todo Once we implement other option spaces we should add else clause
     // here and gather option definitions for them. For now leaving option_defs
     // empty will imply creation of generic Option.
 
-    // Get the search index #1. It allows to search for option definitions
-    // using option code.
-    const OptionDefContainerTypeIndex& idx = option_defs.get<1>();
-
     // The buffer being read comprises a set of options, each starting with
     // a two-byte type code and a two-byte length field.
     while (offset + 4 <= length) {
@@ -273,9 +280,14 @@ size_t LibDHCP::unpackOptions6(const OptionBuffer& buf,
         // code is non-unique within this container however at this point we
         // expect to get one option definition with the particular code. If more
         // are returned we report an error.
-        const OptionDefContainerTypeRange& range = idx.equal_range(opt_type);
-        // Get the number of returned option definitions for the option code.
-        size_t num_defs = distance(range.first, range.second);
+        OptionDefContainerTypeRange range;
+        size_t num_defs = 0;
+        if (option_defs) {
+            range = option_defs->get<1>().equal_range(opt_type);
+            // Get the number of returned option definitions for the option
+            // code.
+            num_defs = distance(range.first, range.second);
+        }
 
         OptionPtr opt;
         if (num_defs > 1) {
@@ -315,18 +327,12 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                                bundy::dhcp::OptionCollection& options) {
     size_t offset = 0;
 
-    // Get the list of stdandard option definitions.
-    OptionDefContainer option_defs;
-    if (option_space == "dhcp4") {
-        option_defs = LibDHCP::getOptionDefs(Option::V4);
-    }
-    // @todo Once we implement other option spaces we should add else clause
-    // here and gather option definitions for them. For now leaving option_defs
-    // empty will imply creation of generic Option.
-
-    // Get the search index #1. It allows to search for option definitions
-    // using option code.
-    const OptionDefContainerTypeIndex& idx = option_defs.get<1>();
+    // Standard option definitions are looked up in the table indexed by
+    // option code.
+    // @todo Once we implement other option spaces we should gather option
+    // definitions for them. For now, options of other spaces are created
+    // as generic Option.
+    const bool std_space = (option_space == "dhcp4");
 
     // The buffer being read comprises a set of options, each starting with
     // a one-byte type code and a one-byte length field.
@@ -356,35 +362,19 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
                       << "-byte long buffer.");
         }
 
-        // Get all definitions with the particular option code. Note that option code
-        // is non-unique within this container however at this point we expect
-        // to get one option definition with the particular code. If more are
-        // returned we report an error.
-        const OptionDefContainerTypeRange& range = idx.equal_range(opt_type);
-        // Get the number of returned option definitions for the option code.
-        size_t num_defs = distance(range.first, range.second);
-
         OptionPtr opt;
-        if (num_defs > 1) {
-            // Multiple options of the same code are not supported right now!
-            bundy_throw(bundy::Unexpected, "Internal error: multiple option definitions"
-                      " for option type " << static_cast<int>(opt_type)
-                      << " returned. Currently it is not supported to initialize"
-                      << " multiple option definitions for the same option code."
-                      << " This will be supported once support for option spaces"
-                      << " is implemented");
-        } else if (num_defs == 0) {
-            opt = OptionPtr(new Option(Option::V4, opt_type,
-                                       buf.begin() + offset,
-                                       buf.begin() + offset + opt_len));
-        } else {
+        const OptionDefinition* def =
+            std_space ? getStdOptionDef4(opt_type).get() : NULL;
+        if (def) {
             // The option definition has been found. Use it to create
             // the option instance from the provided buffer chunk.
-            const OptionDefinitionPtr& def = *(range.first);
-            assert(def);
             opt = def->optionFactory(Option::V4, opt_type,
                                      buf.begin() + offset,
                                      buf.begin() + offset + opt_len);
+        } else {
+            opt = OptionPtr(new Option(Option::V4, opt_type,
+                                       buf.begin() + offset,
+                                       buf.begin() + offset + opt_len));
         }
 
         options.insert(std::make_pair(opt_type, opt));
@@ -393,6 +383,82 @@ size_t LibDHCP::unpackOptions4(const OptionBuffer& buf,
     return (offset);
 }
 
+size_t LibDHCP::scanOptions4(const OptionBuffer& buf, size_t offset,
+                             OptionView4* views, size_t max_views,
+                             size_t& count) {
+    count = 0;
+    while (offset < buf.size()) {
+        const uint8_t opt_type = buf[offset];
+
+        // Nothing after DHO_END is of interest.
+        if (opt_type == DHO_END) {
+            return (buf.size());
+        }
+
+        if (opt_type == DHO_PAD) {
+            ++offset;
+            continue;
+        }
+
+        if (count == max_views) {
+            // The rest is left for the caller.
+            return (offset);
+        }
+
+        if (offset + 2 >= buf.size()) {
+            bundy_throw(OutOfRange, "Attempt to parse truncated option "
+                      << static_cast<int>(opt_type));
+        }
+
+        const uint8_t opt_len = buf[offset + 1];
+        offset += 2;
+        if (offset + opt_len > buf.size()) {
+            bundy_throw(OutOfRange, "Option parse failed. Tried to parse "
+                      << offset + opt_len << " bytes from " << buf.size()
+                      << "-byte long buffer.");
+        }
+
+        views[count].type_ = opt_type;
+        views[count].len_ = opt_len;
+        views[count].offset_ = offset;
+        ++count;
+        offset += opt_len;
+    }
+    return (buf.size());
+}
+
+size_t LibDHCP::scanOptions6(const OptionBuffer& buf, size_t offset,
+                             size_t end, OptionView6* views,
+                             size_t max_views, size_t& count,
+                             size_t* relay_msg_offset /* = 0 */,
+                             size_t* relay_msg_len /* = 0 */) {
+    count = 0;
+    while (offset + 4 <= end) {
+        const uint16_t opt_type = bundy::util::readUint16(&buf[offset], 2);
+        const uint16_t opt_len = bundy::util::readUint16(&buf[offset + 2], 2);
+
+        if (offset + 4 + opt_len > end) {
+            // Truncated option, ignored as by unpackOptions6().
+            break;
+        }
+
+        if (opt_type == D6O_RELAY_MSG && relay_msg_offset && relay_msg_len) {
+            *relay_msg_offset = offset + 4;
+            *relay_msg_len = opt_len;
+        } else if (count == max_views) {
+            // The rest is left for the caller.
+            return (offset);
+        } else {
+            views[count].type_ = opt_type;
+            views[count].len_ = opt_len;
+            views[count].offset_ = offset + 4;
+            ++count;
+        }
+        offset += 4 + opt_len;
+    }
+    return (end);
+}
+
 size_t LibDHCP::unpackVendorOptions6(const uint32_t vendor_id,
                                      const OptionBuffer& buf,
                                      bundy::dhcp::OptionCollection& options) {
@@ -629,6 +695,26 @@ void LibDHCP::OptionFactoryRegister(Option::Universe u,
 void
 LibDHCP::initStdOptionDefs4() {
     initOptionSpace(v4option_defs_, OPTION_DEF_PARAMS4, OPTION_DEF_PARAMS_SIZE4);
+
+    // Index the definitions by option code for getStdOptionDef4().
+    for (size_t code = 0; code < 256; ++code) {
+        v4option_def_table_[code].reset();
+    }
+    for (OptionDefContainer::const_iterator def = v4option_defs_.begin();
+         def != v4option_defs_.end(); ++def) {
+        const uint16_t code = (*def)->getCode();
+        if (code > 255) {
+            bundy_throw(bundy::Unexpected, "Internal error: invalid DHCPv4"
+                        " option code " << code);
+        } else if (v4option_def_table_[code]) {
+            // Multiple options of the same code are not supported right now!
+            bundy_throw(bundy::Unexpected, "Internal error: multiple option"
+                        " definitions for option type " << code << ". Currently"
+                        " it is not supported to initialize multiple option"
+                        " definitions for the same option code.");
+        }
+        v4option_def_table_[code] = *def;
+    }
 }
 
 void
@@ -55,6 +55,18 @@ public:
     static OptionDefinitionPtr getOptionDef(const Option::Universe u,
                                             const uint16_t code);
 
+    /// @brief Return the definition of a standard DHCPv4 option.
+    ///
+    /// Unlike @c getOptionDef, this is a lookup in a table indexed by the
+    /// option code, which is built together with the definitions. It is
+    /// meant for parsing the options of received packets.
+    ///
+    /// @param code option code.
+    ///
+    /// @return reference to the option definition or NULL pointer if
+    /// there is no standard definition for the code.
+    static const OptionDefinitionPtr& getStdOptionDef4(const uint8_t code);
+
     /// @brief Returns vendor option definition for a given vendor-id and code
     ///
     /// @param u universe (V4 or V6)
@@ -127,6 +139,53 @@ public:
                                  const std::string& option_space,
                                  bundy::dhcp::OptionCollection& options);
 
+    /// @brief Finds DHCPv4 options in a buffer without parsing them.
+    ///
+    /// The buffer is walked in the same way as by @c unpackOptions4, but
+    /// only the positions of the options are stored, so no Option objects
+    /// are created and no data is copied. The scan stops at the END option,
+    /// at the end of the buffer, or when the array of views is full.
+    ///
+    /// @param buf Buffer to be scanned.
+    /// @param offset Position of the first option in the buffer.
+    /// @param views Array in which the positions of the options are stored.
+    /// @param max_views Size of the array.
+    /// @param [out] count Number of options stored in the array.
+    ///
+    /// @return Position of the first option which didn't fit in the array,
+    /// or the size of the buffer if all options have been found.
+    /// @throw bundy::OutOfRange if an option is truncated.
+    static size_t scanOptions4(const OptionBuffer& buf, size_t offset,
+                               OptionView4* views, size_t max_views,
+                               size_t& count);
+
+    /// @brief Finds DHCPv6 options in a buffer without parsing them.
+    ///
+    /// This is the DHCPv6 counterpart of @c scanOptions4. The buffer is
+    /// walked in the same way as by @c unpackOptions6: a truncated option
+    /// ends the scan, and the relay-msg option is reported through
+    /// @c relay_msg_offset and @c relay_msg_len if they are given, instead
+    /// of being stored in the array.
+    ///
+    /// @param buf Buffer to be scanned.
+    /// @param offset Position of the first option in the buffer.
+    /// @param end Position of the end of the options in the buffer.
+    /// @param views Array in which the positions of the options are stored.
+    /// @param max_views Size of the array.
+    /// @param [out] count Number of options stored in the array.
+    /// @param relay_msg_offset Set to the position in the buffer of the data
+    /// of the relay-msg option, if it's found.
+    /// @param relay_msg_len Set to the length of the relay-msg option, if
+    /// it's found.
+    ///
+    /// @return Position of the first option which didn't fit in the array,
+    /// or @c end if all options have been found.
+    static size_t scanOptions6(const OptionBuffer& buf, size_t offset,
+                               size_t end, OptionView6* views,
+                               size_t max_views, size_t& count,
+                               size_t* relay_msg_offset = 0,
+                               size_t* relay_msg_len = 0);
+
     /// @brief Parses provided buffer as DHCPv6 options and creates Option objects.
     ///
     /// Parses provided buffer and stores created Option objects in options
@@ -243,6 +302,9 @@ private:
     /// Container with DHCPv4 option definitions.
     static OptionDefContainer v4option_defs_;
 
+    /// DHCPv4 option definitions indexed by option code.
+    static OptionDefinitionPtr v4option_def_table_[256];
+
     /// Container with DHCPv6 option definitions.
     static OptionDefContainer v6option_defs_;
 
@@ -48,6 +48,31 @@ typedef boost::shared_ptr<Option> OptionPtr;
 /// A collection of DHCP (v4 or v6) options
 typedef std::multimap<unsigned int, OptionPtr> OptionCollection;
 
+/// @brief Position of a DHCPv4 option in a buffer holding it in wire format.
+///
+/// It's used to refer to an option without parsing or copying it (see
+/// @c LibDHCP::scanOptions4).
+struct OptionView4 {
+    /// Option code.
+    uint8_t type_;
+    /// Length of the option data.
+    uint8_t len_;
+    /// Position of the option data (after the code and length) in the buffer.
+    uint32_t offset_;
+};
+
+/// @brief Position of a DHCPv6 option in a buffer holding it in wire format.
+///
+/// See @c LibDHCP::scanOptions6.
+struct OptionView6 {
+    /// Option code.
+    uint16_t type_;
+    /// Length of the option data.
+    uint16_t len_;
+    /// Position of the option data (after the code and length) in the buffer.
+    uint32_t offset_;
+};
+
 /// @brief This type describes a callback function to parse options from buffer.
 ///
 /// @note The last two parameters should be specified in the callback function
@@ -49,7 +49,9 @@ Pkt4::Pkt4(uint8_t msg_type, uint32_t transid)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      lazy_unpack_(false),
+      option_views_count_(0)
 {
     memset(sname_, 0, MAX_SNAME_LEN);
     memset(file_, 0, MAX_FILE_LEN);
@@ -74,7 +76,9 @@ Pkt4::Pkt4(const uint8_t* data, size_t len)
       ciaddr_(DEFAULT_ADDRESS),
       yiaddr_(DEFAULT_ADDRESS),
       siaddr_(DEFAULT_ADDRESS),
-      giaddr_(DEFAULT_ADDRESS)
+      giaddr_(DEFAULT_ADDRESS),
+      lazy_unpack_(false),
+      option_views_count_(0)
 {
     if (len < DHCPV4_PKT_HDR_LEN) {
         bundy_throw(OutOfRange, "Truncated DHCPv4 packet (len=" << len
@@ -93,6 +97,8 @@ size_t
 Pkt4::len() {
     size_t length = DHCPV4_PKT_HDR_LEN; // DHCPv4 header
 
+    unpackOptionViews();
+
     // ... and sum of lengths of all options
     for (OptionCollection::const_iterator it = options_.begin();
          it != options_.end();
@@ -152,6 +158,7 @@ Pkt4::pack() {
         // write DHCP magic cookie
         buffer_out_.writeUint32(DHCP_OPTIONS_COOKIE);
 
+        unpackOptionViews();
         LibDHCP::packOptions(buffer_out_, options_);
 
         // add END option that indicates end of options
@@ -213,12 +220,24 @@ Pkt4::unpack() {
       bundy_throw(Unexpected, "Invalid or missing DHCP magic cookie");
     }
 
-    size_t opts_len = buffer_in.getLength() - buffer_in.getPosition();
-    vector<uint8_t> opts_buffer;
+    size_t opts_offset = buffer_in.getPosition();
+    if (lazy_unpack_) {
+        // Only record where the options are. If there are too many of them,
+        // the rest is parsed below.
+        opts_offset = LibDHCP::scanOptions4(data_, opts_offset, option_views_,
+                                            MAX_OPTION_VIEWS,
+                                            option_views_count_);
+        if (opts_offset < data_.size()) {
+            // Options of the same type must be kept in the order they were
+            // received.
+            unpackOptionViews();
+        }
+    }
 
-    // Use readVector because a function which parses option requires
+    // Copy the options because a function which parses option requires
     // a vector as an input.
-    buffer_in.readVector(opts_buffer, opts_len);
+    const vector<uint8_t> opts_buffer(data_.begin() + opts_offset,
+                                      data_.end());
     if (callback_.empty()) {
         LibDHCP::unpackOptions4(opts_buffer, "dhcp4", options_);
     } else {
@@ -278,6 +297,8 @@ void Pkt4::repack() {
 
 std::string
 Pkt4::toText() {
+    unpackOptionViews();
+
     stringstream tmp;
     tmp << "localAddr=" << local_addr_ << ":" << local_port_
         << " remoteAddr=" << remote_addr_
@@ -444,6 +465,7 @@ Pkt4::addOption(boost::shared_ptr<Option> opt) {
 
 boost::shared_ptr<bundy::dhcp::Option>
 Pkt4::getOption(uint8_t type) const {
+    unpackOptionViews(type);
     OptionCollection::const_iterator x = options_.find(type);
     if (x != options_.end()) {
         return (*x).second;
@@ -453,6 +475,7 @@ Pkt4::getOption(uint8_t type) const {
 
 bool
 Pkt4::delOption(uint8_t type) {
+    unpackOptionViews(type);
     bundy::dhcp::OptionCollection::iterator x = options_.find(type);
     if (x != options_.end()) {
         options_.erase(x);
@@ -461,6 +484,52 @@ Pkt4::delOption(uint8_t type) {
     return (false); // can't find option to be deleted
 }
 
+void
+Pkt4::unpackOptionViews(uint8_t type) const {
+    for (size_t i = 0; i < option_views_count_; ++i) {
+        if (option_views_[i].type_ == type) {
+            unpackOptionView(option_views_[i]);
+        }
+    }
+}
+
+void
+Pkt4::unpackOptionViews() const {
+    for (size_t i = 0; i < option_views_count_; ++i) {
+        if (option_views_[i].type_ != DHO_PAD) {
+            unpackOptionView(option_views_[i]);
+        }
+    }
+    option_views_count_ = 0;
+}
+
+void
+Pkt4::unpackOptionView(OptionView4& view) const {
+    const uint8_t type = view.type_;
+    const OptionBufferConstIter begin = data_.begin() + view.offset_;
+    const OptionBufferConstIter end = begin + view.len_;
+
+    // Mark the view as parsed first, so a failed option isn't tried again.
+    view.type_ = DHO_PAD;
+
+    if (!callback_.empty()) {
+        // The callback parses options from a buffer in wire format, so
+        // give it the option with its code and length.
+        const OptionBuffer buf(begin - Option::OPTION4_HDR_LEN, end);
+        callback_(buf, "dhcp4", options_, NULL, NULL);
+        return;
+    }
+
+    OptionPtr opt;
+    const OptionDefinitionPtr& def = LibDHCP::getStdOptionDef4(type);
+    if (def) {
+        opt = def->optionFactory(Option::V4, type, begin, end);
+    } else {
+        opt = OptionPtr(new Option(Option::V4, type, begin, end));
+    }
+    options_.insert(std::make_pair(type, opt));
+}
+
 void
 Pkt4::updateTimestamp() {
     timestamp_ = boost::posix_time::microsec_clock::universal_time();
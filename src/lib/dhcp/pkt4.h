@@ -54,6 +54,9 @@ public:
     /// to check whether client requested broadcast response.
     const static uint16_t FLAG_BROADCAST_MASK = 0x8000;
 
+    /// Maximum number of options left unparsed by a lazy unpack()
+    const static size_t MAX_OPTION_VIEWS = 32;
+
     /// Constructor, used in replying to a message.
     ///
     /// @param msg_type type of message (e.g. DHCPDISOVER=1)
@@ -87,6 +90,12 @@ public:
     /// Will create a collection of option objects that will
     /// be stored in options_ container.
     ///
+    /// If lazy unpacking is enabled (see @c setLazyUnpack), only the
+    /// positions of the options in the received data are recorded, and
+    /// option objects are created when they are asked for. Options which
+    /// don't fit in the @c MAX_OPTION_VIEWS positions are parsed right
+    /// away.
+    ///
     /// Method with throw exception if packet parsing fails.
     void unpack();
 
@@ -512,6 +521,30 @@ public:
         callback_ = callback;
     }
 
+    /// @brief Enable or disable lazy unpacking of options.
+    ///
+    /// With lazy unpacking, unpack() only checks the framing of the options,
+    /// and an option is parsed when it is first asked for by getOption(),
+    /// or when all options are needed, e.g. by pack() or toText(). This
+    /// saves parsing (and allocating) the options the server never looks at.
+    /// The downside is that errors in the content of an option are reported
+    /// by the call parsing it rather than by unpack().
+    ///
+    /// If a callback is set, it is called with a buffer holding a single
+    /// option in wire format each time an option is parsed.
+    ///
+    /// @param lazy true to unpack options lazily.
+    void setLazyUnpack(bool lazy) {
+        lazy_unpack_ = lazy;
+    }
+
+    /// @brief Checks whether options are unpacked lazily.
+    ///
+    /// @return true if options are unpacked lazily.
+    bool getLazyUnpack() const {
+        return (lazy_unpack_);
+    }
+
     /// @brief Update packet timestamp.
     ///
     /// Updates packet timestamp. This method is invoked
@@ -600,6 +633,22 @@ private:
                          const std::vector<uint8_t>& mac_addr,
                          HWAddrPtr& hw_addr);
 
+    /// @brief Parses the options of the given type not parsed yet.
+    ///
+    /// The options are added to options_, in the order they appear in
+    /// the received data.
+    ///
+    /// @param type option type.
+    void unpackOptionViews(uint8_t type) const;
+
+    /// @brief Parses all the options not parsed yet.
+    void unpackOptionViews() const;
+
+    /// @brief Parses a single option not parsed yet.
+    ///
+    /// @param view position of the option in data_.
+    void unpackOptionView(OptionView4& view) const;
+
 protected:
 
     /// converts DHCP message type to BOOTP op type
@@ -693,7 +742,10 @@ protected:
     /// behavior must be taken into consideration before making
     /// changes to this member such as access scope restriction or
     /// data format change etc.
-    bundy::dhcp::OptionCollection options_;
+    ///
+    /// It's mutable as options unpacked lazily are added when they are
+    /// asked for.
+    mutable bundy::dhcp::OptionCollection options_;
 
     /// packet timestamp
     boost::posix_time::ptime timestamp_;
@@ -701,6 +753,17 @@ protected:
     /// A callback to be called to unpack options from the packet.
     UnpackOptionsCallback callback_;
 
+    /// Whether options are unpacked lazily
+    bool lazy_unpack_;
+
+    /// Positions in data_ of the options not parsed yet.
+    ///
+    /// Parsed ones are marked with DHO_PAD (0) type.
+    mutable OptionView4 option_views_[MAX_OPTION_VIEWS];
+
+    /// Number of entries used in option_views_
+    mutable size_t option_views_count_;
+
 }; // Pkt4 class
 
 typedef boost::shared_ptr<Pkt4> Pkt4Ptr;
@@ -24,6 +24,16 @@
 using namespace std;
 using namespace bundy::asiolink;
 
+namespace {
+
+// Relay level of the options of the message itself
+const int MESSAGE_LEVEL = -1;
+
+// Relay level of the option views already parsed
+const int PARSED_LEVEL = -2;
+
+}
+
 namespace bundy {
 namespace dhcp {
 
@@ -43,7 +53,9 @@ Pkt6::Pkt6(const uint8_t* buf, uint32_t buf_len, DHCPv6Proto proto /* = UDP */)
     remote_addr_("::"),
     local_port_(0),
     remote_port_(0),
-    buffer_out_(0) {
+    buffer_out_(0),
+    lazy_unpack_(false),
+    option_views_count_(0) {
     data_.resize(buf_len);
     memcpy(&data_[0], buf, buf_len);
 }
@@ -58,10 +70,14 @@ Pkt6::Pkt6(uint8_t msg_type, uint32_t transid, DHCPv6Proto proto /*= UDP*/) :
     remote_addr_("::"),
     local_port_(0),
     remote_port_(0),
-    buffer_out_(0) {
+    buffer_out_(0),
+    lazy_unpack_(false),
+    option_views_count_(0) {
 }
 
 uint16_t Pkt6::len() {
+    unpackOptionViews();
+
     if (relay_info_.empty()) {
         return (directLen());
     } else {
@@ -135,6 +151,8 @@ OptionPtr Pkt6::getRelayOption(uint16_t opt_type, uint8_t relay_level) {
                   << " There is no info about " << relay_level + 1 << " relay.");
     }
 
+    unpackOptionViews(opt_type, relay_level);
+
     for (OptionCollection::iterator it = relay_info_[relay_level].options_.begin();
          it != relay_info_[relay_level].options_.end(); ++it) {
         if ((*it).second->getType() == opt_type) {
@@ -198,6 +216,8 @@ Pkt6::pack() {
 
 void
 Pkt6::packUDP() {
+    unpackOptionViews();
+
     try {
         // Make sure that the buffer is empty before we start writting to it.
         buffer_out_.clear();
@@ -288,6 +308,9 @@ Pkt6::unpackUDP() {
         // once we turn this function to void.
         return (false);
     }
+    // Forget the options located by a previous lazy unpack().
+    option_views_count_ = 0;
+
     msg_type_ = data_[0];
     switch (msg_type_) {
     case DHCPV6_SOLICIT:
@@ -325,6 +348,14 @@ Pkt6::unpackMsg(OptionBuffer::const_iterator begin,
     transid_ = transid_ & 0xffffff;
 
     try {
+        if (lazy_unpack_) {
+            // Only record where the options are.
+            const OptionBufferConstIter data_begin = data_.begin();
+            scanOptionViews(begin - data_begin, end - data_begin,
+                            MESSAGE_LEVEL, NULL, NULL);
+            return (true);
+        }
+
         OptionBuffer opt_buffer(begin, end);
 
         // If custom option parsing function has been set, use this function
@@ -371,17 +402,33 @@ Pkt6::unpackRelayMsg() {
         bufsize -= DHCPV6_RELAY_HDR_LEN; // 34 bytes (1+1+16+16)
 
         try {
-            // parse the rest as options
-            OptionBuffer opt_buffer(&data_[offset], &data_[offset+bufsize]);
-
-            // If custom option parsing function has been set, use this function
-            // to parse options. Otherwise, use standard function from libdhcp.
-            if (callback_.empty()) {
-                LibDHCP::unpackOptions6(opt_buffer, "dhcp6", relay.options_,
-                                        &relay_msg_offset, &relay_msg_len);
+            if (lazy_unpack_) {
+                // Only record where the options are, without copying the
+                // rest of the message. The relay is stored first, so
+                // its options can be parsed into it later.
+                addRelayInfo(relay);
+                scanOptionViews(offset, offset + bufsize,
+                                relay_info_.size() - 1,
+                                &relay_msg_offset, &relay_msg_len);
+                if (relay_msg_len != 0) {
+                    // Make it relative, as returned by the parsers below.
+                    relay_msg_offset -= offset;
+                }
             } else {
-                callback_(opt_buffer, "dhcp6", relay.options_,
-                          &relay_msg_offset, &relay_msg_len);
+                // parse the rest as options
+                OptionBuffer opt_buffer(&data_[offset], &data_[offset+bufsize]);
+
+                // If custom option parsing function has been set, use this
+                // function to parse options. Otherwise, use standard function
+                // from libdhcp.
+                if (callback_.empty()) {
+                    LibDHCP::unpackOptions6(opt_buffer, "dhcp6",
+                                            relay.options_,
+                                            &relay_msg_offset, &relay_msg_len);
+                } else {
+                    callback_(opt_buffer, "dhcp6", relay.options_,
+                              &relay_msg_offset, &relay_msg_len);
+                }
             }
 
             /// @todo: check that each option appears at most once
@@ -393,8 +440,10 @@ Pkt6::unpackRelayMsg() {
                 bundy_throw(BadValue, "Mandatory relay-msg option missing");
             }
 
-            // store relay information parsed so far
-            addRelayInfo(relay);
+            if (!lazy_unpack_) {
+                // store relay information parsed so far
+                addRelayInfo(relay);
+            }
 
             /// @todo: implement ERO here
 
@@ -452,6 +501,8 @@ Pkt6::unpackTCP() {
 
 std::string
 Pkt6::toText() {
+    unpackOptionViews();
+
     stringstream tmp;
     tmp << "localAddr=[" << local_addr_ << "]:" << local_port_
         << " remoteAddr=[" << remote_addr_
@@ -468,6 +519,7 @@ Pkt6::toText() {
 
 OptionPtr
 Pkt6::getOption(uint16_t opt_type) {
+    unpackOptionViews(opt_type, MESSAGE_LEVEL);
     bundy::dhcp::OptionCollection::const_iterator x = options_.find(opt_type);
     if (x!=options_.end()) {
         return (*x).second;
@@ -479,6 +531,8 @@ bundy::dhcp::OptionCollection
 Pkt6::getOptions(uint16_t opt_type) {
     bundy::dhcp::OptionCollection found;
 
+    unpackOptionViews(opt_type, MESSAGE_LEVEL);
+
     for (OptionCollection::const_iterator x = options_.begin();
          x != options_.end(); ++x) {
         if (x->first == opt_type) {
@@ -490,11 +544,14 @@ Pkt6::getOptions(uint16_t opt_type) {
 
 void
 Pkt6::addOption(const OptionPtr& opt) {
+    // Received options of the same type go first.
+    unpackOptionViews(opt->getType(), MESSAGE_LEVEL);
     options_.insert(pair<int, boost::shared_ptr<Option> >(opt->getType(), opt));
 }
 
 bool
 Pkt6::delOption(uint16_t type) {
+    unpackOptionViews(type, MESSAGE_LEVEL);
     bundy::dhcp::OptionCollection::iterator x = options_.find(type);
     if (x!=options_.end()) {
         options_.erase(x);
@@ -503,6 +560,72 @@ Pkt6::delOption(uint16_t type) {
     return (false); // can't find option to be deleted
 }
 
+void
+Pkt6::scanOptionViews(size_t offset, size_t end, int relay_level,
+                      size_t* relay_msg_offset, size_t* relay_msg_len) {
+    for (;;) {
+        size_t count = 0;
+        offset = LibDHCP::scanOptions6(data_, offset, end,
+                                       option_views_ + option_views_count_,
+                                       MAX_OPTION_VIEWS - option_views_count_,
+                                       count, relay_msg_offset, relay_msg_len);
+        for (size_t i = option_views_count_; i < option_views_count_ + count;
+             ++i) {
+            option_view_levels_[i] = relay_level;
+        }
+        option_views_count_ += count;
+        if (offset == end) {
+            return;
+        }
+
+        // The array is full. Parse what's in it to make room, which also
+        // keeps the options of the same type in the order they were received.
+        unpackOptionViews();
+    }
+}
+
+void
+Pkt6::unpackOptionViews() {
+    for (size_t i = 0; i < option_views_count_; ++i) {
+        if (option_view_levels_[i] != PARSED_LEVEL) {
+            unpackOptionView(i);
+        }
+    }
+    option_views_count_ = 0;
+}
+
+void
+Pkt6::unpackOptionViews(uint16_t type, int relay_level) {
+    for (size_t i = 0; i < option_views_count_; ++i) {
+        if (option_views_[i].type_ == type &&
+            option_view_levels_[i] == relay_level) {
+            unpackOptionView(i);
+        }
+    }
+}
+
+void
+Pkt6::unpackOptionView(size_t index) {
+    const OptionView6& view = option_views_[index];
+    OptionCollection& options = (option_view_levels_[index] == MESSAGE_LEVEL ?
+                                 options_ :
+                                 relay_info_[option_view_levels_[index]].options_);
+
+    // Mark the view as parsed first, so a failed option isn't tried again.
+    option_view_levels_[index] = PARSED_LEVEL;
+
+    // The parsers take options in wire format, so give them the option
+    // with its code and length.
+    const OptionBuffer buf(data_.begin() + view.offset_ -
+                           Option::OPTION6_HDR_LEN,
+                           data_.begin() + view.offset_ + view.len_);
+    if (callback_.empty()) {
+        LibDHCP::unpackOptions6(buf, "dhcp6", options);
+    } else {
+        callback_(buf, "dhcp6", options, NULL, NULL);
+    }
+}
+
 void Pkt6::repack() {
     buffer_out_.writeData(&data_[0], data_.size());
 }
@@ -43,6 +43,9 @@ public:
     /// specifies relay DHCPv6 packet header length (over UDP)
     const static size_t DHCPV6_RELAY_HDR_LEN = 34;
 
+    /// Maximum number of options left unparsed by a lazy unpack()
+    const static size_t MAX_OPTION_VIEWS = 32;
+
     /// DHCPv6 transport protocol
     enum DHCPv6Proto {
         UDP = 0, // most packets are UDP
@@ -129,6 +132,10 @@ public:
     /// This method calls appropriate dispatch function (unpackUDP or
     /// unpackTCP).
     ///
+    /// If lazy unpacking is enabled (see @c setLazyUnpack), the options of
+    /// the message and of the relays are only located in the received data,
+    /// and they are parsed when they are asked for.
+    ///
     /// @return true if parsing was successful
     bool unpack();
 
@@ -399,6 +406,42 @@ public:
         callback_ = callback;
     }
 
+    /// @brief Enable or disable lazy unpacking of options.
+    ///
+    /// With lazy unpacking, unpack() only walks the message and its relay
+    /// encapsulations, recording the positions of the options in the
+    /// received data without copying it. An option is parsed when it is
+    /// first asked for by getOption(), getOptions(), getRelayOption() and
+    /// the like, or when all options are needed, e.g. by pack() or toText().
+    /// Options which don't fit in the @c MAX_OPTION_VIEWS positions are
+    /// parsed during unpack(). Errors in the content of an option are
+    /// reported by the call parsing it rather than by unpack().
+    ///
+    /// If a callback is set, it is called with a buffer holding a single
+    /// option in wire format each time an option is parsed.
+    ///
+    /// @note The options_ members of the packet and of its relays only
+    /// hold the parsed options. Code using them directly must call
+    /// @c unpackOptionViews() first.
+    ///
+    /// @param lazy true to unpack options lazily.
+    void setLazyUnpack(bool lazy) {
+        lazy_unpack_ = lazy;
+    }
+
+    /// @brief Checks whether options are unpacked lazily.
+    ///
+    /// @return true if options are unpacked lazily.
+    bool getLazyUnpack() const {
+        return (lazy_unpack_);
+    }
+
+    /// @brief Parses all the options not parsed yet.
+    ///
+    /// The options of the message and of the relays left by a lazy unpack()
+    /// are parsed and stored in their options_ members.
+    void unpackOptionViews();
+
     /// @brief copies relay information from client's packet to server's response
     ///
     /// This information is not simply copied over. Some parameter are
@@ -513,6 +556,38 @@ protected:
     /// @return true if parsing was successful
     bool unpackRelayMsg();
 
+    /// @brief Locates the options in a part of the received data.
+    ///
+    /// The positions of the options are recorded to be parsed later. If there
+    /// are too many of them, all the recorded options are parsed to make
+    /// room.
+    ///
+    /// @param offset Position of the first option in data_.
+    /// @param end Position of the end of the options in data_.
+    /// @param relay_level Index of the relay the options belong to in
+    /// relay_info_, or -1 for the options of the message.
+    /// @param relay_msg_offset Set to the position of the relay-msg option
+    /// data in data_, if it's found and this is not NULL.
+    /// @param relay_msg_len Set to the length of the relay-msg option, if
+    /// it's found and this is not NULL.
+    void scanOptionViews(size_t offset, size_t end, int relay_level,
+                         size_t* relay_msg_offset, size_t* relay_msg_len);
+
+    /// @brief Parses the options of the given type not parsed yet.
+    ///
+    /// The options are added to the options of the message or the relay,
+    /// in the order they appear in the received data.
+    ///
+    /// @param type option type.
+    /// @param relay_level Index of the relay in relay_info_, or -1 for
+    /// the options of the message.
+    void unpackOptionViews(uint16_t type, int relay_level);
+
+    /// @brief Parses a single option not parsed yet.
+    ///
+    /// @param index Index of the option in option_views_.
+    void unpackOptionView(size_t index);
+
     /// @brief calculates overhead introduced in specified relay
     ///
     /// It is used when calculating message size and packing message
@@ -578,6 +653,20 @@ protected:
     /// A callback to be called to unpack options from the packet.
     UnpackOptionsCallback callback_;
 
+    /// Whether options are unpacked lazily
+    bool lazy_unpack_;
+
+    /// Positions in data_ of the options not parsed yet
+    OptionView6 option_views_[MAX_OPTION_VIEWS];
+
+    /// Relay level of each entry of option_views_ (see scanOptionViews()).
+    ///
+    /// Entries already parsed are marked with -2.
+    int option_view_levels_[MAX_OPTION_VIEWS];
+
+    /// Number of entries used in option_views_
+    size_t option_views_count_;
+
 }; // Pkt6 class
 
 } // bundy::dhcp namespace
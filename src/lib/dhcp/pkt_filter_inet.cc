@@ -192,7 +192,14 @@ PktFilterInet::receive(const Iface& iface, const SocketInfo& socket_info) {
 int
 PktFilterInet::send(const Iface&, uint16_t sockfd,
                     const Pkt4Ptr& pkt) {
-    memset(&control_buf_[0], 0, control_buf_len_);
+    // The control buffer is on the stack rather than shared with receive,
+    // so that packets may be sent by several threads while another one
+    // is receiving.
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+    } control;
+    memset(&control, 0, sizeof(control));
 
     // Set the target address we're sending to.
     sockaddr_in to;
@@ -229,8 +236,8 @@ PktFilterInet::send(const Iface&, uint16_t sockfd,
     // define the IPv4 packet information. We could set the
     // source address if we wanted, but we can safely let the
     // kernel decide what that should be.
-    m.msg_control = &control_buf_[0];
-    m.msg_controllen = control_buf_len_;
+    m.msg_control = control.buf;
+    m.msg_controllen = sizeof(control.buf);
     struct cmsghdr* cmsg = CMSG_FIRSTHDR(&m);
     cmsg->cmsg_level = IPPROTO_IP;
     cmsg->cmsg_type = IP_PKTINFO;
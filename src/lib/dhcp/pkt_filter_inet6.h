@@ -88,7 +88,7 @@ public:
 private:
     /// Length of the control_buf_ array.
     size_t control_buf_len_;
-    /// Control buffer, used in transmission and reception.
+    /// Control buffer, used in reception.
     boost::scoped_array<char> control_buf_;
 };
 
@@ -639,6 +639,113 @@ TEST_F(LibDhcpTest, unpackOptions4) {
 
 }
 
+// This test verifies that the positions of DHCPv4 options are found
+// without parsing them.
+TEST_F(LibDhcpTest, scanOptions4) {
+    vector<uint8_t> v4packed(v4_opts, v4_opts + sizeof(v4_opts));
+    // Skip leading padding, and ignore what follows the END option.
+    v4packed.insert(v4packed.begin(), 3, DHO_PAD);
+    v4packed.push_back(DHO_END);
+    v4packed.push_back(12);
+
+    OptionView4 views[10];
+    size_t count = 0;
+    EXPECT_EQ(v4packed.size(),
+              LibDHCP::scanOptions4(v4packed, 1, views, 10, count));
+    ASSERT_EQ(6, count);
+    const uint8_t types[] = { 12, 60, 14, 254, 128, DHO_DHCP_AGENT_OPTIONS };
+    for (size_t i = 0; i < 5; ++i) {
+        EXPECT_EQ(types[i], views[i].type_);
+        EXPECT_EQ(3, views[i].len_);
+        EXPECT_EQ(3 + i * 5 + 2, views[i].offset_);
+    }
+    EXPECT_EQ(types[5], views[5].type_);
+    EXPECT_EQ(0x19, views[5].len_);
+    EXPECT_EQ(3 + 27, views[5].offset_);
+
+    // The rest is left when the array is full.
+    EXPECT_EQ(3 + 10, LibDHCP::scanOptions4(v4packed, 0, views, 2, count));
+    EXPECT_EQ(2, count);
+    EXPECT_EQ(3 + 20, LibDHCP::scanOptions4(v4packed, 3 + 10, views, 2,
+                                            count));
+    EXPECT_EQ(2, count);
+    EXPECT_EQ(14, views[0].type_);
+
+    // Truncated options are rejected.
+    v4packed.resize(3 + 8);
+    EXPECT_THROW(LibDHCP::scanOptions4(v4packed, 0, views, 10, count),
+                 OutOfRange);
+    v4packed.resize(3 + 6);
+    EXPECT_THROW(LibDHCP::scanOptions4(v4packed, 0, views, 10, count),
+                 OutOfRange);
+}
+
+// This test verifies that the positions of DHCPv6 options are found
+// without parsing them.
+TEST_F(LibDhcpTest, scanOptions6) {
+    OptionBuffer buf(v6packed, v6packed + sizeof(v6packed));
+
+    OptionView6 views[10];
+    size_t count = 0;
+    EXPECT_EQ(sizeof(v6packed),
+              LibDHCP::scanOptions6(buf, 0, buf.size(), views, 10, count));
+    ASSERT_EQ(6, count);
+    const uint16_t types[] = { D6O_CLIENTID, D6O_SERVERID, D6O_RAPID_COMMIT,
+                               D6O_ORO, D6O_ELAPSED_TIME, D6O_VENDOR_OPTS };
+    const uint16_t lens[] = { 5, 3, 0, 4, 2, 0x16 };
+    const uint32_t offsets[] = { 4, 13, 20, 24, 32, 38 };
+    for (size_t i = 0; i < count; ++i) {
+        EXPECT_EQ(types[i], views[i].type_);
+        EXPECT_EQ(lens[i], views[i].len_);
+        EXPECT_EQ(offsets[i], views[i].offset_);
+    }
+
+    // The rest is left when the array is full.
+    EXPECT_EQ(16, LibDHCP::scanOptions6(buf, 0, buf.size(), views, 2, count));
+    EXPECT_EQ(2, count);
+    EXPECT_EQ(28, LibDHCP::scanOptions6(buf, 16, buf.size(), views, 2,
+                                        count));
+    EXPECT_EQ(2, count);
+    EXPECT_EQ(D6O_RAPID_COMMIT, views[0].type_);
+
+    // A truncated option ends the options, as for unpackOptions6().
+    EXPECT_EQ(buf.size() - 1,
+              LibDHCP::scanOptions6(buf, 0, buf.size() - 1, views, 10,
+                                    count));
+    EXPECT_EQ(5, count);
+
+    // The relay-msg option is reported separately if requested.
+    const uint8_t relay_msg[] = { 0, D6O_RELAY_MSG, 0, 3, 1, 2, 3 };
+    buf.insert(buf.begin() + 9, relay_msg, relay_msg + sizeof(relay_msg));
+    size_t relay_msg_offset = 0;
+    size_t relay_msg_len = 0;
+    EXPECT_EQ(buf.size(),
+              LibDHCP::scanOptions6(buf, 0, buf.size(), views, 10, count,
+                                    &relay_msg_offset, &relay_msg_len));
+    EXPECT_EQ(6, count);
+    EXPECT_EQ(D6O_SERVERID, views[1].type_);
+    EXPECT_EQ(13 + sizeof(relay_msg), views[1].offset_);
+    EXPECT_EQ(13, relay_msg_offset);
+    EXPECT_EQ(3, relay_msg_len);
+
+    // Otherwise, it's just another option.
+    EXPECT_EQ(buf.size(),
+              LibDHCP::scanOptions6(buf, 0, buf.size(), views, 10, count));
+    EXPECT_EQ(7, count);
+    EXPECT_EQ(D6O_RELAY_MSG, views[1].type_);
+}
+
+// This test verifies that the table of standard DHCPv4 option definitions
+// matches the definitions.
+TEST_F(LibDhcpTest, getStdOptionDef4) {
+    for (int code = 0; code < 256; ++code) {
+        EXPECT_EQ(LibDHCP::getOptionDef(Option::V4, code),
+                  LibDHCP::getStdOptionDef4(code));
+    }
+    EXPECT_TRUE(LibDHCP::getStdOptionDef4(DHO_DHCP_AGENT_OPTIONS));
+    EXPECT_FALSE(LibDHCP::getStdOptionDef4(254));
+}
+
 TEST_F(LibDhcpTest, isStandardOption4) {
     // Get all option codes that are not occupied by standard options.
     const uint16_t unassigned_codes[] = { 84, 96, 102, 103, 104, 105, 106, 107, 108,
@@ -693,6 +693,127 @@ TEST_F(Pkt4Test, unpackOptionsWithCallback) {
 
 }
 
+// This test verifies that options can be unpacked lazily, i.e. when they
+// are asked for.
+TEST_F(Pkt4Test, unpackOptionsLazily) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    for (int i = 0; i < sizeof(v4_opts); i++) {
+        expectedFormat.push_back(v4_opts[i]);
+    }
+
+    boost::shared_ptr<Pkt4> pkt(new Pkt4(&expectedFormat[0],
+                                expectedFormat.size()));
+    EXPECT_FALSE(pkt->getLazyUnpack());
+    pkt->setLazyUnpack(true);
+    EXPECT_TRUE(pkt->getLazyUnpack());
+
+    CustomUnpackCallback cb;
+    pkt->setCallback(boost::bind(&CustomUnpackCallback::execute, &cb,
+                                 _1, _2, _3));
+
+    // Only the message type is parsed, by the check done in unpack().
+    EXPECT_NO_THROW(pkt->unpack());
+    EXPECT_TRUE(cb.executed_);
+    EXPECT_EQ(DHCPOFFER, pkt->getType());
+
+    // The others are parsed by the callback when asked for.
+    cb.executed_ = false;
+    EXPECT_TRUE(pkt->getOption(12));
+    EXPECT_TRUE(cb.executed_);
+    cb.executed_ = false;
+    EXPECT_TRUE(pkt->getOption(12));
+    EXPECT_FALSE(cb.executed_);
+    EXPECT_FALSE(pkt->getOption(127));
+    verifyParsedOptions(pkt);
+
+    // Options not parsed yet can be deleted, and can't be added again.
+    EXPECT_TRUE(pkt->delOption(60));
+    EXPECT_FALSE(pkt->getOption(60));
+    EXPECT_THROW(pkt->addOption(OptionPtr(new Option(Option::V4, 128))),
+                 BadValue);
+
+    // Without the callback, libdhcp++ parses them. All options are parsed
+    // for packing.
+    pkt.reset(new Pkt4(&expectedFormat[0], expectedFormat.size()));
+    pkt->setLazyUnpack(true);
+    EXPECT_NO_THROW(pkt->unpack());
+    EXPECT_NO_THROW(pkt->pack());
+    const OutputBuffer& buf = pkt->getBuffer();
+    ASSERT_EQ(expectedFormat.size() + 1, buf.getLength());
+    EXPECT_EQ(0, memcmp(&expectedFormat[Pkt4::DHCPV4_PKT_HDR_LEN],
+                        static_cast<const uint8_t*>(buf.getData()) +
+                        Pkt4::DHCPV4_PKT_HDR_LEN,
+                        expectedFormat.size() - Pkt4::DHCPV4_PKT_HDR_LEN));
+}
+
+// This test verifies that a lazy unpack() parses the options which don't
+// fit in the views and keeps options of the same type in order.
+TEST_F(Pkt4Test, unpackManyOptionsLazily) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    for (int i = 0; i < sizeof(v4_opts); i++) {
+        expectedFormat.push_back(v4_opts[i]);
+    }
+    // Add more options than views, the first and the last of the same type
+    for (int i = 0; i < Pkt4::MAX_OPTION_VIEWS; ++i) {
+        expectedFormat.push_back(160 + i);
+        expectedFormat.push_back(1);
+        expectedFormat.push_back(i);
+    }
+    expectedFormat.push_back(160);
+    expectedFormat.push_back(1);
+    expectedFormat.push_back(0xff);
+    expectedFormat.push_back(DHO_END);
+
+    boost::shared_ptr<Pkt4> pkt(new Pkt4(&expectedFormat[0],
+                                expectedFormat.size()));
+    pkt->setLazyUnpack(true);
+    EXPECT_NO_THROW(pkt->unpack());
+    verifyParsedOptions(pkt);
+
+    OptionPtr opt = pkt->getOption(160);
+    ASSERT_TRUE(opt);
+    EXPECT_EQ(0, opt->getUint8());
+    EXPECT_TRUE(pkt->delOption(160));
+    opt = pkt->getOption(160);
+    ASSERT_TRUE(opt);
+    EXPECT_EQ(0xff, opt->getUint8());
+    EXPECT_TRUE(pkt->getOption(160 + Pkt4::MAX_OPTION_VIEWS - 1));
+}
+
+// This test verifies that a lazy unpack() still rejects truncated options.
+TEST_F(Pkt4Test, unpackTruncatedOptionLazily) {
+    vector<uint8_t> expectedFormat = generateTestPacket2();
+
+    expectedFormat.push_back(0x63);
+    expectedFormat.push_back(0x82);
+    expectedFormat.push_back(0x53);
+    expectedFormat.push_back(0x63);
+
+    for (int i = 0; i < sizeof(v4_opts); i++) {
+        expectedFormat.push_back(v4_opts[i]);
+    }
+    expectedFormat.push_back(12);
+    expectedFormat.push_back(10);
+    expectedFormat.push_back(0);
+
+    boost::shared_ptr<Pkt4> pkt(new Pkt4(&expectedFormat[0],
+                                expectedFormat.size()));
+    pkt->setLazyUnpack(true);
+    EXPECT_THROW(pkt->unpack(), OutOfRange);
+}
+
 // This test verifies methods that are used for manipulating meta fields
 // i.e. fields that are not part of DHCPv4 (e.g. interface name).
 TEST_F(Pkt4Test, metaFields) {
@@ -59,7 +59,7 @@ public:
     ///
     /// Marks that callback hasn't been called.
     CustomUnpackCallback()
-        : executed_(false) {
+        : executed_(false), calls_(0) {
     }
 
     /// @brief A callback
@@ -84,6 +84,7 @@ public:
         // Set the executed_ member to true to allow verification that the
         // callback has been actually called.
         executed_ = true;
+        ++calls_;
         // Use default implementation of the unpack algorithm to parse options.
         return (LibDHCP::unpackOptions6(buf, option_space, options, relay_msg_offset,
                                         relay_msg_len));
@@ -91,6 +92,9 @@ public:
 
     /// A flag which indicates if callback function has been called.
     bool executed_;
+
+    /// The number of times the callback function has been called.
+    size_t calls_;
 };
 
 class Pkt6Test : public ::testing::Test {
@@ -672,6 +676,102 @@ TEST_F(Pkt6Test, relayPack) {
     EXPECT_EQ(0, memcmp(relay_opt_data, relay_opt_data, sizeof(relay_opt_data)));
 }
 
+// This test verifies that the options of a relayed message are only
+// parsed when they are asked for, if the message is unpacked lazily.
+TEST_F(Pkt6Test, relayUnpackLazily) {
+    scoped_ptr<Pkt6> msg(capture2());
+    msg->setLazyUnpack(true);
+    ASSERT_TRUE(msg->unpack());
+
+    EXPECT_EQ(DHCPV6_SOLICIT, msg->getType());
+    EXPECT_EQ(0x6b4fe2, msg->getTransid());
+
+    // The relay headers are unpacked, but no option is parsed yet.
+    ASSERT_EQ(2, msg->relay_info_.size());
+    EXPECT_EQ("fe80::200:21ff:fe5c:18a9",
+              msg->relay_info_[0].peeraddr_.toText());
+    EXPECT_TRUE(msg->relay_info_[0].options_.empty());
+    EXPECT_TRUE(msg->relay_info_[1].options_.empty());
+    EXPECT_TRUE(msg->options_.empty());
+
+    // Only the options asked for are parsed.
+    OptionPtr opt = msg->getRelayOption(D6O_INTERFACE_ID, 1);
+    ASSERT_TRUE(opt);
+    EXPECT_EQ(25, opt->len());
+    EXPECT_TRUE(msg->relay_info_[0].options_.empty());
+    EXPECT_EQ(1, msg->relay_info_[1].options_.size());
+
+    opt = msg->getAnyRelayOption(D6O_REMOTE_ID, Pkt6::RELAY_GET_LAST);
+    ASSERT_TRUE(opt);
+    EXPECT_EQ(22, opt->len());
+    EXPECT_EQ(1, msg->relay_info_[0].options_.size());
+    EXPECT_FALSE(msg->getRelayOption(D6O_IA_NA, 1));
+
+    opt = msg->getOption(D6O_IA_NA);
+    ASSERT_TRUE(opt);
+    boost::shared_ptr<Option6IA> ia =
+        boost::dynamic_pointer_cast<Option6IA>(opt);
+    ASSERT_TRUE(ia);
+    EXPECT_EQ(1, ia->getIAID());
+    EXPECT_EQ(1, msg->options_.size());
+    EXPECT_FALSE(msg->getOption(D6O_SERVERID));
+
+    // The rest is parsed when the whole message is needed.
+    EXPECT_EQ(217, msg->len());
+    EXPECT_EQ(2, msg->relay_info_[0].options_.size());
+    EXPECT_EQ(2, msg->relay_info_[1].options_.size());
+
+    scoped_ptr<Pkt6> eager(capture2());
+    ASSERT_TRUE(eager->unpack());
+    EXPECT_EQ(eager->options_.size(), msg->options_.size());
+    ASSERT_NO_THROW(eager->pack());
+    ASSERT_NO_THROW(msg->pack());
+    ASSERT_EQ(eager->getBuffer().getLength(), msg->getBuffer().getLength());
+    EXPECT_EQ(0, memcmp(eager->getBuffer().getData(),
+                        msg->getBuffer().getData(),
+                        msg->getBuffer().getLength()));
+}
+
+// This test verifies that a message with more options than can be located
+// at once is unpacked lazily, with a custom callback parsing each option.
+TEST_F(Pkt6Test, unpackManyOptionsLazily) {
+    scoped_ptr<Pkt6> parent(new Pkt6(DHCPV6_SOLICIT, 0x020304));
+    const size_t max_views = Pkt6::MAX_OPTION_VIEWS;
+    const size_t options_count = max_views + 8;
+    for (size_t i = 0; i < options_count; ++i) {
+        parent->addOption(generateRandomOption(1000 + i, i));
+    }
+    ASSERT_NO_THROW(parent->pack());
+
+    Pkt6 clone(static_cast<const uint8_t*>(parent->getBuffer().getData()),
+               parent->getBuffer().getLength());
+    CustomUnpackCallback cb;
+    clone.setCallback(boost::bind(&CustomUnpackCallback::execute, &cb,
+                                  _1, _2, _3, _4, _5));
+    clone.setLazyUnpack(true);
+    EXPECT_TRUE(clone.getLazyUnpack());
+    ASSERT_TRUE(clone.unpack());
+
+    // The options which filled the array were parsed to make room for
+    // the rest.
+    EXPECT_EQ(max_views, cb.calls_);
+
+    // The last option is parsed only when asked for.
+    OptionPtr opt = clone.getOption(1000 + options_count - 1);
+    ASSERT_TRUE(opt);
+    EXPECT_TRUE(opt->equal(parent->getOption(1000 + options_count - 1)));
+    EXPECT_EQ(max_views + 1, cb.calls_);
+
+    // All options are there, parsed once each.
+    EXPECT_EQ(parent->len(), clone.len());
+    EXPECT_EQ(options_count, cb.calls_);
+    EXPECT_EQ(options_count, clone.options_.size());
+    for (size_t i = 0; i < options_count; ++i) {
+        opt = clone.getOption(1000 + i);
+        ASSERT_TRUE(opt);
+        EXPECT_TRUE(opt->equal(parent->getOption(1000 + i)));
+    }
+}
 
 // This test verified that options added by relays to the message can be
 // accessed and retrieved properly
@@ -0,0 +1,167 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <dhcpsrv/address_index.h>
+
+#include <vector>
+
+using namespace bundy::asiolink;
+
+namespace {
+
+/// @brief Returns the address increased or decreased by one.
+///
+/// @param addr Address to be modified.
+/// @param [out] result The adjacent address. It is not modified if the
+/// address is the highest (or lowest) address of its family.
+/// @param increase true to increase the address, false to decrease it.
+///
+/// @return false if the address has no adjacent address in the requested
+/// direction.
+bool
+adjacentAddress(const IOAddress& addr, IOAddress& result, const bool increase) {
+    std::vector<uint8_t> packed = addr.toBytes();
+    const uint8_t limit = (increase ? 0xff : 0);
+    for (int i = packed.size() - 1; i >= 0; --i) {
+        if (packed[i] != limit) {
+            packed[i] += (increase ? 1 : -1);
+            result = IOAddress::fromBytes(addr.getFamily(), &packed[0]);
+            return (true);
+        }
+        // Overflow (0xff -> 0x0) or underflow (0x0 -> 0xff), continue with
+        // the next byte.
+        packed[i] = ~limit;
+    }
+    return (false);
+}
+
+}
+
+namespace bundy {
+namespace dhcp {
+
+AddressIndex::AddressIndex()
+    : used_(0) {
+}
+
+AddressIndex::RangeMap::iterator
+AddressIndex::findRange(const IOAddress& addr) {
+    // Find the last range starting at or before the address.
+    RangeMap::iterator range = ranges_.upper_bound(addr);
+    if (range == ranges_.begin()) {
+        return (ranges_.end());
+    }
+    --range;
+    if (range->first.getFamily() != addr.getFamily() ||
+        range->second < addr) {
+        return (ranges_.end());
+    }
+    return (range);
+}
+
+AddressIndex::RangeMap::const_iterator
+AddressIndex::findRange(const IOAddress& addr) const {
+    return (const_cast<AddressIndex*>(this)->findRange(addr));
+}
+
+void
+AddressIndex::add(const IOAddress& addr) {
+    if (findRange(addr) != ranges_.end()) {
+        return;
+    }
+    ++used_;
+
+    IOAddress first = addr;
+    IOAddress last = addr;
+
+    // Merge with the following range if it starts right after the address.
+    IOAddress next = addr;
+    if (adjacentAddress(addr, next, true)) {
+        RangeMap::iterator range = ranges_.find(next);
+        if (range != ranges_.end()) {
+            last = range->second;
+            ranges_.erase(range);
+        }
+    }
+
+    // Extend the preceding range if it ends right before the address.
+    IOAddress previous = addr;
+    if (adjacentAddress(addr, previous, false)) {
+        RangeMap::iterator range = findRange(previous);
+        if (range != ranges_.end()) {
+            range->second = last;
+            return;
+        }
+    }
+    ranges_.insert(RangeMap::value_type(first, last));
+}
+
+void
+AddressIndex::remove(const IOAddress& addr) {
+    RangeMap::iterator range = findRange(addr);
+    if (range == ranges_.end()) {
+        return;
+    }
+    --used_;
+
+    const IOAddress first = range->first;
+    const IOAddress last = range->second;
+    ranges_.erase(range);
+
+    // Keep the parts of the range before and after the address. Both exist
+    // if the address is not the first (last) address of the range.
+    IOAddress adjacent = addr;
+    if (first < addr && adjacentAddress(addr, adjacent, false)) {
+        ranges_.insert(RangeMap::value_type(first, adjacent));
+    }
+    if (addr < last && adjacentAddress(addr, adjacent, true)) {
+        ranges_.insert(RangeMap::value_type(adjacent, last));
+    }
+}
+
+bool
+AddressIndex::isUsed(const IOAddress& addr) const {
+    return (findRange(addr) != ranges_.end());
+}
+
+bool
+AddressIndex::findFree(const IOAddress& first, const IOAddress& last,
+                       IOAddress& free) const {
+    if (last < first) {
+        return (false);
+    }
+    RangeMap::const_iterator range = findRange(first);
+    if (range == ranges_.end()) {
+        free = first;
+        return (true);
+    }
+    // The ranges are merged when they become adjacent, so the address
+    // following the range is free.
+    IOAddress candidate = first;
+    if (!adjacentAddress(range->second, candidate, true) ||
+        last < candidate) {
+        return (false);
+    }
+    free = candidate;
+    return (true);
+}
+
+void
+AddressIndex::clear() {
+    ranges_.clear();
+    used_ = 0;
+}
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
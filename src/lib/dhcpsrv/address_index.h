@@ -0,0 +1,128 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ADDRESS_INDEX_H
+#define ADDRESS_INDEX_H
+
+#include <asiolink/io_address.h>
+
+#include <map>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief In-memory index of the addresses for which leases exist.
+///
+/// The index is maintained by the lease manager, so that the allocation
+/// engine can find a free address in a pool without querying the lease
+/// database for each candidate address. It doesn't hold the leases, only
+/// the addresses for which the lease database holds a lease (including
+/// expired leases).
+///
+/// The used addresses are stored as a set of disjoint ranges, merged when
+/// they become adjacent. Thus, a densely used pool takes little memory and
+/// the first free address following any address is found in logarithmic
+/// time, regardless of how many addresses of the pool are used. IPv4 and
+/// IPv6 addresses may be held in the same index.
+///
+/// Since the lease database may be shared with other servers, the index
+/// should be considered as a hint: an address which is free according to
+/// the index must still be checked in the lease database before it is
+/// allocated.
+class AddressIndex {
+public:
+
+    /// @brief Constructor.
+    ///
+    /// Creates an empty index.
+    AddressIndex();
+
+    /// @brief Marks the address as used.
+    ///
+    /// Adding an address which is already used is a no-op.
+    ///
+    /// @param addr Address of the lease.
+    void add(const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Marks the address as free.
+    ///
+    /// Removing an address which is not used is a no-op.
+    ///
+    /// @param addr Address of the lease.
+    void remove(const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Checks if the address is used.
+    ///
+    /// @param addr Address to be checked.
+    ///
+    /// @return true if the address is used.
+    bool isUsed(const bundy::asiolink::IOAddress& addr) const;
+
+    /// @brief Finds the first free address in the range.
+    ///
+    /// @param first The first address of the range.
+    /// @param last The last address of the range (must be of the same family
+    /// as the first address).
+    /// @param [out] free The first free address in the range. It is not
+    /// modified if all addresses in the range are used.
+    ///
+    /// @return true if a free address has been found.
+    bool findFree(const bundy::asiolink::IOAddress& first,
+                  const bundy::asiolink::IOAddress& last,
+                  bundy::asiolink::IOAddress& free) const;
+
+    /// @brief Returns the number of used addresses.
+    size_t getUsedCount() const {
+        return (used_);
+    }
+
+    /// @brief Returns the number of ranges of the used addresses.
+    ///
+    /// This is mostly useful for testing.
+    size_t getRangeCount() const {
+        return (ranges_.size());
+    }
+
+    /// @brief Marks all addresses as free.
+    void clear();
+
+private:
+
+    /// @brief Container of the ranges of the used addresses.
+    ///
+    /// It maps the first address of each range to its last address.
+    typedef std::map<bundy::asiolink::IOAddress,
+                     bundy::asiolink::IOAddress> RangeMap;
+
+    /// @brief Returns the range holding the address.
+    ///
+    /// @return Iterator pointing to the range or @c ranges_.end() if the
+    /// address is free.
+    RangeMap::iterator findRange(const bundy::asiolink::IOAddress& addr);
+
+    /// @brief Returns the range holding the address (const version).
+    RangeMap::const_iterator
+    findRange(const bundy::asiolink::IOAddress& addr) const;
+
+    /// @brief Ranges of the used addresses.
+    RangeMap ranges_;
+
+    /// @brief Number of the used addresses.
+    size_t used_;
+};
+
+} // end of bundy::dhcp namespace
+} // end of bundy namespace
+
+#endif // ADDRESS_INDEX_H
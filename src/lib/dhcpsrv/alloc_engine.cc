@@ -20,11 +20,15 @@
 #include <hooks/hooks_manager.h>
 
 #include <cstring>
+#include <ctime>
+#include <limits>
 #include <vector>
 #include <string.h>
+#include <unistd.h>
 
 using namespace bundy::asiolink;
 using namespace bundy::hooks;
+using bundy::util::thread::Mutex;
 
 namespace {
 
@@ -48,6 +52,101 @@ struct AllocEngineHooks {
 // module is called.
 AllocEngineHooks Hooks;
 
+/// @brief Converts an address to a 128-bit number held in two words.
+///
+/// @param addr address to be converted (IPv4 or IPv6)
+/// @param [out] high the most significant 64 bits
+/// @param [out] low the least significant 64 bits
+void
+addressToWords(const IOAddress& addr, uint64_t& high, uint64_t& low) {
+    const std::vector<uint8_t>& vec = addr.toBytes();
+    high = 0;
+    low = 0;
+    for (std::vector<uint8_t>::const_iterator byte = vec.begin();
+         byte != vec.end(); ++byte) {
+        high = (high << 8) | (low >> 56);
+        low = (low << 8) | *byte;
+    }
+}
+
+/// @brief Converts a 128-bit number held in two words to an address.
+///
+/// @param family address family (AF_INET or AF_INET6)
+/// @param high the most significant 64 bits
+/// @param low the least significant 64 bits
+/// @return the address (only the lowest 32 bits are used for IPv4)
+IOAddress
+wordsToAddress(const short family, uint64_t high, uint64_t low) {
+    uint8_t packed[V6ADDRESS_LEN];
+    const int len = (family == AF_INET ? V4ADDRESS_LEN : V6ADDRESS_LEN);
+    for (int i = len - 1; i >= 0; --i) {
+        packed[i] = low & 0xff;
+        low = (low >> 8) | (high << 56);
+        high >>= 8;
+    }
+    return (IOAddress::fromBytes(family, packed));
+}
+
+/// @brief Returns the number of addresses or prefixes in a pool.
+///
+/// @param pool the pool
+/// @param step number of bits of the address not in the delegated prefix
+/// (zero for address pools)
+/// @return the number, saturated at the largest 64-bit value
+uint64_t
+poolCapacity(const bundy::dhcp::Pool& pool, const unsigned step) {
+    uint64_t first_high, first_low, last_high, last_low;
+    addressToWords(pool.getFirstAddress(), first_high, first_low);
+    addressToWords(pool.getLastAddress(), last_high, last_low);
+
+    // last - first
+    uint64_t high = last_high - first_high - (last_low < first_low ? 1 : 0);
+    uint64_t low = last_low - first_low;
+
+    // Divide by the size of the prefix (step is lower than 128).
+    if (step >= 64) {
+        low = high >> (step - 64);
+        high = 0;
+    } else if (step > 0) {
+        low = (low >> step) | (high << (64 - step));
+        high >>= step;
+    }
+
+    if (high != 0 || low == std::numeric_limits<uint64_t>::max()) {
+        return (std::numeric_limits<uint64_t>::max());
+    }
+    return (low + 1);
+}
+
+/// @brief Returns an address increased by a number of addresses or prefixes.
+///
+/// @param addr address to be increased
+/// @param offset number of addresses or prefixes
+/// @param step number of bits of the address not in the delegated prefix
+/// (zero for address pools)
+/// @return the increased address
+IOAddress
+offsetAddress(const IOAddress& addr, const uint64_t offset,
+              const unsigned step) {
+    uint64_t high, low;
+    addressToWords(addr, high, low);
+
+    // offset << step
+    uint64_t offset_high = 0;
+    uint64_t offset_low = offset;
+    if (step >= 64) {
+        offset_high = offset << (step - 64);
+        offset_low = 0;
+    } else if (step > 0) {
+        offset_high = offset >> (64 - step);
+        offset_low = offset << step;
+    }
+
+    low += offset_low;
+    high += offset_high + (low < offset_low ? 1 : 0);
+    return (wordsToAddress(addr.getFamily(), high, low));
+}
+
 }; // anonymous namespace
 
 namespace bundy {
@@ -142,10 +241,136 @@ AllocEngine::IterativeAllocator::increasePrefix(const bundy::asiolink::IOAddress
 }
 
 
+bool
+AllocEngine::Allocator::findFreeAddress(const SubnetPtr& subnet,
+                                        const IOAddress& start,
+                                        IOAddress& free) const {
+    const AddressIndex& index =
+        LeaseMgrFactory::instance().getAddressIndex();
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+
+    // Find the pool holding the start address.
+    size_t start_pool = 0;
+    while (start_pool < pools.size() && !pools[start_pool]->inRange(start)) {
+        ++start_pool;
+    }
+    if (start_pool == pools.size()) {
+        return (false);
+    }
+
+    // Search the remainder of that pool, then the following pools and
+    // finally the beginning of the pool holding the start address.
+    if (index.findFree(start, pools[start_pool]->getLastAddress(), free)) {
+        return (true);
+    }
+    for (size_t i = 1; i <= pools.size(); ++i) {
+        const PoolPtr& pool = pools[(start_pool + i) % pools.size()];
+        if (index.findFree(pool->getFirstAddress(), pool->getLastAddress(),
+                           free)) {
+            return (true);
+        }
+    }
+    return (false);
+}
+
+bool
+AllocEngine::Allocator::findFreeFromOffset(const SubnetPtr& subnet,
+                                           const uint64_t offset,
+                                           IOAddress& free) const {
+    const IOAddress start = addressAtOffset(subnet, offset);
+    if (pool_type_ != Lease::TYPE_PD) {
+        return (findFreeAddress(subnet, start, free));
+    }
+
+    // The prefixes are checked one by one. There can't be more used
+    // prefixes than leases in the index, so if the pools hold more
+    // prefixes one of the checked prefixes is free.
+    const AddressIndex& index =
+        LeaseMgrFactory::instance().getAddressIndex();
+    const uint64_t limit = index.getUsedCount() + 1;
+    IOAddress prefix = start;
+    for (uint64_t i = 0; i < limit; ++i) {
+        if (i > 0) {
+            prefix = addressAtOffset(subnet, offset + i);
+            if (prefix == start) {
+                // We have wrapped around the pools.
+                break;
+            }
+        }
+        if (!index.isUsed(prefix)) {
+            free = prefix;
+            return (true);
+        }
+    }
+    return (false);
+}
+
+bundy::asiolink::IOAddress
+AllocEngine::Allocator::addressAtOffset(const SubnetPtr& subnet,
+                                        uint64_t offset) const {
+    const PoolCollection& pools = subnet->getPools(pool_type_);
+    if (pools.empty()) {
+        bundy_throw(AllocFailed, "No pools defined in selected subnet");
+    }
+
+    // Get the number of addresses (or delegated prefixes) in each pool and
+    // in all pools, saturating at the largest 64-bit value.
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> capacities;
+    std::vector<unsigned> steps;
+    uint64_t total = 0;
+    for (PoolCollection::const_iterator pool = pools.begin();
+         pool != pools.end(); ++pool) {
+        unsigned step = 0;
+        if (pool_type_ == Lease::TYPE_PD) {
+            Pool6Ptr pool6 = boost::dynamic_pointer_cast<Pool6>(*pool);
+            if (!pool6) {
+                bundy_throw(Unexpected, "Wrong type of pool: "
+                            << (*pool)->toText() << " is not Pool6");
+            }
+            step = 128 - pool6->getLength();
+        }
+        const uint64_t capacity = poolCapacity(**pool, step);
+        capacities.push_back(capacity);
+        steps.push_back(step);
+        total = (max - total < capacity) ? max : total + capacity;
+    }
+
+    // Every pool holds at least one address, so the total is not zero.
+    offset %= total;
+    for (size_t i = 0; i < pools.size(); ++i) {
+        if (offset < capacities[i]) {
+            return (offsetAddress(pools[i]->getFirstAddress(), offset,
+                                  steps[i]));
+        }
+        offset -= capacities[i];
+    }
+    // Not reached: the offset is lower than the sum of the capacities.
+    return (pools[0]->getFirstAddress());
+}
+
 bundy::asiolink::IOAddress
 AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
-                                             const DuidPtr&,
-                                             const IOAddress&) {
+                                             const DuidPtr& duid,
+                                             const IOAddress& hint) {
+    IOAddress next = pickNextAddress(subnet, duid, hint);
+
+    // Skip the addresses for which leases exist. Prefixes are not indexed
+    // as they are not adjacent addresses. If all addresses are leased, the
+    // next address is returned so that the expired leases are reused.
+    IOAddress free = next;
+    if (pool_type_ != Lease::TYPE_PD &&
+        findFreeAddress(subnet, next, free)) {
+        subnet->setLastAllocated(pool_type_, free);
+        return (free);
+    }
+    return (next);
+}
+
+bundy::asiolink::IOAddress
+AllocEngine::IterativeAllocator::pickNextAddress(const SubnetPtr& subnet,
+                                                 const DuidPtr&,
+                                                 const IOAddress&) {
 
     // Is this prefix allocation?
     bool prefix = pool_type_ == Lease::TYPE_PD;
@@ -218,29 +443,61 @@ AllocEngine::IterativeAllocator::pickAddress(const SubnetPtr& subnet,
 }
 
 AllocEngine::HashedAllocator::HashedAllocator(Lease::Type lease_type)
-    :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
+    :Allocator(lease_type), exhausted_(0) {
 }
 
+uint64_t
+AllocEngine::HashedAllocator::hashDuid(const DuidPtr& duid) {
+    // 64-bit FNV-1a offset basis and prime.
+    uint64_t hash = 0xcbf29ce484222325ull;
+    if (duid) {
+        const std::vector<uint8_t>& data = duid->getDuid();
+        for (std::vector<uint8_t>::const_iterator byte = data.begin();
+             byte != data.end(); ++byte) {
+            hash ^= *byte;
+            hash *= 0x100000001b3ull;
+        }
+    }
+    return (hash);
+}
 
 bundy::asiolink::IOAddress
-AllocEngine::HashedAllocator::pickAddress(const SubnetPtr&,
-                                          const DuidPtr&,
+AllocEngine::HashedAllocator::pickAddress(const SubnetPtr& subnet,
+                                          const DuidPtr& duid,
                                           const IOAddress&) {
-    bundy_throw(NotImplemented, "Hashed allocator is not implemented");
+    const uint64_t hash = hashDuid(duid);
+
+    // The hashed address, or the first free address following it.
+    IOAddress free("::");
+    if (findFreeFromOffset(subnet, hash, free)) {
+        exhausted_ = 0;
+        return (free);
+    }
+
+    // All addresses are leased. Walk over the addresses from the hashed
+    // one, so the allocation engine can find the expired leases.
+    return (addressAtOffset(subnet, hash + exhausted_++));
 }
 
 AllocEngine::RandomAllocator::RandomAllocator(Lease::Type lease_type)
     :Allocator(lease_type) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+    rng_.seed(time(NULL) ^ getpid());
 }
 
-
 bundy::asiolink::IOAddress
-AllocEngine::RandomAllocator::pickAddress(const SubnetPtr&,
+AllocEngine::RandomAllocator::pickAddress(const SubnetPtr& subnet,
                                           const DuidPtr&,
                                           const IOAddress&) {
-    bundy_throw(NotImplemented, "Random allocator is not implemented");
+    const uint64_t offset = (static_cast<uint64_t>(rng_()) << 32) | rng_();
+
+    // The random address, or the first free address following it. If all
+    // addresses are leased, the random address is returned so the
+    // allocation engine can find the expired leases.
+    IOAddress free("::");
+    if (findFreeFromOffset(subnet, offset, free)) {
+        return (free);
+    }
+    return (addressAtOffset(subnet, offset));
 }
 
 
@@ -302,6 +559,8 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                              Lease6Collection& old_leases) {
 
     try {
+        Mutex::Locker lease_locker(LeaseMgrFactory::instance().getMutex());
+
         AllocatorPtr allocator = getAllocator(type);
 
         if (!allocator) {
@@ -459,6 +718,9 @@ AllocEngine::allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
                     collection.push_back(existing);
                     return (collection);
                 }
+                // The lease may have been added by another server sharing
+                // the lease database, so the allocator has not known it.
+                LeaseMgrFactory::instance().getAddressIndex().add(candidate);
             }
 
             // Continue trying allocation until we run out of attempts
@@ -492,6 +754,7 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
     old_lease.reset();
 
     try {
+        Mutex::Locker lease_locker(LeaseMgrFactory::instance().getMutex());
 
         AllocatorPtr allocator = getAllocator(Lease::TYPE_V4);
 
@@ -625,6 +888,9 @@ AllocEngine::allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid
                                               hostname, callout_handle,
                                               fake_allocation));
                 }
+                // The lease may have been added by another server sharing
+                // the lease database, so the allocator has not known it.
+                LeaseMgrFactory::instance().getAddressIndex().add(candidate);
             }
 
             // Continue trying allocation until we run out of attempts
@@ -22,6 +22,7 @@
 #include <dhcpsrv/lease_mgr.h>
 #include <hooks/callout_handle.h>
 
+#include <boost/random/mersenne_twister.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/noncopyable.hpp>
 
@@ -100,6 +101,52 @@ protected:
         }
     protected:
 
+        /// @brief Finds the first free address in the pools of a subnet
+        ///
+        /// The pools are searched from the specified address, wrapping
+        /// around to the first pool, according to the address index of the
+        /// lease manager.
+        ///
+        /// @param subnet subnet to search
+        /// @param start address to start the search from
+        /// @param [out] free the free address found
+        /// @return true if a free address has been found
+        bool findFreeAddress(const SubnetPtr& subnet,
+                             const bundy::asiolink::IOAddress& start,
+                             bundy::asiolink::IOAddress& free) const;
+
+        /// @brief Finds the first free address or prefix at or after an
+        /// offset in the pools of a subnet
+        ///
+        /// This is the counterpart of @c findFreeAddress for the allocators
+        /// which pick an offset rather than an address. For prefix pools,
+        /// the delegated prefixes are checked one by one in the address
+        /// index, as they are not adjacent addresses. At most as many
+        /// prefixes as there are leases in the index are checked.
+        ///
+        /// @param subnet subnet to search
+        /// @param offset offset to start the search from (see
+        /// @c addressAtOffset)
+        /// @param [out] free the free address or prefix found
+        /// @return true if a free address or prefix has been found
+        bool findFreeFromOffset(const SubnetPtr& subnet, uint64_t offset,
+                                bundy::asiolink::IOAddress& free) const;
+
+        /// @brief Returns the address at the given offset in the pools
+        ///
+        /// The pools of the subnet are considered as a single sequence of
+        /// addresses (or delegated prefixes for prefix pools) and the
+        /// offset is taken modulo its length, so any value maps to an
+        /// address in one of the pools. If the pools hold more than 2^64
+        /// addresses, the offset is counted from the first pool.
+        ///
+        /// @param subnet an address will be returned from pool of that subnet
+        /// @param offset offset of the address
+        /// @return address at the offset
+        /// @throw AllocFailed if the subnet has no pools
+        bundy::asiolink::IOAddress
+        addressAtOffset(const SubnetPtr& subnet, uint64_t offset) const;
+
         /// @brief defines pool type allocation
         Lease::Type pool_type_;
     };
@@ -124,6 +171,13 @@ protected:
 
         /// @brief returns the next address from pools in a subnet
         ///
+        /// The addresses for which the lease manager holds leases (as
+        /// recorded in its @c AddressIndex) are skipped, so the returned
+        /// address is usually free and the allocation engine doesn't need
+        /// to query the lease database for many candidates when the pools
+        /// are almost fully leased. If all addresses are leased, the next
+        /// address is returned, so the expired leases can be reused.
+        ///
         /// @param subnet next address will be returned from pool of that subnet
         /// @param duid Client's DUID (ignored)
         /// @param hint client's hint (ignored)
@@ -134,6 +188,18 @@ protected:
                         const bundy::asiolink::IOAddress& hint);
     protected:
 
+        /// @brief returns the next address from pools in a subnet
+        ///
+        /// Unlike @c pickAddress, this method doesn't skip leased addresses.
+        ///
+        /// @param subnet next address will be returned from pool of that subnet
+        /// @param duid Client's DUID (ignored)
+        /// @param hint client's hint (ignored)
+        /// @return the next address
+        bundy::asiolink::IOAddress
+        pickNextAddress(const SubnetPtr& subnet, const DuidPtr& duid,
+                        const bundy::asiolink::IOAddress& hint);
+
         /// @brief Returns an address increased by one
         ///
         /// This method works for both IPv4 and IPv6 addresses. For example,
@@ -161,41 +227,67 @@ protected:
 
     /// @brief Address/prefix allocator that gets an address based on a hash
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// This allocator hashes the client's DUID (or client identifier) to
+    /// an offset in the pools of the subnet, so a returning client gets
+    /// the same address as long as it is free. If the hashed address is
+    /// leased, the first free address following it is returned, according
+    /// to the @c AddressIndex of the lease manager. Hence, a collision
+    /// doesn't require rehashing nor probing the lease database.
     class HashedAllocator : public Allocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief default constructor
         /// @param type - specifies allocation type
         HashedAllocator(Lease::Type type);
 
         /// @brief returns an address based on hash calculated from client's DUID.
         ///
-        /// @todo: Implement this method
+        /// If all addresses are leased according to the address index, the
+        /// addresses following the hashed address are returned by the
+        /// subsequent calls, so the expired leases can be reused.
         ///
         /// @param subnet an address will be picked from pool of that subnet
-        /// @param duid Client's DUID
-        /// @param hint a hint (last address that was picked)
+        /// @param duid Client's DUID (may be null)
+        /// @param hint a hint (last address that was picked, ignored)
         /// @return selected address
         virtual bundy::asiolink::IOAddress pickAddress(const SubnetPtr& subnet,
                                                      const DuidPtr& duid,
                                                      const bundy::asiolink::IOAddress& hint);
+
+        /// @brief Returns the hash of the DUID.
+        ///
+        /// This is the 64-bit FNV-1a hash of the DUID. It is public for
+        /// testing.
+        ///
+        /// @param duid Client's DUID (may be null)
+        /// @return hash of the DUID
+        static uint64_t hashDuid(const DuidPtr& duid);
+
+    private:
+
+        /// @brief Number of the addresses returned while the pools were
+        /// fully leased.
+        uint64_t exhausted_;
     };
 
     /// @brief Random allocator that picks address randomly
     ///
-    /// @todo: This is a skeleton class for now and is missing implementation.
+    /// This allocator picks a random address in the pools of the subnet.
+    /// If that address is leased, the first free address following it is
+    /// returned, according to the @c AddressIndex of the lease manager, so
+    /// the number of attempts doesn't grow as the pools are depleted. This
+    /// allocator is suitable for the temporary addresses.
     class RandomAllocator : public Allocator {
     public:
 
-        /// @brief default constructor (does nothing)
+        /// @brief default constructor
+        ///
+        /// Seeds the random number generator.
         /// @param type - specifies allocation type
         RandomAllocator(Lease::Type type);
 
         /// @brief returns an random address from pool of specified subnet
         ///
-        /// @todo: Implement this method
-        ///
         /// @param subnet an address will be picked from pool of that subnet
         /// @param duid Client's DUID (ignored)
         /// @param hint the last address that was picked (ignored)
@@ -203,6 +295,11 @@ protected:
         virtual bundy::asiolink::IOAddress
         pickAddress(const SubnetPtr& subnet, const DuidPtr& duid,
                     const bundy::asiolink::IOAddress& hint);
+
+    private:
+
+        /// @brief Random number generator
+        boost::mt19937 rng_;
     };
 
     public:
@@ -273,6 +370,8 @@ protected:
     ///        lease. The NULL pointer indicates that lease didn't exist prior
     ///        to calling this function (e.g. new lease has been allocated).
     ///
+    /// The mutex of the lease manager is held during the allocation.
+    ///
     /// @return Allocated IPv4 lease (or NULL if allocation failed)
     Lease4Ptr
     allocateLease4(const SubnetPtr& subnet, const ClientIdPtr& clientid,
@@ -305,6 +404,8 @@ protected:
     ///        will be executed if this parameter is passed.
     /// @param fake_allocation Is this real i.e. REQUEST (false) or just picking
     ///        an address for DISCOVER that is not really allocated (true)
+    ///
+    /// The caller must hold the mutex of the lease manager.
     Lease4Ptr
     renewLease4(const SubnetPtr& subnet,
                 const ClientIdPtr& clientid,
@@ -344,6 +445,8 @@ protected:
     ///        leases (not renewed) the NULL pointers are stored in this
     ///        collection as old leases.
     ///
+    /// The mutex of the lease manager is held during the allocation.
+    ///
     /// @return Allocated IPv6 leases (may be empty if allocation failed)
     Lease6Collection
     allocateLeases6(const Subnet6Ptr& subnet, const DuidPtr& duid,
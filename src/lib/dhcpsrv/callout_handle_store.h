@@ -18,9 +18,53 @@
 #include <hooks/hooks_manager.h>
 #include <hooks/callout_handle.h>
 
+#include <pthread.h>
+
 namespace bundy {
 namespace dhcp {
 
+/// @brief Data stored by @c getCalloutHandle for a thread.
+///
+/// This is an implementation detail of @c getCalloutHandle.
+template <typename T>
+struct CalloutHandleStore {
+    T pointer;                              // Pointer to last packet seen
+    bundy::hooks::CalloutHandlePtr handle;  // Pointer to stored handle
+
+    /// @brief Returns the data of the calling thread.
+    ///
+    /// The data is created on first use in the thread and deleted when
+    /// the thread exits.
+    static CalloutHandleStore& get() {
+        pthread_once(&once_, &CalloutHandleStore::createKey);
+        CalloutHandleStore* store =
+            static_cast<CalloutHandleStore*>(pthread_getspecific(key_));
+        if (!store) {
+            store = new CalloutHandleStore();
+            pthread_setspecific(key_, store);
+        }
+        return (*store);
+    }
+
+private:
+    static void createKey() {
+        pthread_key_create(&key_, &CalloutHandleStore::destroy);
+    }
+
+    static void destroy(void* store) {
+        delete static_cast<CalloutHandleStore*>(store);
+    }
+
+    static pthread_key_t key_;
+    static pthread_once_t once_;
+};
+
+template <typename T>
+pthread_key_t CalloutHandleStore<T>::key_;
+
+template <typename T>
+pthread_once_t CalloutHandleStore<T>::once_ = PTHREAD_ONCE_INIT;
+
 /// @brief CalloutHandle Store
 ///
 /// When using the Hooks Framework, there is a need to associate an
@@ -40,10 +84,9 @@ namespace dhcp {
 /// CalloutHandle.  As the stored pointers are shared pointers, clearing them
 /// removes one reference that keeps the pointed-to objects in existence.
 ///
-/// @note If the behaviour of the server changes so that multiple packets can
-///       be active at the same time, this simplistic approach will no longer
-///       be adequate and a more complicated structure (such as a map) will
-///       be needed.
+/// @note The servers may process packets in several threads, each thread
+///       processing a single request at a time. The stored pointers are
+///       therefore kept for each thread.
 ///
 /// @param pktptr Pointer to the packet being processed.  This is typically a
 ///        Pkt4Ptr or Pkt6Ptr object.  An empty pointer is passed to clear
@@ -57,10 +100,11 @@ namespace dhcp {
 template <typename T>
 bundy::hooks::CalloutHandlePtr getCalloutHandle(const T& pktptr) {
 
-    // Stored data is declared static, so is initialized when first accessed
-    static T stored_pointer;                // Pointer to last packet seen
-    static bundy::hooks::CalloutHandlePtr stored_handle;
-                                            // Pointer to stored handle
+    // Stored data is kept for each thread, and is initialized when first
+    // accessed by the thread
+    CalloutHandleStore<T>& store = CalloutHandleStore<T>::get();
+    T& stored_pointer = store.pointer;
+    bundy::hooks::CalloutHandlePtr& stored_handle = store.handle;
 
     if (pktptr) {
 
@@ -18,6 +18,7 @@
 #include <dhcpsrv/lease_mgr_factory.h>
 
 #include <boost/foreach.hpp>
+#include <boost/lexical_cast.hpp>
 
 #include <map>
 #include <string>
@@ -57,14 +58,19 @@ DbAccessParser::build(bundy::data::ConstElementPtr config_value) {
 
     // 3. Update the copy with the passed keywords.
     BOOST_FOREACH(ConfigPair param, config_value->mapValue()) {
-        // The persist parameter is the only boolean parameter at the
-        // moment. It needs special handling.
-        if (param.first != "persist") {
-            values_copy[param.first] = param.second->stringValue();
-
-        } else {
+        // The persist parameter is the only boolean parameter and the
+        // lfc-interval is the only integer parameter at the moment. They
+        // need special handling.
+        if (param.first == "persist") {
             values_copy[param.first] = (param.second->boolValue() ?
                                         "true" : "false");
+
+        } else if (param.first == "lfc-interval") {
+            values_copy[param.first] =
+                boost::lexical_cast<std::string>(param.second->intValue());
+
+        } else {
+            values_copy[param.first] = param.second->stringValue();
         }
     }
 
@@ -57,5 +57,19 @@ LeaseMgr::getLease6(Lease::Type type, const DUID& duid,
     return (*col.begin());
 }
 
+void
+LeaseMgr::rebuildAddressIndex(const Lease4Collection& leases4,
+                              const Lease6Collection& leases6) {
+    address_index_.clear();
+    for (Lease4Collection::const_iterator lease = leases4.begin();
+         lease != leases4.end(); ++lease) {
+        address_index_.add((*lease)->addr_);
+    }
+    for (Lease6Collection::const_iterator lease = leases6.begin();
+         lease != leases6.end(); ++lease) {
+        address_index_.add((*lease)->addr_);
+    }
+}
+
 } // namespace bundy::dhcp
 } // namespace bundy
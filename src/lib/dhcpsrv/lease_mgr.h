@@ -19,9 +19,11 @@
 #include <dhcp/duid.h>
 #include <dhcp/option.h>
 #include <dhcp/hwaddr.h>
+#include <dhcpsrv/address_index.h>
 #include <dhcpsrv/lease.h>
 #include <dhcpsrv/subnet.h>
 #include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
@@ -375,6 +377,60 @@ public:
     /// @brief returns value of the parameter
     virtual std::string getParameter(const std::string& name) const;
 
+    /// @brief Returns the index of the addresses for which leases exist.
+    ///
+    /// The index is updated by the backend when leases are added or deleted
+    /// and rebuilt when the backend is created. The allocation engine uses
+    /// it to skip addresses which are known to be leased, without querying
+    /// the database for each of them.
+    ///
+    /// The non-const version allows the allocation engine to mark addresses
+    /// as used when it finds leases which are not in the index, e.g. leases
+    /// added by another server sharing the database.
+    ///
+    /// Note: This method is not virtual on purpose. It is common for all
+    /// backends.
+    ///
+    /// @return Reference to the address index.
+    AddressIndex& getAddressIndex() {
+        return (address_index_);
+    }
+
+    /// @brief Returns the index of the addresses for which leases exist.
+    ///
+    /// @return Const reference to the address index.
+    const AddressIndex& getAddressIndex() const {
+        return (address_index_);
+    }
+
+    /// @brief Returns the mutex serializing the use of the lease manager.
+    ///
+    /// The backends are not thread safe. When the server processes packets
+    /// in several threads, the callers hold this mutex for as long as they
+    /// use the lease manager, the address index or the leases returned by
+    /// it, which may be shared with the backend. The backends don't lock
+    /// it themselves.
+    ///
+    /// @return Reference to the mutex.
+    bundy::util::thread::Mutex& getMutex() const {
+        return (mutex_);
+    }
+
+protected:
+
+    /// @brief Rebuilds the address index from the leases.
+    ///
+    /// The backends call this method when they are created, with all
+    /// leases held in the database.
+    ///
+    /// @param leases4 All IPv4 leases.
+    /// @param leases6 All IPv6 leases.
+    void rebuildAddressIndex(const Lease4Collection& leases4,
+                             const Lease6Collection& leases6);
+
+    /// @brief Index of the addresses for which leases exist.
+    AddressIndex address_index_;
+
 private:
     /// @brief list of parameters passed in dbconfig
     ///
@@ -382,6 +438,9 @@ private:
     /// password and other parameters required for DB access. It is not
     /// intended to keep any DHCP-related parameters.
     ParameterMap parameters_;
+
+    /// @brief Mutex returned by @c getMutex.
+    mutable bundy::util::thread::Mutex mutex_;
 };
 
 }; // end of bundy::dhcp namespace
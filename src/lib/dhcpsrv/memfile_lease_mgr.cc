@@ -16,13 +16,142 @@
 #include <dhcpsrv/dhcpsrv_log.h>
 #include <dhcpsrv/memfile_lease_mgr.h>
 #include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
 
+#include <boost/bind.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <limits>
+#include <vector>
+
+#include <sys/stat.h>
 
 using namespace bundy::dhcp;
+using bundy::util::thread::Mutex;
+using bundy::util::thread::Thread;
+
+namespace {
+
+/// @brief Checks if the specified file exists.
+bool
+fileExists(const std::string& file_name) {
+    struct stat st;
+    return (stat(file_name.c_str(), &st) == 0);
+}
+
+/// @brief Writes leases to a new lease file.
+///
+/// @tparam LeaseFileType Type of the lease file: @c CSVLeaseFile4 or
+/// @c CSVLeaseFile6.
+/// @tparam LeasePtrType Type of the pointer to the lease.
+template <typename LeaseFileType, typename LeasePtrType>
+void
+writeLeaseFile(const std::string& file_name,
+               const std::vector<LeasePtrType>& leases)
+{
+    LeaseFileType lease_file(file_name);
+    lease_file.recreate();
+    for (typename std::vector<LeasePtrType>::const_iterator lease =
+             leases.begin(); lease != leases.end(); ++lease) {
+        lease_file.append(**lease);
+    }
+    lease_file.flush();
+    lease_file.close();
+}
+
+}
+
+/// @brief Snapshot of the leases written by the LFC thread.
+///
+/// The leases are copied when the LFC is started, so the LFC thread doesn't
+/// share any data with the thread updating leases, except for the
+/// completion status, which is protected by a mutex.
+class Memfile_LeaseMgr::LFCTask {
+public:
+    /// @brief Constructor.
+    ///
+    /// @param u Universe (V4 or V6).
+    /// @param lease_file Name of the (current) lease file.
+    LFCTask(const Universe u, const std::string& lease_file) :
+        universe_(u), lease_file_(lease_file), done_(false)
+    {}
+
+    /// @brief Writes the snapshot and replaces the lease files with it.
+    ///
+    /// This is run in the LFC thread.
+    void run() {
+        std::string error;
+        try {
+            const std::string output = appendSuffix(lease_file_, FILE_OUTPUT);
+            if (universe_ == V4) {
+                writeLeaseFile<CSVLeaseFile4>(output, leases4_);
+            } else {
+                writeLeaseFile<CSVLeaseFile6>(output, leases6_);
+            }
+            // Once the snapshot has replaced the old one, the rotated lease
+            // file isn't needed anymore.
+            if (rename(output.c_str(),
+                       appendSuffix(lease_file_, FILE_SNAPSHOT).c_str())
+                != 0) {
+                bundy_throw(DbOperationError, "failed to rename '" << output
+                            << "': " << strerror(errno));
+            }
+            const std::string previous =
+                appendSuffix(lease_file_, FILE_PREVIOUS);
+            if (unlink(previous.c_str()) != 0 && errno != ENOENT) {
+                bundy_throw(DbOperationError, "failed to remove '"
+                            << previous << "': " << strerror(errno));
+            }
+        } catch (const std::exception& ex) {
+            error = ex.what();
+        }
+        // Release the memory of the snapshot before reporting completion.
+        std::vector<Lease4Ptr>().swap(leases4_);
+        std::vector<Lease6Ptr>().swap(leases6_);
+
+        Mutex::Locker locker(mutex_);
+        error_ = error;
+        done_ = true;
+    }
+
+    /// @brief Checks if the snapshot has been written.
+    bool isDone() {
+        Mutex::Locker locker(mutex_);
+        return (done_);
+    }
+
+    /// @brief Returns the error of the LFC (empty if it succeeded).
+    std::string getError() {
+        Mutex::Locker locker(mutex_);
+        return (error_);
+    }
+
+    /// @brief Universe of the leases.
+    const Universe universe_;
+
+    /// @brief Name of the lease file.
+    const std::string lease_file_;
+
+    /// @brief Copy of the DHCPv4 leases to be written.
+    std::vector<Lease4Ptr> leases4_;
+
+    /// @brief Copy of the DHCPv6 leases to be written.
+    std::vector<Lease6Ptr> leases6_;
+
+private:
+    Mutex mutex_;
+    bool done_;
+    std::string error_;
+};
 
 Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
-    : LeaseMgr(parameters) {
+    : LeaseMgr(parameters), lfc_interval_(initLFCInterval()),
+      lfc_last_(time(NULL)) {
     // Check the universe and use v4 file or v6 file.
     std::string universe = getParameter("universe");
     if (universe == "4") {
@@ -51,6 +180,7 @@ Memfile_LeaseMgr::Memfile_LeaseMgr(const ParameterMap& parameters)
 }
 
 Memfile_LeaseMgr::~Memfile_LeaseMgr() {
+    waitLFC();
     if (lease_file4_) {
         lease_file4_->close();
         lease_file4_.reset();
@@ -79,6 +209,8 @@ Memfile_LeaseMgr::addLease(const Lease4Ptr& lease) {
     }
 
     storage4_.insert(lease);
+    address_index_.add(lease->addr_);
+    scheduleLFC();
     return (true);
 }
 
@@ -100,6 +232,8 @@ Memfile_LeaseMgr::addLease(const Lease6Ptr& lease) {
     }
 
     storage6_.insert(lease);
+    address_index_.add(lease->addr_);
+    scheduleLFC();
     return (true);
 }
 
@@ -307,6 +441,7 @@ Memfile_LeaseMgr::updateLease4(const Lease4Ptr& lease) {
     }
 
     **lease_it = *lease;
+    scheduleLFC();
 }
 
 void
@@ -328,6 +463,7 @@ Memfile_LeaseMgr::updateLease6(const Lease6Ptr& lease) {
     }
 
     **lease_it = *lease;
+    scheduleLFC();
 }
 
 bool
@@ -351,6 +487,8 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
                 lease_file4_->append(lease_copy);
             }
             storage4_.erase(l);
+            address_index_.remove(addr);
+            scheduleLFC();
             return (true);
         }
 
@@ -372,6 +510,8 @@ Memfile_LeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
             }
 
             storage6_.erase(l);
+            address_index_.remove(addr);
+            scheduleLFC();
             return (true);
         }
     }
@@ -425,6 +565,137 @@ Memfile_LeaseMgr::persistLeases(Universe u) const {
     return (u == V6 && lease_file6_);
 }
 
+std::string
+Memfile_LeaseMgr::appendSuffix(const std::string& file_name,
+                               const LFCFileType file_type) {
+    switch (file_type) {
+    case FILE_SNAPSHOT:
+        return (file_name + ".1");
+    case FILE_PREVIOUS:
+        return (file_name + ".2");
+    case FILE_OUTPUT:
+        return (file_name + ".output");
+    default:
+        ;
+    }
+    return (file_name);
+}
+
+bool
+Memfile_LeaseMgr::startLFC() {
+    if (!persistLeases(V4) && !persistLeases(V6)) {
+        return (false);
+    }
+    if (isLFCRunning()) {
+        LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE,
+                  DHCPSRV_MEMFILE_LFC_IN_PROGRESS);
+        return (false);
+    }
+
+    const Universe u = (lease_file4_ ? V4 : V6);
+    const std::string lease_file = getLeaseFilePath(u);
+    lfc_last_ = time(NULL);
+
+    // Move the lease file aside and continue with a new one. If the rotated
+    // file of an earlier LFC still exists, it hasn't been merged into the
+    // snapshot yet, so the current file is kept: the new snapshot covers
+    // both.
+    const std::string previous = appendSuffix(lease_file, FILE_PREVIOUS);
+    if (!fileExists(previous)) {
+        if (u == V4) {
+            lease_file4_->close();
+        } else {
+            lease_file6_->close();
+        }
+        const bool renamed = (rename(lease_file.c_str(),
+                                     previous.c_str()) == 0);
+        const int rename_error = errno;
+        if (u == V4) {
+            lease_file4_->open();
+        } else {
+            lease_file6_->open();
+        }
+        if (!renamed) {
+            bundy_throw(DbOperationError, "failed to rename the lease file '"
+                        << lease_file << "' to '" << previous << "': "
+                        << strerror(rename_error));
+        }
+    }
+
+    // Copy the leases: the originals may be modified while the snapshot is
+    // being written.
+    boost::shared_ptr<LFCTask> task(new LFCTask(u, lease_file));
+    if (u == V4) {
+        task->leases4_.reserve(storage4_.size());
+        for (Lease4Storage::const_iterator lease = storage4_.begin();
+             lease != storage4_.end(); ++lease) {
+            task->leases4_.push_back(Lease4Ptr(new Lease4(**lease)));
+        }
+    } else {
+        task->leases6_.reserve(storage6_.size());
+        for (Lease6Storage::const_iterator lease = storage6_.begin();
+             lease != storage6_.end(); ++lease) {
+            task->leases6_.push_back(Lease6Ptr(new Lease6(**lease)));
+        }
+    }
+
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START).arg(lease_file)
+        .arg(u == V4 ? storage4_.size() : storage6_.size());
+    lfc_thread_.reset(new Thread(boost::bind(&LFCTask::run, task)));
+    lfc_task_ = task;
+    return (true);
+}
+
+bool
+Memfile_LeaseMgr::isLFCRunning() {
+    if (!lfc_thread_) {
+        return (false);
+    }
+    if (!lfc_task_->isDone()) {
+        return (true);
+    }
+    waitLFC();
+    return (false);
+}
+
+void
+Memfile_LeaseMgr::waitLFC() {
+    if (!lfc_thread_) {
+        return;
+    }
+    try {
+        lfc_thread_->wait();
+    } catch (const std::exception& ex) {
+        // The task catches all errors itself, so this shouldn't happen.
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAIL)
+            .arg(lfc_task_->lease_file_).arg(ex.what());
+    }
+    const std::string error = lfc_task_->getError();
+    if (error.empty()) {
+        LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_COMPLETE)
+            .arg(lfc_task_->lease_file_);
+    } else {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_FAIL)
+            .arg(lfc_task_->lease_file_).arg(error);
+    }
+    lfc_thread_.reset();
+    lfc_task_.reset();
+}
+
+void
+Memfile_LeaseMgr::scheduleLFC() {
+    if (lfc_interval_ == 0 ||
+        time(NULL) - lfc_last_ < static_cast<time_t>(lfc_interval_)) {
+        return;
+    }
+    try {
+        startLFC();
+    } catch (const std::exception& ex) {
+        LOG_ERROR(dhcpsrv_logger, DHCPSRV_MEMFILE_LFC_START_FAIL)
+            .arg(ex.what());
+    }
+}
+
 std::string
 Memfile_LeaseMgr::initLeaseFilePath(Universe u) {
     std::string persist_val;
@@ -454,6 +725,29 @@ Memfile_LeaseMgr::initLeaseFilePath(Universe u) {
     return (lease_file);
 }
 
+uint32_t
+Memfile_LeaseMgr::initLFCInterval() {
+    std::string lfc_interval;
+    try {
+        lfc_interval = getParameter("lfc-interval");
+    } catch (const Exception& ex) {
+        // The LFC is not run periodically by default.
+        return (0);
+    }
+    int64_t interval = -1;
+    try {
+        interval = boost::lexical_cast<int64_t>(lfc_interval);
+    } catch (const boost::bad_lexical_cast&) {
+        // Reported below.
+    }
+    if (interval < 0 ||
+        interval > std::numeric_limits<uint32_t>::max()) {
+        bundy_throw(bundy::BadValue, "invalid value 'lfc-interval="
+                    << lfc_interval << "'");
+    }
+    return (static_cast<uint32_t>(interval));
+}
+
 void
 Memfile_LeaseMgr::load4() {
     // If lease file hasn't been opened, we are working in non-persistent mode.
@@ -462,22 +756,50 @@ Memfile_LeaseMgr::load4() {
         return;
     }
 
-    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD4)
-        .arg(lease_file4_->getFilename());
-
     // Remove existing leases (if any). We will recreate them based on the
     // data on disk.
     storage4_.clear();
 
+    // Load the snapshot written by the last Lease File Cleanup and the lease
+    // file it was cleaning up (if any), which hold older leases than the
+    // lease file.
+    const std::string& lease_file = lease_file4_->getFilename();
+    const LFCFileType lfc_files[] = { FILE_SNAPSHOT, FILE_PREVIOUS };
+    for (size_t i = 0; i < sizeof(lfc_files) / sizeof(lfc_files[0]); ++i) {
+        const std::string file_name = appendSuffix(lease_file, lfc_files[i]);
+        if (fileExists(file_name)) {
+            CSVLeaseFile4 lfc_file(file_name);
+            lfc_file.open();
+            loadLeaseFile4(lfc_file);
+            lfc_file.close();
+        }
+    }
+
+    loadLeaseFile4(*lease_file4_);
+
+    // Leases are loaded bypassing addLease, so the address index needs to
+    // be rebuilt.
+    address_index_.clear();
+    for (Lease4Storage::const_iterator lease = storage4_.begin();
+         lease != storage4_.end(); ++lease) {
+        address_index_.add((*lease)->addr_);
+    }
+}
+
+void
+Memfile_LeaseMgr::loadLeaseFile4(CSVLeaseFile4& lease_file) {
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD4)
+        .arg(lease_file.getFilename());
+
     Lease4Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file4_->next(lease)) {
+        if (!lease_file.next(lease)) {
             bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file4_->getReadMsg());
+                      " the lease file: " << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
@@ -523,22 +845,50 @@ Memfile_LeaseMgr::load6() {
         return;
     }
 
-    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD6)
-        .arg(lease_file6_->getFilename());
-
     // Remove existing leases (if any). We will recreate them based on the
     // data on disk.
     storage6_.clear();
 
+    // Load the snapshot written by the last Lease File Cleanup and the lease
+    // file it was cleaning up (if any), which hold older leases than the
+    // lease file.
+    const std::string& lease_file = lease_file6_->getFilename();
+    const LFCFileType lfc_files[] = { FILE_SNAPSHOT, FILE_PREVIOUS };
+    for (size_t i = 0; i < sizeof(lfc_files) / sizeof(lfc_files[0]); ++i) {
+        const std::string file_name = appendSuffix(lease_file, lfc_files[i]);
+        if (fileExists(file_name)) {
+            CSVLeaseFile6 lfc_file(file_name);
+            lfc_file.open();
+            loadLeaseFile6(lfc_file);
+            lfc_file.close();
+        }
+    }
+
+    loadLeaseFile6(*lease_file6_);
+
+    // Leases are loaded bypassing addLease, so the address index needs to
+    // be rebuilt.
+    address_index_.clear();
+    for (Lease6Storage::const_iterator lease = storage6_.begin();
+         lease != storage6_.end(); ++lease) {
+        address_index_.add((*lease)->addr_);
+    }
+}
+
+void
+Memfile_LeaseMgr::loadLeaseFile6(CSVLeaseFile6& lease_file) {
+    LOG_INFO(dhcpsrv_logger, DHCPSRV_MEMFILE_LEASES_RELOAD6)
+        .arg(lease_file.getFilename());
+
     Lease6Ptr lease;
     do {
         /// @todo Currently we stop parsing on first failure. It is possible
         /// that only one (or a few) leases are bad, so in theory we could
         /// continue parsing but that would require some error counters to
         /// prevent endless loops. That is enhancement for later time.
-        if (!lease_file6_->next(lease)) {
+        if (!lease_file.next(lease)) {
             bundy_throw(DbOperationError, "Failed to parse the DHCPv6 lease in"
-                      " the lease file: " << lease_file6_->getReadMsg());
+                      " the lease file: " << lease_file.getReadMsg());
         }
         // If we got the lease, we update the internal container holding
         // leases. Otherwise, we reached the end of file and we leave.
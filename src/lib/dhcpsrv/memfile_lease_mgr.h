@@ -25,8 +25,18 @@
 #include <boost/multi_index/ordered_index.hpp>
 #include <boost/multi_index_container.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <time.h>
 
 namespace bundy {
+namespace util {
+namespace thread {
+class Thread;
+}
+}
+
 namespace dhcp {
 
 /// @brief Concrete implementation of a lease database backend using flat file.
@@ -68,6 +78,20 @@ namespace dhcp {
 /// is not specified, the default location in the installation
 /// directory is used: var/bundy/kea-leases4.csv and
 /// var/bundy/kea-leases6.csv.
+///
+/// As the lease file only grows, the backend supports the Lease File
+/// Cleanup (LFC), which replaces the history of lease updates with a
+/// snapshot of the current leases. When the LFC is started, the lease file
+/// is renamed to the file with the ".2" suffix and a new lease file is
+/// created, to which the server continues appending lease updates. The
+/// copy of the leases held in memory is then written, in a separate thread,
+/// to the file with the ".output" suffix, which is renamed to the file with
+/// the ".1" suffix when complete. Finally, the ".2" file is removed. When
+/// the backend is starting up, it reads the ".1", ".2" and the lease file,
+/// in this order, so the leases are restored correctly regardless of the
+/// phase in which the LFC may have been interrupted. The LFC is started
+/// periodically if the "lfc-interval=[seconds]" parameter is specified with
+/// a non-zero value, or it can be started explicitly with @c startLFC.
 class Memfile_LeaseMgr : public LeaseMgr {
 public:
 
@@ -82,6 +106,17 @@ public:
         V6
     };
 
+    /// @brief Types of the lease files used by the Lease File Cleanup.
+    ///
+    /// This enumeration is used by @c appendSuffix to build the name of a
+    /// file used by the LFC from the name of the lease file.
+    enum LFCFileType {
+        FILE_CURRENT,  ///< Lease file the server appends to (no suffix).
+        FILE_SNAPSHOT, ///< Snapshot of leases written by the last LFC (".1").
+        FILE_PREVIOUS, ///< Lease file being cleaned up by the LFC (".2").
+        FILE_OUTPUT    ///< Snapshot being written by the LFC (".output").
+    };
+
     /// @brief The sole lease manager constructor
     ///
     /// dbconfig is a generic way of passing parameters. Parameters
@@ -315,6 +350,50 @@ public:
     /// server shut down.
     bool persistLeases(Universe u) const;
 
+    /// @brief Returns the name of a file used by the Lease File Cleanup.
+    ///
+    /// @param file_name Name of the lease file.
+    /// @param file_type Type of the file.
+    ///
+    /// @return The lease file name with the suffix for the file type.
+    static std::string appendSuffix(const std::string& file_name,
+                                    const LFCFileType file_type);
+
+    /// @brief Returns the interval between the LFC runs in seconds.
+    ///
+    /// @return The value of the "lfc-interval" parameter or 0 if the LFC
+    /// is not started periodically.
+    uint32_t getLFCInterval() const {
+        return (lfc_interval_);
+    }
+
+    /// @brief Starts the Lease File Cleanup.
+    ///
+    /// This method rotates the lease file (unless the ".2" file left by an
+    /// earlier, interrupted LFC still exists) and starts a thread writing
+    /// the snapshot of the current leases. It returns immediately; the
+    /// server may continue to update leases while the LFC is in progress.
+    ///
+    /// @throw bundy::DbOperationError If the lease file can't be rotated.
+    ///
+    /// @return true if the LFC has been started, false if the leases are not
+    /// written to disk or the LFC is already in progress.
+    bool startLFC();
+
+    /// @brief Checks if the Lease File Cleanup is in progress.
+    ///
+    /// If the LFC thread has completed, this method collects it and logs
+    /// the result.
+    ///
+    /// @return true if the LFC thread is still running.
+    bool isLFCRunning();
+
+    /// @brief Waits for the Lease File Cleanup in progress to complete.
+    ///
+    /// This method does nothing if the LFC is not in progress. Errors of
+    /// the LFC are logged, not thrown.
+    void waitLFC();
+
 protected:
 
     /// @brief Load all DHCPv4 leases from the file.
@@ -339,6 +418,14 @@ protected:
     /// @param lease Pointer to the lease read from the lease file.
     void loadLease4(Lease4Ptr& lease);
 
+    /// @brief Loads all DHCPv4 leases from the specified file.
+    ///
+    /// @param lease_file Opened lease file to read leases from.
+    ///
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile4(CSVLeaseFile4& lease_file);
+
     /// @brief Load all DHCPv6 leases from the file.
     ///
     /// This method loads all DHCPv6 leases from a file to memory. It removes
@@ -361,6 +448,14 @@ protected:
     /// @param lease Pointer to the lease read from the lease file.
     void loadLease6(Lease6Ptr& lease);
 
+    /// @brief Loads all DHCPv6 leases from the specified file.
+    ///
+    /// @param lease_file Opened lease file to read leases from.
+    ///
+    /// @throw bundy::DbOperationError If failed to read a lease from the lease
+    /// file.
+    void loadLeaseFile6(CSVLeaseFile6& lease_file);
+
     /// @brief Initialize the location of the lease file.
     ///
     /// This method uses the parameters passed as a map to the constructor to
@@ -380,6 +475,22 @@ protected:
     /// argument to this function.
     std::string initLeaseFilePath(Universe u);
 
+    /// @brief Initialize the interval between the LFC runs.
+    ///
+    /// @throw bundy::BadValue If the "lfc-interval" parameter is not a
+    /// non-negative integer.
+    ///
+    /// @return The value of the "lfc-interval" parameter or 0 if it is not
+    /// specified.
+    uint32_t initLFCInterval();
+
+    /// @brief Starts the Lease File Cleanup if the LFC interval has elapsed.
+    ///
+    /// This method is called after each write to the lease file. Errors in
+    /// starting the LFC are logged, not thrown, so that the lease update
+    /// succeeds.
+    void scheduleLFC();
+
     // This is a multi-index container, which holds elements that can
     // be accessed using different search indexes.
     typedef boost::multi_index_container<
@@ -494,6 +605,22 @@ protected:
     /// @brief Holds the pointer to the DHCPv6 lease file IO.
     boost::shared_ptr<CSVLeaseFile6> lease_file6_;
 
+private:
+
+    /// @brief Snapshot of the leases written by the LFC thread.
+    class LFCTask;
+
+    /// @brief Interval between the LFC runs in seconds (0 if disabled).
+    uint32_t lfc_interval_;
+
+    /// @brief Time when the last LFC was started (or the backend created).
+    time_t lfc_last_;
+
+    /// @brief The task written by the LFC in progress.
+    boost::shared_ptr<LFCTask> lfc_task_;
+
+    /// @brief The thread running the LFC in progress (NULL if none).
+    boost::scoped_ptr<bundy::util::thread::Thread> lfc_thread_;
 };
 
 }; // end of bundy::dhcp namespace
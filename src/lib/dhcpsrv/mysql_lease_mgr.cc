@@ -127,6 +127,11 @@ TaggedStatement tagged_statements[] = {
                     "DELETE FROM lease4 WHERE address = ?"},
     {MySqlLeaseMgr::DELETE_LEASE6,
                     "DELETE FROM lease6 WHERE address = ?"},
+    {MySqlLeaseMgr::GET_LEASE4,
+                    "SELECT address, hwaddr, client_id, "
+                        "valid_lifetime, expire, subnet_id, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease4"},
     {MySqlLeaseMgr::GET_LEASE4_ADDR,
                     "SELECT address, hwaddr, client_id, "
                         "valid_lifetime, expire, subnet_id, "
@@ -157,6 +162,12 @@ TaggedStatement tagged_statements[] = {
                         "fqdn_fwd, fqdn_rev, hostname "
                             "FROM lease4 "
                             "WHERE hwaddr = ? AND subnet_id = ?"},
+    {MySqlLeaseMgr::GET_LEASE6,
+                    "SELECT address, duid, valid_lifetime, "
+                        "expire, subnet_id, pref_lifetime, "
+                        "lease_type, iaid, prefix_len, "
+                        "fqdn_fwd, fqdn_rev, hostname "
+                            "FROM lease6"},
     {MySqlLeaseMgr::GET_LEASE6_ADDR,
                     "SELECT address, duid, valid_lifetime, "
                         "expire, subnet_id, pref_lifetime, "
@@ -1124,6 +1135,13 @@ MySqlLeaseMgr::MySqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
     // program and the database.
     exchange4_.reset(new MySqlLease4Exchange());
     exchange6_.reset(new MySqlLease6Exchange());
+
+    // Index the addresses of the leases held in the database.
+    Lease4Collection leases4;
+    getLeaseCollection(GET_LEASE4, NULL, leases4);
+    Lease6Collection leases6;
+    getLeaseCollection(GET_LEASE6, NULL, leases6);
+    rebuildAddressIndex(leases4, leases6);
 }
 
 
@@ -1369,7 +1387,12 @@ MySqlLeaseMgr::addLease(const Lease4Ptr& lease) {
     std::vector<MYSQL_BIND> bind = exchange4_->createBindForSend(lease);
 
     // ... and drop to common code.
-    return (addLeaseCommon(INSERT_LEASE4, bind));
+    const bool added = addLeaseCommon(INSERT_LEASE4, bind);
+
+    // If the lease wasn't added, because a lease for the address exists
+    // already, the address is in use as well.
+    address_index_.add(lease->addr_);
+    return (added);
 }
 
 bool
@@ -1382,7 +1405,12 @@ MySqlLeaseMgr::addLease(const Lease6Ptr& lease) {
     std::vector<MYSQL_BIND> bind = exchange6_->createBindForSend(lease);
 
     // ... and drop to common code.
-    return (addLeaseCommon(INSERT_LEASE6, bind));
+    const bool added = addLeaseCommon(INSERT_LEASE6, bind);
+
+    // If the lease wasn't added, because a lease for the address exists
+    // already, the address is in use as well.
+    address_index_.add(lease->addr_);
+    return (added);
 }
 
 // Extraction of leases from the database.
@@ -1905,6 +1933,7 @@ MySqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
     MYSQL_BIND inbind[1];
     memset(inbind, 0, sizeof(inbind));
 
+    bool deleted = false;
     if (addr.isV4()) {
         uint32_t addr4 = static_cast<uint32_t>(addr);
 
@@ -1912,7 +1941,7 @@ MySqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
         inbind[0].buffer = reinterpret_cast<char*>(&addr4);
         inbind[0].is_unsigned = MLM_TRUE;
 
-        return (deleteLeaseCommon(DELETE_LEASE4, inbind));
+        deleted = deleteLeaseCommon(DELETE_LEASE4, inbind);
 
     } else {
         std::string addr6 = addr.toText();
@@ -1925,8 +1954,13 @@ MySqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
         inbind[0].buffer_length = addr6_length;
         inbind[0].length = &addr6_length;
 
-        return (deleteLeaseCommon(DELETE_LEASE6, inbind));
+        deleted = deleteLeaseCommon(DELETE_LEASE6, inbind);
+    }
+
+    if (deleted) {
+        address_index_.remove(addr);
     }
+    return (deleted);
 }
 
 // Miscellaneous database methods.
@@ -0,0 +1,347 @@
+// Copyright (C) 2026  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef PACKET_WORKERS_H
+#define PACKET_WORKERS_H
+
+/// @file packet_workers.h Defines the PacketWorkers class template.
+
+#include <dhcp/iface_mgr.h>
+#include <dhcp_ddns/watch_socket.h>
+#include <dhcpsrv/dhcpsrv_log.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <boost/bind.hpp>
+#include <boost/function.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace bundy {
+namespace dhcp {
+
+/// @brief Pool of threads processing the packets received by a server.
+///
+/// The thread receiving the packets (the "receiving thread", which runs
+/// the main loop of the server) pushes them to a bounded queue, from which
+/// the worker threads take them and pass them to the handler. A packet is
+/// dropped if the queue is full, in the same way as the kernel drops it if
+/// the socket buffer is full.
+///
+/// The handler may use @c processSerialized to make sure that the packets
+/// of one client are not processed by two workers at the same time.
+///
+/// The workers may also need to use objects which are not thread safe and
+/// are only used by the receiving thread, such as the sender of the name
+/// change requests. They post tasks with @c post, which are then run by
+/// the receiving thread, when it waits for packets in @c IfaceMgr.
+///
+/// At last, the receiving thread may stop the processing with a @c Pause
+/// object, for example when the configuration is about to change.
+///
+/// @tparam PktPtr Pointer to the packets, @c Pkt4Ptr or @c Pkt6Ptr.
+template <typename PktPtr>
+class PacketWorkers : boost::noncopyable {
+public:
+    /// @brief Function processing a packet.
+    typedef boost::function<void (const PktPtr&)> Handler;
+
+    /// @brief Function posted by a worker to the receiving thread.
+    typedef boost::function<void ()> Task;
+
+    /// @brief Identifier of a client, used to serialize its packets.
+    typedef std::vector<uint8_t> ClientKey;
+
+    /// @brief Suspends the processing of the packets while it exists.
+    ///
+    /// The constructor waits until no worker is processing a packet, and
+    /// no worker takes a packet from the queue until the object is
+    /// destroyed. Packets may still be pushed in the meantime. It must be
+    /// used by the receiving thread only.
+    class Pause : boost::noncopyable {
+    public:
+        /// @brief Constructor.
+        ///
+        /// @param workers Workers to pause. If it is NULL, the object does
+        /// nothing, so the callers don't need to check if the server uses
+        /// workers.
+        explicit Pause(PacketWorkers* workers) : workers_(workers) {
+            if (workers_) {
+                workers_->pause();
+            }
+        }
+
+        /// @brief Destructor. Resumes the processing.
+        ~Pause() {
+            if (workers_) {
+                workers_->resume();
+            }
+        }
+
+    private:
+        PacketWorkers* workers_;
+    };
+
+    /// @brief Constructor. Starts the workers.
+    ///
+    /// The socket used to notify the receiving thread of posted tasks is
+    /// registered in @c IfaceMgr as an external socket.
+    ///
+    /// @param thread_count Number of worker threads.
+    /// @param queue_size Maximum number of packets waiting in the queue.
+    /// @param handler Function processing the packets. Exceptions derived
+    /// from std::exception thrown by it are logged.
+    ///
+    /// @throw bundy::BadValue if the thread count or the queue size is 0.
+    PacketWorkers(size_t thread_count, size_t queue_size,
+                  const Handler& handler) :
+        queue_size_(queue_size), handler_(handler), stopping_(false),
+        paused_(false), busy_(0)
+    {
+        if (thread_count == 0 || queue_size == 0) {
+            bundy_throw(BadValue, "packet workers require at least one"
+                        " thread and a queue of at least one packet");
+        }
+        IfaceMgr::instance().addExternalSocket(watch_.getSelectFd(),
+            boost::bind(&PacketWorkers::runPostedTasks, this));
+        try {
+            for (size_t i = 0; i < thread_count; ++i) {
+                threads_.push_back(ThreadPtr(new util::thread::Thread(
+                    boost::bind(&PacketWorkers::run, this))));
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    /// @brief Destructor.
+    ///
+    /// Waits for the workers to finish the packets they are processing
+    /// and stops them. The packets left in the queue and the tasks which
+    /// haven't been run yet are dropped.
+    ~PacketWorkers() {
+        stop();
+    }
+
+    /// @brief Queues a packet for processing.
+    ///
+    /// @param pkt Packet to be processed.
+    ///
+    /// @return true if the packet was queued, false if it was dropped
+    /// because the queue is full.
+    bool push(const PktPtr& pkt) {
+        util::thread::Mutex::Locker locker(mutex_);
+        if (queue_.size() >= queue_size_) {
+            return (false);
+        }
+        queue_.push_back(pkt);
+        work_cond_.signal();
+        return (true);
+    }
+
+    /// @brief Processes the packet of a client, one at a time.
+    ///
+    /// If no other worker is processing a packet of the same client, the
+    /// packet is processed by the calling thread. Otherwise, it is left to
+    /// the other worker, which processes it after the packet it is working
+    /// on. Only the last such packet is kept: it replaces the one which
+    /// was already waiting, which is usually a retransmission of the same
+    /// message.
+    ///
+    /// @param key Identifier of the client. If it is empty, the packet is
+    /// processed without waiting for other packets.
+    /// @param pkt Packet to be processed.
+    /// @param handler Function processing the packet.
+    void processSerialized(const ClientKey& key, const PktPtr& pkt,
+                           const Handler& handler)
+    {
+        if (key.empty()) {
+            handler(pkt);
+            return;
+        }
+
+        {
+            util::thread::Mutex::Locker locker(clients_mutex_);
+            typename ClientMap::iterator client = clients_.find(key);
+            if (client != clients_.end()) {
+                if (client->second) {
+                    LOG_DEBUG(dhcpsrv_logger, DHCPSRV_DBG_TRACE_DETAIL,
+                              DHCPSRV_WORKERS_PACKET_SUPERSEDED);
+                }
+                client->second = pkt;
+                return;
+            }
+            clients_.insert(std::make_pair(key, PktPtr()));
+        }
+
+        PktPtr current = pkt;
+        while (current) {
+            try {
+                handler(current);
+            } catch (...) {
+                util::thread::Mutex::Locker locker(clients_mutex_);
+                clients_.erase(key);
+                throw;
+            }
+
+            util::thread::Mutex::Locker locker(clients_mutex_);
+            typename ClientMap::iterator client = clients_.find(key);
+            current = client->second;
+            if (current) {
+                client->second.reset();
+            } else {
+                clients_.erase(client);
+            }
+        }
+    }
+
+    /// @brief Posts a task to be run by the receiving thread.
+    ///
+    /// @param task Function to run. Exceptions derived from std::exception
+    /// thrown by it are logged.
+    ///
+    /// @throw dhcp_ddns::WatchSocketError if the receiving thread can't be
+    /// notified.
+    void post(const Task& task) {
+        util::thread::Mutex::Locker locker(tasks_mutex_);
+        tasks_.push_back(task);
+        if (tasks_.size() == 1) {
+            watch_.markReady();
+        }
+    }
+
+    /// @brief Runs the tasks posted by the workers.
+    ///
+    /// This is called by @c IfaceMgr in the receiving thread when the
+    /// workers have posted tasks; there is usually no need to call it
+    /// otherwise.
+    void runPostedTasks() {
+        std::vector<Task> tasks;
+        {
+            util::thread::Mutex::Locker locker(tasks_mutex_);
+            tasks.swap(tasks_);
+            watch_.clearReady();
+        }
+        for (typename std::vector<Task>::iterator task = tasks.begin();
+             task != tasks.end(); ++task) {
+            try {
+                (*task)();
+            } catch (const std::exception& ex) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_WORKERS_TASK_FAILED)
+                    .arg(ex.what());
+            }
+        }
+    }
+
+private:
+    /// @brief Main function of the worker threads.
+    void run() {
+        for (;;) {
+            PktPtr pkt;
+            {
+                util::thread::Mutex::Locker locker(mutex_);
+                while (!stopping_ && (paused_ || queue_.empty())) {
+                    work_cond_.wait(mutex_);
+                }
+                if (stopping_) {
+                    return;
+                }
+                pkt = queue_.front();
+                queue_.pop_front();
+                ++busy_;
+            }
+
+            try {
+                handler_(pkt);
+            } catch (const std::exception& ex) {
+                LOG_ERROR(dhcpsrv_logger, DHCPSRV_WORKERS_PACKET_FAILED)
+                    .arg(ex.what());
+            }
+
+            util::thread::Mutex::Locker locker(mutex_);
+            if (--busy_ == 0 && paused_) {
+                idle_cond_.broadcast();
+            }
+        }
+    }
+
+    /// @brief Waits until no worker processes a packet and blocks them.
+    void pause() {
+        util::thread::Mutex::Locker locker(mutex_);
+        paused_ = true;
+        while (busy_ > 0) {
+            idle_cond_.wait(mutex_);
+        }
+    }
+
+    /// @brief Lets the workers take packets from the queue again.
+    void resume() {
+        util::thread::Mutex::Locker locker(mutex_);
+        paused_ = false;
+        work_cond_.broadcast();
+    }
+
+    /// @brief Stops and joins the workers and unregisters the socket.
+    void stop() {
+        {
+            util::thread::Mutex::Locker locker(mutex_);
+            stopping_ = true;
+            work_cond_.broadcast();
+        }
+        for (typename std::vector<ThreadPtr>::iterator thread =
+                 threads_.begin(); thread != threads_.end(); ++thread) {
+            (*thread)->wait();
+        }
+        threads_.clear();
+        IfaceMgr::instance().deleteExternalSocket(watch_.getSelectFd());
+    }
+
+    typedef boost::shared_ptr<util::thread::Thread> ThreadPtr;
+    typedef std::map<ClientKey, PktPtr> ClientMap;
+
+    const size_t queue_size_;
+    const Handler handler_;
+    std::vector<ThreadPtr> threads_;
+
+    // The following are protected by mutex_.
+    util::thread::Mutex mutex_;
+    util::thread::CondVar work_cond_;
+    util::thread::CondVar idle_cond_;
+    std::deque<PktPtr> queue_;
+    bool stopping_;
+    bool paused_;
+    size_t busy_;
+
+    // Clients whose packets are being processed, each with the packet
+    // to be processed next, if any. Protected by clients_mutex_.
+    util::thread::Mutex clients_mutex_;
+    ClientMap clients_;
+
+    // Tasks posted for the receiving thread. Protected by tasks_mutex_.
+    util::thread::Mutex tasks_mutex_;
+    std::vector<Task> tasks_;
+    dhcp_ddns::WatchSocket watch_;
+};
+
+} // namespace dhcp
+} // namespace bundy
+
+#endif // PACKET_WORKERS_H
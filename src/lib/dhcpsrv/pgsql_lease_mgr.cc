@@ -71,6 +71,12 @@ TaggedStatement tagged_statements[] = {
         { 1043 },
         "delete_lease6",
      "DELETE FROM lease6 WHERE address = $1"},
+    {PgSqlLeaseMgr::GET_LEASE4, 0,
+        { 0 },
+        "get_lease4",
+     "SELECT address, hwaddr, client_id, "
+     "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease4"},
     {PgSqlLeaseMgr::GET_LEASE4_ADDR, 1,
         { 20 },
         "get_lease4_addr",
@@ -106,6 +112,13 @@ TaggedStatement tagged_statements[] = {
      "valid_lifetime, extract(epoch from expire)::bigint, subnet_id, fqdn_fwd, fqdn_rev, hostname "
      "FROM lease4 "
      "WHERE hwaddr = $1 AND subnet_id = $2"},
+    {PgSqlLeaseMgr::GET_LEASE6, 0,
+        { 0 },
+        "get_lease6",
+     "SELECT address, duid, valid_lifetime, "
+     "extract(epoch from expire)::bigint, subnet_id, pref_lifetime, "
+     "lease_type, iaid, prefix_len, fqdn_fwd, fqdn_rev, hostname "
+     "FROM lease6"},
     {PgSqlLeaseMgr::GET_LEASE6_ADDR, 2,
         { 1043, 21 },
         "get_lease6_addr",
@@ -574,6 +587,14 @@ PgSqlLeaseMgr::PgSqlLeaseMgr(const LeaseMgr::ParameterMap& parameters)
     exchange6_(new PgSqlLease6Exchange()), conn_(NULL) {
     openDatabase();
     prepareStatements();
+
+    // Index the addresses of the leases held in the database.
+    BindParams params;
+    Lease4Collection leases4;
+    getLeaseCollection(GET_LEASE4, params, leases4);
+    Lease6Collection leases6;
+    getLeaseCollection(GET_LEASE6, params, leases6);
+    rebuildAddressIndex(leases4, leases6);
 }
 
 PgSqlLeaseMgr::~PgSqlLeaseMgr() {
@@ -711,7 +732,12 @@ PgSqlLeaseMgr::addLease(const Lease4Ptr& lease) {
               DHCPSRV_PGSQL_ADD_ADDR4).arg(lease->addr_.toText());
     BindParams params = exchange4_->createBindForSend(lease);
 
-    return (addLeaseCommon(INSERT_LEASE4, params));
+    const bool added = addLeaseCommon(INSERT_LEASE4, params);
+
+    // If the lease wasn't added, because a lease for the address exists
+    // already, the address is in use as well.
+    address_index_.add(lease->addr_);
+    return (added);
 }
 
 bool
@@ -720,7 +746,12 @@ PgSqlLeaseMgr::addLease(const Lease6Ptr& lease) {
               DHCPSRV_PGSQL_ADD_ADDR6).arg(lease->addr_.toText());
     BindParams params = exchange6_->createBindForSend(lease);
 
-    return (addLeaseCommon(INSERT_LEASE6, params));
+    const bool added = addLeaseCommon(INSERT_LEASE6, params);
+
+    // If the lease wasn't added, because a lease for the address exists
+    // already, the address is in use as well.
+    address_index_.add(lease->addr_);
+    return (added);
 }
 
 template <typename Exchange, typename LeaseCollection>
@@ -737,9 +768,12 @@ void PgSqlLeaseMgr::getLeaseCollection(StatementIndex stindex,
     vector<int> out_formats;
     convertToQuery(params, out_values, out_lengths, out_formats);
 
+    // The statements returning all leases have no parameters.
     PGresult* r = PQexecPrepared(conn_, statements_[stindex].stmt_name,
-                       statements_[stindex].stmt_nbparams, &out_values[0],
-                       &out_lengths[0], &out_formats[0], 0);
+                       statements_[stindex].stmt_nbparams,
+                       out_values.empty() ? NULL : &out_values[0],
+                       out_lengths.empty() ? NULL : &out_lengths[0],
+                       out_formats.empty() ? NULL : &out_formats[0], 0);
 
     checkStatementError(r, stindex);
 
@@ -1105,15 +1139,22 @@ PgSqlLeaseMgr::deleteLease(const bundy::asiolink::IOAddress& addr) {
     // Set up the WHERE clause value
     BindParams inparams;
 
+    bool deleted = false;
     if (addr.isV4()) {
         ostringstream tmp;
         tmp << static_cast<uint32_t>(addr);
         inparams.push_back(PgSqlParam(tmp.str()));
-        return (deleteLeaseCommon(DELETE_LEASE4, inparams));
+        deleted = deleteLeaseCommon(DELETE_LEASE4, inparams);
+
+    } else {
+        inparams.push_back(PgSqlParam(addr.toText()));
+        deleted = deleteLeaseCommon(DELETE_LEASE6, inparams);
     }
 
-    inparams.push_back(PgSqlParam(addr.toText()));
-    return (deleteLeaseCommon(DELETE_LEASE6, inparams));
+    if (deleted) {
+        address_index_.remove(addr);
+    }
+    return (deleted);
 }
 
 string
@@ -0,0 +1,164 @@
+// Copyright (C) 2014 Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcpsrv/address_index.h>
+
+#include <gtest/gtest.h>
+
+using namespace bundy::dhcp;
+using namespace bundy::asiolink;
+
+namespace {
+
+// This test verifies that addresses can be marked as used and free.
+TEST(AddressIndexTest, addRemove) {
+    AddressIndex index;
+    EXPECT_EQ(0, index.getUsedCount());
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.1")));
+
+    index.add(IOAddress("192.0.2.1"));
+    EXPECT_TRUE(index.isUsed(IOAddress("192.0.2.1")));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.0")));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.2")));
+    EXPECT_EQ(1, index.getUsedCount());
+
+    // Adding the same address again is no-op.
+    index.add(IOAddress("192.0.2.1"));
+    EXPECT_EQ(1, index.getUsedCount());
+
+    index.remove(IOAddress("192.0.2.1"));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.1")));
+    EXPECT_EQ(0, index.getUsedCount());
+    EXPECT_EQ(0, index.getRangeCount());
+
+    // Removing a free address is no-op.
+    index.remove(IOAddress("192.0.2.1"));
+    EXPECT_EQ(0, index.getUsedCount());
+}
+
+// This test verifies that adjacent addresses are merged into ranges and
+// that removing an address splits the range.
+TEST(AddressIndexTest, ranges) {
+    AddressIndex index;
+    index.add(IOAddress("192.0.2.1"));
+    index.add(IOAddress("192.0.2.3"));
+    EXPECT_EQ(2, index.getRangeCount());
+
+    // The address between them merges both ranges.
+    index.add(IOAddress("192.0.2.2"));
+    EXPECT_EQ(1, index.getRangeCount());
+    EXPECT_EQ(3, index.getUsedCount());
+
+    // Extend the range at both ends, crossing the byte boundary.
+    index.add(IOAddress("192.0.2.0"));
+    index.add(IOAddress("192.0.1.255"));
+    index.add(IOAddress("192.0.2.4"));
+    EXPECT_EQ(1, index.getRangeCount());
+    EXPECT_EQ(6, index.getUsedCount());
+
+    // Removing an address from the middle splits the range.
+    index.remove(IOAddress("192.0.2.2"));
+    EXPECT_EQ(2, index.getRangeCount());
+    EXPECT_TRUE(index.isUsed(IOAddress("192.0.2.1")));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.2")));
+    EXPECT_TRUE(index.isUsed(IOAddress("192.0.2.3")));
+
+    // Removing the first and the last address shrinks the ranges.
+    index.remove(IOAddress("192.0.1.255"));
+    index.remove(IOAddress("192.0.2.4"));
+    EXPECT_EQ(2, index.getRangeCount());
+    EXPECT_EQ(3, index.getUsedCount());
+    EXPECT_TRUE(index.isUsed(IOAddress("192.0.2.0")));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.1.255")));
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.4")));
+
+    index.clear();
+    EXPECT_EQ(0, index.getRangeCount());
+    EXPECT_EQ(0, index.getUsedCount());
+    EXPECT_FALSE(index.isUsed(IOAddress("192.0.2.0")));
+}
+
+// This test verifies that the first free address in a range is found.
+TEST(AddressIndexTest, findFree) {
+    AddressIndex index;
+    IOAddress free("0.0.0.0");
+
+    // All addresses are free.
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.10"),
+                               IOAddress("192.0.2.20"), free));
+    EXPECT_EQ("192.0.2.10", free.toText());
+
+    const uint32_t base = static_cast<uint32_t>(IOAddress("192.0.2.0"));
+    for (uint32_t i = 10; i < 15; ++i) {
+        index.add(IOAddress(base + i));
+    }
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.10"),
+                               IOAddress("192.0.2.20"), free));
+    EXPECT_EQ("192.0.2.15", free.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.12"),
+                               IOAddress("192.0.2.20"), free));
+    EXPECT_EQ("192.0.2.15", free.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("192.0.2.5"),
+                               IOAddress("192.0.2.20"), free));
+    EXPECT_EQ("192.0.2.5", free.toText());
+
+    // All addresses in the range are used.
+    free = IOAddress("0.0.0.0");
+    EXPECT_FALSE(index.findFree(IOAddress("192.0.2.10"),
+                                IOAddress("192.0.2.14"), free));
+    EXPECT_EQ("0.0.0.0", free.toText());
+
+    // Invalid range.
+    EXPECT_FALSE(index.findFree(IOAddress("192.0.2.20"),
+                                IOAddress("192.0.2.10"), free));
+
+    // The highest address has no next address.
+    index.add(IOAddress("255.255.255.255"));
+    EXPECT_FALSE(index.findFree(IOAddress("255.255.255.255"),
+                                IOAddress("255.255.255.255"), free));
+}
+
+// This test verifies that IPv4 and IPv6 addresses can be held in the same
+// index.
+TEST(AddressIndexTest, mixedFamilies) {
+    AddressIndex index;
+    index.add(IOAddress("2001:db8:1::ffff"));
+    index.add(IOAddress("2001:db8:1::1:0"));
+    index.add(IOAddress("255.255.255.255"));
+    index.add(IOAddress("::"));
+    EXPECT_EQ(4, index.getUsedCount());
+    // IPv6 addresses across the 16-bit boundary are merged.
+    EXPECT_EQ(3, index.getRangeCount());
+
+    EXPECT_TRUE(index.isUsed(IOAddress("255.255.255.255")));
+    EXPECT_TRUE(index.isUsed(IOAddress("::")));
+    EXPECT_FALSE(index.isUsed(IOAddress("0.0.0.0")));
+    EXPECT_FALSE(index.isUsed(IOAddress("::ffff:ffff")));
+
+    IOAddress free("::");
+    ASSERT_TRUE(index.findFree(IOAddress("2001:db8:1::ffff"),
+                               IOAddress("2001:db8:1::ffff:ffff"), free));
+    EXPECT_EQ("2001:db8:1::1:1", free.toText());
+    ASSERT_TRUE(index.findFree(IOAddress("::"), IOAddress("::ff"), free));
+    EXPECT_EQ("::1", free.toText());
+
+    index.remove(IOAddress("2001:db8:1::ffff"));
+    EXPECT_EQ(3, index.getRangeCount());
+    EXPECT_FALSE(index.isUsed(IOAddress("2001:db8:1::ffff")));
+    EXPECT_TRUE(index.isUsed(IOAddress("2001:db8:1::1:0")));
+}
+
+} // end of anonymous namespace
@@ -64,6 +64,8 @@ public:
     // Expose internal classes for testing purposes
     using AllocEngine::Allocator;
     using AllocEngine::IterativeAllocator;
+    using AllocEngine::HashedAllocator;
+    using AllocEngine::RandomAllocator;
     using AllocEngine::getAllocator;
 
     /// @brief IterativeAllocator with internal methods exposed
@@ -470,9 +472,15 @@ public:
 TEST_F(AllocEngine6Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)), NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)), NotImplemented);
+    // Hashed and random allocators are supported for all lease types
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_NA));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_TA));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_NA));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_TA));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_PD));
 
     ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_ITERATIVE, 100, true)));
 
@@ -586,6 +594,91 @@ TEST_F(AllocEngine6Test, IterativeAllocator) {
     }
 }
 
+// This test verifies that the hashed allocator picks addresses and prefixes
+// that belong to the pools and that the same client gets the same address.
+TEST_F(AllocEngine6Test, HashedAllocator) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_NA);
+    NakedAllocEngine::HashedAllocator pd_alloc(Lease::TYPE_PD);
+
+    const IOAddress addr = alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, addr));
+    const IOAddress prefix = pd_alloc.pickAddress(subnet_, duid_,
+                                                  IOAddress("::"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, prefix));
+
+    // Other clients get addresses from the pools too, and these are
+    // spread over the pool.
+    std::set<IOAddress> addrs;
+    for (int i = 0; i < 100; ++i) {
+        DuidPtr duid(new DUID(vector<uint8_t>(8, i)));
+        IOAddress candidate = alloc.pickAddress(subnet_, duid,
+                                                IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        addrs.insert(candidate);
+        candidate = pd_alloc.pickAddress(subnet_, duid, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+        // The prefix is aligned to the delegated length.
+        EXPECT_EQ(0, candidate.toBytes()[8]);
+    }
+    EXPECT_LT(5, addrs.size());
+
+    // The client gets the same address and prefix again.
+    EXPECT_EQ(addr, alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+    EXPECT_EQ(prefix, pd_alloc.pickAddress(subnet_, duid_, IOAddress("::")));
+
+    // If the prefix is leased, the next free one is picked without
+    // rehashing.
+    LeaseMgrFactory::instance().getAddressIndex().add(prefix);
+    const IOAddress next = pd_alloc.pickAddress(subnet_, duid_,
+                                                IOAddress("::"));
+    EXPECT_NE(prefix, next);
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, next));
+}
+
+// This test verifies that the random allocator picks addresses and prefixes
+// that belong to the pools.
+TEST_F(AllocEngine6Test, RandomAllocator) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_NA);
+    NakedAllocEngine::RandomAllocator pd_alloc(Lease::TYPE_PD);
+
+    std::set<IOAddress> addrs;
+    for (int i = 0; i < 1000; ++i) {
+        IOAddress candidate = alloc.pickAddress(subnet_, duid_,
+                                                IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_NA, candidate));
+        addrs.insert(candidate);
+        candidate = pd_alloc.pickAddress(subnet_, duid_, IOAddress("::"));
+        EXPECT_TRUE(subnet_->inPool(Lease::TYPE_PD, candidate));
+    }
+    // All 17 addresses of the pool are very likely picked.
+    EXPECT_LT(10, addrs.size());
+}
+
+// This test checks that the addresses can be allocated with the hashed and
+// random allocators until the pool is depleted.
+TEST_F(AllocEngine6Test, hashedAndRandomAlloc6) {
+    const AllocEngine::AllocType types[] = { AllocEngine::ALLOC_HASHED,
+                                             AllocEngine::ALLOC_RANDOM };
+    for (int t = 0; t < 2; ++t) {
+        SCOPED_TRACE(t == 0 ? "hashed" : "random");
+        factory_.create("type=memfile universe=6 persist=false");
+        AllocEngine engine(types[t], 3);
+
+        // The pool holds 17 addresses and each one is picked at the first
+        // attempt, as the leased addresses are skipped.
+        for (int i = 0; i < 17; ++i) {
+            duid_ = DuidPtr(new DUID(vector<uint8_t>(8, i)));
+            Lease6Ptr lease = expectOneLease(engine.allocateLeases6(
+                subnet_, duid_, iaid_, IOAddress("::"), Lease::TYPE_NA,
+                false, false, "", false, CalloutHandlePtr(), old_leases_));
+            ASSERT_TRUE(lease);
+            checkLease6(lease, Lease::TYPE_NA);
+        }
+        EXPECT_EQ(17, LeaseMgrFactory::instance().getAddressIndex().
+                  getUsedCount());
+    }
+}
+
 TEST_F(AllocEngine6Test, IterativeAllocatorAddrStep) {
     NakedAllocEngine::NakedIterativeAllocator alloc(Lease::TYPE_NA);
 
@@ -992,11 +1085,13 @@ TEST_F(AllocEngine6Test, requestReuseExpiredLease6) {
 TEST_F(AllocEngine4Test, constructor) {
     boost::scoped_ptr<AllocEngine> x;
 
-    // Hashed and random allocators are not supported yet
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5, false)),
-                 NotImplemented);
-    ASSERT_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5, false)),
-                 NotImplemented);
+    // Hashed and random allocators are supported
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_HASHED, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
+    ASSERT_NO_THROW(x.reset(new AllocEngine(AllocEngine::ALLOC_RANDOM, 5,
+                                            false)));
+    EXPECT_TRUE(x->getAllocator(Lease::TYPE_V4));
 
     // Create V4 (ipv6=false) Allocation Engine that will try at most
     // 100 attempts to pick up a lease
@@ -1310,6 +1405,118 @@ TEST_F(AllocEngine4Test, IterativeAllocator_manyPools4) {
 }
 
 
+// This test verifies that the iterative allocator skips the addresses for
+// which leases exist, according to the address index of the lease manager.
+TEST_F(AllocEngine4Test, IterativeAllocatorSkipsLeased4) {
+    NakedAllocEngine::IterativeAllocator alloc(Lease::TYPE_V4);
+
+    // Lease all addresses of the pool (192.0.2.100 - 192.0.2.109) except
+    // for .104 and .107.
+    uint8_t hwaddr2[] = { 0, 0xfe, 0xfe, 0xfe, 0xfe, 0xfe};
+    const uint32_t first = static_cast<uint32_t>(IOAddress("192.0.2.100"));
+    for (uint32_t i = 0; i < 10; ++i) {
+        if (i == 4 || i == 7) {
+            continue;
+        }
+        Lease4Ptr lease(new Lease4(IOAddress(first + i), hwaddr2,
+                                   sizeof(hwaddr2), 0, 0, 501, 502, 503,
+                                   time(NULL), subnet_->getID()));
+        ASSERT_TRUE(LeaseMgrFactory::instance().addLease(lease));
+    }
+
+    // Only the free addresses are picked.
+    EXPECT_EQ("192.0.2.104", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+    EXPECT_EQ("192.0.2.107", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+    EXPECT_EQ("192.0.2.104", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+
+    // Once the lease is deleted, the address is picked again.
+    ASSERT_TRUE(LeaseMgrFactory::instance().deleteLease(IOAddress("192.0.2.105")));
+    EXPECT_EQ("192.0.2.105", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+
+    // When all addresses are leased, the allocator iterates over them, so
+    // the expired leases can be reused.
+    LeaseMgrFactory::instance().getAddressIndex().add(IOAddress("192.0.2.104"));
+    LeaseMgrFactory::instance().getAddressIndex().add(IOAddress("192.0.2.105"));
+    LeaseMgrFactory::instance().getAddressIndex().add(IOAddress("192.0.2.107"));
+    EXPECT_EQ("192.0.2.106", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+    EXPECT_EQ("192.0.2.107", alloc.pickAddress(subnet_, clientid_,
+                                               IOAddress("0.0.0.0")).toText());
+}
+
+// This test verifies that the hashed allocator returns the same address to
+// the same client and that collisions are resolved with the address index.
+TEST_F(AllocEngine4Test, HashedAllocator4) {
+    NakedAllocEngine::HashedAllocator alloc(Lease::TYPE_V4);
+
+    const IOAddress addr = alloc.pickAddress(subnet_, clientid_,
+                                             IOAddress("0.0.0.0"));
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4, addr));
+    EXPECT_EQ(addr, alloc.pickAddress(subnet_, clientid_,
+                                      IOAddress("0.0.0.0")));
+
+    // The hash doesn't depend on the client identifier type.
+    EXPECT_EQ(NakedAllocEngine::HashedAllocator::hashDuid(clientid_),
+              NakedAllocEngine::HashedAllocator::
+              hashDuid(DuidPtr(new DUID(clientid_->getDuid()))));
+    EXPECT_NE(NakedAllocEngine::HashedAllocator::hashDuid(clientid_),
+              NakedAllocEngine::HashedAllocator::hashDuid(DuidPtr()));
+
+    // Clients without client identifier get an address too.
+    EXPECT_TRUE(subnet_->inPool(Lease::TYPE_V4,
+                                alloc.pickAddress(subnet_, ClientIdPtr(),
+                                                  IOAddress("0.0.0.0"))));
+
+    // Lease the hashed address and the following address (wrapping around
+    // the pool 192.0.2.100 - 192.0.2.109). The next one is picked.
+    uint32_t next = static_cast<uint32_t>(addr);
+    for (int i = 0; i < 2; ++i) {
+        LeaseMgrFactory::instance().getAddressIndex().add(IOAddress(next));
+        next = (next == static_cast<uint32_t>(IOAddress("192.0.2.109")) ?
+                static_cast<uint32_t>(IOAddress("192.0.2.100")) : next + 1);
+    }
+    EXPECT_EQ(IOAddress(next), alloc.pickAddress(subnet_, clientid_,
+                                                 IOAddress("0.0.0.0")));
+
+    // When all addresses are leased, the allocator walks over them from
+    // the hashed address, so the expired leases can be reused.
+    const uint32_t first = static_cast<uint32_t>(IOAddress("192.0.2.100"));
+    for (uint32_t i = 0; i < 10; ++i) {
+        LeaseMgrFactory::instance().getAddressIndex().add(IOAddress(first + i));
+    }
+    std::set<IOAddress> addrs;
+    for (int i = 0; i < 10; ++i) {
+        addrs.insert(alloc.pickAddress(subnet_, clientid_,
+                                       IOAddress("0.0.0.0")));
+    }
+    EXPECT_EQ(10, addrs.size());
+    EXPECT_EQ(1, addrs.count(addr));
+}
+
+// This test verifies that the random allocator picks the free addresses
+// of the pool.
+TEST_F(AllocEngine4Test, RandomAllocator4) {
+    NakedAllocEngine::RandomAllocator alloc(Lease::TYPE_V4);
+
+    // Lease all addresses but 192.0.2.105.
+    const uint32_t first = static_cast<uint32_t>(IOAddress("192.0.2.100"));
+    for (uint32_t i = 0; i < 10; ++i) {
+        if (i != 5) {
+            LeaseMgrFactory::instance().getAddressIndex().
+                add(IOAddress(first + i));
+        }
+    }
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ("192.0.2.105", alloc.pickAddress(subnet_, clientid_,
+                                                   IOAddress("0.0.0.0")).
+                  toText());
+    }
+}
+
 // This test checks if really small pools are working
 TEST_F(AllocEngine4Test, smallPool4) {
     boost::scoped_ptr<AllocEngine> engine;
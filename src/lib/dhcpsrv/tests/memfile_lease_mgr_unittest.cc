@@ -25,6 +25,7 @@
 #include <dhcpsrv/tests/generic_lease_mgr_unittest.h>
 #include <gtest/gtest.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -172,6 +173,34 @@ TEST_F(MemfileLeaseMgrTest, getLeaseFilePath) {
     EXPECT_TRUE(lease_mgr->getLeaseFilePath(Memfile_LeaseMgr::V6).empty());
 }
 
+// Checks that the address index is updated when leases are added and
+// deleted, and rebuilt when the leases are loaded from the lease file.
+TEST_F(MemfileLeaseMgrTest, addressIndex) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    EXPECT_EQ(0, lease_mgr->getAddressIndex().getUsedCount());
+
+    std::vector<Lease4Ptr> leases = createLeases4();
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_TRUE(lease_mgr->addLease(leases[i]));
+        EXPECT_TRUE(lease_mgr->getAddressIndex().isUsed(leases[i]->addr_));
+    }
+    EXPECT_EQ(3, lease_mgr->getAddressIndex().getUsedCount());
+
+    ASSERT_TRUE(lease_mgr->deleteLease(leases[1]->addr_));
+    EXPECT_FALSE(lease_mgr->getAddressIndex().isUsed(leases[1]->addr_));
+    EXPECT_EQ(2, lease_mgr->getAddressIndex().getUsedCount());
+
+    // The index is rebuilt from the lease file.
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_EQ(2, lease_mgr->getAddressIndex().getUsedCount());
+    EXPECT_TRUE(lease_mgr->getAddressIndex().isUsed(leases[0]->addr_));
+    EXPECT_FALSE(lease_mgr->getAddressIndex().isUsed(leases[1]->addr_));
+    EXPECT_TRUE(lease_mgr->getAddressIndex().isUsed(leases[2]->addr_));
+}
+
 // Check if the persitLeases correctly checks that leases should not be written
 // to disk when disabled through configuration.
 TEST_F(MemfileLeaseMgrTest, persistLeases) {
@@ -203,6 +232,189 @@ TEST_F(MemfileLeaseMgrTest, persistLeases) {
     EXPECT_FALSE(lease_mgr->persistLeases(Memfile_LeaseMgr::V6));
 }
 
+// Checks that the interval between the lease file cleanups is initialized
+// from the "lfc-interval" parameter.
+TEST_F(MemfileLeaseMgrTest, lfcInterval) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["persist"] = "false";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    EXPECT_EQ(0, lease_mgr->getLFCInterval());
+
+    pmap["lfc-interval"] = "3600";
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_EQ(3600, lease_mgr->getLFCInterval());
+
+    pmap["lfc-interval"] = "-1";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+    pmap["lfc-interval"] = "bogus";
+    EXPECT_THROW(lease_mgr.reset(new Memfile_LeaseMgr(pmap)), bundy::BadValue);
+}
+
+// Checks the names of the files used by the lease file cleanup.
+TEST_F(MemfileLeaseMgrTest, appendSuffix) {
+    EXPECT_EQ("leases.csv",
+              Memfile_LeaseMgr::appendSuffix("leases.csv",
+                                             Memfile_LeaseMgr::FILE_CURRENT));
+    EXPECT_EQ("leases.csv.1",
+              Memfile_LeaseMgr::appendSuffix("leases.csv",
+                                             Memfile_LeaseMgr::FILE_SNAPSHOT));
+    EXPECT_EQ("leases.csv.2",
+              Memfile_LeaseMgr::appendSuffix("leases.csv",
+                                             Memfile_LeaseMgr::FILE_PREVIOUS));
+    EXPECT_EQ("leases.csv.output",
+              Memfile_LeaseMgr::appendSuffix("leases.csv",
+                                             Memfile_LeaseMgr::FILE_OUTPUT));
+}
+
+// Checks that the lease file cleanup replaces the history of DHCPv4 lease
+// updates with the current leases, and that the leases are restored from
+// the resulting files.
+TEST_F(MemfileLeaseMgrTest, leaseFileCleanup4) {
+    LeaseFileIO snapshot(io4_.testfile_ + ".1");
+    LeaseFileIO previous(io4_.testfile_ + ".2");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    // Add some leases, then update one and delete another, so the lease
+    // file holds records which are not needed anymore.
+    std::vector<Lease4Ptr> leases = createLeases4();
+    for (size_t i = 0; i < 4; ++i) {
+        ASSERT_TRUE(lease_mgr->addLease(leases[i]));
+    }
+    leases[1]->valid_lft_ = 1000;
+    lease_mgr->updateLease4(leases[1]);
+    ASSERT_TRUE(lease_mgr->deleteLease(leases[2]->addr_));
+
+    ASSERT_TRUE(lease_mgr->startLFC());
+    // The lease file has been rotated, so updates go to the new one.
+    EXPECT_TRUE(io4_.exists());
+    ASSERT_TRUE(lease_mgr->addLease(leases[4]));
+    ASSERT_TRUE(lease_mgr->deleteLease(leases[0]->addr_));
+    lease_mgr->waitLFC();
+    EXPECT_FALSE(lease_mgr->isLFCRunning());
+
+    // The snapshot replaces the rotated file.
+    EXPECT_TRUE(snapshot.exists());
+    EXPECT_FALSE(previous.exists());
+    EXPECT_FALSE(LeaseFileIO(io4_.testfile_ + ".output").exists());
+    const std::string snapshot_text = snapshot.readFile();
+    // The header and the leases 0, 1 and 3.
+    EXPECT_EQ(4, std::count(snapshot_text.begin(), snapshot_text.end(),
+                            '\n')) << snapshot_text;
+    const std::string current_text = io4_.readFile();
+    // The header, the lease 4 and the deletion of the lease 0.
+    EXPECT_EQ(3, std::count(current_text.begin(), current_text.end(),
+                            '\n')) << current_text;
+
+    // The leases are restored from the snapshot and the new lease file.
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease4(leases[0]->addr_));
+    Lease4Ptr lease = lease_mgr->getLease4(leases[1]->addr_);
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(1000, lease->valid_lft_);
+    EXPECT_FALSE(lease_mgr->getLease4(leases[2]->addr_));
+    EXPECT_TRUE(lease_mgr->getLease4(leases[3]->addr_));
+    EXPECT_TRUE(lease_mgr->getLease4(leases[4]->addr_));
+
+    // Another cleanup merges them into a new snapshot.
+    ASSERT_TRUE(lease_mgr->startLFC());
+    lease_mgr->waitLFC();
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease4(leases[0]->addr_));
+    EXPECT_TRUE(lease_mgr->getLease4(leases[1]->addr_));
+    EXPECT_TRUE(lease_mgr->getLease4(leases[3]->addr_));
+    EXPECT_TRUE(lease_mgr->getLease4(leases[4]->addr_));
+}
+
+// Checks the lease file cleanup of DHCPv6 leases.
+TEST_F(MemfileLeaseMgrTest, leaseFileCleanup6) {
+    LeaseFileIO snapshot(io6_.testfile_ + ".1");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "6";
+    pmap["name"] = io6_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+
+    std::vector<Lease6Ptr> leases = createLeases6();
+    for (size_t i = 0; i < 3; ++i) {
+        ASSERT_TRUE(lease_mgr->addLease(leases[i]));
+    }
+    ASSERT_TRUE(lease_mgr->deleteLease(leases[1]->addr_));
+
+    ASSERT_TRUE(lease_mgr->startLFC());
+    lease_mgr->waitLFC();
+    EXPECT_TRUE(snapshot.exists());
+
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_TRUE(lease_mgr->getLease6(leases[0]->type_, leases[0]->addr_));
+    EXPECT_FALSE(lease_mgr->getLease6(leases[1]->type_, leases[1]->addr_));
+    EXPECT_TRUE(lease_mgr->getLease6(leases[2]->type_, leases[2]->addr_));
+}
+
+// Checks that the lease file cleanup is not started if leases are not
+// written to disk.
+TEST_F(MemfileLeaseMgrTest, startLFCNoPersist) {
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["persist"] = "false";
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->startLFC());
+    EXPECT_FALSE(lease_mgr->isLFCRunning());
+    // Waiting without the cleanup in progress is no-op.
+    EXPECT_NO_THROW(lease_mgr->waitLFC());
+}
+
+// Checks that the leases are restored correctly if the lease file cleanup
+// has been interrupted, and that the next cleanup completes it.
+TEST_F(MemfileLeaseMgrTest, interruptedLFC4) {
+    LeaseFileIO snapshot(io4_.testfile_ + ".1");
+    LeaseFileIO previous(io4_.testfile_ + ".2");
+    const std::string header = "address,hwaddr,client_id,valid_lifetime,"
+        "expire,subnet_id,fqdn_fwd,fqdn_rev,hostname\n";
+
+    // The snapshot of an earlier cleanup, the rotated lease file being
+    // cleaned up and the current lease file.
+    snapshot.writeFile(header +
+                       "192.0.2.1,06:07:08:09:0a:bc,,200,200,8,1,1,\n"
+                       "192.0.2.2,06:07:08:09:0a:bd,,200,200,8,1,1,\n");
+    previous.writeFile(header +
+                       "192.0.2.1,06:07:08:09:0a:bc,,0,200,8,1,1,\n"
+                       "192.0.2.3,06:07:08:09:0a:be,,200,200,8,1,1,\n");
+    io4_.writeFile(header +
+                   "192.0.2.2,06:07:08:09:0a:bd,,300,300,8,1,1,\n"
+                   "192.0.2.4,06:07:08:09:0a:bf,,200,200,8,1,1,\n");
+
+    LeaseMgr::ParameterMap pmap;
+    pmap["universe"] = "4";
+    pmap["name"] = io4_.testfile_;
+    boost::scoped_ptr<Memfile_LeaseMgr> lease_mgr(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    Lease4Ptr lease = lease_mgr->getLease4(IOAddress("192.0.2.2"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(300, lease->valid_lft_);
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.4")));
+
+    // As the rotated file still exists, the current one is not rotated but
+    // the snapshot covers both.
+    ASSERT_TRUE(lease_mgr->startLFC());
+    lease_mgr->waitLFC();
+    EXPECT_FALSE(previous.exists());
+    EXPECT_TRUE(io4_.exists());
+
+    lease_mgr.reset(new Memfile_LeaseMgr(pmap));
+    EXPECT_FALSE(lease_mgr->getLease4(IOAddress("192.0.2.1")));
+    lease = lease_mgr->getLease4(IOAddress("192.0.2.2"));
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(300, lease->valid_lft_);
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.3")));
+    EXPECT_TRUE(lease_mgr->getLease4(IOAddress("192.0.2.4")));
+}
+
 
 // Checks that adding/getting/deleting a Lease6 object works.
 TEST_F(MemfileLeaseMgrTest, addGetDelete6) {
@@ -0,0 +1,228 @@
+// Copyright (C) 2026  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <config.h>
+
+#include <dhcp/dhcp4.h>
+#include <dhcp/pkt4.h>
+#include <dhcpsrv/packet_workers.h>
+#include <exceptions/exceptions.h>
+#include <util/threads/sync.h>
+
+#include <boost/bind.hpp>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace bundy;
+using namespace bundy::dhcp;
+using bundy::util::thread::CondVar;
+using bundy::util::thread::Mutex;
+
+namespace {
+
+typedef PacketWorkers<Pkt4Ptr> Workers;
+
+/// @brief Test fixture class for @c PacketWorkers.
+///
+/// It records the transaction ids of the packets passed to the handler.
+class PacketWorkersTest : public ::testing::Test {
+public:
+    /// @brief Handler recording the packet.
+    void handle(const Pkt4Ptr& pkt) {
+        Mutex::Locker locker(mutex_);
+        processed_.push_back(pkt->getTransid());
+        cond_.signal();
+    }
+
+    /// @brief Waits until the given number of packets have been handled.
+    void waitProcessed(size_t count) {
+        Mutex::Locker locker(mutex_);
+        while (processed_.size() < count) {
+            cond_.wait(mutex_);
+        }
+    }
+
+    /// @brief Returns the number of packets handled so far.
+    size_t processedCount() {
+        Mutex::Locker locker(mutex_);
+        return (processed_.size());
+    }
+
+    /// @brief Creates a packet with the given transaction id.
+    static Pkt4Ptr createPacket(uint32_t transid) {
+        return (Pkt4Ptr(new Pkt4(DHCPDISCOVER, transid)));
+    }
+
+    Mutex mutex_;
+    CondVar cond_;
+    std::vector<uint32_t> processed_;
+};
+
+// Checks that the constructor rejects invalid sizes.
+TEST_F(PacketWorkersTest, constructor) {
+    const Workers::Handler handler =
+        boost::bind(&PacketWorkersTest::handle, this, _1);
+    EXPECT_THROW(Workers(0, 10, handler), BadValue);
+    EXPECT_THROW(Workers(2, 0, handler), BadValue);
+}
+
+// Checks that the queued packets are processed by the workers.
+TEST_F(PacketWorkersTest, push) {
+    Workers workers(4, 100, boost::bind(&PacketWorkersTest::handle, this,
+                                        _1));
+    for (uint32_t transid = 0; transid < 50; ++transid) {
+        EXPECT_TRUE(workers.push(createPacket(transid)));
+    }
+    waitProcessed(50);
+
+    std::sort(processed_.begin(), processed_.end());
+    for (uint32_t transid = 0; transid < 50; ++transid) {
+        EXPECT_EQ(transid, processed_[transid]);
+    }
+}
+
+// Checks that the workers don't process packets while paused, and that
+// packets are dropped when the queue is full.
+TEST_F(PacketWorkersTest, pauseAndQueueFull) {
+    Workers workers(2, 3, boost::bind(&PacketWorkersTest::handle, this, _1));
+    {
+        Workers::Pause pause(&workers);
+        EXPECT_TRUE(workers.push(createPacket(1)));
+        EXPECT_TRUE(workers.push(createPacket(2)));
+        EXPECT_TRUE(workers.push(createPacket(3)));
+        EXPECT_FALSE(workers.push(createPacket(4)));
+
+        usleep(100000);
+        EXPECT_EQ(0, processedCount());
+    }
+    waitProcessed(3);
+    EXPECT_TRUE(workers.push(createPacket(5)));
+    waitProcessed(4);
+
+    // A pause with no workers does nothing.
+    Workers::Pause pause(NULL);
+}
+
+/// @brief Handler which receives other packets of the same client while
+/// processing one, as if other workers received them.
+class SerializedHandler {
+public:
+    SerializedHandler(Workers& workers, PacketWorkersTest& test) :
+        workers_(workers), test_(test)
+    {}
+
+    void operator()(const Pkt4Ptr& pkt) {
+        test_.handle(pkt);
+        if (pkt->getTransid() == 1) {
+            const Workers::ClientKey key(1, 1);
+            workers_.processSerialized(key, PacketWorkersTest::createPacket(2),
+                                       *this);
+            workers_.processSerialized(key, PacketWorkersTest::createPacket(3),
+                                       *this);
+            // Another client is not delayed.
+            workers_.processSerialized(Workers::ClientKey(1, 2),
+                                       PacketWorkersTest::createPacket(4),
+                                       *this);
+        }
+    }
+
+private:
+    Workers& workers_;
+    PacketWorkersTest& test_;
+};
+
+// Checks that the packets of a client are processed one at a time and
+// that only the newest waiting packet is processed.
+TEST_F(PacketWorkersTest, processSerialized) {
+    Workers workers(1, 10, boost::bind(&PacketWorkersTest::handle, this, _1));
+    SerializedHandler handler(workers, *this);
+
+    workers.processSerialized(Workers::ClientKey(1, 1), createPacket(1),
+                              handler);
+    ASSERT_EQ(3, processed_.size());
+    EXPECT_EQ(1, processed_[0]);
+    EXPECT_EQ(4, processed_[1]);
+    EXPECT_EQ(3, processed_[2]);
+
+    // The client is no longer being processed, so its next packet is
+    // processed at once.
+    processed_.clear();
+    workers.processSerialized(Workers::ClientKey(1, 1), createPacket(2),
+                              handler);
+    ASSERT_EQ(1, processed_.size());
+    EXPECT_EQ(2, processed_[0]);
+
+    // Packets with no client key are processed at once.
+    workers.processSerialized(Workers::ClientKey(), createPacket(5),
+                              handler);
+    ASSERT_EQ(2, processed_.size());
+}
+
+/// @brief Handler which throws.
+void
+throwingHandler(const Pkt4Ptr&) {
+    bundy_throw(Unexpected, "handler failure");
+}
+
+// Checks that a client is released if the processing of its packet fails.
+TEST_F(PacketWorkersTest, processSerializedThrow) {
+    Workers workers(1, 10, boost::bind(&PacketWorkersTest::handle, this, _1));
+    const Workers::ClientKey key(1, 1);
+    EXPECT_THROW(workers.processSerialized(key, createPacket(1),
+                                           &throwingHandler),
+                 Unexpected);
+
+    workers.processSerialized(key, createPacket(2),
+                              boost::bind(&PacketWorkersTest::handle, this,
+                                          _1));
+    ASSERT_EQ(1, processed_.size());
+    EXPECT_EQ(2, processed_[0]);
+}
+
+/// @brief Task incrementing a counter.
+void
+incrementTask(int* counter) {
+    ++*counter;
+}
+
+/// @brief Task which throws.
+void
+throwingTask() {
+    bundy_throw(Unexpected, "task failure");
+}
+
+// Checks that the posted tasks are run by runPostedTasks and that
+// exceptions thrown by the tasks don't stop the others.
+TEST_F(PacketWorkersTest, post) {
+    Workers workers(1, 10, boost::bind(&PacketWorkersTest::handle, this, _1));
+    int counter = 0;
+    workers.post(boost::bind(&incrementTask, &counter));
+    workers.post(&throwingTask);
+    workers.post(boost::bind(&incrementTask, &counter));
+    EXPECT_EQ(0, counter);
+
+    EXPECT_NO_THROW(workers.runPostedTasks());
+    EXPECT_EQ(2, counter);
+
+    // The tasks are run only once.
+    EXPECT_NO_THROW(workers.runPostedTasks());
+    EXPECT_EQ(2, counter);
+}
+
+} // end of anonymous namespace
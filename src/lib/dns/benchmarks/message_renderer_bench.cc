@@ -18,8 +18,10 @@
 #include <dns/labelsequence.h>
 #include <dns/messagerenderer.h>
 #include <oldmessagerenderer.h>
+#include <bucketmessagerenderer.h>
 
 #include <cassert>
+#include <sstream>
 #include <vector>
 
 using namespace std;
@@ -100,6 +102,24 @@ const char* const example_servfail_names[] = {
     "www.example.com", NULL
 };
 
+// Names contained in a large response, such as an AXFR message over TCP:
+// a number of distinct owner names in a zone, each followed by a target
+// name in another zone.  Such a message makes the compression table much
+// larger than typical UDP responses do.
+vector<Name>
+createLargeResponseNames(size_t n_names) {
+    vector<Name> names;
+    for (size_t i = 0; i < n_names; ++i) {
+        stringstream ss;
+        ss << "host" << i << ".example.com";
+        names.push_back(Name(ss.str()));
+        ss.str("");
+        ss << "mail" << (i % 16) << ".example.net";
+        names.push_back(Name(ss.str()));
+    }
+    return (names);
+}
+
 // An experimental "dumb" renderer for comparison.  It doesn't do any name
 // compression.  It simply ignores all setter method, returns a dummy value
 // for getter methods, and write names to the internal buffer as plain binary
@@ -152,20 +172,28 @@ main(int argc, char* argv[]) {
     cout << "Parameters:" << endl;
     cout << "  Iterations: " << iteration << endl;
 
-    typedef pair<const char* const*, string> DataSpec;
+    typedef pair<vector<Name>, string> DataSpec;
     vector<DataSpec> spec_list;
-    spec_list.push_back(DataSpec(root_to_com_names, "(positive response)"));
-    spec_list.push_back(DataSpec(example_nxdomain_names,
-                                 "(NXDOMAIN response)"));
-    spec_list.push_back(DataSpec(example_servfail_names,
-                                 "(SERVFAIL response)"));
+    const char* const* const builtin_data[] = {
+        root_to_com_names, example_nxdomain_names, example_servfail_names
+    };
+    const char* const builtin_desc[] = {
+        "(positive response)", "(NXDOMAIN response)", "(SERVFAIL response)"
+    };
+    for (size_t i = 0; i < sizeof(builtin_data) / sizeof(builtin_data[0]);
+         ++i) {
+        vector<Name> names;
+        for (size_t j = 0; builtin_data[i][j] != NULL; ++j) {
+            names.push_back(Name(builtin_data[i][j]));
+        }
+        spec_list.push_back(DataSpec(names, builtin_desc[i]));
+    }
+    spec_list.push_back(DataSpec(createLargeResponseNames(500),
+                                 "(large response)"));
     for (vector<DataSpec>::const_iterator it = spec_list.begin();
          it != spec_list.end();
          ++it) {
-        vector<Name> names;
-        for (size_t i = 0; it->first[i] != NULL; ++i) {
-            names.push_back(Name(it->first[i]));
-        }
+        const vector<Name>& names = it->first;
 
         typedef MessageRendererBenchMark<OldMessageRenderer>
             OldRendererBenchMark;
@@ -173,6 +201,13 @@ main(int argc, char* argv[]) {
         BenchMark<OldRendererBenchMark>(iteration,
                                         OldRendererBenchMark(names));
 
+        typedef MessageRendererBenchMark<BucketMessageRenderer>
+            BucketRendererBenchMark;
+        cout << "Benchmark for bucket MessageRenderer " << it->second
+             << endl;
+        BenchMark<BucketRendererBenchMark>(iteration,
+                                           BucketRendererBenchMark(names));
+
         typedef MessageRendererBenchMark<DumbMessageRenderer>
             DumbRendererBenchMark;
         cout << "Benchmark for dumb MessageRenderer " << it->second << endl;
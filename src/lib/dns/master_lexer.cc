@@ -93,6 +93,25 @@ struct MasterLexer::MasterLexerImpl {
                 separators_.test(c & 0x7f));
     }
 
+    // Set token_ to a string token of the given length.  If beg is non NULL,
+    // it's the start of the string in the memory-mapped source, and the
+    // token refers to it directly unless it can't be nul-terminated in place
+    // (see InputSource::terminate()); otherwise the string is in data_.
+    // The string must be contiguous in the source in the former case.
+    void setStringToken(const char* beg, size_t len, bool quoted) {
+        if (beg != NULL) {
+            if (source_->terminate(beg + len)) {
+                token_ = MasterToken(beg, len, quoted);
+                return;
+            }
+            data_.assign(beg, beg + len);
+        }
+        // make sure it nul-terminated as a c-str (excluded from token data).
+        // This also simplifies the case of an empty string.
+        data_.push_back('\0');
+        token_ = MasterToken(&data_.at(0), len, quoted);
+    }
+
     void setTotalSize() {
         assert(source_ != NULL);
         if (total_size_ != SOURCE_SIZE_UNKNOWN) {
@@ -517,6 +536,10 @@ String::handle(MasterLexer& lexer) const {
     std::vector<char>& data = getLexerImpl(lexer)->data_;
     data.clear();
 
+    // If the source is memory-mapped, the string is taken from there in
+    // place, so we only need to count the characters.
+    const char* const beg = getLexerImpl(lexer)->source_->getCurrentData();
+    size_t len = 0;
     bool escaped = false;
     while (true) {
         const int c = getLexerImpl(lexer)->skipComment(
@@ -524,15 +547,14 @@ String::handle(MasterLexer& lexer) const {
 
         if (getLexerImpl(lexer)->isTokenEnd(c, escaped)) {
             getLexerImpl(lexer)->source_->ungetChar();
-            // make sure it nul-terminated as a c-str (excluded from token
-            // data).
-            data.push_back('\0');
-            getLexerImpl(lexer)->token_ =
-                MasterToken(&data.at(0), data.size() - 1);
+            getLexerImpl(lexer)->setStringToken(beg, len, false);
             return;
         }
         escaped = (c == '\\' && !escaped);
-        data.push_back(c);
+        if (beg == NULL) {
+            data.push_back(c);
+        }
+        ++len;
     }
 }
 
@@ -581,6 +603,9 @@ Number::handle(MasterLexer& lexer) const {
     bool digits_only = true;
     std::vector<char>& data = getLexerImpl(lexer)->data_;
     data.clear();
+    // See String::handle()
+    const char* const beg = getLexerImpl(lexer)->source_->getCurrentData();
+    size_t len = 0;
     bool escaped = false;
 
     while (true) {
@@ -589,20 +614,20 @@ Number::handle(MasterLexer& lexer) const {
         if (getLexerImpl(lexer)->isTokenEnd(c, escaped)) {
             getLexerImpl(lexer)->source_->ungetChar();
             // We need to close the string whether it's digits-only (for
-            // lexical_cast) or not (see String::handle()).
-            data.push_back('\0');
+            // lexical_cast) or not (see String::handle()), so we first make
+            // it a string token.
+            getLexerImpl(lexer)->setStringToken(beg, len, false);
             if (digits_only) {
                 try {
                     const uint32_t number32 =
-                        boost::lexical_cast<uint32_t, const char*>(&data[0]);
+                        boost::lexical_cast<uint32_t, const char*>(
+                            token.getStringRegion().beg);
                     token = MasterToken(number32);
                 } catch (const boost::bad_lexical_cast&) {
                     // Since we already know we have only digits,
                     // range should be the only possible problem.
                     token = MasterToken(MasterToken::NUMBER_OUT_OF_RANGE);
                 }
-            } else {
-                token = MasterToken(&data.at(0), data.size() - 1);
             }
             return;
         }
@@ -610,7 +635,10 @@ Number::handle(MasterLexer& lexer) const {
             digits_only = false;
         }
         escaped = (c == '\\' && !escaped);
-        data.push_back(c);
+        if (beg == NULL) {
+            data.push_back(c);
+        }
+        ++len;
     }
 }
 
@@ -15,12 +15,20 @@
 #include <dns/master_lexer_inputsource.h>
 #include <dns/master_lexer.h>
 
+#include <algorithm>
 #include <istream>
 #include <iostream>
+#include <limits>
 #include <cassert>
 #include <cerrno>
 #include <cstring>
 
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace bundy {
 namespace dns {
 namespace master_lexer_internal {
@@ -82,6 +90,16 @@ getStreamSize(std::istream& is) {
     return (ret);
 }
 
+// The position of the terminator when there's none.
+const size_t NO_TERMINATOR = std::numeric_limits<size_t>::max();
+
+// The amount of the mapped data that we pass before releasing the pages
+// (see InputSource::compact()).
+const size_t MAP_RELEASE_SIZE = 1024 * 1024;
+
+// The amount of data read from the file into the mapping at a time.
+const size_t MAP_FILL_SIZE = 64 * 1024;
+
 } // end of unnamed namespace
 
 // Explicit definition of class static constant.  The value is given in the
@@ -94,6 +112,14 @@ InputSource::InputSource(std::istream& input_stream) :
     saved_line_(line_),
     buffer_pos_(0),
     total_pos_(0),
+    map_data_(NULL),
+    map_size_(0),
+    map_filled_(0),
+    map_fd_(-1),
+    map_start_(0),
+    map_released_(0),
+    term_pos_(NO_TERMINATOR),
+    term_char_(0),
     name_(createStreamName(input_stream)),
     input_(input_stream),
     input_size_(getStreamSize(input_))
@@ -126,20 +152,68 @@ InputSource::InputSource(const char* filename) :
     saved_line_(line_),
     buffer_pos_(0),
     total_pos_(0),
+    map_data_(NULL),
+    map_size_(0),
+    map_filled_(0),
+    map_fd_(-1),
+    map_start_(0),
+    map_released_(0),
+    term_pos_(NO_TERMINATOR),
+    term_char_(0),
     name_(filename),
-    input_(openFileStream(file_stream_, filename)),
-    input_size_(getStreamSize(input_))
+    input_(file_stream_),
+    input_size_(openFile(filename))
 {}
 
 InputSource::~InputSource()
 {
+    if (map_data_ != NULL) {
+        munmap(map_data_, map_size_);
+    }
+    if (map_fd_ != -1) {
+        close(map_fd_);
+    }
     if (file_stream_.is_open()) {
         file_stream_.close();
     }
 }
 
+size_t
+InputSource::openFile(const char* filename) {
+    // Map the file if it's a non-empty regular file.  In any other case,
+    // including failure of the mapping, we fall back to the file stream,
+    // which will also report the errors.
+    //
+    // We don't map the file itself: reading a page of such a mapping beyond
+    // the end of the file raises SIGBUS, which would happen if the file is
+    // truncated or rewritten during the load.  Instead, the file is read into
+    // an anonymous mapping, which only takes memory for the pages that are
+    // filled and not released yet (see compact()).
+    const int fd = open(filename, O_RDONLY);
+    if (fd != -1) {
+        struct stat st;
+        // (the last condition excludes files too large to be mapped)
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0 &&
+            static_cast<off_t>(static_cast<size_t>(st.st_size)) ==
+            st.st_size) {
+            void* const data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                                    MAP_PRIVATE | MAP_ANONYMOUS |
+                                    MAP_NORESERVE, -1, 0);
+            if (data != MAP_FAILED) {
+                map_data_ = static_cast<char*>(data);
+                map_size_ = st.st_size;
+                map_fd_ = fd;
+                return (map_size_);
+            }
+        }
+        close(fd);
+    }
+    openFileStream(file_stream_, filename);
+    return (getStreamSize(input_));
+}
+
 int
-InputSource::getChar() {
+InputSource::getStreamChar() {
     if (buffer_pos_ == buffer_.size()) {
         // We may have reached EOF at the last call to
         // getChar(). at_eof_ will be set then. We then simply return
@@ -175,10 +249,67 @@ InputSource::getChar() {
     return (c);
 }
 
+void
+InputSource::fillMap() {
+    assert(map_fd_ != -1);
+    const size_t len = std::min(MAP_FILL_SIZE, map_size_ - map_filled_);
+    ssize_t result;
+    do {
+        result = read(map_fd_, map_data_ + map_filled_, len);
+    } while (result == -1 && errno == EINTR);
+    // The file is shorter than it was when it was opened if we get nothing,
+    // so it was modified, and the data can't be trusted.
+    if (result <= 0) {
+        bundy_throw(MasterLexer::ReadError,
+                  "Error reading from the input file: " << getName());
+    }
+    map_filled_ += result;
+    if (map_filled_ == map_size_) {
+        close(map_fd_);
+        map_fd_ = -1;
+    }
+}
+
+bool
+InputSource::terminate(const char* end) {
+    assert(map_data_ != NULL);
+    const size_t pos = end - map_data_;
+    assert(pos >= map_start_);
+    if (pos >= map_size_) {
+        return (false);
+    }
+    assert(pos < map_filled_);
+    if (term_pos_ != NO_TERMINATOR) {
+        restoreTerminator();
+    }
+    term_pos_ = pos;
+    term_char_ = map_data_[pos];
+    map_data_[pos] = '\0';
+    return (true);
+}
+
+void
+InputSource::restoreTerminator() {
+    map_data_[term_pos_] = term_char_;
+    term_pos_ = NO_TERMINATOR;
+}
+
 void
 InputSource::ungetChar() {
     if (at_eof_) {
         at_eof_ = false;
+    } else if (map_data_ != NULL) {
+        if (total_pos_ == map_start_) {
+            bundy_throw(UngetBeforeBeginning,
+                      "Cannot skip before the start of buffer");
+        }
+        --total_pos_;
+        if (total_pos_ == term_pos_) {
+            restoreTerminator();
+        }
+        if (map_data_[total_pos_] == '\n') {
+            --line_;
+        }
     } else if (buffer_pos_ == 0) {
         bundy_throw(UngetBeforeBeginning,
                   "Cannot skip before the start of buffer");
@@ -193,6 +324,12 @@ InputSource::ungetChar() {
 
 void
 InputSource::ungetAll() {
+    if (map_data_ != NULL) {
+        total_pos_ = map_start_;
+        line_ = saved_line_;
+        at_eof_ = false;
+        return;
+    }
     assert(total_pos_ >= buffer_pos_);
     total_pos_ -= buffer_pos_;
     buffer_pos_ = 0;
@@ -207,6 +344,23 @@ InputSource::saveLine() {
 
 void
 InputSource::compact() {
+    if (map_data_ != NULL) {
+        map_start_ = total_pos_;
+        // The data before this point won't be read any more.  Release the
+        // pages of such data from time to time, so that the filled pages
+        // don't accumulate for large files.
+        if (map_start_ - map_released_ >= MAP_RELEASE_SIZE) {
+            static const size_t page_size = sysconf(_SC_PAGESIZE);
+            const size_t end = map_start_ - (map_start_ % page_size);
+            if (term_pos_ == NO_TERMINATOR || term_pos_ >= end) {
+                madvise(map_data_ + map_released_, end - map_released_,
+                        MADV_DONTNEED);
+                map_released_ = end;
+            }
+        }
+        return;
+    }
+
     if (buffer_pos_ == buffer_.size()) {
         buffer_.clear();
     } else {
@@ -36,6 +36,16 @@ namespace master_lexer_internal {
 /// can have multiple InputSources if $INCLUDE is used. The source can
 /// also be generic input stream (std::istream).
 ///
+/// If the source is a regular file, its content is read (when possible)
+/// into an anonymous memory mapping of the size of the file instead of
+/// through a stream.  The mapping is filled by blocks as the reading
+/// progresses, so only the part being read takes memory.  In that case
+/// \c getChar() and \c ungetChar() simply move a position in the mapped
+/// data, and the lexer can refer to the data in place for string tokens
+/// (see \c getCurrentData() and \c terminate()).  The file itself is not
+/// mapped, so a file which is truncated while being read results in a
+/// read error rather than a bus error.
+///
 /// This class is not meant for public use. We also enforce that
 /// instances are non-copyable.
 class InputSource : boost::noncopyable {
@@ -150,7 +160,57 @@ public:
     ///
     /// \throws MasterLexer::ReadError when reading from the input stream or
     /// file fails.
-    int getChar();
+    int getChar() {
+        if (map_data_ == NULL) {
+            return (getStreamChar());
+        }
+        if (total_pos_ == map_size_) {
+            at_eof_ = true;
+            return (END_OF_STREAM);
+        }
+        if (total_pos_ == map_filled_) {
+            fillMap();
+        } else if (total_pos_ == term_pos_) {
+            restoreTerminator();
+        }
+        const int c = map_data_[total_pos_];
+        ++total_pos_;
+        if (c == '\n') {
+            ++line_;
+        }
+        return (c);
+    }
+
+    /// \brief Returns the address of the next character to be read if the
+    /// source is memory-mapped, or NULL otherwise.
+    ///
+    /// The data starting at the returned address are those that
+    /// subsequent calls to \c getChar() will return, up to the end of the
+    /// source.  They are available only after they are returned by
+    /// \c getChar().
+    ///
+    /// \throw None
+    const char* getCurrentData() const {
+        return (map_data_ == NULL ? NULL : map_data_ + total_pos_);
+    }
+
+    /// \brief Makes the data of a memory-mapped source nul-terminated at
+    /// the given address.
+    ///
+    /// This replaces the character at \c end (which must be in the range
+    /// of the data returned by \c getCurrentData() since the last
+    /// \c compact()) with a nul character, so the data before it can be
+    /// used as a C string in place.  The original character is restored
+    /// when it's read again, and only one such terminator is kept at a
+    /// time; terminating a new position restores the previous one.
+    ///
+    /// It's not possible to terminate the data at the end of the source,
+    /// in which case this method returns false and the caller needs to
+    /// copy the data.
+    ///
+    /// \throw None
+    /// \return true if the data is terminated at \c end, false otherwise.
+    bool terminate(const char* end);
 
     /// \brief Skips backward a single character in the input
     /// source. The last-read character is unget.
@@ -168,6 +228,18 @@ public:
     void ungetAll();
 
 private:
+    // getChar() for sources that are not memory-mapped.
+    int getStreamChar();
+
+    // Open the file to read, by mapping it if possible, and return its size.
+    size_t openFile(const char* filename);
+
+    // Read the next block of the file into the mapped data.
+    void fillMap();
+
+    // Put back the character overwritten by terminate().
+    void restoreTerminator();
+
     bool at_eof_;
     size_t line_;
     size_t saved_line_;
@@ -176,6 +248,17 @@ private:
     size_t buffer_pos_;
     size_t total_pos_;
 
+    // These are used only if the source is memory-mapped, in which case
+    // total_pos_ is the position in the mapped data.
+    char* map_data_;            // the mapped data (NULL if not mapped)
+    size_t map_size_;           // the size of the mapped data
+    size_t map_filled_;         // the end of the data read from the file
+    int map_fd_;                // the file, until it's entirely read
+    size_t map_start_;          // the position of the last compact()
+    size_t map_released_;       // the end of the pages already released
+    size_t term_pos_;           // the position of the terminator, if any
+    char term_char_;            // the character overwritten by terminate()
+
     const std::string name_;
     std::ifstream file_stream_;
     std::istream& input_;
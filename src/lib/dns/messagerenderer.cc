@@ -42,14 +42,19 @@ namespace {     // hide internal-only names from the public namespaces
 /// objects in a hash table, and searches the table for the position of the
 /// longest match (ancestor) name against each new name to be rendered into
 /// the buffer.
+///
+/// An item whose \c len_ is 0 is an empty slot of the table; the root name
+/// (the only name of that length) is never stored.
 struct OffsetItem {
-    OffsetItem(size_t hash, size_t pos, size_t len) :
+    OffsetItem() : hash_(0), pos_(0), len_(0) {}
+    OffsetItem(uint32_t hash, size_t pos, size_t len) :
         hash_(hash), pos_(pos), len_(len)
     {}
 
-    /// The hash value for the stored name calculated by LabelSequence.getHash.
-    /// This will help make name comparison in \c NameCompare more efficient.
-    size_t hash_;
+    /// The hash value for the stored name calculated by LabelSequence.getHash
+    /// (truncated to 32 bits).  This will help make name comparison in
+    /// \c NameCompare more efficient.
+    uint32_t hash_;
 
     /// The position (offset from the beginning) in the buffer where the
     /// name starts.
@@ -76,7 +81,7 @@ struct NameCompare {
     /// name to be newly rendered (and only that data).
     /// \param hash The hash value for the name.
     NameCompare(const OutputBuffer& buffer, InputBuffer& name_buf,
-                size_t hash) :
+                uint32_t hash) :
         buffer_(&buffer), name_buf_(&name_buf), hash_(hash)
     {}
 
@@ -144,7 +149,7 @@ private:
 
     const OutputBuffer* buffer_;
     InputBuffer* name_buf_;
-    const size_t hash_;
+    const uint32_t hash_;
 };
 }
 
@@ -158,13 +163,19 @@ private:
 /// It internally holds a hash table for OffsetItem objects corresponding
 /// to portions of names rendered in this renderer.  The offset information
 /// is used to compress subsequent names to be rendered.
+///
+/// The table is a flat array of items with open addressing (linear
+/// probing), so a lookup normally touches only one or two contiguous items
+/// and the buffer is read only when the hash and length of an item match.
+/// The initial size is enough for typical responses, so no memory is
+/// allocated for rendering them.  The table is doubled when it gets half
+/// full.  The used slots are recorded so \c clear() only needs to reset
+/// them.
 struct MessageRenderer::MessageRendererImpl {
-    // The size of hash buckets and number of hash entries per bucket for
-    // which space is preallocated and kept reserved for subsequent rendering
-    // to provide better performance.  These values are derived from the
-    // BIND 9 implementation that uses a similar hash table.
-    static const size_t BUCKETS = 64;
-    static const size_t RESERVED_ITEMS = 16;
+    // The initial (and minimum) number of slots of the table.  Each name
+    // adds one item per label (except the root), so this allows 128 of
+    // them before the table is enlarged.  It must be a power of 2.
+    static const size_t INITIAL_TABLE_SIZE = 256;
     static const uint16_t NO_OFFSET = 65535; // used as a marker of 'not found'
 
     /// \brief Constructor
@@ -172,43 +183,104 @@ struct MessageRenderer::MessageRendererImpl {
         msglength_limit_(512), truncated_(false),
         compress_mode_(MessageRenderer::CASE_INSENSITIVE)
     {
-        // Reserve some spaces for hash table items.
-        for (size_t i = 0; i < BUCKETS; ++i) {
-            table_[i].reserve(RESERVED_ITEMS);
+        resetTable(INITIAL_TABLE_SIZE);
+    }
+
+    // (Re)allocate the table with the given number of empty slots.
+    void resetTable(size_t size) {
+        vector<OffsetItem>(size).swap(table_);
+        table_mask_ = size - 1;
+        hash_shift_ = 32;
+        for (size_t n = size; n > 1; n >>= 1) {
+            --hash_shift_;
+        }
+        vector<uint16_t> new_used;
+        new_used.reserve(size / 2);
+        new_used.swap(used_slots_);
+    }
+
+    // Return the slot to start probing for the given hash.  We use the
+    // higher bits of the multiplicative (Fibonacci) hash so all bits of
+    // the original hash value affect the slot.
+    size_t getSlot(uint32_t hash) const {
+        return (static_cast<uint32_t>(hash * 2654435761u) >> hash_shift_);
+    }
+
+    template <bool CASE_SENSITIVE>
+    uint16_t findOffset(const OutputBuffer& buffer, InputBuffer& name_buf,
+                        uint32_t hash) const
+    {
+        const NameCompare<CASE_SENSITIVE> compare(buffer, name_buf, hash);
+        for (size_t slot = getSlot(hash); table_[slot].len_ != 0;
+             slot = (slot + 1) & table_mask_) {
+            if (compare(table_[slot])) {
+                return (table_[slot].pos_);
+            }
         }
+        return (NO_OFFSET);
     }
 
     uint16_t findOffset(const OutputBuffer& buffer, InputBuffer& name_buf,
-                        size_t hash, bool case_sensitive) const
+                        uint32_t hash, bool case_sensitive) const
     {
-        // Find a matching entry, if any.  We use some heuristics here: often
-        // the same name appears consecutively (like repeating the same owner
-        // name for a single RRset), so in case there's a collision in the
-        // bucket it will be more likely to find it in the tail side of the
-        // bucket.
-        const size_t bucket_id = hash % BUCKETS;
-        vector<OffsetItem>::const_reverse_iterator found;
         if (case_sensitive) {
-            found = find_if(table_[bucket_id].rbegin(),
-                            table_[bucket_id].rend(),
-                            NameCompare<true>(buffer, name_buf, hash));
-        } else {
-            found = find_if(table_[bucket_id].rbegin(),
-                            table_[bucket_id].rend(),
-                            NameCompare<false>(buffer, name_buf, hash));
+            return (findOffset<true>(buffer, name_buf, hash));
         }
-        if (found != table_[bucket_id].rend()) {
-            return (found->pos_);
+        return (findOffset<false>(buffer, name_buf, hash));
+    }
+
+    void addOffset(uint32_t hash, size_t offset, size_t len) {
+        if ((used_slots_.size() + 1) * 2 > table_.size()) {
+            growTable();
+        }
+        insertItem(OffsetItem(hash, offset, len));
+    }
+
+    void insertItem(const OffsetItem& item) {
+        size_t slot = getSlot(item.hash_);
+        while (table_[slot].len_ != 0) {
+            slot = (slot + 1) & table_mask_;
+        }
+        table_[slot] = item;
+        used_slots_.push_back(slot);
+    }
+
+    void growTable() {
+        vector<OffsetItem> old_table;
+        old_table.swap(table_);
+        vector<uint16_t> old_used;
+        old_used.swap(used_slots_);
+        resetTable(old_table.size() * 2);
+        for (vector<uint16_t>::const_iterator it = old_used.begin();
+             it != old_used.end();
+             ++it) {
+            insertItem(old_table[*it]);
         }
-        return (NO_OFFSET);
     }
 
-    void addOffset(size_t hash, size_t offset, size_t len) {
-        table_[hash % BUCKETS].push_back(OffsetItem(hash, offset, len));
+    void clearTable() {
+        if (table_.size() > INITIAL_TABLE_SIZE) {
+            // Trim excessive space used for a large message, so the
+            // renderer only keeps reasonably large space.
+            resetTable(INITIAL_TABLE_SIZE);
+            return;
+        }
+        for (vector<uint16_t>::const_iterator it = used_slots_.begin();
+             it != used_slots_.end();
+             ++it) {
+            table_[*it].len_ = 0;
+        }
+        used_slots_.clear();
     }
 
-    // The hash table for the (offset + position in the buffer) entries
-    vector<OffsetItem> table_[BUCKETS];
+    // The hash table for the (offset + position in the buffer) entries.
+    // The offsets are limited to Name::MAX_COMPRESS_POINTER, so its size
+    // never exceeds 32768 and slot numbers fit in 16 bits.
+    vector<OffsetItem> table_;
+    // The slots of table_ that are in use
+    vector<uint16_t> used_slots_;
+    size_t table_mask_;
+    unsigned int hash_shift_;
     /// The maximum length of rendered data that can fit without
     /// truncation.
     uint16_t msglength_limit_;
@@ -221,7 +293,7 @@ struct MessageRenderer::MessageRendererImpl {
     // Placeholder for hash values as they are calculated in writeName().
     // Note: we may want to make it a local variable of writeName() if it
     // works more efficiently.
-    boost::array<size_t, Name::MAX_LABELS> seq_hashes_;
+    boost::array<uint32_t, Name::MAX_LABELS> seq_hashes_;
 };
 
 MessageRenderer::MessageRenderer() :
@@ -239,19 +311,7 @@ MessageRenderer::clear() {
     impl_->msglength_limit_ = 512;
     impl_->truncated_ = false;
     impl_->compress_mode_ = CASE_INSENSITIVE;
-
-    // Clear the hash table.  We reserve the minimum space for possible
-    // subsequent use of the renderer.
-    for (size_t i = 0; i < MessageRendererImpl::BUCKETS; ++i) {
-        if (impl_->table_[i].size() > MessageRendererImpl::RESERVED_ITEMS) {
-            // Trim excessive capacity: swap ensures the new capacity is only
-            // reasonably large for the reserved space.
-            vector<OffsetItem> new_table;
-            new_table.reserve(MessageRendererImpl::RESERVED_ITEMS);
-            new_table.swap(impl_->table_[i]);
-        }
-        impl_->table_[i].clear();
-    }
+    impl_->clearTable();
 }
 
 size_t
@@ -18,11 +18,13 @@
 
 #include <gtest/gtest.h>
 
+#include <fstream>
 #include <iostream>
 #include <sstream>
 #include <string>
 
 #include <string.h>
+#include <unistd.h>
 
 using namespace std;
 using namespace bundy::dns;
@@ -141,6 +143,62 @@ TEST_F(InputSourceTest, file) {
     checkGetAndUngetChar(source, str.c_str(), str.size());
 }
 
+// A file source is memory-mapped, and the data can be nul-terminated in
+// place.
+TEST_F(InputSourceTest, mappedFile) {
+    // A stream source isn't mapped.
+    EXPECT_EQ(static_cast<const char*>(NULL), source_.getCurrentData());
+
+    InputSource source(TEST_DATA_SRCDIR "/masterload.txt");
+    const char* const data = source.getCurrentData();
+    ASSERT_NE(static_cast<const char*>(NULL), data);
+    EXPECT_EQ(';', source.getChar());
+    EXPECT_EQ(data + 1, source.getCurrentData());
+
+    // Terminate the data after ";;".  The original character is returned
+    // when it's read.
+    EXPECT_TRUE(source.terminate(data + 2));
+    EXPECT_EQ(string(";;"), string(data));
+    EXPECT_EQ(';', source.getChar());
+    EXPECT_EQ(' ', source.getChar());
+    EXPECT_EQ(';', data[0]);
+    EXPECT_EQ(' ', data[2]);
+
+    // The same for the case where it's ungotten and read again.
+    EXPECT_TRUE(source.terminate(data + 1));
+    EXPECT_EQ(string(";"), string(data));
+    source.ungetAll();
+    EXPECT_EQ(data, source.getCurrentData());
+    EXPECT_EQ(';', source.getChar());
+    EXPECT_EQ(';', source.getChar());
+    EXPECT_EQ(';', data[1]);
+
+    // The data can't be terminated at the end.
+    EXPECT_FALSE(source.terminate(data + source.getSize()));
+}
+
+// If a mapped file is truncated while it's being read, the rest can't be
+// read, which results in a read error.
+TEST_F(InputSourceTest, truncatedMappedFile) {
+    const char* const filename = TEST_DATA_BUILDDIR "/truncated.txt";
+    {
+        ofstream fs(filename);
+        for (size_t i = 0; i < 100000; ++i) {
+            fs << "example.org. 3600 IN A 192.0.2.1\n";
+        }
+    }
+    InputSource source(filename);
+    ASSERT_NE(static_cast<const char*>(NULL), source.getCurrentData());
+    EXPECT_EQ('e', source.getChar());
+
+    ASSERT_EQ(0, truncate(filename, 0));
+    EXPECT_THROW({
+        while (source.getChar() != InputSource::END_OF_STREAM) {
+        }
+    }, MasterLexer::ReadError);
+    unlink(filename);
+}
+
 // ungetAll() should skip back to the place where the InputSource
 // started at construction, or the last saved start of line.
 TEST_F(InputSourceTest, ungetAll) {
@@ -24,6 +24,7 @@
 #include <boost/scoped_ptr.hpp>
 #include <boost/bind.hpp>
 
+#include <fstream>
 #include <string>
 #include <sstream>
 
@@ -526,4 +527,52 @@ TEST_F(MasterLexerTest, getNextTokenErrors) {
               lexer.getNextToken(MasterToken::STRING).getString());
 }
 
+// A file source is memory-mapped and string tokens refer to the mapped data
+// in place.  Check the result is the same as that of the stream version,
+// including the nul-termination of the strings and reading tokens again
+// after ungetToken().
+TEST_F(MasterLexerTest, mappedFile) {
+    const char* const files[] = {
+        TEST_DATA_SRCDIR "/example.org",
+        TEST_DATA_SRCDIR "/masterload.txt",
+        TEST_DATA_SRCDIR "/broken.zone", // no newline at the end of file
+        NULL
+    };
+    for (size_t i = 0; files[i] != NULL; ++i) {
+        SCOPED_TRACE(files[i]);
+        MasterLexer file_lexer;
+        ASSERT_TRUE(file_lexer.pushSource(files[i]));
+        std::ifstream ifs(files[i]);
+        MasterLexer stream_lexer;
+        stream_lexer.pushSource(ifs);
+
+        const MasterLexer::Options options =
+            MasterLexer::NUMBER | MasterLexer::QSTRING;
+        for (size_t count = 0; ; ++count) {
+            // Every other token is read twice
+            if (count % 2 != 0) {
+                file_lexer.getNextToken(options);
+                file_lexer.ungetToken();
+            }
+            const MasterToken& token = file_lexer.getNextToken(options);
+            const MasterToken& expected = stream_lexer.getNextToken(options);
+            ASSERT_EQ(expected.getType(), token.getType());
+            EXPECT_EQ(stream_lexer.getSourceLine(),
+                      file_lexer.getSourceLine());
+            EXPECT_EQ(stream_lexer.getPosition(), file_lexer.getPosition());
+            if (token.getType() == MasterToken::STRING ||
+                token.getType() == MasterToken::QSTRING) {
+                EXPECT_EQ(expected.getString(), token.getString());
+                const MasterToken::StringRegion& region =
+                    token.getStringRegion();
+                EXPECT_EQ('\0', region.beg[region.len]);
+            } else if (token.getType() == MasterToken::NUMBER) {
+                EXPECT_EQ(expected.getNumber(), token.getNumber());
+            } else if (token.getType() == MasterToken::END_OF_FILE) {
+                break;
+            }
+        }
+    }
+}
+
 }
@@ -295,4 +295,28 @@ TEST_F(MessageRendererTest, manyRRs) {
     // any disruption.
     EXPECT_NO_THROW(renderer.clear());
 }
+
+TEST_F(MessageRendererTest, compressAfterClear) {
+    // Check compression works for both a small number of names and a large
+    // one (which enlarges the compression table), and names rendered before
+    // clear() are not used for compression after that.
+    const size_t counts[] = { 10, 1000 };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+        for (size_t j = 0; j < counts[i]; ++j) {
+            renderer.writeName(Name(lexical_cast<std::string>(j) +
+                                    ".example"));
+        }
+        const size_t length = renderer.getLength();
+        renderer.writeName(Name("0.example"));
+        EXPECT_EQ(length + 2, renderer.getLength());
+        renderer.writeName(Name(lexical_cast<std::string>(counts[i] - 1) +
+                                ".EXAMPLE"));
+        EXPECT_EQ(length + 4, renderer.getLength());
+
+        renderer.clear();
+        renderer.writeName(Name("0.example"));
+        EXPECT_EQ(Name("0.example").getLength(), renderer.getLength());
+        renderer.clear();
+    }
+}
 }
@@ -60,6 +60,7 @@ HooksManager::calloutsPresent(int index) {
 
 void
 HooksManager::callCalloutsInternal(int index, CalloutHandle& handle) {
+    bundy::util::thread::Mutex::Locker locker(callouts_mutex_);
     conditionallyInitialize();
     return (callout_manager_->callCallouts(index, handle));
 }
@@ -16,6 +16,7 @@
 #define HOOKS_MANAGER_H
 
 #include <hooks/server_hooks.h>
+#include <util/threads/sync.h>
 
 #include <boost/noncopyable.hpp>
 #include <boost/shared_ptr.hpp>
@@ -105,6 +106,10 @@ public:
     /// @note This method invalidates the current library index set with
     ///       setLibraryIndex().
     ///
+    /// Calls from different threads are serialized, so the callouts of a
+    /// library never run concurrently. Callouts must not wait for another
+    /// thread which may call this method.
+    ///
     /// @param index Index of the hook to call.
     /// @param handle Reference to the CalloutHandle object for the current
     ///        object being processed.
@@ -308,6 +313,10 @@ private:
 
     /// Callout manager for the set of library managers.
     boost::shared_ptr<CalloutManager> callout_manager_;
+
+    /// Serializes the calls to the callouts, as the callout manager keeps
+    /// the state of the current call.
+    bundy::util::thread::Mutex callouts_mutex_;
 };
 
 } // namespace util
@@ -0,0 +1,259 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#include <log/async_output.h>
+#include <log/logger_manager.h>
+#include <log/interprocess/interprocess_sync_file.h>
+
+#include <exceptions/exceptions.h>
+
+#include <boost/bind.hpp>
+
+#include <algorithm>
+#include <cstring>
+
+using namespace bundy::util::thread;
+
+namespace bundy {
+namespace log {
+
+AsyncOutput* AsyncOutput::instance_ = NULL;
+
+void
+AsyncOutput::start(size_t capacity) {
+    if (capacity == 0) {
+        bundy_throw(BadValue, "capacity of the log message buffers is zero");
+    }
+    if (!instance_) {
+        instance_ = new AsyncOutput(capacity);
+    }
+}
+
+void
+AsyncOutput::stop() {
+    AsyncOutput* output = instance_;
+    instance_ = NULL;
+    delete output;
+}
+
+bool
+AsyncOutput::isRunning() {
+    return (instance_ != NULL);
+}
+
+void
+AsyncOutput::flush() {
+    if (instance_) {
+        instance_->waitWritten();
+    }
+}
+
+bool
+AsyncOutput::push(const log4cplus::Logger& logger, log4cplus::LogLevel level,
+                  const std::string& message)
+{
+    AsyncOutput* output = instance_;
+    if (!output) {
+        return (false);
+    }
+    output->append(Record(logger, level, message));
+    if (level >= log4cplus::FATAL_LOG_LEVEL) {
+        output->waitWritten();
+    }
+    return (true);
+}
+
+AsyncOutput::AsyncOutput(size_t capacity) :
+    capacity_(capacity), pending_(false), stopping_(false), started_(0),
+    completed_(0), sync_(new interprocess::InterprocessSyncFile("logger"))
+{
+    const int result = pthread_key_create(&key_, &AsyncOutput::retireBuffer);
+    if (result != 0) {
+        bundy_throw(Unexpected, "unable to create the key of the log "
+                    "message buffers: " << std::strerror(result));
+    }
+    thread_.reset(new Thread(boost::bind(&AsyncOutput::run, this)));
+}
+
+AsyncOutput::~AsyncOutput() {
+    {
+        Mutex::Locker locker(mutex_);
+        stopping_ = true;
+        wakeup_.signal();
+    }
+    try {
+        thread_->wait();
+    } catch (...) {
+        // The thread catches all exceptions, ignore any unexpected one.
+    }
+
+    // No more thread specific buffers are expected: the buffers can be
+    // deleted without the terminating threads retiring them later.
+    pthread_key_delete(key_);
+    for (std::vector<ThreadBuffer*>::iterator buffer = buffers_.begin();
+         buffer != buffers_.end(); ++buffer) {
+        delete *buffer;
+    }
+}
+
+void
+AsyncOutput::append(const Record& record) {
+    ThreadBuffer& buffer = getBuffer();
+    bool was_empty;
+    {
+        Mutex::Locker locker(buffer.mutex_);
+        // The output thread has been woken up when the first record was
+        // added to the buffer, it will take the records.
+        while (buffer.records_.size() >= capacity_) {
+            buffer.taken_.wait(buffer.mutex_);
+        }
+        was_empty = buffer.records_.empty();
+        buffer.records_.push_back(record);
+    }
+    if (was_empty) {
+        Mutex::Locker locker(mutex_);
+        pending_ = true;
+        wakeup_.signal();
+    }
+}
+
+void
+AsyncOutput::waitWritten() {
+    Mutex::Locker locker(mutex_);
+    // Any cycle starting after this point takes the records appended
+    // before, whether the output thread is waiting or in a cycle now.
+    const uint64_t target = started_ + 1;
+    pending_ = true;
+    wakeup_.signal();
+    while (completed_ < target) {
+        written_.wait(mutex_);
+    }
+}
+
+AsyncOutput::ThreadBuffer&
+AsyncOutput::getBuffer() {
+    ThreadBuffer* buffer =
+        static_cast<ThreadBuffer*>(pthread_getspecific(key_));
+    if (!buffer) {
+        buffer = new ThreadBuffer;
+        {
+            Mutex::Locker locker(mutex_);
+            buffers_.push_back(buffer);
+        }
+        pthread_setspecific(key_, buffer);
+    }
+    return (*buffer);
+}
+
+void
+AsyncOutput::retireBuffer(void* buffer) {
+    ThreadBuffer* thread_buffer = static_cast<ThreadBuffer*>(buffer);
+    Mutex::Locker locker(thread_buffer->mutex_);
+    thread_buffer->retired_ = true;
+}
+
+void
+AsyncOutput::run() {
+    bool stopping = false;
+    while (!stopping) {
+        std::vector<ThreadBuffer*> buffers;
+        uint64_t cycle;
+        {
+            Mutex::Locker locker(mutex_);
+            while (!pending_ && !stopping_) {
+                wakeup_.wait(mutex_);
+            }
+            pending_ = false;
+            stopping = stopping_;
+            cycle = ++started_;
+            buffers = buffers_;
+        }
+
+        // On stop, this last cycle writes the remaining messages.
+        drain(buffers);
+
+        Mutex::Locker locker(mutex_);
+        completed_ = cycle;
+        written_.broadcast();
+    }
+}
+
+void
+AsyncOutput::drain(const std::vector<ThreadBuffer*>& buffers) {
+    RecordVector records;
+    std::vector<ThreadBuffer*> retired;
+    for (std::vector<ThreadBuffer*>::const_iterator buffer = buffers.begin();
+         buffer != buffers.end(); ++buffer) {
+        {
+            Mutex::Locker locker((*buffer)->mutex_);
+            if ((*buffer)->records_.empty()) {
+                // The thread has terminated and all its records have been
+                // written.
+                if ((*buffer)->retired_) {
+                    retired.push_back(*buffer);
+                }
+                continue;
+            }
+            records.swap((*buffer)->records_);
+            (*buffer)->taken_.signal();
+        }
+        write(records);
+        records.clear();
+    }
+
+    if (!retired.empty()) {
+        Mutex::Locker locker(mutex_);
+        for (std::vector<ThreadBuffer*>::iterator buffer = retired.begin();
+             buffer != retired.end(); ++buffer) {
+            buffers_.erase(std::find(buffers_.begin(), buffers_.end(),
+                                     *buffer));
+            delete *buffer;
+        }
+    }
+}
+
+void
+AsyncOutput::write(const RecordVector& records) {
+    try {
+        // Use a mutex locker for mutual exclusion from other threads in
+        // this process (which write messages when the asynchronous output
+        // is stopped).
+        Mutex::Locker mutex_locker(LoggerManager::getMutex());
+
+        // Use an interprocess sync locker for mutual exclusion from other
+        // processes to avoid log messages getting interspersed.
+        interprocess::InterprocessSyncLocker locker(*sync_);
+        const log4cplus::Logger& logger = records.front().logger_;
+        if (!locker.lock()) {
+            logger.forcedLog(log4cplus::ERROR_LOG_LEVEL,
+                             "Unable to lock logger lockfile");
+        }
+
+        for (RecordVector::const_iterator record = records.begin();
+             record != records.end(); ++record) {
+            record->logger_.forcedLog(record->level_, record->message_);
+        }
+
+        if (!locker.unlock()) {
+            logger.forcedLog(log4cplus::ERROR_LOG_LEVEL,
+                             "Unable to unlock logger lockfile");
+        }
+    } catch (...) {
+        // There is nowhere to report the failure to write the log
+        // messages, but the output thread must keep running.
+    }
+}
+
+} // namespace log
+} // namespace bundy
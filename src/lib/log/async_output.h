@@ -0,0 +1,207 @@
+// Copyright (C) 2014  Internet Systems Consortium, Inc. ("ISC")
+//
+// Permission to use, copy, modify, and/or distribute this software for any
+// purpose with or without fee is hereby granted, provided that the above
+// copyright notice and this permission notice appear in all copies.
+//
+// THE SOFTWARE IS PROVIDED "AS IS" AND ISC DISCLAIMS ALL WARRANTIES WITH
+// REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF MERCHANTABILITY
+// AND FITNESS.  IN NO EVENT SHALL ISC BE LIABLE FOR ANY SPECIAL, DIRECT,
+// INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER RESULTING FROM
+// LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF CONTRACT, NEGLIGENCE
+// OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN CONNECTION WITH THE USE OR
+// PERFORMANCE OF THIS SOFTWARE.
+
+#ifndef ASYNC_OUTPUT_H
+#define ASYNC_OUTPUT_H
+
+#include <log/interprocess/interprocess_sync.h>
+#include <util/threads/sync.h>
+#include <util/threads/thread.h>
+
+#include <log4cplus/logger.h>
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_ptr.hpp>
+
+#include <pthread.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+namespace bundy {
+namespace log {
+
+/// \brief Asynchronous output of log messages
+///
+/// In the asynchronous mode, log messages are not written by the threads
+/// logging them.  Each thread appends its messages to a buffer of its own,
+/// and a single output thread takes the messages from all buffers and
+/// writes them to the log4cplus appenders in batches.  The output thread
+/// takes the process-wide logging mutex and the interprocess lock (a lock
+/// on a file) once per batch, instead of once per message.
+///
+/// A logging thread only shares the lock of its buffer with the output
+/// thread, which holds it just to take the whole contents of the buffer.
+/// The logging thread wakes up the output thread when it adds a message to
+/// an empty buffer, so the state shared by all threads is not touched for
+/// each message either.  If the buffer is full, the logging thread waits
+/// until the output thread has emptied it, so no message is lost.
+///
+/// The messages of a thread are written in the order they were logged.
+/// The time of a message (if written by the layout) is the time it is
+/// written by the output thread, which is usually a fraction of a second
+/// later.  The FATAL messages are written before \c push() returns, as
+/// the program is likely to terminate after logging them.
+///
+/// The class is used through the static methods.  \c start() and \c stop()
+/// must not be called while other threads log messages; they are meant to
+/// be called on initialization and shutdown of the program.
+class AsyncOutput : boost::noncopyable {
+public:
+    /// \brief Default maximum number of messages in the buffer of a thread
+    static const size_t DEFAULT_CAPACITY = 1024;
+
+    /// \brief Start the asynchronous output
+    ///
+    /// Starts the output thread.  The following messages are written by
+    /// it.  Calling this method when the asynchronous output is running is
+    /// a no-op.
+    ///
+    /// \param capacity Maximum number of messages in the buffer of a thread.
+    /// \throw bundy::BadValue the capacity is zero
+    static void start(size_t capacity = DEFAULT_CAPACITY);
+
+    /// \brief Stop the asynchronous output
+    ///
+    /// Writes the pending messages and stops the output thread.  The
+    /// following messages are written by the threads logging them.  Calling
+    /// this method when the asynchronous output is not running is a no-op.
+    static void stop();
+
+    /// \brief Is the asynchronous output running?
+    static bool isRunning();
+
+    /// \brief Wait until the pending messages are written
+    ///
+    /// Returns when the messages logged by any thread before the call have
+    /// been written.  Returns immediately if the asynchronous output is not
+    /// running.
+    static void flush();
+
+    /// \brief Queue a message for output
+    ///
+    /// The caller must have checked that the logger is enabled for the
+    /// level.
+    ///
+    /// \param logger Logger to which the message is written.
+    /// \param level Level of the message.
+    /// \param message Text of the message.
+    ///
+    /// \return true if the message has been queued, false if the
+    /// asynchronous output is not running (and the caller has to write the
+    /// message itself).
+    static bool push(const log4cplus::Logger& logger,
+                     log4cplus::LogLevel level, const std::string& message);
+
+private:
+    /// \brief A message waiting for output
+    struct Record {
+        Record(const log4cplus::Logger& logger, log4cplus::LogLevel level,
+               const std::string& message) :
+            logger_(logger), level_(level), message_(message)
+        {}
+
+        log4cplus::Logger logger_;
+        log4cplus::LogLevel level_;
+        std::string message_;
+    };
+
+    typedef std::vector<Record> RecordVector;
+
+    /// \brief Buffer of the messages of one thread
+    struct ThreadBuffer : boost::noncopyable {
+        ThreadBuffer() : retired_(false) {}
+
+        /// Protects the other members.
+        bundy::util::thread::Mutex mutex_;
+        /// Signaled when the records have been taken by the output thread.
+        bundy::util::thread::CondVar taken_;
+        /// The messages.
+        RecordVector records_;
+        /// Set when the thread has terminated.
+        bool retired_;
+    };
+
+    /// \brief Constructor
+    ///
+    /// Starts the output thread.
+    AsyncOutput(size_t capacity);
+
+    /// \brief Destructor
+    ///
+    /// Writes the pending messages and stops the output thread.
+    ~AsyncOutput();
+
+    /// \brief Add a message to the buffer of the calling thread
+    void append(const Record& record);
+
+    /// \brief Wait until the messages appended so far are written
+    void waitWritten();
+
+    /// \brief Return the buffer of the calling thread
+    ///
+    /// The buffer is created on the first call by a thread.
+    ThreadBuffer& getBuffer();
+
+    /// \brief Main function of the output thread
+    void run();
+
+    /// \brief Take the messages of all buffers and write them
+    ///
+    /// Also deletes the buffers of the terminated threads.
+    void drain(const std::vector<ThreadBuffer*>& buffers);
+
+    /// \brief Write a batch of messages
+    void write(const RecordVector& records);
+
+    /// \brief Mark a buffer as retired
+    ///
+    /// This is the destructor of the thread specific data, called when a
+    /// thread terminates.
+    static void retireBuffer(void* buffer);
+
+    /// \brief The running instance (NULL if not running)
+    static AsyncOutput* instance_;
+
+    /// Maximum number of messages in a buffer
+    const size_t capacity_;
+    /// Key of the thread specific buffers
+    pthread_key_t key_;
+    /// Protects the following members
+    bundy::util::thread::Mutex mutex_;
+    /// Signaled when there are messages to write or on stop
+    bundy::util::thread::CondVar wakeup_;
+    /// Signaled when a cycle of the output thread has completed
+    bundy::util::thread::CondVar written_;
+    /// Buffers of all threads
+    std::vector<ThreadBuffer*> buffers_;
+    /// Set when a buffer became non-empty or a flush is requested
+    bool pending_;
+    /// Set to stop the output thread
+    bool stopping_;
+    /// Number of the cycles the output thread has started
+    uint64_t started_;
+    /// Number of the cycles the output thread has completed
+    uint64_t completed_;
+    /// Synchronization with other processes writing to the same files
+    boost::scoped_ptr<interprocess::InterprocessSync> sync_;
+    /// The output thread (last, so it starts with the other members set)
+    boost::scoped_ptr<bundy::util::thread::Thread> thread_;
+};
+
+} // namespace log
+} // namespace bundy
+
+#endif // ASYNC_OUTPUT_H
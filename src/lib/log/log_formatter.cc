@@ -24,6 +24,27 @@
 using namespace std;
 using namespace boost;
 
+namespace {
+
+// Return the placeholder mark ("%1", "%2" etc.).  This is called for each
+// argument of each logged message, so the number is converted directly
+// rather than with lexical_cast.
+string
+placeholderMark(unsigned placeholder) {
+    char digits[sizeof(unsigned) * 3 + 1];
+    char* end = digits + sizeof(digits);
+    char* begin = end;
+    do {
+        *--begin = '0' + placeholder % 10;
+        placeholder /= 10;
+    } while (placeholder != 0);
+    string mark(1, '%');
+    mark.append(begin, end);
+    return (mark);
+}
+
+}
+
 namespace bundy {
 namespace log {
 
@@ -31,7 +52,7 @@ void
 replacePlaceholder(string* message, const string& arg,
                    const unsigned placeholder)
 {
-    const string mark("%" + lexical_cast<string>(placeholder));
+    const string mark(placeholderMark(placeholder));
     size_t pos(message->find(mark));
     if (pos != string::npos) {
         do {
@@ -55,7 +76,7 @@ replacePlaceholder(string* message, const string& arg,
 
 void
 checkExcessPlaceholders(string* message, unsigned int placeholder) {
-    const string mark("%" + lexical_cast<string>(placeholder));
+    const string mark(placeholderMark(placeholder));
     const size_t pos(message->find(mark));
     if (pos != string::npos) {
         // Excess placeholders were found.  If we enable the harsh check,
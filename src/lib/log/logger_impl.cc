@@ -24,6 +24,7 @@
 #include <log4cplus/configurator.h>
 #include <log4cplus/loggingmacros.h>
 
+#include <log/async_output.h>
 #include <log/logger.h>
 #include <log/logger_impl.h>
 #include <log/logger_level.h>
@@ -42,6 +43,42 @@
 
 using namespace std;
 
+namespace {
+
+// Convert the severity of a message to the log4cplus level it is logged at.
+// Returns false for the severities which are not logged.
+bool
+toLog4cplusLevel(const bundy::log::Severity& severity,
+                 log4cplus::LogLevel& level)
+{
+    switch (severity) {
+        case bundy::log::DEBUG:
+            level = log4cplus::DEBUG_LOG_LEVEL;
+            return (true);
+
+        case bundy::log::INFO:
+            level = log4cplus::INFO_LOG_LEVEL;
+            return (true);
+
+        case bundy::log::WARN:
+            level = log4cplus::WARN_LOG_LEVEL;
+            return (true);
+
+        case bundy::log::ERROR:
+            level = log4cplus::ERROR_LOG_LEVEL;
+            return (true);
+
+        case bundy::log::FATAL:
+            level = log4cplus::FATAL_LOG_LEVEL;
+            return (true);
+
+        default:
+            return (false);
+    }
+}
+
+} // Anonymous namespace
+
 namespace bundy {
 namespace log {
 
@@ -124,6 +161,16 @@ LoggerImpl::setInterprocessSync(bundy::log::interprocess::InterprocessSync* sync
 
 void
 LoggerImpl::outputRaw(const Severity& severity, const string& message) {
+    // In the asynchronous mode, the message is written by the output
+    // thread, which takes the locks below once for a batch of messages.
+    log4cplus::LogLevel level;
+    if (AsyncOutput::isRunning() && toLog4cplusLevel(severity, level)) {
+        if (!logger_.isEnabledFor(level) ||
+            AsyncOutput::push(logger_, level, message)) {
+            return;
+        }
+    }
+
     // Use a mutex locker for mutual exclusion from other threads in
     // this process.
     bundy::util::thread::Mutex::Locker mutex_locker(LoggerManager::getMutex());
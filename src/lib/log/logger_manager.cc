@@ -15,6 +15,9 @@
 #include <algorithm>
 #include <vector>
 
+#include <stdlib.h>
+
+#include <log/async_output.h>
 #include <log/logger.h>
 #include <log/logger_manager.h>
 #include <log/logger_manager_impl.h>
@@ -55,6 +58,12 @@ std::string& initRootName() {
     return (root);
 }
 
+// Write the pending messages on exit.  This is registered with atexit()
+// after log4cplus is initialized, so it runs before log4cplus is destroyed.
+void stopAsyncOutput() {
+    bundy::log::AsyncOutput::stop();
+}
+
 } // Anonymous namespace
 
 
@@ -74,6 +83,8 @@ LoggerManager::~LoggerManager() {
 // Initialize processing
 void
 LoggerManager::processInit() {
+    // The pending messages go to the current destinations.
+    AsyncOutput::flush();
     impl_->processInit();
 }
 
@@ -196,6 +207,26 @@ LoggerManager::reset() {
     LoggerManagerImpl::reset(initSeverity(), initDebugLevel());
 }
 
+void
+LoggerManager::setAsync(bool async) {
+    if (!async) {
+        AsyncOutput::stop();
+        return;
+    }
+
+    static bool exit_handler_registered = false;
+    if (!exit_handler_registered) {
+        atexit(stopAsyncOutput);
+        exit_handler_registered = true;
+    }
+    AsyncOutput::start();
+}
+
+bool
+LoggerManager::isAsync() {
+    return (AsyncOutput::isRunning());
+}
+
 bundy::util::thread::Mutex&
 LoggerManager::getMutex() {
     static bundy::util::thread::Mutex mutex;
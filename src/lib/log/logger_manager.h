@@ -135,6 +135,24 @@ public:
     /// \param file Name of the local message file
     static void readLocalMessageFile(const char* file);
 
+    /// \brief Enable or disable asynchronous output
+    ///
+    /// In the asynchronous mode, the log messages are queued by the
+    /// threads logging them and written by a separate output thread, in
+    /// batches.  This reduces the cost of logging for the threads, in
+    /// particular at high debug levels.  See \c AsyncOutput for details.
+    ///
+    /// When enabled, the asynchronous output is stopped (and the pending
+    /// messages are written) on exit of the program.  This must not be
+    /// called while other threads log messages.
+    ///
+    /// \param async true to enable the asynchronous output, false to
+    ///        disable it (writing the pending messages).
+    static void setAsync(bool async);
+
+    /// \brief Is the asynchronous output enabled?
+    static bool isAsync();
+
     /// \brief Return a process-global mutex that's used for mutual
     /// exclusion among threads of a single process during logging
     /// calls.
@@ -18,9 +18,12 @@
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <boost/bind.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/scoped_array.hpp>
 #include <boost/lexical_cast.hpp>
 
@@ -33,6 +36,9 @@
 #include <log/logger_manager.h>
 #include <log/logger_specification.h>
 #include <log/output_option.h>
+#include <log/async_output.h>
+
+#include <util/threads/thread.h>
 
 #include "tempdir.h"
 
@@ -246,6 +252,109 @@ TEST_F(LoggerManagerTest, FileLogger) {
     checkFileContents(file_spec.getFileName(), ids.begin(), ids.end());
 }
 
+// Log a number of messages, each one identifying the thread and its
+// sequence number in the thread.
+void
+logSequence(const string& logger_name, int thread, int count) {
+    Logger logger(logger_name.c_str());
+    for (int i = 0; i < count; ++i) {
+        LOG_WARN(logger, LOG_NO_SUCH_MESSAGE).
+            arg("thread-" + boost::lexical_cast<string>(thread) + "-" +
+                boost::lexical_cast<string>(i));
+    }
+}
+
+// Check that the messages of all threads in the file are complete and in
+// the order they were logged by each thread.
+void
+checkSequences(const string& filename, int threads, int count) {
+    ifstream infile(filename.c_str());
+    ASSERT_TRUE(infile.good()) << "Unable to open the logging file "
+                               << filename;
+    vector<int> next(threads, 0);
+    string line;
+    int lines = 0;
+    while (getline(infile, line)) {
+        ++lines;
+        const size_t pos = line.find("'thread-");
+        ASSERT_NE(string::npos, pos) << line;
+        int thread, seq;
+        ASSERT_EQ(2, sscanf(line.c_str() + pos, "'thread-%d-%d'",
+                            &thread, &seq)) << line;
+        ASSERT_LE(0, thread);
+        ASSERT_GT(threads, thread);
+        EXPECT_EQ(next[thread], seq) << line;
+        next[thread] = seq + 1;
+    }
+    EXPECT_EQ(threads * count, lines);
+}
+
+// Check that messages logged by several threads are written to the file in
+// the asynchronous mode.
+TEST_F(LoggerManagerTest, AsyncFileLogger) {
+    SpecificationForFileLogger file_spec;
+    LoggerManager manager;
+    manager.process(file_spec.getSpecification());
+
+    EXPECT_FALSE(LoggerManager::isAsync());
+    LoggerManager::setAsync(true);
+    EXPECT_TRUE(LoggerManager::isAsync());
+    // Enabling it again is a no-op.
+    LoggerManager::setAsync(true);
+    EXPECT_TRUE(LoggerManager::isAsync());
+
+    const int threads = 4;
+    const int count = 500;
+    {
+        vector<boost::shared_ptr<bundy::util::thread::Thread> > workers;
+        for (int i = 0; i < threads; ++i) {
+            workers.push_back(boost::shared_ptr<bundy::util::thread::Thread>(
+                new bundy::util::thread::Thread(
+                    boost::bind(&logSequence, file_spec.getLoggerName(), i,
+                                count))));
+        }
+        for (int i = 0; i < threads; ++i) {
+            workers[i]->wait();
+        }
+    }
+
+    // Disabling the asynchronous mode writes the pending messages.
+    LoggerManager::setAsync(false);
+    EXPECT_FALSE(LoggerManager::isAsync());
+    LoggerManager::reset();
+
+    checkSequences(file_spec.getFileName(), threads, count);
+}
+
+// Check that a thread waits for the output thread when its buffer is full,
+// and that the messages can be flushed.
+TEST_F(LoggerManagerTest, AsyncSmallBuffer) {
+    SpecificationForFileLogger file_spec;
+    LoggerManager manager;
+    manager.process(file_spec.getSpecification());
+
+    EXPECT_THROW(AsyncOutput::start(0), bundy::BadValue);
+    EXPECT_FALSE(AsyncOutput::isRunning());
+
+    AsyncOutput::start(1);
+    logSequence(file_spec.getLoggerName(), 0, 100);
+    AsyncOutput::flush();
+    checkSequences(file_spec.getFileName(), 1, 100);
+
+    logSequence(file_spec.getLoggerName(), 0, 100);
+    AsyncOutput::stop();
+    LoggerManager::reset();
+
+    // The same sequence has been written twice.
+    ifstream infile(file_spec.getFileName().c_str());
+    string line;
+    int lines = 0;
+    while (getline(infile, line)) {
+        ++lines;
+    }
+    EXPECT_EQ(200, lines);
+}
+
 // Check if the file rolls over when it gets above a certain size.
 TEST_F(LoggerManagerTest, FileSizeRollover) {
     // Set to a suitable minimum that log4cplus can copy with
@@ -15,7 +15,9 @@
 
 #
 # Functions for reading and parsing cc messages
-# Currently these are only abstraction functions for JSON conversion.
+# The messages are either in JSON or in the binary wire format; the
+# latter is described in src/lib/cc/data.cc, and both implementations
+# must be kept compatible.
 #
 
 import sys
@@ -23,18 +25,191 @@ import struct
 
 import json
 
-def to_wire(items):
+from bundy.cc.proto_defs import CC_WIRE_INTERNED_STRINGS
+
+BINARY_WIRE_MARKER = b'\xbc'
+
+_TAG_NULL = 0
+_TAG_FALSE = 1
+_TAG_TRUE = 2
+_TAG_INTEGER = 3
+_TAG_REAL = 4
+_TAG_STRING = 5
+_TAG_INTERNED = 6
+_TAG_LIST = 7
+_TAG_MAP = 8
+
+_INTERNED_STRINGS = CC_WIRE_INTERNED_STRINGS.split()
+_INTERNED_INDEXES = dict((s, i) for i, s in enumerate(_INTERNED_STRINGS))
+
+def _write_varint(out, value):
+    while value >= 0x80:
+        out.append((value & 0x7f) | 0x80)
+        value >>= 7
+    out.append(value)
+
+def _write_string(out, value):
+    index = _INTERNED_INDEXES.get(value)
+    if index is not None:
+        out.append(_TAG_INTERNED)
+        out.append(index)
+    else:
+        data = value.encode('utf8')
+        out.append(_TAG_STRING)
+        _write_varint(out, len(data))
+        out += data
+
+def _map_key(key):
+    # Non-string keys are converted the same way the json module does.
+    if isinstance(key, str):
+        return key
+    elif key is True:
+        return 'true'
+    elif key is False:
+        return 'false'
+    elif key is None:
+        return 'null'
+    elif isinstance(key, (int, float)):
+        return json.dumps(key)
+    raise TypeError('key ' + repr(key) + ' is not a string')
+
+def _write_binary(out, value):
+    if value is None:
+        out.append(_TAG_NULL)
+    elif value is True:
+        out.append(_TAG_TRUE)
+    elif value is False:
+        out.append(_TAG_FALSE)
+    elif isinstance(value, int):
+        if value < -2**63 or value >= 2**63:
+            raise TypeError(repr(value) + ' does not fit in 64 bits')
+        out.append(_TAG_INTEGER)
+        _write_varint(out, ((value << 1) ^ (value >> 63)) & (2**64 - 1))
+    elif isinstance(value, float):
+        out.append(_TAG_REAL)
+        out += struct.pack('!d', value)
+    elif isinstance(value, str):
+        _write_string(out, value)
+    elif isinstance(value, (list, tuple)):
+        out.append(_TAG_LIST)
+        _write_varint(out, len(value))
+        for item in value:
+            _write_binary(out, item)
+    elif isinstance(value, dict):
+        out.append(_TAG_MAP)
+        _write_varint(out, len(value))
+        for key, item in value.items():
+            _write_string(out, _map_key(key))
+            _write_binary(out, item)
+    else:
+        raise TypeError(repr(value) + ' is not serializable')
+
+class _BinaryReader:
+    '''Parser of the binary wire format. Raises a ValueError on broken
+       data.'''
+    def __init__(self, data):
+        self._data = data
+        self._pos = 0
+
+    def at_end(self):
+        return self._pos == len(self._data)
+
+    def _read_byte(self):
+        if self._pos >= len(self._data):
+            raise ValueError('binary wire data too short')
+        self._pos += 1
+        return self._data[self._pos - 1]
+
+    def _read_bytes(self, length):
+        if length > len(self._data) - self._pos:
+            raise ValueError('binary wire data too short')
+        self._pos += length
+        return self._data[self._pos - length:self._pos]
+
+    def _read_varint(self):
+        value = 0
+        for shift in range(0, 64, 7):
+            byte = self._read_byte()
+            value |= (byte & 0x7f) << shift
+            if byte & 0x80 == 0:
+                return value
+        raise ValueError('binary wire varint too long')
+
+    def _read_count(self):
+        # At least one byte per unit needs to follow, so we don't try to
+        # preallocate anything insane.
+        count = self._read_varint()
+        if count > len(self._data) - self._pos:
+            raise ValueError('binary wire count exceeds the data')
+        return count
+
+    def _read_string(self, tag):
+        if tag == _TAG_INTERNED:
+            index = self._read_byte()
+            if index >= len(_INTERNED_STRINGS):
+                raise ValueError('unknown interned string in binary wire: ' +
+                                 str(index))
+            return _INTERNED_STRINGS[index]
+        elif tag == _TAG_STRING:
+            # UnicodeDecodeError is a ValueError too
+            return bytes(self._read_bytes(self._read_count())).decode('utf8')
+        raise ValueError('binary wire string expected, tag: ' + str(tag))
+
+    def read_value(self):
+        tag = self._read_byte()
+        if tag == _TAG_NULL:
+            return None
+        elif tag == _TAG_FALSE:
+            return False
+        elif tag == _TAG_TRUE:
+            return True
+        elif tag == _TAG_INTEGER:
+            value = self._read_varint()
+            return (value >> 1) ^ -(value & 1)
+        elif tag == _TAG_REAL:
+            return struct.unpack('!d', self._read_bytes(8))[0]
+        elif tag == _TAG_STRING or tag == _TAG_INTERNED:
+            return self._read_string(tag)
+        elif tag == _TAG_LIST:
+            return [self.read_value() for _ in range(self._read_count())]
+        elif tag == _TAG_MAP:
+            result = {}
+            for _ in range(self._read_count()):
+                key = self._read_string(self._read_byte())
+                result[key] = self.read_value()
+            return result
+        raise ValueError('unknown binary wire tag: ' + str(tag))
+
+def to_wire(items, binary=False):
     '''Encodes the given python structure in JSON, and converts the
-       result to bytes. Raises a TypeError if the given structure is
-       not serializable with JSON.'''
+       result to bytes. If binary is true, the structure is encoded in
+       the binary wire format instead, which is smaller and faster to
+       parse, but which the receiver must support. Raises a TypeError
+       if the given structure is not serializable.'''
+    if binary:
+        out = bytearray(BINARY_WIRE_MARKER)
+        _write_binary(out, items)
+        return bytes(out)
     return json.dumps(items).encode('utf8')
 
+def is_binary(data):
+    '''Returns True if the given bytes are in the binary wire format.'''
+    return isinstance(data, (bytes, bytearray)) and \
+        data[:1] == BINARY_WIRE_MARKER
+
 def from_wire(data):
-    '''Decodes the given bytes and parses it with the builtin JSON
-       parser. Raises a ValueError if the data is not valid JSON.
-       Raises an AttributeError if the given object has no decode()
-       method (which should return a string).
+    '''Decodes the given bytes, either in the binary wire format or in
+       JSON, which is parsed with the builtin JSON parser. Raises a
+       ValueError if the data is not valid. Raises an AttributeError if
+       the given object has no decode() method (which should return a
+       string).
        '''
+    if is_binary(data):
+        reader = _BinaryReader(memoryview(data)[1:])
+        result = reader.read_value()
+        if not reader.at_end():
+            raise ValueError('trailing garbage in binary wire data')
+        return result
     return json.loads(data.decode('utf8'), strict=False)
 
 if __name__ == "__main__":
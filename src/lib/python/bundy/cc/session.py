@@ -45,6 +45,7 @@ class Session:
         self.set_timeout(self.MSGQ_DEFAULT_TIMEOUT);
         self._recv_len_size = 0
         self._recv_size = 0
+        self._binary_wire = False
 
         if socket_file is None:
             if "BUNDY_MSGQ_SOCKET_FILE" in os.environ:
@@ -57,10 +58,15 @@ class Session:
         try:
             self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
             self._socket.connect(self.socket_file)
-            self.sendmsg({ CC_HEADER_TYPE: CC_COMMAND_GET_LNAME })
+            # Offer the binary wire format; if the msgq supports it, it
+            # confirms that in the answer and we use it from then on.
+            self.sendmsg({ CC_HEADER_TYPE: CC_COMMAND_GET_LNAME,
+                           CC_HEADER_WIRE_FORMAT: CC_WIRE_FORMAT_BINARY })
             env, msg = self.recvmsg(False)
             if not env:
                 raise ProtocolError("Could not get local name")
+            self._binary_wire = \
+                env.get(CC_HEADER_WIRE_FORMAT) == CC_WIRE_FORMAT_BINARY
             self._lname = msg[CC_PAYLOAD_LNAME]
             if not self._lname:
                 raise ProtocolError("Could not get local name")
@@ -85,11 +91,11 @@ class Session:
             if self._closed:
                 raise SessionError("Session has been closed.")
             if type(env) == dict:
-                env = bundy.cc.message.to_wire(env)
+                env = bundy.cc.message.to_wire(env, self._binary_wire)
             if len(env) > 65535:
                 raise ProtocolError("Envelope too large")
             if type(msg) == dict:
-                msg = bundy.cc.message.to_wire(msg)
+                msg = bundy.cc.message.to_wire(msg, self._binary_wire)
             length = 2 + len(env);
             if msg is not None:
                 length += len(msg)
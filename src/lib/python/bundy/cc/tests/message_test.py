@@ -60,6 +60,40 @@ class MessageTest(unittest.TestCase):
         self.assertRaises(ValueError, bundy.cc.message.from_wire, b'[ 1 ')
         self.assertRaises(ValueError, bundy.cc.message.from_wire, b']')
 
+    def test_binary(self):
+        # Some known encodings, the same as in the C++ tests
+        to_wire = bundy.cc.message.to_wire
+        self.assertEqual(b'\xbc\x00', to_wire(None, True))
+        self.assertEqual(b'\xbc\x02', to_wire(True, True))
+        self.assertEqual(b'\xbc\x03\x03', to_wire(-2, True))
+        self.assertEqual(b'\xbc\x03\x80\x01', to_wire(64, True))
+        self.assertEqual(b'\xbc\x05\x03abc', to_wire("abc", True))
+        self.assertEqual(b'\xbc\x08\x01\x06\x00\x06\x08',
+                         to_wire({"type": "send"}, True))
+
+        for value in [self.msg1, self.msg2, self.msg3, self.msg_float, 0,
+                      2**63 - 1, -2**63, "", "été", [], {},
+                      {"type": "send", "group": "Stats", "seq": 4,
+                       "nested": {"list": [1.1, True, "*", None]}}]:
+            wire = to_wire(value, True)
+            self.assertTrue(bundy.cc.message.is_binary(wire))
+            self.assertEqual(value, bundy.cc.message.from_wire(wire))
+        self.assertFalse(bundy.cc.message.is_binary(self.msg1_wire))
+        self.assertLess(len(to_wire(self.msg2, True)), len(self.msg2_wire))
+        # Tuples are sent as lists, like in JSON
+        self.assertEqual([1, 2],
+                         bundy.cc.message.from_wire(to_wire((1, 2), True)))
+
+        self.assertRaises(TypeError, to_wire, NotImplemented, True)
+        self.assertRaises(TypeError, to_wire, 2**64, True)
+
+        for broken in [b'\xbc', b'\xbc\x09', b'\xbc\x00\x00', b'\xbc\x03\x80',
+                       b'\xbc\x04\x01\x02', b'\xbc\x05\x04abc',
+                       b'\xbc\x05\x01\xff', b'\xbc\x06\xff',
+                       b'\xbc\x07\x02\x02', b'\xbc\x08\x01\x02\x02',
+                       b'\xbc\x07\xff\xff\xff\xff\x0f']:
+            self.assertRaises(ValueError, bundy.cc.message.from_wire, broken)
+
 if __name__ == '__main__':
     unittest.main()
 
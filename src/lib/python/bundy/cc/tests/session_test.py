@@ -152,6 +152,7 @@ class MySession(Session):
         self._closed = False
         self._queue = []
         self._lock = threading.RLock()
+        self._binary_wire = False
 
         if s is not None:
             self._socket = s
@@ -185,6 +186,23 @@ class testSession(unittest.TestCase):
         sess.close()
         self.assertRaises(SessionError, sess.sendmsg, {}, {"hello": "a"})
 
+    def test_session_sendmsg_binary(self):
+        # Once negotiated, the messages are sent in the binary wire format
+        sess = MySession()
+        sess._binary_wire = True
+        sess.sendmsg({"type": "send"}, {"hello": "a"})
+        sent = sess._socket.readsentmsg();
+        self.assertEqual(sent, b'\x00\x00\x00\x16\x00\x07' +
+                         b'\xbc\x08\x01\x06\x00\x06\x08' +
+                         b'\xbc\x08\x01\x05\x05hello\x05\x01a')
+
+        # Whatever the format, both are received
+        sess._socket.addrecv(bundy.cc.message.to_wire({"to": "me"}, True),
+                             bundy.cc.message.to_wire({"hello": "b"}, True))
+        self.assertEqual(({"to": "me"}, {"hello": "b"}), sess.recvmsg(True))
+        sess._socket.addrecv({"to": "me"}, {"hello": "c"})
+        self.assertEqual(({"to": "me"}, {"hello": "c"}), sess.recvmsg(True))
+
     def test_session_sendmsg2(self):
         sess = MySession()
         sess.sendmsg({'to': 'someone', 'reply': 1}, {"hello": "a"})
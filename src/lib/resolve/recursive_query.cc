@@ -78,6 +78,27 @@ questionText(const bundy::dns::Question& question) {
     return (text);
 }
 
+// The callback of the queries refreshing the cache.  Nobody waits for
+// the answer, the query itself updates the cache.
+class PrefetchCallback : public bundy::resolve::ResolverInterface::Callback {
+public:
+    PrefetchCallback(const bundy::dns::Question& question) :
+        question_(question)
+    {}
+    virtual void success(const MessagePtr) {
+        LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_CACHE,
+                  RESLIB_PREFETCH_DONE).arg(questionText(question_)).
+            arg(true);
+    }
+    virtual void failure() {
+        LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_CACHE,
+                  RESLIB_PREFETCH_DONE).arg(questionText(question_)).
+            arg(false);
+    }
+private:
+    const bundy::dns::Question question_;
+};
+
 } // anonymous namespace
 
 /// \brief Find deepest usable delegation in the cache
@@ -305,6 +326,12 @@ private:
     // sent to this object as well as being used to update the NSAS.
     boost::shared_ptr<RttRecorder> rtt_recorder_;
 
+    // If set, the next lookup goes upstream even if the answer is in
+    // the cache.  Used to refresh cache entries before they expire; it
+    // is reset after the first lookup, so the CNAME chains are still
+    // followed through the cache.
+    bool skip_cache_;
+
     // perform a single lookup; first we check the cache to see
     // if we have a response for our query stored already. if
     // so, call handlerecursiveresponse(), if not, we call send()
@@ -314,14 +341,16 @@ private:
 
         Message cached_message(Message::RENDER);
         bundy::resolve::initResponseMessage(question_, cached_message);
-        if (cache_.lookup(question_.getName(), question_.getType(),
+        const bool skip_cache = skip_cache_;
+        skip_cache_ = false;
+        if (!skip_cache &&
+            cache_.lookup(question_.getName(), question_.getType(),
                           question_.getClass(), cached_message)) {
 
             LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_CACHE, RESLIB_RUNQ_CACHE_FIND)
                       .arg(questionText(question_));
-            // Should these be set by the cache too?
+            // The cache sets the RCODE (it may be NXDOMAIN), but not these.
             cached_message.setOpcode(Opcode::QUERY());
-            cached_message.setRcode(Rcode::NOERROR());
             cached_message.setHeaderFlag(Message::HEADERFLAG_QR);
             if (handleRecursiveAnswer(cached_message)) {
                 callCallback(true);
@@ -676,7 +705,8 @@ public:
         unsigned retries,
         bundy::nsas::NameserverAddressStore& nsas,
         bundy::cache::ResolverCache& cache,
-        boost::shared_ptr<RttRecorder>& recorder)
+        boost::shared_ptr<RttRecorder>& recorder,
+        bool skip_cache = false)
         :
         io_(io),
         question_(question),
@@ -699,7 +729,8 @@ public:
         nsas_callback_(),
         nsas_callback_out_(false),
         outstanding_events_(0),
-        rtt_recorder_(recorder)
+        rtt_recorder_(recorder),
+        skip_cache_(skip_cache)
     {
         // Set here to avoid using "this" in initializer list.
         nsas_callback_.reset(new ResolverNSASCallback(this));
@@ -1099,6 +1130,7 @@ RecursiveQuery::resolve(const QuestionPtr& question,
         // TODO: err, should cache set rcode as well?
         answer_message->setRcode(Rcode::NOERROR());
         callback->success(answer_message);
+        prefetch();
     } else {
         // Perhaps we only have the one RRset?
         // TODO: can we do this? should we check for specific types only?
@@ -1161,6 +1193,7 @@ RecursiveQuery::resolve(const Question& question,
         // TODO: err, should cache set rcode as well?
         answer_message->setRcode(Rcode::NOERROR());
         crs->success(answer_message);
+        prefetch();
     } else {
         // Perhaps we only have the one RRset?
         // TODO: can we do this? should we check for specific types only?
@@ -1190,6 +1223,27 @@ RecursiveQuery::resolve(const Question& question,
     return (NULL);
 }
 
+void
+RecursiveQuery::prefetch() {
+    std::vector<QuestionPtr> questions;
+    cache_.getPrefetchQuestions(questions);
+    for (std::vector<QuestionPtr>::const_iterator it = questions.begin();
+         it != questions.end(); ++it) {
+        LOG_DEBUG(bundy::resolve::logger, RESLIB_DBG_TRACE, RESLIB_PREFETCH)
+                  .arg(questionText(**it));
+        MessagePtr answer_message(new Message(Message::RENDER));
+        bundy::resolve::initResponseMessage(**it, *answer_message);
+        const ResolverInterface::CallbackPtr
+            callback(new PrefetchCallback(**it));
+        // There's no client to answer, so no client timeout.  The query
+        // deletes itself when it is done.
+        new RunningQuery(dns_service_.getIOService(), **it, answer_message,
+                         test_server_, OutputBufferPtr(new OutputBuffer(0)),
+                         callback, query_timeout_, -1, lookup_timeout_,
+                         retries_, nsas_, cache_, rtt_recorder_, true);
+    }
+}
+
 AbstractRunningQuery*
 RecursiveQuery::forward(ConstMessagePtr query_message,
     MessagePtr answer_message,
@@ -196,6 +196,15 @@ public:
                  bundy::resolve::ResolverInterface::CallbackPtr callback =
                      bundy::resolve::ResolverInterface::CallbackPtr());
 
+    /// \brief Refresh the popular cache entries that are about to expire.
+    ///
+    /// Starts a query for each of the questions the cache asked to be
+    /// prefetched (see \c ResolverCache::setPrefetchPolicy()).  The
+    /// queries skip the cache and update it with the answer; no client
+    /// waits for them.  This is called after each answer from the cache,
+    /// it is public only for use-cases such as unit tests.
+    void prefetch();
+
     /// \brief Set Test Server
     ///
     /// This method is *only* for unit testing the class.  If set, it enables
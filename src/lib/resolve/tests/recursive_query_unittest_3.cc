@@ -66,6 +66,9 @@ using namespace std;
 /// - Send EDNS question over TCP - get FORMERR
 /// - Send non-EDNS question over UDP - get RESPONSE
 ///
+/// It also checks that a popular answer about to expire from the cache is
+/// refreshed by exactly one query.
+///
 /// By using the "test_server_" element of RecursiveQuery, all queries are
 /// directed to one or other of the "servers" in the RecursiveQueryTest3 class.
 
@@ -103,7 +106,9 @@ public:
         NONE = 0,                   ///< Default
         EDNS_UDP = 1,               ///< EDNS query over UDP
         NON_EDNS_UDP = 2,           ///< Non-EDNS query over UDP
-        COMPLETE = 6                ///< Query is complete
+        COMPLETE = 6,               ///< Query is complete
+        PREFETCH_UDP = 7,           ///< Prefetch query over UDP
+        PREFETCH_COMPLETE = 8       ///< Prefetch query is complete
     };
 
     // Common stuff
@@ -253,6 +258,12 @@ public:
             expected_ = COMPLETE;
             break;
 
+        case PREFETCH_UDP:
+            // Answer the refresh; there must be no other query.
+            setAnswer(message);
+            expected_ = PREFETCH_COMPLETE;
+            break;
+
          default:
             FAIL() << "UdpReceiveHandler called with unknown state";
         }
@@ -586,5 +597,56 @@ TEST_F(RecursiveQueryTest3, Resolve) {
     }
 }
 
+// Checks that the hit which makes a cached answer due for prefetching
+// sends exactly one query to refresh it, and that the hits after it don't.
+
+TEST_F(RecursiveQueryTest3, Prefetch) {
+    udp_socket_.set_option(socket_base::reuse_address(true));
+    udp_socket_.bind(udp::endpoint(address::from_string(TEST_ADDRESS3),
+                                   TEST_PORT3));
+    udp_socket_.async_receive_from(asio::buffer(udp_receive_buffer_,
+                                                sizeof(udp_receive_buffer_)),
+                                   udp_remote_,
+                           boost::bind(&RecursiveQueryTest3::udpReceiveHandler,
+                                               this, _1, _2));
+
+    std::vector<std::pair<std::string, uint16_t> > upstream;         // Empty
+    std::vector<std::pair<std::string, uint16_t> > upstream_root;    // Empty
+    RecursiveQuery query(dns_service_, *nsas_, cache_,
+                         upstream, upstream_root);
+    query.setTestServer(TEST_ADDRESS3, TEST_PORT3);
+
+    // Cache the answer.  As the whole TTL counts as near the expiry, it's
+    // due on the second hit.
+    Message message(Message::RENDER);
+    setCommonMessage(message, 0);
+    setAnswer(message);
+    ASSERT_TRUE(cache_.update(message));
+    cache_.setPrefetchPolicy(2, 1.0);
+
+    // All the answers come from the cache.  (The callback stops the
+    // service, so it has to be reset before it's run.)
+    expected_ = PREFETCH_UDP;
+    last_ = COMPLETE;
+    for (int i = 0; i < 3; ++i) {
+        bundy::resolve::ResolverInterface::CallbackPtr
+            resolver_callback(new ResolverCallback3(service_));
+        EXPECT_EQ(static_cast<AbstractRunningQuery*>(NULL),
+                  query.resolve(question_, resolver_callback));
+        EXPECT_TRUE(static_cast<ResolverCallback3*>(
+                        resolver_callback.get())->getStatus());
+    }
+
+    // Give the refresh (and any unexpected other query) time to arrive.
+    asio::deadline_timer timer(service_.get_io_service());
+    timer.expires_from_now(boost::posix_time::seconds(1));
+    timer.async_wait(boost::bind(&IOService::stop, &service_));
+    service_.get_io_service().reset();
+    service_.run();
+
+    EXPECT_EQ(PREFETCH_UDP, last_);
+    EXPECT_EQ(PREFETCH_COMPLETE, expected_);
+}
+
 } // namespace asiodns
 } // namespace bundy
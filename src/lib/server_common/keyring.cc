@@ -41,7 +41,9 @@ updateKeyring(const std::string&, ConstElementPtr data,
     for (size_t i(0); list && i < list->size(); ++ i) {
         load->add(TSIGKey(list->get(i)->stringValue()));
     }
-    keyring.swap(load);
+    // The keyring can be used by other threads (e.g., UDP query processing
+    // threads of bundy-auth), which read it with boost::atomic_load().
+    boost::atomic_store(&keyring, load);
 }
 
 }
@@ -63,7 +65,7 @@ deinitKeyring(config::ModuleCCSession& session) {
         return;
     }
     LOG_DEBUG(logger, DBG_TRACE_BASIC, SRVCOMM_KEYS_DEINIT);
-    keyring.reset();
+    boost::atomic_store(&keyring, KeyringPtr());
     session.removeRemoteConfig("tsig_keys");
 }
 
@@ -76,6 +76,27 @@ public:
         }
         return (counters_.at(type));
     }
+
+    /// \brief Add the values of another set of counters to this one.
+    ///
+    /// This is intended to be used to aggregate counters maintained
+    /// separately, e.g., by different threads.
+    ///
+    /// \param other %Counter to be added; it must have the same number
+    /// of items as this one
+    ///
+    /// \throw bundy::InvalidParameter \a other has a different number of
+    /// items
+    void add(const Counter& other) {
+        if (other.counters_.size() != counters_.size()) {
+            bundy_throw(bundy::InvalidParameter,
+                        "Counter sizes mismatch: " << counters_.size() <<
+                        " vs " << other.counters_.size());
+        }
+        for (size_t i = 0; i < counters_.size(); ++i) {
+            counters_[i] += other.counters_[i];
+        }
+    }
 };
 
 }   // namespace statistics
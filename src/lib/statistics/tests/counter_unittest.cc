@@ -80,6 +80,25 @@ TEST_F(CounterTest, incrementCounterItem) {
     EXPECT_EQ(counter.get(ITEM1), 4294967308LL); // 4294967306 + 2
 }
 
+TEST_F(CounterTest, addCounter) {
+    Counter other(NUMBER_OF_ITEMS);
+    counter.inc(ITEM1);
+    other.inc(ITEM1);
+    other.inc(ITEM3);
+    other.inc(ITEM3);
+    counter.add(other);
+    EXPECT_EQ(counter.get(ITEM1), 2);
+    EXPECT_EQ(counter.get(ITEM2), 0);
+    EXPECT_EQ(counter.get(ITEM3), 2);
+    // other is intact
+    EXPECT_EQ(other.get(ITEM1), 1);
+
+    // Adding counters of a different size will cause an
+    // bundy::InvalidParameter exception
+    Counter small(NUMBER_OF_ITEMS - 1);
+    EXPECT_THROW(counter.add(small), bundy::InvalidParameter);
+}
+
 TEST_F(CounterTest, invalidCounterItem) {
     // Incrementing out-of-bound counter will cause an bundy::OutOfRange
     // exception
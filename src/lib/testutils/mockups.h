@@ -113,7 +113,7 @@ private:
 // to addServerXXX methods so the test code subsequently checks the parameters.
 class MockDNSService : public bundy::asiodns::DNSServiceBase {
 public:
-    MockDNSService() : tcp_recv_timeout_(0) {}
+    MockDNSService() : tcp_recv_timeout_(0), udp_workers_(0) {}
 
     // A helper tuple of parameters passed to addServerUDPFromFD().
     struct UDPFdParams {
@@ -130,6 +130,17 @@ public:
         udp_fd_params_.push_back(params);
     }
     virtual void clearServers() {}
+    virtual void addUDPWorker(asiolink::IOService&, asiodns::DNSLookup*) {
+        ++udp_workers_;
+    }
+    virtual void clearUDPWorkers() {
+        udp_workers_ = 0;
+    }
+
+    // Allow the tests to check how many UDP workers have been added.
+    size_t getUDPWorkerCount() const {
+        return (udp_workers_);
+    }
 
     virtual asiolink::IOService& getIOService() {
         bundy_throw(bundy::Unexpected,
@@ -157,6 +168,7 @@ private:
     std::vector<std::pair<int, int> > tcp_fd_params_;
     std::vector<UDPFdParams> udp_fd_params_;
     size_t tcp_recv_timeout_;
+    size_t udp_workers_;
 };
 
 // A nonoperative DNSServer object to be used in calls to processMessage().
@@ -60,6 +60,17 @@ struct Deinitializer {
     pthread_mutexattr_t& attributes_;
 };
 
+struct RWLockDeinitializer {
+    RWLockDeinitializer(pthread_rwlockattr_t& attributes):
+        attributes_(attributes)
+    {}
+    ~RWLockDeinitializer() {
+        const int result = pthread_rwlockattr_destroy(&attributes_);
+        assert(result == 0);
+    }
+    pthread_rwlockattr_t& attributes_;
+};
+
 }
 
 Mutex::Mutex() :
@@ -199,6 +210,80 @@ Mutex::unlock() {
     assert(result == 0); // This should never be possible
 }
 
+class RWMutex::Impl {
+public:
+    pthread_rwlock_t rwlock;
+};
+
+RWMutex::RWMutex() :
+    impl_(NULL)
+{
+    pthread_rwlockattr_t attributes;
+    int result = pthread_rwlockattr_init(&attributes);
+    switch (result) {
+        case 0: // All 0K
+            break;
+        case ENOMEM:
+            throw std::bad_alloc();
+        default:
+            bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+    RWLockDeinitializer deinitializer(attributes);
+
+    // The default glibc rwlock prefers readers, so a writer could wait
+    // forever while readers keep taking the lock one after another.
+    // Other common implementations prefer writers by default.
+#ifdef __GLIBC__
+    result = pthread_rwlockattr_setkind_np(
+        &attributes, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    if (result != 0) {
+        bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+#endif // __GLIBC__
+
+    unique_ptr<Impl> impl(new Impl);
+    result = pthread_rwlock_init(&impl->rwlock, &attributes);
+    switch (result) {
+        case 0: // All 0K
+            impl_ = impl.release();
+            break;
+        case ENOMEM:
+        case EAGAIN:
+            throw std::bad_alloc();
+        default:
+            bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+}
+
+RWMutex::~RWMutex() {
+    const int result = pthread_rwlock_destroy(&impl_->rwlock);
+    delete impl_;
+    // As with Mutex, we don't want to throw from the destructor.
+    assert(result == 0);
+}
+
+void
+RWMutex::readLock() {
+    const int result = pthread_rwlock_rdlock(&impl_->rwlock);
+    if (result != 0) {
+        bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+}
+
+void
+RWMutex::writeLock() {
+    const int result = pthread_rwlock_wrlock(&impl_->rwlock);
+    if (result != 0) {
+        bundy_throw(bundy::InvalidOperation, std::strerror(result));
+    }
+}
+
+void
+RWMutex::unlock() {
+    const int result = pthread_rwlock_unlock(&impl_->rwlock);
+    assert(result == 0); // This should never be possible
+}
+
 class CondVar::Impl {
 public:
     Impl() {
@@ -255,6 +340,15 @@ CondVar::signal() {
     assert(result == 0);
 }
 
+void
+CondVar::broadcast() {
+    const int result = pthread_cond_broadcast(&impl_->cond_);
+
+    // pthread_cond_broadcast() can only fail when if cond_ is invalid.  It
+    // should be impossible as long as this is a valid CondVar object.
+    assert(result == 0);
+}
+
 }
 }
 }
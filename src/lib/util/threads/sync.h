@@ -170,6 +170,93 @@ private:
     Impl* impl_;
 };
 
+/// \brief Reader-writer lock with a simple interface
+///
+/// This is a wrapper around a reader-writer lock, which can be held by
+/// any number of readers at the same time, or by a single writer.  It's
+/// intended for data that is read frequently from multiple threads but
+/// rarely modified.  A waiting writer is preferred over new readers, so
+/// it can't be starved by readers which keep taking the lock.
+///
+/// Like \c Mutex, it's locked only via the nested locker classes:
+/// \c ReaderLocker acquires a shared lock and \c Locker acquires an
+/// exclusive lock.  The exclusive locker is named the same as
+/// \c Mutex::Locker so this class can be used in place of \c Mutex in
+/// code templated on the mutex type where only exclusive locks are needed.
+///
+/// A thread must not try to acquire a lock on the same object while it
+/// already holds one (of any type); the result is undefined.
+///
+/// Errors are handled the same way as \c Mutex.
+class RWMutex : boost::noncopyable {
+public:
+    /// \brief Constructor.
+    ///
+    /// \throw std::bad_alloc In case allocation of something (memory, the
+    ///     OS lock) fails.
+    /// \throw bundy::InvalidOperation Other unspecified errors around the
+    ///     lock.  This should be rare.
+    RWMutex();
+
+    /// \brief Destructor.
+    ///
+    /// It is not allowed to destroy the lock while it's held.
+    ~RWMutex();
+
+    /// \brief This holds a shared (reader) lock on a RWMutex.
+    class ReaderLocker : boost::noncopyable {
+    public:
+        /// \brief Constructor.
+        ///
+        /// Acquires a shared lock.  It blocks while a writer holds the lock.
+        ///
+        /// \throw bundy::InvalidOperation when OS reports error.
+        ReaderLocker(RWMutex& mutex) : mutex_(mutex) {
+            mutex.readLock();
+        }
+
+        /// \brief Destructor.
+        ///
+        /// Releases the lock.
+        ~ReaderLocker() {
+            mutex_.unlock();
+        }
+    private:
+        RWMutex& mutex_;
+    };
+
+    /// \brief This holds an exclusive (writer) lock on a RWMutex.
+    class Locker : boost::noncopyable {
+    public:
+        /// \brief Constructor.
+        ///
+        /// Acquires an exclusive lock.  It blocks while any other thread
+        /// holds the lock.
+        ///
+        /// \throw bundy::InvalidOperation when OS reports error.
+        Locker(RWMutex& mutex) : mutex_(mutex) {
+            mutex.writeLock();
+        }
+
+        /// \brief Destructor.
+        ///
+        /// Releases the lock.
+        ~Locker() {
+            mutex_.unlock();
+        }
+    private:
+        RWMutex& mutex_;
+    };
+
+private:
+    void readLock();
+    void writeLock();
+    void unlock();
+
+    class Impl;
+    Impl* impl_;
+};
+
 /// \brief Encapsulation for a condition variable.
 ///
 /// This class provides a simple encapsulation of condition variable for
@@ -194,11 +281,10 @@ private:
 /// Note that \c mutex passed to the \c wait() method must be the same one
 /// used to construct the \c locker.
 ///
-/// Right now there is no equivalent to pthread_cond_broadcast() or
-/// pthread_cond_timedwait() in this class, because this class is meant
-/// for internal development of BUNDY and we don't need these at the
-/// moment.  If and when we need these interfaces they can be added at that
-/// point.
+/// Right now there is no equivalent to pthread_cond_timedwait() in this
+/// class, because this class is meant for internal development of BUNDY
+/// and we don't need it at the moment.  If and when we need this interface
+/// it can be added at that point.
 ///
 /// \note This class is defined as a friend class of \c Mutex and directly
 /// refers to and modifies private internals of the \c Mutex class.  It breaks
@@ -248,6 +334,15 @@ public:
     /// This method never throws; if some unexpected low level error happens
     /// it terminates the program.
     void signal();
+
+    /// \brief Unblock all threads waiting for the condition variable.
+    ///
+    /// This method works like \c pthread_cond_broadcast().  It wakes all
+    /// other threads (if any) waiting on this object via the \c wait() call.
+    ///
+    /// This method never throws; if some unexpected low level error happens
+    /// it terminates the program.
+    void broadcast();
 private:
     class Impl;
     Impl* impl_;
@@ -168,4 +168,92 @@ TEST(MutexTest, swarm) {
     }
 }
 
+// Readers of RWMutex can hold the lock at the same time.
+void
+holdReaderLock(RWMutex* mutex, volatile bool* locked, volatile bool* done) {
+    RWMutex::ReaderLocker locker(*mutex);
+    *locked = true;
+    while (!*done) {}
+}
+
+TEST(RWMutexTest, sharedReaders) {
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        RWMutex mutex;
+        bool locked = false;
+        bool done = false;
+        Thread thread(boost::bind(&holdReaderLock, &mutex, &locked, &done));
+        while (!locked) {}
+        {
+            // This would block forever if the reader lock weren't shared.
+            RWMutex::ReaderLocker locker(mutex);
+        }
+        done = true;
+        thread.wait();
+    }
+}
+
+// The same test as MutexTest.swarm, for the exclusive lock of RWMutex.
+void
+performRWIncrement(volatile double* canary, volatile bool* ready_me,
+                   volatile bool* ready_other, RWMutex* mutex)
+{
+    *ready_me = true;
+    while (!*ready_other) {}
+
+    for (size_t i = 0; i < iterations; ++i) {
+        RWMutex::Locker lock(*mutex);
+        *canary += 1;
+    }
+}
+
+TEST(RWMutexTest, swarm) {
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        double canary = 0;
+        RWMutex mutex;
+        bool ready1 = false;
+        bool ready2 = false;
+        Thread t1(boost::bind(&performRWIncrement, &canary, &ready1, &ready2,
+                              &mutex));
+        Thread t2(boost::bind(&performRWIncrement, &canary, &ready2, &ready1,
+                              &mutex));
+        t1.wait();
+        t2.wait();
+        EXPECT_EQ(iterations * 2, canary) << "Threads are badly synchronized";
+    }
+}
+
+// A reader which keeps taking the lock until it's told to stop.
+void
+repeatReaderLock(RWMutex* mutex, volatile bool* locked, volatile bool* done) {
+    while (!*done) {
+        RWMutex::ReaderLocker locker(*mutex);
+        *locked = true;
+        usleep(1000);
+    }
+}
+
+// A writer gets the lock even if the readers hold it all the time.
+TEST(RWMutexTest, writerNotStarved) {
+    if (!bundy::util::unittests::runningOnValgrind()) {
+        RWMutex mutex;
+        bool locked1 = false;
+        bool locked2 = false;
+        bool done = false;
+        Thread t1(boost::bind(&repeatReaderLock, &mutex, &locked1, &done));
+        Thread t2(boost::bind(&repeatReaderLock, &mutex, &locked2, &done));
+        while (!locked1 || !locked2) {}
+
+        // If the writer were starved, this would block forever, so the
+        // alarm kills the test instead.
+        alarm(10);
+        {
+            RWMutex::Locker locker(mutex);
+            done = true;
+        }
+        alarm(0);
+        t1.wait();
+        t2.wait();
+    }
+}
+
 }